@@ -0,0 +1,100 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "ObjLoader.hpp"
+#include "Object.hpp"
+#include "TaskPool.hpp"
+
+namespace {
+
+  /**
+   * @brief Writes a flat grid mesh made of quads to an OBJ file.
+   * @param path The path of the generated file.
+   * @param triangles The minimum number of triangles wanted.
+   */
+  void writeGrid(const std::string &path, std::size_t triangles) {
+    std::size_t side = 1;
+    while (2 * side * side < triangles)
+      side++;
+
+    std::ofstream out(path);
+    out << "vn 0 0 1\n";
+    for (std::size_t y = 0; y <= side; y++)
+      for (std::size_t x = 0; x <= side; x++)
+        out << "v " << x << ' ' << y << " 0\n";
+    for (std::size_t y = 0; y < side; y++) {
+      for (std::size_t x = 0; x < side; x++) {
+        std::size_t a = y * (side + 1) + x + 1;
+        std::size_t b = a + side + 1;
+        out << "f " << a << "//1 " << a + 1 << "//1 " << b + 1 << "//1 " << b
+            << "//1\n";
+      }
+    }
+  }
+
+  /**
+   * @brief Gets the milliseconds elapsed since a point in time.
+   * @param start The point in time.
+   * @return double The elapsed time in milliseconds.
+   */
+  double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+  }
+
+}  // namespace
+
+/**
+ * @brief Measures the OBJ loader and the mesh BVH build on a generated grid.
+ *
+ * The BVH is built with every quality preset, on the global task pool.
+ * Usage: obj_loader_bench [triangles] [path]
+ * The grid has 10 million triangles by default and is written next to the
+ * binary unless a path is given. An existing file is reused.
+ */
+int main(int argc, char **argv) {
+  std::size_t triangles = argc > 1 ? std::strtoull(argv[1], nullptr, 10)
+                                   : 10'000'000;
+  std::string path = argc > 2 ? argv[2]
+      : "obj_loader_bench_" + std::to_string(triangles) + ".obj";
+
+  if (!std::filesystem::exists(path)) {
+    auto start = std::chrono::steady_clock::now();
+    writeGrid(path, triangles);
+    std::cout << "Generated " << path << " in " << elapsedMs(start)
+              << " ms" << std::endl;
+  }
+
+  Raytracer::Object object;
+  auto start = std::chrono::steady_clock::now();
+  Raytracer::ObjLoader::load(path, object);
+  double loadMs = elapsedMs(start);
+
+  auto parallelFor = [](std::size_t count,
+                        const std::function<void(std::size_t)> &fn) {
+    Raytracer::TaskPool::global().parallelFor(count, fn);
+  };
+  double buildMs[Raytracer::BVH::QualityCount];
+  for (int i = 0; i < Raytracer::BVH::QualityCount; i++) {
+    start = std::chrono::steady_clock::now();
+    object.buildAccel(static_cast<Raytracer::BVH::Quality>(i), parallelFor);
+    buildMs[i] = elapsedMs(start);
+  }
+
+  double size = static_cast<double>(std::filesystem::file_size(path));
+  std::cout << "Vertices: " << object.getVertices().size() << std::endl
+            << "Triangles: " << object.getFaces().size() << std::endl
+            << "Load: " << loadMs << " ms ("
+            << size / (1024.0 * 1024.0) / (loadMs / 1000.0) << " MiB/s)"
+            << std::endl;
+  for (int i = 0; i < Raytracer::BVH::QualityCount; i++) {
+    auto quality = static_cast<Raytracer::BVH::Quality>(i);
+    std::cout << "BVH build (" << Raytracer::BVH::qualityName(quality)
+              << "): " << buildMs[i] << " ms" << std::endl;
+  }
+  return 0;
+}
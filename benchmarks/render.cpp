@@ -0,0 +1,481 @@
+#include <sys/resource.h>
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Camera.hpp"
+#include "RenderStats.hpp"
+#include "Renderer.hpp"
+#include "Trace.hpp"
+
+namespace {
+
+  /**
+   * @brief Command line options.
+   */
+  struct Options {
+    std::string scenes = "scenes";   ///< Directory of the scenes to render.
+    int width = 320;                 ///< Render width in pixels.
+    int height = 240;                ///< Render height in pixels.
+    int runs = 5;                    ///< Timed renders per scene.
+    std::string output;              ///< JSON output file, stdout if empty.
+    std::string baseline;            ///< JSON results to compare against.
+    double maxRegression = 10.0;     ///< Allowed slowdown in percent.
+    Raytracer::Renderer::Heatmap heatmap =
+        Raytracer::Renderer::HeatmapOff; ///< Heatmap to write per scene.
+    std::string trace;               ///< Chrome trace file, none if empty.
+    bool denoise = false;            ///< Whether the frames are denoised.
+    bool packets = true;             ///< Whether primary rays go in packets.
+    bool wavefront = false;          ///< Whether frames go stage by stage.
+    Raytracer::BVH::Quality bvh =
+        Raytracer::BVH::QualitySah;  ///< Preset of the mesh BVHs.
+  };
+
+  /**
+   * @brief Measurements of one scene.
+   */
+  struct Result {
+    std::string scene;               ///< Path of the scene.
+    std::string error;               ///< Why it could not be rendered.
+    double loadMs = 0;               ///< Time to parse the scene.
+    std::vector<double> runsMs;      ///< Wall time of each timed render.
+    Raytracer::RenderStats::Snapshot stats; ///< Work done by the last render.
+    std::array<double, Raytracer::Renderer::StageCount>
+        stageMs{}; ///< Wavefront stage times, summed over the timed renders.
+    long peakRssKb = 0;              ///< Peak RSS of the process so far.
+
+    double median() const {
+      std::vector<double> sorted = runsMs;
+      std::sort(sorted.begin(), sorted.end());
+      std::size_t n = sorted.size();
+      return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+    }
+
+    double perSecond(Raytracer::RayStats::Counter counter) const {
+      return static_cast<double>(stats[counter]) / (median() / 1000.0);
+    }
+  };
+
+  /**
+   * @brief Gets the milliseconds elapsed since a point in time.
+   * @param start The point in time.
+   * @return double The elapsed time in milliseconds.
+   */
+  double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+  }
+
+  /**
+   * @brief Gets the peak resident set size of the process.
+   * @return long The peak RSS in kilobytes.
+   */
+  long peakRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+  }
+
+  /**
+   * @brief Escapes a string for a JSON document.
+   * @param value The string.
+   * @return std::string The quoted, escaped string.
+   */
+  std::string quote(const std::string &value) {
+    std::string out = "\"";
+    for (char c : value) {
+      if (c == '"' || c == '\\')
+        out += '\\';
+      if (c == '\n')
+        out += "\\n";
+      else
+        out += c;
+    }
+    return out + "\"";
+  }
+
+  /**
+   * @brief Writes the heatmap of a scene as screenshots/<scene>_<mode>.ppm.
+   * @param scene The path of the scene.
+   * @param framebuffer The heatmap.
+   * @param options The options.
+   */
+  void writeHeatmap(const std::string &scene,
+                    const std::vector<sf::Color> &framebuffer,
+                    const Options &options) {
+    std::filesystem::create_directories("screenshots");
+    std::string path = "screenshots/" +
+                       std::filesystem::path(scene).stem().string() + "_" +
+                       Raytracer::Renderer::heatmapName(options.heatmap) +
+                       ".ppm";
+    std::ofstream out(path);
+    out << "P3\n" << options.width << " " << options.height << "\n255\n";
+    for (const auto &color : framebuffer)
+      out << static_cast<int>(color.r) << " " << static_cast<int>(color.g)
+          << " " << static_cast<int>(color.b) << "\n";
+    if (!out)
+      throw std::runtime_error("Cannot write heatmap: " + path);
+    std::cerr << path << std::endl;
+  }
+
+  /**
+   * @brief Parses the command line.
+   * @param argc The number of arguments.
+   * @param argv The arguments.
+   * @param options Receives the options.
+   * @return bool false if the command line is invalid.
+   */
+  bool parseOptions(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      if (i + 1 >= argc)
+        return false;
+      std::string value = argv[++i];
+      if (arg == "--scenes")
+        options.scenes = value;
+      else if (arg == "--width")
+        options.width = std::atoi(value.c_str());
+      else if (arg == "--height")
+        options.height = std::atoi(value.c_str());
+      else if (arg == "--runs")
+        options.runs = std::atoi(value.c_str());
+      else if (arg == "--output")
+        options.output = value;
+      else if (arg == "--baseline")
+        options.baseline = value;
+      else if (arg == "--max-regression")
+        options.maxRegression = std::atof(value.c_str());
+      else if (arg == "--trace")
+        options.trace = value;
+      else if (arg == "--denoise" && (value == "on" || value == "off"))
+        options.denoise = value == "on";
+      else if (arg == "--packets" && (value == "on" || value == "off"))
+        options.packets = value == "on";
+      else if (arg == "--wavefront" && (value == "on" || value == "off"))
+        options.wavefront = value == "on";
+      else if (arg == "--bvh") {
+        try {
+          options.bvh = Raytracer::BVH::parseQuality(value);
+        } catch (const std::exception &e) {
+          std::cerr << "[ERROR] - " << e.what() << std::endl;
+          return false;
+        }
+      }
+      else if (arg == "--heatmap") {
+        try {
+          options.heatmap = Raytracer::Renderer::parseHeatmap(value);
+        } catch (const std::exception &e) {
+          std::cerr << "[ERROR] - " << e.what() << std::endl;
+          return false;
+        }
+      }
+      else
+        return false;
+    }
+    return options.width > 0 && options.height > 0 && options.runs > 0;
+  }
+
+  /**
+   * @brief Gets the plugins the renderer creates shapes and lights from.
+   * @return std::vector<std::string> The .so files of ./plugins.
+   */
+  std::vector<std::string> findPlugins() {
+    std::vector<std::string> plugins;
+    for (const auto &entry :
+         std::filesystem::directory_iterator("./plugins")) {
+      if (entry.is_regular_file() && entry.path().extension() == ".so")
+        plugins.push_back(entry.path().string());
+    }
+    return plugins;
+  }
+
+  /**
+   * @brief Loads a scene and renders it once untimed, then `runs` times,
+   * then once more untimed in heatmap mode if one was requested.
+   *
+   * The camera keeps the position and orientation of the scene but renders
+   * at the benchmark resolution, so that every scene costs the same number
+   * of primary rays.
+   * @param path The path of the scene.
+   * @param plugins The plugins.
+   * @param options The options.
+   * @return Result The measurements, or the error.
+   */
+  Result benchmarkScene(const std::string &path,
+                        const std::vector<std::string> &plugins,
+                        const Options &options) {
+    Result result;
+    result.scene = path;
+
+    try {
+      Raytracer::Camera camera;
+      auto start = std::chrono::steady_clock::now();
+      Raytracer::Renderer renderer(options.width, options.height, path,
+                                   camera, plugins, options.bvh);
+      result.loadMs = elapsedMs(start);
+      camera.setWidth(options.width);
+      camera.setHeight(options.height);
+      renderer.setDenoise(options.denoise);
+      renderer.setPackets(options.packets);
+      renderer.setWavefront(options.wavefront);
+
+      std::vector<sf::Color> framebuffer(options.width * options.height);
+      renderer.renderToBuffer(framebuffer, camera);
+      for (int i = 0; i < options.runs; i++) {
+        start = std::chrono::steady_clock::now();
+        renderer.renderToBuffer(framebuffer, camera);
+        result.runsMs.push_back(elapsedMs(start));
+        for (int s = 0; s < Raytracer::Renderer::StageCount; s++)
+          result.stageMs[s] += renderer.getStageMs()[s];
+      }
+      result.stats = renderer.getFrameStats();
+      if (options.heatmap != Raytracer::Renderer::HeatmapOff) {
+        renderer.setHeatmap(options.heatmap);
+        renderer.renderToBuffer(framebuffer, camera);
+        writeHeatmap(path, framebuffer, options);
+      }
+    } catch (const std::exception &e) {
+      result.error = e.what();
+    }
+    result.peakRssKb = peakRssKb();
+    return result;
+  }
+
+  /**
+   * @brief Writes the results as JSON, one scene object per line.
+   * @param out The stream.
+   * @param results The results.
+   * @param options The options.
+   */
+  void writeJson(std::ostream &out, const std::vector<Result> &results,
+                 const Options &options) {
+    out << "{\n  \"width\": " << options.width << ",\n  \"height\": "
+        << options.height << ",\n  \"runs\": " << options.runs
+        << ",\n  \"scenes\": [\n";
+    using Raytracer::RayStats;
+    for (std::size_t i = 0; i < results.size(); i++) {
+      const Result &r = results[i];
+      out << "    {\"scene\": " << quote(r.scene);
+      if (!r.error.empty()) {
+        out << ", \"error\": " << quote(r.error);
+      } else {
+        auto [min, max] = std::minmax_element(r.runsMs.begin(), r.runsMs.end());
+        double mean = std::accumulate(r.runsMs.begin(), r.runsMs.end(), 0.0) /
+                      r.runsMs.size();
+        out << ", \"load_ms\": " << r.loadMs << ", \"median_ms\": "
+            << r.median() << ", \"min_ms\": " << *min << ", \"max_ms\": "
+            << *max << ", \"mean_ms\": " << mean
+            << ", \"primary_rays\": " << r.stats[RayStats::PrimaryRays]
+            << ", \"shadow_rays\": " << r.stats[RayStats::ShadowRays]
+            << ", \"secondary_rays\": " << r.stats[RayStats::SecondaryRays]
+            << ", \"primary_rays_per_s\": "
+            << r.perSecond(RayStats::PrimaryRays)
+            << ", \"shadow_rays_per_s\": "
+            << r.perSecond(RayStats::ShadowRays)
+            << ", \"secondary_rays_per_s\": "
+            << r.perSecond(RayStats::SecondaryRays)
+            << ", \"shape_tests\": " << r.stats[RayStats::ShapeTests]
+            << ", \"triangle_tests\": " << r.stats[RayStats::TriangleTests]
+            << ", \"bvh_nodes\": " << r.stats[RayStats::BvhNodes];
+        if (options.wavefront) {
+          for (int s = 0; s < Raytracer::Renderer::StageCount; s++)
+            out << ", \"" << Raytracer::Renderer::stageName(
+                                  static_cast<Raytracer::Renderer::Stage>(s))
+                << "_ms\": " << r.stageMs[s] / r.runsMs.size();
+        }
+      }
+      out << ", \"peak_rss_kb\": " << r.peakRssKb << "}"
+          << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+  }
+
+  /**
+   * @brief Reads an integer field of the header written by writeJson().
+   * @param text The JSON text.
+   * @param name The name of the field.
+   * @return int The value, or -1 if the field is missing.
+   */
+  int readHeaderField(const std::string &text, const std::string &name) {
+    std::smatch match;
+    if (!std::regex_search(text, match,
+                           std::regex("\"" + name + "\": ([0-9]+)")))
+      return -1;
+    return std::stoi(match[1]);
+  }
+
+  /**
+   * @brief Reads the median time of every scene of a previous run.
+   *
+   * Only the layout written by writeJson() is supported: flat scene objects
+   * with "scene" before "median_ms", and scene paths without quotes. Times
+   * taken at another resolution or over another number of runs cannot be
+   * compared, so the width, height and runs of the baseline must match the
+   * options.
+   * @param path The path of the JSON file.
+   * @param options The options of this run.
+   * @return std::map<std::string, double> Median times by scene.
+   * @throws std::runtime_error if the file cannot be read or was written
+   * with other settings.
+   */
+  std::map<std::string, double> readBaseline(const std::string &path,
+                                             const Options &options) {
+    std::ifstream file(path);
+    if (!file)
+      throw std::runtime_error("Cannot read baseline: " + path);
+    std::stringstream content;
+    content << file.rdbuf();
+    std::string text = content.str();
+
+    std::size_t header = text.find("\"scenes\"");
+    std::string head = text.substr(0, header);
+    int width = readHeaderField(head, "width");
+    int height = readHeaderField(head, "height");
+    int runs = readHeaderField(head, "runs");
+    if (width != options.width || height != options.height ||
+        runs != options.runs)
+      throw std::runtime_error(
+          "Baseline " + path + " was run at " + std::to_string(width) + "x" +
+          std::to_string(height) + " with " + std::to_string(runs) +
+          " runs, not " + std::to_string(options.width) + "x" +
+          std::to_string(options.height) + " with " +
+          std::to_string(options.runs) + " runs");
+
+    std::map<std::string, double> medians;
+    std::regex scene(
+        "\\{\"scene\": \"([^\"]*)\"[^{}]*\"median_ms\": "
+        "([-+0-9.eE]+)");
+    for (auto it = std::sregex_iterator(text.begin(), text.end(), scene);
+         it != std::sregex_iterator(); ++it)
+      medians[(*it)[1]] = std::stod((*it)[2]);
+    return medians;
+  }
+
+}  // namespace
+
+/**
+ * @brief Renders every scene of a directory headless and reports timings.
+ *
+ * Usage: render_bench [--scenes dir] [--width w] [--height h] [--runs n]
+ *                     [--output file.json] [--baseline file.json]
+ *                     [--max-regression percent]
+ *                     [--heatmap time|tests|bounces] [--trace file.json]
+ *                     [--denoise on|off] [--bvh fast|sah]
+ *                     [--packets on|off] [--wavefront on|off]
+ * With --denoise on, the timed frames include the denoiser. --bvh picks the
+ * preset of the mesh BVHs built while loading, which shows in the load time.
+ * --packets off traces every primary and secondary ray on its own, instead
+ * of in packets and sorted bounce queues. --wavefront on renders through the
+ * wavefront pipeline and adds the mean time of each of its stages to the
+ * results, as <stage>_ms; comparing it against a --wavefront off baseline
+ * gives the difference scene by scene. With --heatmap, the cost of every
+ * pixel of each scene is also written to screenshots/<scene>_<mode>.ppm.
+ * Must be run from the repository root, where ./plugins is. Scenes that
+ * cannot be rendered are reported and skipped, unless the baseline has a
+ * time for them. The baseline must have been run with the same width,
+ * height and runs. Returns 84 on invalid arguments, on a baseline run with
+ * other settings or if a scene of the baseline cannot be rendered anymore,
+ * 1 if a scene is slower than the baseline by more than the allowed
+ * percentage, 0 otherwise.
+ */
+int main(int argc, char **argv) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    std::cerr << "USAGE:\t./render_bench [--scenes dir] [--width w] "
+                 "[--height h] [--runs n] [--output file.json] "
+                 "[--baseline file.json] [--max-regression percent] "
+                 "[--heatmap time|tests|bounces] [--trace file.json] "
+                 "[--denoise on|off] [--bvh fast|sah] [--packets on|off] "
+                 "[--wavefront on|off]"
+              << std::endl;
+    return 84;
+  }
+
+  std::vector<std::string> scenes;
+  std::vector<std::string> plugins;
+  std::map<std::string, double> baseline;
+  try {
+    for (const auto &entry :
+         std::filesystem::directory_iterator(options.scenes)) {
+      if (entry.is_regular_file() && entry.path().extension() == ".cfg")
+        scenes.push_back(entry.path().string());
+    }
+    std::sort(scenes.begin(), scenes.end());
+    plugins = findPlugins();
+    if (!options.baseline.empty())
+      baseline = readBaseline(options.baseline, options);
+  } catch (const std::exception &e) {
+    std::cerr << "[ERROR] - " << e.what() << std::endl;
+    return 84;
+  }
+
+  std::vector<Result> results;
+  bool failed = false;
+  if (!options.trace.empty())
+    Raytracer::Trace::start(options.trace);
+  for (const auto &scene : scenes) {
+    {
+      Raytracer::Trace::Scope scope("benchmark scene", "bench", scene);
+      results.push_back(benchmarkScene(scene, plugins, options));
+    }
+    const Result &r = results.back();
+    if (r.error.empty()) {
+      std::cerr << scene << ": " << r.median() << " ms" << std::endl;
+    } else if (baseline.count(scene) > 0) {
+      std::cerr << "[ERROR] - " << scene << ": " << r.error << std::endl;
+      failed = true;
+    } else {
+      std::cerr << "[WARNING] - " << scene << ": " << r.error << std::endl;
+    }
+  }
+
+  try {
+    Raytracer::Trace::stop();
+  } catch (const std::exception &e) {
+    std::cerr << "[ERROR] - " << e.what() << std::endl;
+    return 84;
+  }
+
+  if (options.output.empty()) {
+    writeJson(std::cout, results, options);
+  } else {
+    std::ofstream out(options.output);
+    writeJson(out, results, options);
+    if (!out) {
+      std::cerr << "[ERROR] - Cannot write " << options.output << std::endl;
+      return 84;
+    }
+  }
+  if (failed)
+    return 84;
+
+  bool regressed = false;
+  for (const auto &r : results) {
+    auto it = baseline.find(r.scene);
+    if (!r.error.empty() || it == baseline.end() || it->second <= 0)
+      continue;
+    double change = (r.median() / it->second - 1.0) * 100.0;
+    if (change > options.maxRegression) {
+      std::cerr << "[REGRESSION] - " << r.scene << ": " << it->second
+                << " ms -> " << r.median() << " ms (+" << change << "%)"
+                << std::endl;
+      regressed = true;
+    }
+  }
+  return regressed ? 1 : 0;
+}
@@ -0,0 +1,247 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "Cone.hpp"
+#include "ConeInf.hpp"
+#include "Cylinder.hpp"
+#include "CylinderInf.hpp"
+#include "Factory.hpp"
+#include "Object.hpp"
+#include "Plane.hpp"
+#include "Ray.hpp"
+#include "Sphere.hpp"
+#include "Triangle.hpp"
+
+namespace {
+
+  constexpr std::size_t rayCount = 1024;  ///< Rays traced per iteration.
+  constexpr double rayDistance = 10.0;    ///< Distance of the ray origins.
+
+  /**
+   * @brief Shape under test and how to aim rays at it.
+   */
+  struct Case {
+    std::string name;                  ///< Name of the benchmark.
+    std::shared_ptr<Raytracer::IShape> shape; ///< The shape.
+    Math::Point3D core;                ///< A point inside the shape.
+    double radius;                     ///< Radius of a sphere around core
+                                       ///< holding the shape, if bounded.
+    bool infinite;                     ///< Whether grazing rays still hit it.
+  };
+
+  /**
+   * @brief Generates rays from a sphere of origins around a shape.
+   *
+   * Hit-heavy rays aim at the core of the shape, slightly jittered.
+   * Miss-heavy rays of bounded shapes pass beside the core, far enough to
+   * clear the shape, so that the kernel runs up to its rejection test;
+   * infinite shapes would still be hit that way, so they get rays pointing
+   * away from the core instead.
+   * @param c The case.
+   * @param hit Whether to generate hit-heavy rays.
+   * @return std::vector<Raytracer::Ray> The rays, always the same for a case.
+   */
+  std::vector<Raytracer::Ray> makeRays(const Case &c, bool hit) {
+    std::mt19937 rng(42);
+    std::normal_distribution<double> normal;
+    std::uniform_real_distribution<double> jitter(-0.25, 0.25);
+    std::vector<Raytracer::Ray> rays;
+
+    rays.reserve(rayCount);
+    while (rays.size() < rayCount) {
+      Math::Vector3D u(normal(rng), normal(rng), normal(rng));
+      if (u.lengthSquared() < 1e-12)
+        continue;
+      u.normalize();
+      Math::Point3D origin = c.core + u * rayDistance;
+      Math::Vector3D direction;
+      if (hit) {
+        Math::Point3D target =
+            c.core + Math::Vector3D(jitter(rng), jitter(rng), jitter(rng));
+        direction = target - origin;
+      } else if (c.infinite) {
+        direction = u + Math::Vector3D(jitter(rng), jitter(rng), jitter(rng));
+      } else {
+        Math::Vector3D side = Math::cross(
+            u, Math::Vector3D(normal(rng), normal(rng), normal(rng)));
+        if (side.lengthSquared() < 1e-12)
+          continue;
+        direction = (c.core + side.normalized() * (2.0 * c.radius)) - origin;
+      }
+      rays.emplace_back(origin, direction.normalized());
+    }
+    return rays;
+  }
+
+  /**
+   * @brief Traces every ray against the shape once per iteration.
+   *
+   * Reports rays per second and the fraction of rays that hit.
+   * @param state The benchmark state.
+   * @param shape The shape.
+   * @param rays The rays.
+   */
+  void traceRays(benchmark::State &state, const Raytracer::IShape &shape,
+                 const std::vector<Raytracer::Ray> &rays) {
+    std::size_t hits = 0;
+
+    for (auto _ : state) {
+      hits = 0;
+      for (const auto &ray : rays) {
+        auto hit = shape.hits(ray);
+        benchmark::DoNotOptimize(hit);
+        if (std::get<0>(hit) > 0.0)
+          hits++;
+      }
+    }
+    state.SetItemsProcessed(state.iterations() *
+                            static_cast<std::int64_t>(rays.size()));
+    state.counters["hit_rate"] =
+        static_cast<double>(hits) / static_cast<double>(rays.size());
+  }
+
+  /**
+   * @brief Builds a wavy grid mesh in [-4, 4]^2.
+   *
+   * The mesh is large enough for its triangles to stay above the fixed
+   * epsilon of the triangle test.
+   * @param side The number of quads along each side.
+   * @return std::shared_ptr<Raytracer::Object> The mesh, with its BVH.
+   */
+  std::shared_ptr<Raytracer::Object> makeGrid(int side) {
+    auto object = std::make_shared<Raytracer::Object>();
+    std::vector<Math::Point3D> vertices;
+    std::vector<Raytracer::Object::Face> faces;
+
+    for (int y = 0; y <= side; y++) {
+      for (int x = 0; x <= side; x++) {
+        double u = 8.0 * x / side - 4.0;
+        double v = 8.0 * y / side - 4.0;
+        vertices.emplace_back(u, v, 0.2 * std::sin(u) * std::cos(v));
+      }
+    }
+    for (int y = 0; y < side; y++) {
+      for (int x = 0; x < side; x++) {
+        int a = y * (side + 1) + x;
+        int b = a + side + 1;
+        faces.push_back({{a, a + 1, b + 1}, {-1, -1, -1}});
+        faces.push_back({{a, b + 1, b}, {-1, -1, -1}});
+      }
+    }
+    object->setVertices(std::move(vertices));
+    object->setFaces(std::move(faces));
+    object->buildAccel();
+    return object;
+  }
+
+  /**
+   * @brief Creates the shapes through the plugins, as the parser does.
+   * @param factory The factory, with the plugins loaded.
+   * @return std::vector<Case> One case per shape kernel.
+   */
+  std::vector<Case> makeCases(Raytracer::Factory &factory) {
+    std::vector<Case> cases;
+
+    auto sphere = factory.create<Raytracer::Sphere>("sphere");
+    sphere->setCenter({0, 0, 0});
+    sphere->setRadius(1.0);
+    cases.push_back({"Sphere", sphere, {0, 0, 0}, 1.0, false});
+
+    auto plane = factory.create<Raytracer::Plane>("plane");
+    plane->setCenter({0, 0, 0});
+    plane->setNormal({0, 1, 0});
+    cases.push_back({"Plane", plane, {0, 0, 0}, 0.0, true});
+
+    auto cylinder = factory.create<Raytracer::Cylinder>("cylinder");
+    cylinder->setCenter({0, -1, 0});
+    cylinder->setRadius(1.0);
+    cylinder->setHeight(2.0);
+    cases.push_back({"Cylinder", cylinder, {0, 0, 0}, 1.5, false});
+
+    auto cylinderInf = factory.create<Raytracer::CylinderInf>("cylinderInf");
+    cylinderInf->setCenter({0, 0, 0});
+    cylinderInf->setRadius(1.0);
+    cases.push_back({"CylinderInf", cylinderInf, {0, 0, 0}, 0.0, true});
+
+    auto cone = factory.create<Raytracer::Cone>("cone");
+    cone->setCenter({0, -1, 0});
+    cone->setNormal({0, 1, 0});
+    cone->setRadius(1.0);
+    cone->setHeight(2.0);
+    cases.push_back({"Cone", cone, {0, -0.5, 0}, 1.5, false});
+
+    auto coneInf = factory.create<Raytracer::ConeInf>("coneInf");
+    coneInf->setCenter({0, 0, 0});
+    coneInf->setNormal({0, 1, 0});
+    coneInf->setAngle(0.35);
+    cases.push_back({"ConeInf", coneInf, {0, 1, 0}, 0.0, true});
+
+    auto triangle = factory.create<Raytracer::Triangle>("triangle");
+    triangle->setP1({-1, -1, 0});
+    triangle->setP2({1, -1, 0});
+    triangle->setP3({0, 1, 0});
+    cases.push_back({"Triangle", triangle, {0, -1.0 / 3.0, 0}, 1.5, false});
+
+    cases.push_back({"Object", makeGrid(256), {0, 0, 0}, 6.0, false});
+    for (const auto &c : cases)
+      Raytracer::shapeCommit(Raytracer::Factory::getShapeAbi(*c.shape),
+                             *c.shape);
+    return cases;
+  }
+
+}  // namespace
+
+/**
+ * @brief Benchmarks the intersection kernel of every shape with hit-heavy and
+ * miss-heavy rays.
+ *
+ * Shapes are created through the plugins of ./plugins, so the binary must be
+ * run from the repository root, e.g.
+ *   ./benchmarks --benchmark_filter=Sphere
+ * The Object case is a 131k-triangle mesh traversed through its BVH.
+ */
+int main(int argc, char **argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+
+  std::vector<std::string> plugins;
+  if (std::filesystem::is_directory("./plugins")) {
+    for (const auto &entry :
+         std::filesystem::directory_iterator("./plugins")) {
+      if (entry.is_regular_file() && entry.path().extension() == ".so")
+        plugins.push_back(entry.path().string());
+    }
+  }
+  Raytracer::Factory factory;
+  std::vector<Case> cases;
+  try {
+    factory.initFactories(plugins);
+    cases = makeCases(factory);
+  } catch (const std::exception &e) {
+    std::cerr << "[ERROR] - Cannot create the shapes, run from the "
+                 "repository root: " << e.what() << std::endl;
+    return 1;
+  }
+
+  for (const auto &c : cases) {
+    for (bool hit : {true, false}) {
+      auto rays = std::make_shared<std::vector<Raytracer::Ray>>(
+          makeRays(c, hit));
+      benchmark::RegisterBenchmark(
+          (c.name + "::hits/" + (hit ? "hit" : "miss")).c_str(),
+          [shape = c.shape, rays](benchmark::State &state) {
+            traceRays(state, *shape, *rays);
+          });
+    }
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -14,6 +14,21 @@ Raytracer::Ray Raytracer::Camera::ray(double u, double v) {
   return Ray(origin, direction);
 }
 
+/**
+ * @brief Generates the primary ray through a point of the image, from the
+ * location of the first pixel and the steps between pixels of the last
+ * updateView().
+ * @param x The column of the point, pixel i being at x = i.
+ * @param y The row of the point, pixel j being at y = j.
+ * @return Raytracer::Ray The ray, with a unit direction.
+ */
+Raytracer::Ray Raytracer::Camera::pixelRay(double x, double y) const {
+  Math::Point3D pixelCenter = _pixel0Location +
+                              _pixelDeltaU * static_cast<float>(x) +
+                              _pixelDeltaV * static_cast<float>(y);
+  return Ray(origin, (pixelCenter - origin).normalize());
+}
+
 /**
  * @brief Updates the camera's view parameters based on its current orientation and position.
  *
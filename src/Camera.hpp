@@ -194,6 +194,15 @@ namespace Raytracer {
        */
       Ray ray(double u, double v);
 
+      /**
+       * @brief Generates the primary ray through a point of the image.
+       * @param x The column of the point, in pixels from the centre of the
+       * first pixel.
+       * @param y The row of the point, in pixels.
+       * @return Ray The ray, with a unit direction.
+       */
+      Ray pixelRay(double x, double y) const;
+
       /**
        * @brief Rotates the camera around the Y-axis (yaw).
        * @param a The angle to rotate by.
@@ -0,0 +1,132 @@
+#include "Denoiser.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "TaskPool.hpp"
+#include "Trace.hpp"
+
+namespace {
+
+  constexpr double kernel[5] = {1.0 / 16, 1.0 / 4, 3.0 / 8, 1.0 / 4,
+                                1.0 / 16}; ///< B3-spline taps.
+  constexpr int bandHeight = 16; ///< Rows filtered by one task.
+  constexpr double minAlbedo = 1e-3; ///< Below this, albedo is not divided out.
+
+  /**
+   * @brief Runs `fn(y)` for every row of the image, in bands on the pool.
+   * @param height The number of rows.
+   * @param fn Callable as fn(int).
+   */
+  template <typename Fn>
+  void forEachRow(int height, Fn &&fn) {
+    int bands = (height + bandHeight - 1) / bandHeight;
+    Raytracer::TaskPool::global().parallelFor(bands, [&](std::size_t band) {
+      int y0 = static_cast<int>(band) * bandHeight;
+      int y1 = std::min(y0 + bandHeight, height);
+      for (int y = y0; y < y1; y++)
+        fn(y);
+    });
+  }
+
+  /**
+   * @brief Divides one component by the albedo, unless the albedo is black.
+   */
+  float demodulate(float value, float albedo) {
+    return albedo > minAlbedo ? value / albedo : value;
+  }
+
+  /**
+   * @brief Multiplies one component by the albedo, unless it was not divided.
+   */
+  float remodulate(float value, float albedo) {
+    return albedo > minAlbedo ? value * albedo : value;
+  }
+
+}  // namespace
+
+/**
+ * @brief Filters an image in place.
+ *
+ * Pixels that missed every surface (depth 0) are only mixed with each other,
+ * never with surfaces. Passes ping-pong between two buffers and every pass
+ * is split in bands of rows run in parallel.
+ * @param colors The image, width x height colours row by row.
+ * @param guides The normals, depths and albedo of every pixel.
+ * @param width The width of the image.
+ * @param height The height of the image.
+ */
+void Raytracer::Denoiser::filter(std::vector<Math::Vector3D> &colors,
+                                 const Guides &guides, int width,
+                                 int height) const {
+  Trace::Scope scope("denoise", "render");
+  std::size_t size = static_cast<std::size_t>(width) * height;
+  std::vector<Math::Vector3D> light(size);
+  std::vector<Math::Vector3D> next(size);
+
+  forEachRow(height, [&](int y) {
+    for (std::size_t k = y * width; k < (y + 1) * std::size_t(width); k++) {
+      const Math::Vector3D &a = guides.albedo[k];
+      light[k] = guides.depths[k] > 0
+                     ? Math::Vector3D(demodulate(colors[k].x, a.x),
+                                      demodulate(colors[k].y, a.y),
+                                      demodulate(colors[k].z, a.z))
+                     : colors[k];
+    }
+  });
+
+  for (int pass = 0; pass < _passes; pass++) {
+    int step = 1 << pass;
+    double sigma = _colorSigma / step;
+    double invSigma2 = 1.0 / (sigma * sigma);
+
+    forEachRow(height, [&](int y) {
+      for (int x = 0; x < width; x++) {
+        std::size_t p = static_cast<std::size_t>(y) * width + x;
+        const Math::Vector3D &center = light[p];
+        float depth = guides.depths[p];
+        Math::Vector3D sum(0, 0, 0);
+        double total = 0.0;
+
+        for (int dy = -2; dy <= 2; dy++) {
+          int qy = y + dy * step;
+          if (qy < 0 || qy >= height)
+            continue;
+          for (int dx = -2; dx <= 2; dx++) {
+            int qx = x + dx * step;
+            if (qx < 0 || qx >= width)
+              continue;
+            std::size_t q = static_cast<std::size_t>(qy) * width + qx;
+            float tapDepth = guides.depths[q];
+            if ((depth > 0) != (tapDepth > 0))
+              continue;
+            double weight = kernel[dx + 2] * kernel[dy + 2];
+            if (depth > 0) {
+              double facing = guides.normals[p].dot(guides.normals[q]);
+              weight *= std::pow(std::max(0.0, facing), _normalPower);
+              double distance = std::max(std::abs(dx), std::abs(dy)) * step;
+              weight *= std::exp(-std::abs(depth - tapDepth) /
+                                 (_depthSigma * depth * distance + 1e-6));
+            }
+            Math::Vector3D diff = light[q] - center;
+            weight *= std::exp(-diff.dot(diff) * invSigma2);
+            sum += light[q] * weight;
+            total += weight;
+          }
+        }
+        next[p] = total > 0 ? sum * (1.0 / total) : center;
+      }
+    });
+    std::swap(light, next);
+  }
+
+  forEachRow(height, [&](int y) {
+    for (std::size_t k = y * width; k < (y + 1) * std::size_t(width); k++) {
+      const Math::Vector3D &a = guides.albedo[k];
+      colors[k] = guides.depths[k] > 0
+                      ? Math::Vector3D(remodulate(light[k].x, a.x),
+                                       remodulate(light[k].y, a.y),
+                                       remodulate(light[k].z, a.z))
+                      : light[k];
+    }
+  });
+}
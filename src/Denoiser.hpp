@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include "Vector3D.hpp"
+
+namespace Raytracer {
+
+  /**
+   * @brief Edge-avoiding à-trous wavelet filter for noisy low-sample frames.
+   *
+   * Each pass blurs the image with a 5x5 B3-spline kernel whose taps are
+   * spread 1, 2, 4... pixels apart, so a few passes cover a wide footprint
+   * for the cost of 25 taps each. Every tap is weighted down when its
+   * normal, depth or colour differs from the centre pixel, which keeps the
+   * edges of the geometry and of the lighting sharp. The albedo is divided
+   * out before filtering and multiplied back after, so textures and flat
+   * colours are not blurred, only the lighting on them.
+   */
+  class Denoiser {
+    public:
+      /**
+       * @brief Guide buffers of a frame, one value per pixel.
+       */
+      struct Guides {
+        const std::vector<Math::Vector3D> &normals; ///< Surface normals.
+        const std::vector<float> &depths;           ///< Distances, 0 for a miss.
+        const std::vector<Math::Vector3D> &albedo;  ///< Surface colours.
+      };
+
+      /**
+       * @brief Creates a denoiser.
+       * @param passes The number of passes, the footprint being 4 * 2^passes
+       * pixels wide.
+       * @param colorSigma How far apart two colours may be and still be
+       * mixed; halved at each pass.
+       * @param normalPower Sharpness of the normal weight.
+       * @param depthSigma Relative depth difference tolerated per pixel of
+       * distance between the taps.
+       */
+      explicit Denoiser(int passes = 3, double colorSigma = 0.5,
+                        double normalPower = 64.0, double depthSigma = 0.02)
+          : _passes(passes),
+            _colorSigma(colorSigma),
+            _normalPower(normalPower),
+            _depthSigma(depthSigma) {
+      }
+
+      /**
+       * @brief Filters an image in place, in parallel on the task pool.
+       * @param colors The image, width x height colours row by row.
+       * @param guides The guide buffers, of the same size.
+       * @param width The width of the image.
+       * @param height The height of the image.
+       */
+      void filter(std::vector<Math::Vector3D> &colors, const Guides &guides,
+                  int width, int height) const;
+
+    private:
+      int _passes;         ///< Number of passes.
+      double _colorSigma;  ///< Colour tolerance of the first pass.
+      double _normalPower; ///< Exponent of the normal weight.
+      double _depthSigma;  ///< Relative depth tolerance per pixel.
+  };
+
+}  // namespace Raytracer
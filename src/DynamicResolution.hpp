@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+namespace Raytracer {
+
+  /**
+   * @brief Picks the render scale of interactive frames from the time the
+   * previous ones took, so that they fit a frame-time budget.
+   *
+   * The cost of a frame grows with its number of pixels, i.e. with the square
+   * of the scale, so the scale that would have hit the budget is the current
+   * one times sqrt(budget / time). The scale moves only part of the way there
+   * each frame, which absorbs the noise of single frames without lagging far
+   * behind real changes of the scene or of the view.
+   */
+  class DynamicResolution {
+    public:
+      /**
+       * @brief Creates a controller.
+       * @param budgetMs The target frame time in milliseconds.
+       * @param minScale The lowest scale, so the image stays recognizable.
+       * @param maxScale The highest scale, 1 for full resolution.
+       */
+      explicit DynamicResolution(double budgetMs = 16.0,
+                                 double minScale = 0.1,
+                                 double maxScale = 1.0)
+          : _budgetMs(budgetMs),
+            _minScale(minScale),
+            _maxScale(maxScale),
+            _scale(std::clamp(0.5, minScale, maxScale)) {
+      }
+
+      /**
+       * @brief Adjusts the scale after a frame rendered at getScale().
+       * @param frameMs The time the frame took in milliseconds.
+       */
+      void update(double frameMs) {
+        if (frameMs <= 0)
+          return;
+        double target = _scale * std::sqrt(_budgetMs / frameMs);
+        _scale = std::clamp(_scale + (target - _scale) * damping, _minScale,
+                            _maxScale);
+      }
+
+      /**
+       * @brief Gets the scale to render the next interactive frame at.
+       * @return double The fraction of the full resolution, on each axis.
+       */
+      double getScale() const {
+        return _scale;
+      }
+
+      /**
+       * @brief Sets the target frame time.
+       * @param budgetMs The target frame time in milliseconds.
+       */
+      void setBudget(double budgetMs) {
+        _budgetMs = budgetMs;
+      }
+
+      /**
+       * @brief Gets the target frame time.
+       * @return double The target frame time in milliseconds.
+       */
+      double getBudget() const {
+        return _budgetMs;
+      }
+
+    private:
+      static constexpr double damping = 0.5; ///< Part of the step taken per frame.
+
+      double _budgetMs; ///< Target frame time.
+      double _minScale; ///< Lowest scale.
+      double _maxScale; ///< Highest scale.
+      double _scale;    ///< Scale of the next frame.
+  };
+
+}  // namespace Raytracer
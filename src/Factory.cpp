@@ -1,26 +1,144 @@
 #include "Factory.hpp"
 #include <dlfcn.h>
+#include <array>
+#include <atomic>
 #include <filesystem>
+#include <iostream>
+#include <mutex>
 #include <string>
+#include <typeinfo>
+#include "Trace.hpp"
+
+namespace {
+
+  /**
+   * @brief Extended entry points of the loaded plugins of one kind, by
+   * dynamic type of the objects they create. Shared by every Factory, since
+   * the scenes of a file are parsed in parallel, each with its own.
+   *
+   * Entries are only ever appended, under the mutex, and published by the
+   * size, so the renderer looks them up without locking.
+   */
+  template <typename Abi>
+  class AbiRegistry {
+    public:
+      /**
+       * @brief Records the table of the objects of a dynamic type, unless
+       * it is known already or the registry is full.
+       */
+      void add(const std::type_info &type, const Abi *abi) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::size_t size = _size.load(std::memory_order_relaxed);
+        if (find(type, size) || size == _entries.size())
+          return;
+        _entries[size] = {&type, abi};
+        _size.store(size + 1, std::memory_order_release);
+      }
+
+      /**
+       * @brief Gets the table of the objects of a dynamic type.
+       * @return const Abi* The table, nullptr if none was recorded.
+       */
+      const Abi *find(const std::type_info &type) const {
+        return find(type, _size.load(std::memory_order_acquire));
+      }
+
+    private:
+      struct Entry {
+        const std::type_info *type;
+        const Abi *abi;
+      };
+
+      const Abi *find(const std::type_info &type, std::size_t size) const {
+        for (std::size_t i = 0; i < size; i++) {
+          if (*_entries[i].type == type)
+            return _entries[i].abi;
+        }
+        return nullptr;
+      }
+
+      std::mutex _mutex;
+      std::array<Entry, 64> _entries{};   ///< One per plugin, at most.
+      std::atomic<std::size_t> _size{0};  ///< Entries published.
+  };
+
+  AbiRegistry<Raytracer::ShapeAbi> &shapeAbis() {
+    static AbiRegistry<Raytracer::ShapeAbi> abis;
+    return abis;
+  }
+
+  AbiRegistry<Raytracer::LightAbi> &lightAbis() {
+    static AbiRegistry<Raytracer::LightAbi> abis;
+    return abis;
+  }
+
+  AbiRegistry<Raytracer::MaterialAbi> &materialAbis() {
+    static AbiRegistry<Raytracer::MaterialAbi> abis;
+    return abis;
+  }
+
+  /**
+   * @brief Records the extended entry points of a plugin, if it exports
+   * them. An object is created once to learn the dynamic type of the
+   * objects of the plugin.
+   *
+   * A plugin without the export (version 0) is left to the fallbacks of the
+   * host. So is a plugin exporting a table of version 0, which is not a
+   * valid table, with a warning.
+   * @param handle The plugin.
+   * @param plugin The path of the plugin, for the warning.
+   * @param symbol The export giving the table.
+   * @param create The factory function of the plugin.
+   * @param registry Where to record the table.
+   */
+  template <typename Abi, typename T>
+  void loadAbi(void *handle, const std::string &plugin, const char *symbol,
+               T *(*create)(), AbiRegistry<Abi> &registry) {
+    using AbiFunc = const Abi *(*)();
+    AbiFunc getAbi = (AbiFunc)dlsym(handle, symbol);
+    const Abi *abi = getAbi ? getAbi() : nullptr;
+    if (!abi)
+      return;
+    if (abi->version == 0) {
+      std::cerr << "[WARNING] - " << plugin << ": " << symbol
+                << "() gives a table of version 0, using the default entry "
+                   "points instead."
+                << std::endl;
+      return;
+    }
+    std::unique_ptr<T> sample(create());
+    if (!sample)
+      return;
+    registry.add(typeid(*sample), abi);
+  }
+
+}  // namespace
 
 /**
  * @brief Initializes the factories by loading and registering creators from plugins.
  *
  * This method iterates over a list of plugin file paths (shared libraries, e.g., .so files).
  * For each plugin, it attempts to load the library and find specific factory functions:
- *  - "addShape": For creating IShape objects.
- *  - "addLight": For creating ILight objects.
- *  - "addMaterial": For creating IMaterials objects.
+ *  - "addShape": For creating IShape objects, along with "shapeAbi" for
+ *    the optional entry points of ShapeAbi.hpp.
+ *  - "addLight": For creating ILight objects, along with "lightAbi" for
+ *    those of LightAbi.hpp.
+ *  - "addMaterial": For creating IMaterials objects, along with
+ *    "materialAbi" for those of MaterialAbi.hpp.
  * If a factory function is found, it's registered with the corresponding factory map
- * using the plugin's filename (without extension) as the key.
+ * using the plugin's filename (without extension) as the key. Plugins without
+ * the optional tables, such as those built against earlier versions, are
+ * registered all the same and go through the fallbacks of the host.
  *
  * @param plugins A vector of strings, where each string is the path to a plugin file.
  */
 void Raytracer::Factory::initFactories(
     const std::vector<std::string> &plugins) {
+  Trace::Scope scope("register plugins", "plugins");
   for (const auto &plugin : plugins) {
     std::string pluginName = plugin.substr(plugin.find_last_of('/') + 1);
     pluginName = pluginName.substr(0, pluginName.find_last_of('.'));
+    Trace::Scope load("dlopen", "plugins", pluginName);
     void *handle = dlopen(plugin.c_str(), RTLD_LAZY);
     if (!handle)
       continue;
@@ -28,20 +146,57 @@ void Raytracer::Factory::initFactories(
     AddShapeFunc addShape = (AddShapeFunc)dlsym(handle, "addShape");
     if (addShape) {
       registerShape<Raytracer::IShape>(pluginName, addShape);
+      loadAbi(handle, plugin, "shapeAbi", addShape, shapeAbis());
       continue;
     }
     using AddLightFunc = Raytracer::ILight *(*)();
     AddLightFunc addLight = (AddLightFunc)dlsym(handle, "addLight");
     if (addLight) {
       registerLight<Raytracer::ILight>(pluginName, addLight);
+      loadAbi(handle, plugin, "lightAbi", addLight, lightAbis());
       continue;
     }
     using AddMaterialFunc = Raytracer::IMaterials *(*)();
     AddMaterialFunc addMaterial = (AddMaterialFunc)dlsym(handle, "addMaterial");
     if (addMaterial) {
       registerMaterial<Raytracer::IMaterials>(pluginName, addMaterial);
+      loadAbi(handle, plugin, "materialAbi", addMaterial, materialAbis());
       continue;
     }
     dlclose(handle);
   }
 }
+
+/**
+ * @brief Gets the extended entry points of the plugin a shape was created by.
+ * @param shape The shape.
+ * @return const Raytracer::ShapeAbi* The entry points, nullptr if the plugin
+ * exports none.
+ */
+const Raytracer::ShapeAbi *Raytracer::Factory::getShapeAbi(
+    const IShape &shape) {
+  return shapeAbis().find(typeid(shape));
+}
+
+/**
+ * @brief Gets the extended entry points of the plugin a light was created by.
+ * @param light The light.
+ * @return const Raytracer::LightAbi* The entry points, nullptr if the plugin
+ * exports none.
+ */
+const Raytracer::LightAbi *Raytracer::Factory::getLightAbi(
+    const ILight &light) {
+  return lightAbis().find(typeid(light));
+}
+
+/**
+ * @brief Gets the extended entry points of the plugin a material was created
+ * by.
+ * @param material The material.
+ * @return const Raytracer::MaterialAbi* The entry points, nullptr if the
+ * plugin exports none.
+ */
+const Raytracer::MaterialAbi *Raytracer::Factory::getMaterialAbi(
+    const IMaterials &material) {
+  return materialAbis().find(typeid(material));
+}
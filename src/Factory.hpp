@@ -8,6 +8,9 @@
 #include <vector>
 #include "ILight.hpp"
 #include "IShape.hpp"
+#include "LightAbi.hpp"
+#include "MaterialAbi.hpp"
+#include "ShapeAbi.hpp"
 
 namespace Raytracer {
   /**
@@ -130,6 +133,34 @@ namespace Raytracer {
        */
       void initFactories(const std::vector<std::string>& plugins);
 
+      /**
+       * @brief Gets the extended entry points of the plugin a shape was
+       * created by, found when the plugin was loaded.
+       * @param shape The shape.
+       * @return const ShapeAbi* The entry points, nullptr for compiled-in
+       * shapes and for plugins that only export addShape().
+       */
+      static const ShapeAbi *getShapeAbi(const IShape& shape);
+
+      /**
+       * @brief Gets the extended entry points of the plugin a light was
+       * created by, found when the plugin was loaded.
+       * @param light The light.
+       * @return const LightAbi* The entry points, nullptr for plugins that
+       * only export addLight().
+       */
+      static const LightAbi *getLightAbi(const ILight& light);
+
+      /**
+       * @brief Gets the extended entry points of the plugin a material was
+       * created by, found when the plugin was loaded. Looked up without a
+       * lock, for every surface shaded.
+       * @param material The material.
+       * @return const MaterialAbi* The entry points, nullptr for plugins that
+       * only export addMaterial().
+       */
+      static const MaterialAbi *getMaterialAbi(const IMaterials& material);
+
     private:
       std::map<std::string, std::function<std::shared_ptr<IShape>()>>
           _shapeFactories;
@@ -0,0 +1,239 @@
+#include "FileWatcher.hpp"
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace {
+
+  /**
+   * @brief Interval at which files are stat'ed where inotify is unavailable.
+   */
+  constexpr std::chrono::milliseconds pollInterval(250);
+
+#ifdef __linux__
+  /**
+   * @brief Directory events that may mean a file was changed, including the
+   * rename dance editors use to save atomically.
+   */
+  constexpr std::uint32_t watchedEvents = IN_CLOSE_WRITE | IN_MODIFY |
+                                          IN_ATTRIB | IN_CREATE | IN_DELETE |
+                                          IN_MOVED_FROM | IN_MOVED_TO;
+#endif
+
+  /**
+   * @brief Makes a path absolute and normalized, so that it can be matched
+   * against the directory and name reported by inotify.
+   * @param path The path.
+   * @return std::string The absolute path, or the path itself on error.
+   */
+  std::string absolutePath(const std::string &path) {
+    std::error_code ec;
+    std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+    if (ec)
+      return path;
+    return absolute.lexically_normal().string();
+  }
+
+}  // namespace
+
+/**
+ * @brief Starts the watcher thread.
+ *
+ * @param settle How long the files must stay quiet before a burst of events
+ * is reported.
+ * @throws std::runtime_error if inotify or the wake-up pipe cannot be created.
+ */
+Raytracer::FileWatcher::FileWatcher(std::chrono::milliseconds settle)
+    : _settle(settle) {
+#ifdef __linux__
+  _inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (_inotify < 0)
+    throw std::runtime_error("Cannot initialize inotify");
+#endif
+  if (pipe(_wake) < 0) {
+    if (_inotify >= 0)
+      close(_inotify);
+    throw std::runtime_error("Cannot create the file watcher pipe");
+  }
+  _thread = std::thread([this]() { run(); });
+}
+
+/**
+ * @brief Wakes the watcher thread up, joins it and releases the descriptors.
+ */
+Raytracer::FileWatcher::~FileWatcher() {
+  char byte = 0;
+
+  _stopping = true;
+  if (write(_wake[1], &byte, 1) < 0) {
+    // The thread still notices _stopping at its next wake-up.
+  }
+  _thread.join();
+  close(_wake[0]);
+  close(_wake[1]);
+  if (_inotify >= 0)
+    close(_inotify);
+}
+
+/**
+ * @brief Replaces the set of watched files.
+ *
+ * Their current state becomes the reference. With inotify, the directories
+ * that hold no watched file anymore stop being watched and the new ones are
+ * added; a directory that cannot be watched (e.g. it does not exist yet) is
+ * skipped.
+ * @param files The files to watch.
+ */
+void Raytracer::FileWatcher::watch(const std::vector<std::string> &files) {
+  std::unordered_map<std::string, Stamp> stamps;
+  for (const auto &file : files) {
+    std::string path = absolutePath(file);
+    if (stamps.find(path) == stamps.end())
+      stamps.emplace(path, stamp(path));
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _files = std::move(stamps);
+#ifdef __linux__
+  std::unordered_map<std::string, int> directories;
+  for (const auto &entry : _files) {
+    std::string directory =
+        std::filesystem::path(entry.first).parent_path().string();
+    if (directories.find(directory) != directories.end())
+      continue;
+    auto it = _directories.find(directory);
+    if (it != _directories.end()) {
+      directories.emplace(directory, it->second);
+      _directories.erase(it);
+      continue;
+    }
+    int wd = inotify_add_watch(_inotify, directory.c_str(), watchedEvents);
+    if (wd >= 0)
+      directories.emplace(directory, wd);
+  }
+  for (const auto &entry : _directories)
+    inotify_rm_watch(_inotify, entry.second);
+  _directories = std::move(directories);
+#endif
+}
+
+/**
+ * @brief Reads the current state of a file.
+ *
+ * @param path The path of the file.
+ * @return Raytracer::FileWatcher::Stamp Its modification time and size, or
+ * an empty stamp if it cannot be stat'ed.
+ */
+Raytracer::FileWatcher::Stamp Raytracer::FileWatcher::stamp(
+    const std::string &path) {
+  Stamp result;
+  std::error_code ec;
+
+  result.time = std::filesystem::last_write_time(path, ec);
+  if (ec)
+    return Stamp();
+  result.size = std::filesystem::file_size(path, ec);
+  if (ec)
+    return Stamp();
+  result.exists = true;
+  return result;
+}
+
+/**
+ * @brief Updates the stamps of the watched files.
+ *
+ * @return true if any of them changed.
+ */
+bool Raytracer::FileWatcher::refresh() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  bool changed = false;
+
+  for (auto &[file, previous] : _files) {
+    Stamp current = stamp(file);
+    if (!(current == previous)) {
+      previous = current;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+/**
+ * @brief Reads the pending inotify events.
+ *
+ * The queue overflowing is treated as a relevant event, the stamps then tell
+ * what really changed.
+ * @return true if any of them concerns a watched file.
+ */
+bool Raytracer::FileWatcher::readEvents() {
+  bool relevant = false;
+#ifdef __linux__
+  alignas(inotify_event) char buffer[4096];
+
+  while (true) {
+    ssize_t length = read(_inotify, buffer, sizeof(buffer));
+    if (length <= 0)
+      break;
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (char *p = buffer; p < buffer + length;) {
+      const auto *event = reinterpret_cast<const inotify_event *>(p);
+      p += sizeof(inotify_event) + event->len;
+      if (event->mask & IN_Q_OVERFLOW) {
+        relevant = true;
+        continue;
+      }
+      if (event->len == 0)
+        continue;
+      for (const auto &[directory, wd] : _directories) {
+        if (wd == event->wd &&
+            _files.count((std::filesystem::path(directory) / event->name)
+                             .string()) > 0)
+          relevant = true;
+      }
+    }
+  }
+#endif
+  return relevant;
+}
+
+/**
+ * @brief Loop of the watcher thread.
+ *
+ * With inotify the thread sleeps until an event arrives. Once an event
+ * concerns a watched file, it waits for the settle delay to pass without
+ * any new one, then compares the stamps and signals a change if one really
+ * differs. Without inotify the stamps are simply compared periodically.
+ */
+void Raytracer::FileWatcher::run() {
+  bool pending = false;
+
+  while (!_stopping) {
+    pollfd fds[2] = {{_wake[0], POLLIN, 0}, {_inotify, POLLIN, 0}};
+    nfds_t count = _inotify >= 0 ? 2 : 1;
+    int timeout = static_cast<int>(pollInterval.count());
+    if (_inotify >= 0)
+      timeout = pending ? static_cast<int>(_settle.count()) : -1;
+
+    int ready = ::poll(fds, count, timeout);
+    if (_stopping)
+      return;
+    if (ready < 0) {
+      if (errno == EINTR)
+        continue;
+      return;
+    }
+    if (ready == 0) {
+      pending = false;
+      if (refresh())
+        _changed = true;
+      continue;
+    }
+    if (count > 1 && (fds[1].revents & POLLIN) && readEvents())
+      pending = true;
+  }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Raytracer {
+
+  /**
+   * @brief Watches the files a scene is built from on a background thread.
+   *
+   * On Linux the directories holding the files are watched with inotify, so
+   * nothing is done until the kernel reports an event; elsewhere the files
+   * are stat'ed a few times per second. Events are coalesced until the files
+   * have been quiet for a short while (editors often write a file in several
+   * steps), and a change is only signalled if the modification time or size
+   * of a watched file really differs: events about other files of the same
+   * directories, such as the scene cache or editor swap files, are ignored.
+   */
+  class FileWatcher {
+    public:
+      /**
+       * @brief Starts the watcher thread.
+       * @param settle How long the files must stay quiet before a burst of
+       * events is reported.
+       * @throw std::runtime_error if inotify cannot be initialized.
+       */
+      explicit FileWatcher(
+          std::chrono::milliseconds settle = std::chrono::milliseconds(100));
+
+      /**
+       * @brief Stops and joins the watcher thread.
+       */
+      ~FileWatcher();
+
+      FileWatcher(const FileWatcher &) = delete;
+      FileWatcher &operator=(const FileWatcher &) = delete;
+
+      /**
+       * @brief Replaces the set of watched files. Their current state is the
+       * new reference, so changes made before this call are not reported.
+       * @param files The files to watch. Duplicates are ignored.
+       */
+      void watch(const std::vector<std::string> &files);
+
+      /**
+       * @brief Checks whether a watched file changed since the last call.
+       * Cheap enough to be called every frame.
+       * @return true once per burst of changes.
+       */
+      bool poll() {
+        return _changed.exchange(false);
+      }
+
+    private:
+      /**
+       * @brief State of a watched file, compared to detect real changes.
+       */
+      struct Stamp {
+        std::filesystem::file_time_type time; ///< Last modification time.
+        std::uintmax_t size = 0;              ///< Size in bytes.
+        bool exists = false;                  ///< Whether the file exists.
+
+        bool operator==(const Stamp &other) const {
+          return exists == other.exists && time == other.time &&
+                 size == other.size;
+        }
+      };
+
+      /**
+       * @brief Reads the current state of a file.
+       * @param path The path of the file.
+       * @return Stamp Its modification time and size.
+       */
+      static Stamp stamp(const std::string &path);
+
+      /**
+       * @brief Updates the stamps of the watched files.
+       * @return true if any of them changed.
+       */
+      bool refresh();
+
+      /**
+       * @brief Reads the pending inotify events.
+       * @return true if any of them concerns a watched file.
+       */
+      bool readEvents();
+
+      /**
+       * @brief Loop of the watcher thread.
+       */
+      void run();
+
+      std::chrono::milliseconds _settle;  ///< Quiet time closing a burst.
+      std::unordered_map<std::string, Stamp>
+          _files;                         ///< Watched files by absolute path.
+      std::unordered_map<std::string, int>
+          _directories;                   ///< inotify watch of each directory.
+      std::mutex _mutex;                  ///< Guards _files and _directories.
+      std::atomic<bool> _changed = false; ///< Set when a change is detected.
+      std::atomic<bool> _stopping = false; ///< Set by the destructor.
+      int _inotify = -1;                  ///< inotify instance, Linux only.
+      int _wake[2] = {-1, -1};            ///< Pipe waking the thread to stop.
+      std::thread _thread;                ///< The watcher thread.
+  };
+
+}  // namespace Raytracer
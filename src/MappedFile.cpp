@@ -0,0 +1,48 @@
+#include "MappedFile.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdexcept>
+
+/**
+ * @brief Maps a file in memory, read-only.
+ *
+ * The kernel is told how the file will be read: sequential mappings are
+ * read ahead aggressively, random ones only fault in the pages touched.
+ * @param path The path of the file.
+ * @param access How the mapping is going to be read.
+ * @throws std::runtime_error if the file cannot be opened, stat'ed or mapped.
+ */
+Raytracer::MappedFile::MappedFile(const std::string &path, Access access) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Cannot open file: " + path);
+
+  struct stat info;
+  if (fstat(fd, &info) < 0) {
+    close(fd);
+    throw std::runtime_error("Cannot stat file: " + path);
+  }
+  _size = static_cast<std::size_t>(info.st_size);
+  if (_size == 0) {
+    close(fd);
+    return;
+  }
+  void *data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    _size = 0;
+    throw std::runtime_error("Cannot map file: " + path);
+  }
+  madvise(data, _size, access == Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+  _data = static_cast<const char *>(data);
+}
+
+/**
+ * @brief Unmaps the file.
+ */
+Raytracer::MappedFile::~MappedFile() {
+  if (_data)
+    munmap(const_cast<char *>(_data), _size);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Raytracer {
+
+  /**
+   * @brief Read-only memory mapping of a whole file.
+   *
+   * The mapping is released when the object is destroyed. Empty files are
+   * valid and give a null data pointer with a size of 0.
+   */
+  class MappedFile {
+    public:
+      /**
+       * @brief How the mapping is going to be read, passed on to the kernel.
+       */
+      enum Access {
+        Sequential, ///< Read once from start to end, like a file parsed.
+        Random      ///< Read where needed, like buffers traced in place.
+      };
+
+      /**
+       * @brief Maps a file in memory.
+       * @param path The path of the file.
+       * @param access How the mapping is going to be read.
+       * @throw std::runtime_error if the file cannot be opened or mapped.
+       */
+      explicit MappedFile(const std::string &path,
+                          Access access = Sequential);
+
+      /**
+       * @brief Unmaps the file.
+       */
+      ~MappedFile();
+
+      MappedFile(const MappedFile &) = delete;
+      MappedFile &operator=(const MappedFile &) = delete;
+
+      /**
+       * @brief Gets the first byte of the file.
+       * @return const char* The mapped content.
+       */
+      const char *data() const {
+        return _data;
+      }
+
+      /**
+       * @brief Gets the size of the file.
+       * @return std::size_t The size in bytes.
+       */
+      std::size_t size() const {
+        return _size;
+      }
+
+    private:
+      const char *_data = nullptr; ///< Start of the mapping.
+      std::size_t _size = 0;       ///< Size of the mapping in bytes.
+  };
+
+}  // namespace Raytracer
@@ -0,0 +1,162 @@
+#include "MeshCache.hpp"
+
+/**
+ * @brief Gets the mesh of a file, loading it on first use.
+ *
+ * The loader runs outside the lock so that different files load in
+ * parallel. Threads asking for a file that is already being loaded wait for
+ * that load instead of starting another one.
+ * @param path The path of the OBJ file.
+ * @param load Called to load the mesh if the file is not cached yet. Any
+ * exception it throws is propagated, to the waiting threads as well, and
+ * nothing is cached.
+ * @return std::shared_ptr<const Raytracer::Object> The shared mesh.
+ */
+std::shared_ptr<const Raytracer::Object> Raytracer::MeshCache::acquire(
+    const std::string &path, const Loader &load) {
+  std::string cacheKey = key(path);
+  std::promise<std::shared_ptr<const Object>> promise;
+  std::shared_future<std::shared_ptr<const Object>> pending;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _meshes.find(cacheKey);
+    if (it != _meshes.end())
+      return it->second;
+    auto loading = _loading.find(cacheKey);
+    if (loading != _loading.end()) {
+      pending = loading->second;
+    } else {
+      _loading.emplace(cacheKey, promise.get_future().share());
+    }
+  }
+  if (pending.valid())
+    return pending.get();
+
+  std::shared_ptr<const Object> mesh;
+  try {
+    mesh = load();
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _loading.erase(cacheKey);
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  _meshes.emplace(cacheKey, mesh);
+  _loading.erase(cacheKey);
+  promise.set_value(mesh);
+  return mesh;
+}
+
+/**
+ * @brief Computes the key under which a file is cached.
+ *
+ * Uses weakly_canonical so that a missing file still gets a stable key and
+ * the loader can report the error itself.
+ * @param path The path of the file.
+ * @return std::string The canonical path.
+ */
+std::string Raytracer::MeshCache::key(const std::string &path) {
+  std::error_code ec;
+  std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+
+  if (ec)
+    return path;
+  return canonical.string();
+}
+
+/**
+ * @brief Records the files a mesh was loaded from.
+ *
+ * Their current write time is stored along with them. A file that cannot be
+ * stat'ed gets the minimal time, so it counts as changed once it appears.
+ * @param path The path of the OBJ file.
+ * @param files The OBJ file and its material libraries.
+ */
+void Raytracer::MeshCache::setSources(const std::string &path,
+                                      const std::vector<std::string> &files) {
+  std::vector<std::pair<std::string, std::filesystem::file_time_type>> sources;
+  for (const auto &file : files) {
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(file, ec);
+    sources.emplace_back(file, ec ? std::filesystem::file_time_type::min()
+                                  : time);
+  }
+  std::string cacheKey = key(path);
+  std::lock_guard<std::mutex> lock(_mutex);
+  _sources[cacheKey] = std::move(sources);
+}
+
+/**
+ * @brief Gets the files a mesh was loaded from.
+ *
+ * @param path The path of the OBJ file.
+ * @return std::vector<std::string> The recorded files.
+ */
+std::vector<std::string> Raytracer::MeshCache::getSources(
+    const std::string &path) const {
+  std::string cacheKey = key(path);
+  std::vector<std::string> files;
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _sources.find(cacheKey);
+
+  if (it != _sources.end()) {
+    for (const auto &source : it->second)
+      files.push_back(source.first);
+  }
+  return files;
+}
+
+/**
+ * @brief Drops the meshes whose source files were modified.
+ *
+ * Only write times are compared, so checking a scene with many large meshes
+ * costs one stat per file.
+ * @return std::size_t The number of meshes dropped.
+ */
+std::size_t Raytracer::MeshCache::evictStale() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::size_t evicted = 0;
+
+  for (auto it = _sources.begin(); it != _sources.end();) {
+    bool stale = false;
+    for (const auto &[file, time] : it->second) {
+      std::error_code ec;
+      auto current = std::filesystem::last_write_time(file, ec);
+      if ((ec ? std::filesystem::file_time_type::min() : current) != time) {
+        stale = true;
+        break;
+      }
+    }
+    if (!stale) {
+      ++it;
+      continue;
+    }
+    evicted += _meshes.erase(it->first);
+    it = _sources.erase(it);
+  }
+  return evicted;
+}
+
+/**
+ * @brief Drops the meshes no instance uses anymore.
+ *
+ * A mesh only referenced by the cache itself belonged to objects that were
+ * removed from the scene.
+ * @return std::size_t The number of meshes dropped.
+ */
+std::size_t Raytracer::MeshCache::prune() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::size_t pruned = 0;
+
+  for (auto it = _meshes.begin(); it != _meshes.end();) {
+    if (it->second.use_count() > 1) {
+      ++it;
+      continue;
+    }
+    _sources.erase(it->first);
+    it = _meshes.erase(it);
+    pruned++;
+  }
+  return pruned;
+}
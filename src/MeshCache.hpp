@@ -0,0 +1,131 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Object.hpp"
+
+namespace Raytracer {
+
+  /**
+   * @brief Keeps one loaded mesh per OBJ file.
+   *
+   * Meshes are keyed by the canonical path of their file, so
+   * "./objects/tree.obj" and "objects/../objects/tree.obj" share the same
+   * entry. The cache is shared between a parser and the parsers of the scenes
+   * it imports, so a mesh used by several sub-scenes is loaded only once.
+   *
+   * The cache is thread-safe: when several threads acquire the same file
+   * at once, one of them loads it and the others wait for its result.
+   */
+  class MeshCache {
+    public:
+      /**
+       * @brief Function loading a mesh that is not in the cache yet.
+       */
+      using Loader = std::function<std::shared_ptr<Object>()>;
+
+      /**
+       * @brief Default constructor.
+       */
+      MeshCache() = default;
+
+      /**
+       * @brief Default destructor.
+       */
+      ~MeshCache() = default;
+
+      /**
+       * @brief Gets the mesh of a file, loading it on first use.
+       * @param path The path of the OBJ file, as written in the scene.
+       * @param load Called once to load the mesh when it is not cached.
+       * @return std::shared_ptr<const Object> The shared mesh.
+       */
+      std::shared_ptr<const Object> acquire(const std::string &path,
+                                            const Loader &load);
+
+      /**
+       * @brief Records the files a mesh was loaded from, so that
+       * evictStale() can notice when they change.
+       * @param path The path of the OBJ file.
+       * @param files The OBJ file itself and its material libraries.
+       */
+      void setSources(const std::string &path,
+                      const std::vector<std::string> &files);
+
+      /**
+       * @brief Gets the files a mesh was loaded from.
+       * @param path The path of the OBJ file.
+       * @return std::vector<std::string> The recorded files, empty if none.
+       */
+      std::vector<std::string> getSources(const std::string &path) const;
+
+      /**
+       * @brief Drops the meshes whose source files were modified since they
+       * were loaded, so that the next acquire() loads them again.
+       * @return std::size_t The number of meshes dropped.
+       */
+      std::size_t evictStale();
+
+      /**
+       * @brief Drops the meshes no instance uses anymore.
+       * @return std::size_t The number of meshes dropped.
+       */
+      std::size_t prune();
+
+      /**
+       * @brief Gets every cached mesh.
+       * Not synchronized: only call it once no other thread uses the cache.
+       * @return The meshes by canonical path.
+       */
+      const std::unordered_map<std::string, std::shared_ptr<const Object>> &
+      getMeshes() const {
+        return _meshes;
+      }
+
+      /**
+       * @brief Gets the number of meshes currently cached.
+       * @return std::size_t The number of entries.
+       */
+      std::size_t size() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _meshes.size();
+      }
+
+      /**
+       * @brief Drops every cached mesh. Meshes still used by instances stay
+       * alive until those instances are destroyed.
+       */
+      void clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _meshes.clear();
+        _sources.clear();
+      }
+
+      /**
+       * @brief Computes the key under which a file is cached.
+       * @param path The path of the file.
+       * @return std::string The canonical path.
+       */
+      static std::string key(const std::string &path);
+
+    private:
+      std::unordered_map<std::string, std::shared_ptr<const Object>>
+          _meshes; ///< Loaded meshes by canonical path.
+      std::unordered_map<std::string,
+                         std::shared_future<std::shared_ptr<const Object>>>
+          _loading; ///< Meshes being loaded by another thread.
+      std::unordered_map<
+          std::string,
+          std::vector<std::pair<std::string, std::filesystem::file_time_type>>>
+          _sources; ///< Source files of each mesh and their write time.
+      mutable std::mutex _mutex; ///< Guards _meshes, _loading and _sources.
+  };
+
+}  // namespace Raytracer
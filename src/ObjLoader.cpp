@@ -0,0 +1,379 @@
+#include "ObjLoader.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include "MappedFile.hpp"
+#include "TaskPool.hpp"
+
+namespace {
+
+  /**
+   * @brief Slice of the OBJ file parsed by one thread, with the counts
+   * gathered by the first pass.
+   */
+  struct Chunk {
+    const char *begin = nullptr;         ///< First byte of the chunk.
+    const char *end = nullptr;           ///< One past the last byte.
+    std::size_t vertices = 0;            ///< Number of `v` lines.
+    std::size_t normals = 0;             ///< Number of `vn` lines.
+    std::size_t triangles = 0;           ///< Triangles after triangulation.
+    bool hasMaterial = false;            ///< Whether a `usemtl` was seen.
+    std::string lastMaterial;            ///< Name of the last `usemtl`.
+    std::vector<std::string> libraries;  ///< Files named by `mtllib`.
+  };
+
+  /**
+   * @brief Skips blanks, stopping at the end of the line.
+   */
+  const char *skipSpaces(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+      p++;
+    return p;
+  }
+
+  /**
+   * @brief Skips a whitespace-delimited token.
+   */
+  const char *skipToken(const char *p, const char *end) {
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r')
+      p++;
+    return p;
+  }
+
+  /**
+   * @brief Gets the rest of a line, without surrounding blanks.
+   */
+  std::string_view readRest(const char *p, const char *end) {
+    p = skipSpaces(p, end);
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+      end--;
+    return std::string_view(p, end - p);
+  }
+
+  /**
+   * @brief Parses a floating point number and advances the cursor.
+   */
+  float readFloat(const char *&p, const char *end) {
+    float value = 0;
+    p = skipSpaces(p, end);
+    if (p < end && *p == '+')
+      p++;
+    auto [next, ec] = std::from_chars(p, end, value);
+    if (ec != std::errc())
+      throw std::runtime_error("invalid number");
+    p = next;
+    return value;
+  }
+
+  /**
+   * @brief Parses an integer and advances the cursor.
+   */
+  long readInt(const char *&p, const char *end) {
+    long value = 0;
+    auto [next, ec] = std::from_chars(p, end, value);
+    if (ec != std::errc())
+      throw std::runtime_error("invalid index");
+    p = next;
+    return value;
+  }
+
+  /**
+   * @brief Turns a 1-based or negative OBJ index into a 0-based one.
+   * @param index The index as written in the file.
+   * @param defined Number of elements defined before the current line.
+   * @param total Number of elements in the whole file.
+   */
+  int resolveIndex(long index, std::size_t defined, std::size_t total) {
+    long resolved = index > 0 ? index - 1 : static_cast<long>(defined) + index;
+    if (index == 0 || resolved < 0 || resolved >= static_cast<long>(total))
+      throw std::runtime_error("index out of range");
+    return static_cast<int>(resolved);
+  }
+
+  /**
+   * @brief Calls `fn(line, lineEnd)` for every line of a chunk.
+   */
+  template <typename Fn>
+  void forEachLine(const Chunk &chunk, Fn &&fn) {
+    const char *p = chunk.begin;
+    while (p < chunk.end) {
+      const char *lineEnd = static_cast<const char *>(
+          std::memchr(p, '\n', chunk.end - p));
+      if (!lineEnd)
+        lineEnd = chunk.end;
+      fn(p, lineEnd);
+      p = lineEnd + 1;
+    }
+  }
+
+  /**
+   * @brief First pass: counts what a chunk will produce.
+   */
+  void countChunk(Chunk &chunk) {
+    forEachLine(chunk, [&](const char *p, const char *end) {
+      p = skipSpaces(p, end);
+      const char *keyEnd = skipToken(p, end);
+      std::string_view key(p, keyEnd - p);
+
+      if (key == "v") {
+        chunk.vertices++;
+      } else if (key == "vn") {
+        chunk.normals++;
+      } else if (key == "f") {
+        std::size_t corners = 0;
+        for (const char *q = skipSpaces(keyEnd, end); q < end;
+             q = skipSpaces(skipToken(q, end), end))
+          corners++;
+        if (corners < 3)
+          throw std::runtime_error("face with less than 3 vertices");
+        chunk.triangles += corners - 2;
+      } else if (key == "usemtl") {
+        chunk.hasMaterial = true;
+        chunk.lastMaterial = readRest(keyEnd, end);
+      } else if (key == "mtllib") {
+        for (const char *q = skipSpaces(keyEnd, end); q < end;) {
+          const char *nameEnd = skipToken(q, end);
+          chunk.libraries.emplace_back(q, nameEnd - q);
+          q = skipSpaces(nameEnd, end);
+        }
+      }
+    });
+  }
+
+}  // namespace
+
+/**
+ * @brief Loads an OBJ file into an object.
+ *
+ * Material libraries are looked up next to the OBJ file first, then relative
+ * to the working directory. A missing library only produces a warning; the
+ * faces using its materials are then rendered white.
+ * @param path The path of the .obj file.
+ * @param object The object to fill.
+ * @return std::vector<std::string> The resolved paths of the material
+ * libraries the file refers to, including missing ones.
+ * @throws std::runtime_error if the file cannot be read or is malformed.
+ */
+std::vector<std::string> Raytracer::ObjLoader::load(const std::string &path,
+                                                    Object &object) {
+  std::unique_ptr<MappedFile> file;
+  try {
+    file = std::make_unique<MappedFile>(path);
+  } catch (const std::runtime_error &) {
+    throw std::runtime_error("Failed to load .obj file: " + path);
+  }
+
+  // Split on line boundaries.
+  std::size_t threads = TaskPool::global().size();
+  std::size_t count =
+      std::max<std::size_t>(1, std::min(threads, file->size() / minChunkSize));
+  std::vector<Chunk> chunks(count);
+  const char *data = file->data();
+  const char *dataEnd = data + file->size();
+  for (std::size_t i = 0; i < count; i++) {
+    chunks[i].begin = i == 0 ? data : chunks[i - 1].end;
+    const char *split = i + 1 == count ? dataEnd
+                                       : data + file->size() * (i + 1) / count;
+    if (split < chunks[i].begin)
+      split = chunks[i].begin;
+    while (split < dataEnd && split > data && split[-1] != '\n')
+      split++;
+    chunks[i].end = split;
+  }
+
+  try {
+    TaskPool::global().parallelFor(
+        count, [&](std::size_t i) { countChunk(chunks[i]); });
+  } catch (const std::runtime_error &e) {
+    throw std::runtime_error("Invalid .obj file " + path + ": " + e.what());
+  }
+
+  // Materials.
+  std::vector<Object::Mtl> materials;
+  std::vector<std::string> libraries;
+  std::unordered_map<std::string, int> materialIndex;
+  std::filesystem::path directory = std::filesystem::path(path).parent_path();
+  for (const auto &chunk : chunks) {
+    for (const auto &library : chunk.libraries) {
+      std::filesystem::path mtlPath = directory / library;
+      if (!std::filesystem::exists(mtlPath))
+        mtlPath = library;
+      libraries.push_back(mtlPath.string());
+      try {
+        for (auto &material : loadMtl(mtlPath.string())) {
+          materialIndex.emplace(material.name,
+                                static_cast<int>(materials.size()));
+          materials.push_back(std::move(material));
+        }
+      } catch (const std::runtime_error &e) {
+        std::cerr << "[WARNING] - " << e.what() << " (used by " << path
+                  << ")" << std::endl;
+      }
+    }
+  }
+
+  // Prefix sums give each chunk its slice of the buffers and the state it
+  // inherits from the previous chunks.
+  std::vector<std::size_t> vertexOffset(count + 1, 0);
+  std::vector<std::size_t> normalOffset(count + 1, 0);
+  std::vector<std::size_t> faceOffset(count + 1, 0);
+  std::vector<int> startMaterial(count, -1);
+  for (std::size_t i = 0; i < count; i++) {
+    vertexOffset[i + 1] = vertexOffset[i] + chunks[i].vertices;
+    normalOffset[i + 1] = normalOffset[i] + chunks[i].normals;
+    faceOffset[i + 1] = faceOffset[i] + chunks[i].triangles;
+    if (i + 1 < count) {
+      startMaterial[i + 1] = startMaterial[i];
+      if (chunks[i].hasMaterial) {
+        auto it = materialIndex.find(chunks[i].lastMaterial);
+        startMaterial[i + 1] = it == materialIndex.end() ? -1 : it->second;
+      }
+    }
+  }
+  std::size_t totalVertices = vertexOffset[count];
+  std::size_t totalNormals = normalOffset[count];
+
+  std::vector<Math::Point3D> vertices(totalVertices);
+  std::vector<Math::Vector3D> normals(totalNormals);
+  std::vector<Object::Face> faces(faceOffset[count]);
+
+  auto parseChunk = [&](std::size_t i) {
+    std::size_t v = vertexOffset[i];
+    std::size_t n = normalOffset[i];
+    std::size_t f = faceOffset[i];
+    int material = startMaterial[i];
+
+    forEachLine(chunks[i], [&](const char *p, const char *end) {
+      p = skipSpaces(p, end);
+      const char *keyEnd = skipToken(p, end);
+      std::string_view key(p, keyEnd - p);
+      p = keyEnd;
+
+      if (key == "v") {
+        float x = readFloat(p, end);
+        float y = readFloat(p, end);
+        float z = readFloat(p, end);
+        vertices[v++] = Math::Point3D(x, y, z);
+      } else if (key == "vn") {
+        float x = readFloat(p, end);
+        float y = readFloat(p, end);
+        float z = readFloat(p, end);
+        normals[n++] = Math::Vector3D(x, y, z);
+      } else if (key == "f") {
+        int first[2] = {0, 0};
+        int previous[2] = {0, 0};
+        int corner = 0;
+        for (p = skipSpaces(p, end); p < end; p = skipSpaces(p, end)) {
+          int vertex = resolveIndex(readInt(p, end), v, totalVertices);
+          int normal = -1;
+          if (p < end && *p == '/') {
+            p++;
+            if (p < end && *p != '/')
+              readInt(p, end);
+            if (p < end && *p == '/') {
+              p++;
+              normal = resolveIndex(readInt(p, end), n, totalNormals);
+            }
+          }
+          if (corner == 0) {
+            first[0] = vertex;
+            first[1] = normal;
+          } else if (corner >= 2) {
+            faces[f++] = Object::Face{{first[0], previous[0], vertex},
+                                      {first[1], previous[1], normal},
+                                      material};
+          }
+          previous[0] = vertex;
+          previous[1] = normal;
+          corner++;
+        }
+      } else if (key == "usemtl") {
+        auto it = materialIndex.find(std::string(readRest(p, end)));
+        material = it == materialIndex.end() ? -1 : it->second;
+      }
+    });
+  };
+
+  try {
+    TaskPool::global().parallelFor(count, parseChunk);
+  } catch (const std::runtime_error &e) {
+    throw std::runtime_error("Invalid .obj file " + path + ": " + e.what());
+  }
+
+  object.setVertices(std::move(vertices));
+  object.setNormals(std::move(normals));
+  object.setFaces(std::move(faces));
+  object.setMaterials(std::move(materials));
+  return libraries;
+}
+
+/**
+ * @brief Loads the materials of an MTL file.
+ *
+ * Supports the fields used by the renderer: Ka, Kd, Ks, Ns, d (or Tr) and
+ * illum. Other statements (texture maps...) are ignored.
+ * @param path The path of the .mtl file.
+ * @return std::vector<Raytracer::Object::Mtl> The materials in file order.
+ * @throws std::runtime_error if the file cannot be read or a value is
+ * malformed.
+ */
+std::vector<Raytracer::Object::Mtl> Raytracer::ObjLoader::loadMtl(
+    const std::string &path) {
+  std::unique_ptr<MappedFile> file;
+  try {
+    file = std::make_unique<MappedFile>(path);
+  } catch (const std::runtime_error &) {
+    throw std::runtime_error("Failed to load .mtl file: " + path);
+  }
+  std::vector<Object::Mtl> materials;
+  Chunk whole;
+  whole.begin = file->data();
+  whole.end = file->data() + file->size();
+
+  auto readColor = [](const char *&p, const char *end) {
+    float r = readFloat(p, end);
+    float g = readFloat(p, end);
+    float b = readFloat(p, end);
+    return Math::Vector3D(r, g, b);
+  };
+  try {
+    forEachLine(whole, [&](const char *p, const char *end) {
+      p = skipSpaces(p, end);
+      const char *keyEnd = skipToken(p, end);
+      std::string_view key(p, keyEnd - p);
+      p = keyEnd;
+
+      if (key == "newmtl") {
+        materials.emplace_back();
+        materials.back().name = readRest(p, end);
+        return;
+      }
+      if (materials.empty() || key.empty() || key[0] == '#')
+        return;
+      Object::Mtl &material = materials.back();
+      if (key == "Ka")
+        material.ambient = readColor(p, end);
+      else if (key == "Kd")
+        material.diffuse = readColor(p, end);
+      else if (key == "Ks")
+        material.specular = readColor(p, end);
+      else if (key == "Ns")
+        material.shininess = readFloat(p, end);
+      else if (key == "d")
+        material.transparency = readFloat(p, end);
+      else if (key == "Tr")
+        material.transparency = 1.0 - readFloat(p, end);
+      else if (key == "illum")
+        material.illumination = static_cast<int>(readFloat(p, end));
+    });
+  } catch (const std::runtime_error &e) {
+    throw std::runtime_error("Invalid .mtl file " + path + ": " + e.what());
+  }
+  return materials;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Object.hpp"
+
+namespace Raytracer {
+
+  /**
+   * @brief Native loader for Wavefront OBJ meshes and their MTL materials.
+   *
+   * The OBJ file is memory-mapped and split into newline-aligned chunks that
+   * are parsed in parallel on the global TaskPool, in two passes:
+   *  1. every chunk counts its vertices, normals and triangles and records the
+   *     material libraries and the last `usemtl` it contains;
+   *  2. once the prefix sums of those counts are known, every chunk parses its
+   *     lines again and writes straight into its slice of the final, exactly
+   *     sized vertex/normal/face buffers, which are then moved into the
+   *     Object.
+   *
+   * The prefix sums are also what resolves negative (relative) indices and
+   * the material active at the start of each chunk. Polygons are triangulated
+   * as fans. Texture coordinates are skipped.
+   */
+  class ObjLoader {
+    public:
+      /**
+       * @brief Loads an OBJ file into an object.
+       * @param path The path of the .obj file.
+       * @param object The object whose vertices, normals, faces and
+       * materials are replaced.
+       * @return std::vector<std::string> The material libraries the file
+       * refers to, so that callers can track them as dependencies.
+       * @throw std::runtime_error if the file cannot be read or contains an
+       * invalid face.
+       */
+      static std::vector<std::string> load(const std::string &path,
+                                           Object &object);
+
+      /**
+       * @brief Loads the materials of an MTL file.
+       * @param path The path of the .mtl file.
+       * @return std::vector<Object::Mtl> The materials, in file order.
+       * @throw std::runtime_error if the file cannot be read.
+       */
+      static std::vector<Object::Mtl> loadMtl(const std::string &path);
+
+      /**
+       * @brief Minimum number of bytes given to each parsing task, so that
+       * small files are parsed by a single task.
+       */
+      static constexpr std::size_t minChunkSize = 1 << 20;
+  };
+
+}  // namespace Raytracer
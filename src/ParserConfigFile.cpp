@@ -1,6 +1,10 @@
 #include "ParserConfigFile.hpp"
+#include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <libconfig.h++>
+#include <stdexcept>
+#include <typeinfo>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -10,122 +14,485 @@
 #include "Cylinder.hpp"
 #include "CylinderInf.hpp"
 #include "DirectionalLight.hpp"
+#include "Instance.hpp"
 #include "LightComposite.hpp"
+#include "ObjLoader.hpp"
 #include "Object.hpp"
 #include "Plane.hpp"
 #include "PointLight.hpp"
 #include "Reflections.hpp"
 #include "Refractions.hpp"
+#include "SceneCache.hpp"
 #include "ShapeComposite.hpp"
 #include "Sphere.hpp"
+#include "TaskPool.hpp"
+#include "Trace.hpp"
 #include "Transparency.hpp"
 #include "Triangle.hpp"
 #include "Vector3D.hpp"
 #include "exceptions/RaytracerException.hpp"
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
 
 /**
  * @brief Parses an OBJ file and populates an Object.
  *
+ * Loading is done by the native ObjLoader, then the BVH over the faces is
+ * built with the preset of the parser, its large splits spread over the
+ * task pool, so that the object is ready to be traced. The build time is
+ * logged and added to the totals of the scene.
  * @param obj_file The path to the OBJ file.
  * @param object The Object to populate.
+ * @return std::vector<std::string> The OBJ file and its material libraries.
+ * @throws ParseError if the OBJ file or one of its material libraries
+ * cannot be read or is malformed.
  */
-void Raytracer::ParserConfigFile::parseObj(const std::string &obj_file,
-                                           Object &object) {
-  tinyobj::attrib_t attrib;
-  std::vector<tinyobj::shape_t> shapes;
-  std::vector<tinyobj::material_t> materials;
-  std::string warn, err;
-
-  bool success = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err,
-                                  obj_file.c_str(), nullptr);
-
-  if (!warn.empty()) {
-    std::cerr << "TinyObjLoader warning: " << warn << std::endl;
-  }
-  if (!err.empty()) {
-    throw std::runtime_error("TinyObjLoader error: " + err);
-  }
-  if (!success) {
-    throw std::runtime_error("Failed to load .obj file: " + obj_file);
+std::vector<std::string> Raytracer::ParserConfigFile::parseObj(
+    const std::string &obj_file, Object &object) {
+  std::vector<std::string> sources;
+  {
+    Trace::Scope scope("load OBJ", "load", obj_file);
+    try {
+      sources = ObjLoader::load(obj_file, object);
+    } catch (const std::runtime_error &e) {
+      throw ParseError(e.what());
+    }
   }
+  sources.insert(sources.begin(), obj_file);
+  Trace::Scope scope("build mesh BVH", "build", obj_file);
+  auto start = std::chrono::steady_clock::now();
+  object.buildAccel(_buildQuality, [](std::size_t count,
+                                      const std::function<void(std::size_t)>
+                                          &fn) {
+    TaskPool::global().parallelFor(count, fn);
+  });
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  const BVH &bvh = object.getAccel();
+  _buildLog->add(bvh.getIndices().size(), ms);
+  std::cout << "[BVH] - " << obj_file << ": " << bvh.getIndices().size()
+            << " triangles, " << bvh.getNodes().size() << " nodes in " << ms
+            << " ms (" << BVH::qualityName(_buildQuality) << ")" << std::endl;
+  return sources;
+}
 
-  std::vector<Object::Face> faces;
-  std::vector<Math::Point3D> vertices;
-  std::vector<Math::Vector3D> normals;
-  std::unordered_map<std::string, Object::Mtl> materials2;
-
-  for (size_t i = 0; i < attrib.vertices.size() / 3; i++) {
-    double x = attrib.vertices[3 * i + 0];
-    double y = attrib.vertices[3 * i + 1];
-    double z = attrib.vertices[3 * i + 2];
-    vertices.emplace_back(Math::Point3D(x, y, z));
+/**
+ * @brief Hashes a setting and everything below it.
+ *
+ * FNV-1a over the names, types and values of the whole subtree, so two
+ * settings get the same signature exactly when they would be parsed the
+ * same way.
+ * @param setting The libconfig setting.
+ * @return std::uint64_t The signature of the setting.
+ */
+std::uint64_t Raytracer::ParserConfigFile::hashSetting(
+    const libconfig::Setting &setting) {
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  auto mix = [&hash](const void *data, std::size_t size) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; i < size; i++)
+      hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+  };
+
+  const char *name = setting.getName();
+  if (name)
+    mix(name, std::char_traits<char>::length(name) + 1);
+  int type = setting.getType();
+  mix(&type, sizeof(type));
+  switch (setting.getType()) {
+    case libconfig::Setting::TypeInt:
+    case libconfig::Setting::TypeInt64: {
+      long long value = setting;
+      mix(&value, sizeof(value));
+      break;
+    }
+    case libconfig::Setting::TypeFloat: {
+      double value = setting;
+      mix(&value, sizeof(value));
+      break;
+    }
+    case libconfig::Setting::TypeString: {
+      const char *value = setting;
+      mix(value, std::char_traits<char>::length(value) + 1);
+      break;
+    }
+    case libconfig::Setting::TypeBoolean: {
+      bool value = setting;
+      mix(&value, sizeof(value));
+      break;
+    }
+    default:
+      for (int i = 0; i < setting.getLength(); i++) {
+        std::uint64_t child = hashSetting(setting[i]);
+        mix(&child, sizeof(child));
+      }
+      break;
   }
+  return hash;
+}
 
-  for (size_t i = 0; i < attrib.normals.size() / 3; i++) {
-    double x = attrib.normals[3 * i + 0];
-    double y = attrib.normals[3 * i + 1];
-    double z = attrib.normals[3 * i + 2];
-    normals.emplace_back(Math::Vector3D(x, y, z));
+/**
+ * @brief Adds a shape to a composite.
+ *
+ * The new shape is committed first, its setters and transforms being all
+ * applied. When reloading, a live shape created from an identical setting is
+ * reused instead of the new one, so that the renderer only updates what
+ * changed.
+ * @param sc The ShapeComposite to add the shape to.
+ * @param shape The freshly created shape.
+ * @param signature The signature of the setting it was created from.
+ */
+void Raytracer::ParserConfigFile::addShape(ShapeComposite &sc,
+                                           std::shared_ptr<IShape> shape,
+                                           std::uint64_t signature) {
+  shapeCommit(Factory::getShapeAbi(*shape), *shape);
+  if (_previous) {
+    auto live = _previous->takeShape(signature);
+    if (live)
+      shape = std::move(live);
   }
+  _current->addShape(signature, shape);
+  sc.addShape(shape);
+}
 
-  for (const auto &material : materials) {
-    Object::Mtl mtl;
-    mtl.ambient = Math::Vector3D(material.ambient[0], material.ambient[1],
-                                 material.ambient[2]);
-    mtl.diffuse = Math::Vector3D(material.diffuse[0], material.diffuse[1],
-                                 material.diffuse[2]);
-    mtl.specular = Math::Vector3D(material.specular[0], material.specular[1],
-                                  material.specular[2]);
-    mtl.shininess = material.shininess;
-    mtl.transparency = material.dissolve;
-    mtl.illumination = material.illum;
-    materials2[material.name] = mtl;
+/**
+ * @brief Adds a light to a composite.
+ *
+ * When reloading, a live light created from an identical setting is reused
+ * instead of the new one.
+ * @param lc The LightComposite to add the light to.
+ * @param light The freshly created light.
+ * @param signature The signature of the setting it was created from.
+ */
+void Raytracer::ParserConfigFile::addLight(LightComposite &lc,
+                                           std::shared_ptr<ILight> light,
+                                           std::uint64_t signature) {
+  if (_previous) {
+    auto live = _previous->takeLight(signature);
+    if (live)
+      light = std::move(live);
   }
+  _current->addLight(signature, light);
+  lc.addLight(light);
+}
+
+/**
+ * @brief Starts the record of a primitive read from a setting.
+ *
+ * @param kind The list the setting belongs to.
+ * @param setting The setting.
+ * @return SceneCache::Primitive The record, every field but the kind and
+ * the hash of the setting zeroed.
+ */
+Raytracer::SceneCache::Primitive Raytracer::ParserConfigFile::newPrimitive(
+    std::uint32_t kind, const libconfig::Setting &setting) {
+  SceneCache::Primitive primitive{};
+  primitive.kind = kind;
+  primitive.setting = hashSetting(setting);
+  return primitive;
+}
 
-  for (const auto &shape : shapes) {
-    for (size_t i = 0; i < shape.mesh.indices.size(); i += 3) {
-      Object::Face face;
+/**
+ * @brief Starts the record of a light read from a setting.
+ *
+ * @param kind The list the setting belongs to.
+ * @param setting The setting.
+ * @return SceneCache::Light The record, every field but the kind and the
+ * hash of the setting zeroed.
+ */
+Raytracer::SceneCache::Light Raytracer::ParserConfigFile::newLight(
+    std::uint32_t kind, const libconfig::Setting &setting) {
+  SceneCache::Light light{};
+  light.kind = kind;
+  light.setting = hashSetting(setting);
+  return light;
+}
 
-      for (size_t j = 0; j < 3; j++) {
-        int vertex_index = shape.mesh.indices[i + j].vertex_index;
-        face.vertex.push_back(vertex_index);
+/**
+ * @brief Records a parsed primitive in the flattened scene, then creates
+ * its shape.
+ *
+ * @param sc The ShapeComposite to add the shape to.
+ * @param primitive The primitive.
+ */
+void Raytracer::ParserConfigFile::addPrimitive(
+    ShapeComposite &sc, const SceneCache::Primitive &primitive) {
+  _primitives.push_back(primitive);
+  createPrimitive(sc, primitive);
+}
 
-        int normal_index = shape.mesh.indices[i + j].normal_index;
-        if (normal_index >= 0) {
-          face.normal.push_back(normal_index);
-        }
-      }
+/**
+ * @brief Records a parsed light in the flattened scene, then creates it.
+ *
+ * @param lc The LightComposite to add the light to.
+ * @param light The light.
+ */
+void Raytracer::ParserConfigFile::addLightEntry(
+    LightComposite &lc, const SceneCache::Light &light) {
+  _lights.push_back(light);
+  createLight(lc, light);
+}
 
-      int material_id = shape.mesh.material_ids[i / 3];
-      if (material_id >= 0 &&
-          material_id < static_cast<int>(materials.size())) {
-        face.material_name = materials[material_id].name;
-      }
-      faces.push_back(face);
+/**
+ * @brief Creates the material of a primitive.
+ *
+ * @param material The SceneCache::Primitive::Material of the primitive.
+ * @return std::shared_ptr<IMaterials> The material, nullptr for none.
+ */
+std::shared_ptr<Raytracer::IMaterials>
+Raytracer::ParserConfigFile::createMaterial(std::uint32_t material) {
+  switch (material) {
+    case SceneCache::Primitive::Reflective:
+      return _factory.create<Raytracer::Reflections>("reflection");
+    case SceneCache::Primitive::Refractive:
+      return _factory.create<Raytracer::Refractions>("refraction");
+    case SceneCache::Primitive::Transparent:
+      return _factory.create<Raytracer::Transparency>("transparent");
+    default:
+      return nullptr;
+  }
+}
+
+/**
+ * @brief Creates the shape of a primitive and adds it to a composite.
+ *
+ * The setters and transforms are applied in the order the primitive lists
+ * always applied them, so a shape created from the scene cache is the one
+ * the parser would create. An instance signs with its mesh too, so that it
+ * is only reused on reload if its mesh was kept.
+ * @param sc The ShapeComposite to add the shape to.
+ * @param primitive The primitive.
+ * @throws ParseError if a plugin fails to create the shape.
+ */
+void Raytracer::ParserConfigFile::createPrimitive(
+    ShapeComposite &sc, const SceneCache::Primitive &primitive) {
+  using Primitive = SceneCache::Primitive;
+  std::shared_ptr<IShape> shape;
+  std::uint64_t salt = 0;
+
+  switch (primitive.kind) {
+    case Primitive::Sphere: {
+      auto sphere = createShape<Raytracer::Sphere>("sphere");
+      sphere->setCenter(primitive.center);
+      sphere->setRadius(primitive.radius);
+      shape = sphere;
+      break;
+    }
+    case Primitive::Cylinder: {
+      auto cylinder = createShape<Raytracer::Cylinder>("cylinder");
+      cylinder->setCenter(primitive.center);
+      cylinder->setRadius(primitive.radius);
+      cylinder->setHeight(primitive.height);
+      shape = cylinder;
+      break;
+    }
+    case Primitive::CylinderInf: {
+      auto cylinderInf = createShape<Raytracer::CylinderInf>("cylinderInf");
+      cylinderInf->setCenter(primitive.center);
+      cylinderInf->setRadius(primitive.radius);
+      shape = cylinderInf;
+      break;
+    }
+    case Primitive::Cone: {
+      auto cone = createShape<Raytracer::Cone>("cone");
+      cone->setCenter(primitive.center);
+      cone->setRadius(primitive.radius);
+      cone->setHeight(primitive.height);
+      shape = cone;
+      break;
+    }
+    case Primitive::ConeInf: {
+      auto coneInf = createShape<Raytracer::ConeInf>("coneInf");
+      coneInf->setCenter(primitive.center);
+      coneInf->setAngle(primitive.radius);
+      shape = coneInf;
+      break;
+    }
+    case Primitive::Plane: {
+      auto plane = createShape<Raytracer::Plane>("plane");
+      plane->setNormal(primitive.normal);
+      shape = plane;
+      break;
+    }
+    case Primitive::Triangle: {
+      auto triangle = createShape<Raytracer::Triangle>("triangle");
+      triangle->setP1(primitive.center);
+      triangle->setP2(primitive.p2);
+      triangle->setP3(primitive.p3);
+      shape = triangle;
+      break;
+    }
+    case Primitive::Instance: {
+      auto instance = _factory.create<Raytracer::Instance>("instance");
+      if (!instance)
+        throw ParseError("Failed to create instance from factory.");
+      auto mesh = acquireMesh(_meshFiles[primitive.mesh]);
+      instance->setPrototype(mesh, Factory::getShapeAbi(*mesh));
+      if (primitive.flags & Primitive::Scaled)
+        instance->setScale(primitive.scale);
+      if (primitive.flags & Primitive::Rotated)
+        instance->rotate(primitive.axis, primitive.angle);
+      if (primitive.flags & Primitive::Translated)
+        instance->translate(primitive.translation);
+      salt = reinterpret_cast<std::uintptr_t>(mesh.get());
+      addShape(sc, instance,
+               (primitive.setting ^ salt) * 31 +
+                   typeid(*instance).hash_code());
+      return;
+    }
+    default:
+      throw ParseError("Unknown primitive in the scene cache.");
+  }
+
+  if (primitive.kind != Primitive::Plane)
+    shape->setColor(primitive.color);
+  if (primitive.flags & Primitive::Translated)
+    shape->translate(primitive.translation);
+  if (primitive.flags & Primitive::Rotated)
+    shape->rotate(primitive.axis, primitive.angle);
+  if (auto material = createMaterial(primitive.material))
+    shape->setMaterial(material);
+  // A plane is placed by its offset once translated, as it always was.
+  if (primitive.kind == Primitive::Plane) {
+    shape->setCenter(primitive.center);
+    shape->setColor(primitive.color);
+  }
+  addShape(sc, shape,
+           (primitive.setting ^ salt) * 31 + typeid(*shape).hash_code());
+}
+
+/**
+ * @brief Creates a light and adds it to a composite.
+ *
+ * @param lc The LightComposite to add the light to.
+ * @param light The light.
+ * @throws ParseError if a plugin fails to create the light.
+ */
+void Raytracer::ParserConfigFile::createLight(LightComposite &lc,
+                                              const SceneCache::Light &light) {
+  std::shared_ptr<ILight> created;
+
+  switch (light.kind) {
+    case SceneCache::Light::Ambient: {
+      auto ambient = _factory.create<AmbientLight>("ambient");
+      if (ambient == nullptr)
+        throw ParseError(
+            "Failed to create ambient light object from factory.");
+      ambient->setColor(light.color);
+      ambient->setIntensity(light.intensity);
+      ambient->setType("AmbientLight");
+      created = ambient;
+      break;
+    }
+    case SceneCache::Light::Point: {
+      auto point = _factory.create<Raytracer::PointLight>("point");
+      if (point == nullptr)
+        throw ParseError("Failed to create point light object from factory.");
+      point->setIntensity(light.intensity);
+      point->setPosition(light.position);
+      point->setColor(light.color);
+      point->setType("PointLight");
+      created = point;
+      break;
     }
+    case SceneCache::Light::Directional: {
+      auto directional =
+          _factory.create<Raytracer::DirectionalLight>("directional");
+      if (directional == nullptr)
+        throw ParseError(
+            "Failed to create directional light object from factory.");
+      directional->setDirection(light.direction);
+      directional->setType("DirectionalLight");
+      created = directional;
+      break;
+    }
+    default:
+      throw ParseError("Unknown light in the scene cache.");
   }
-  object.setVertices(vertices);
-  object.setNormals(normals);
-  object.setFaces(faces);
-  object.setMaterials(materials2);
+  addLight(lc, created, light.setting * 31 + typeid(*created).hash_code());
+}
+
+/**
+ * @brief Gets the mesh of an OBJ file.
+ *
+ * The mesh is taken from the mesh cache, else read from the scene cache
+ * when its files did not change, else loaded from the OBJ file. A mesh
+ * built with the SAH preset without the cache asks for the cache to be
+ * written again. Safe to call from several threads.
+ * @param objFile The path of the OBJ file.
+ * @return std::shared_ptr<const Object> The shared mesh.
+ * @throws ParseError if the OBJ file cannot be loaded.
+ */
+std::shared_ptr<const Raytracer::Object>
+Raytracer::ParserConfigFile::acquireMesh(const std::string &objFile) {
+  return _meshCache->acquire(objFile, [&]() {
+    auto create = [this]() {
+      auto newObject = _factory.create<Raytracer::Object>("object");
+      if (!newObject)
+        throw ParseError("Failed to create object from factory.");
+      return newObject;
+    };
+    std::vector<std::string> sources;
+    std::shared_ptr<Object> newObject =
+        _sceneCache ? _sceneCache->find(objFile, create, sources) : nullptr;
+    if (!newObject) {
+      newObject = create();
+      newObject->setObjFile(objFile);
+      sources = parseObj(objFile, *newObject);
+      if (_sceneCache && _buildQuality == BVH::QualitySah)
+        _sceneCache->markDirty();
+    }
+    _meshCache->setSources(objFile, sources);
+    return newObject;
+  });
+}
+
+/**
+ * @brief Loads meshes ahead of their instances, in parallel.
+ *
+ * @param objFiles The paths of the OBJ files, possibly repeated.
+ */
+void Raytracer::ParserConfigFile::loadMeshes(
+    const std::vector<std::string> &objFiles) {
+  TaskPool::global().parallelFor(
+      objFiles.size(), [&](std::size_t i) { acquireMesh(objFiles[i]); });
 }
 
 /**
  * @brief Constructor for ParserConfigFile.
  *
+ * Opens the scene cache of the file. When it holds the flattened scene and
+ * none of its files changed, the file is not even read: parseConfigFile()
+ * creates the scene from the cache.
  * @param filename The path to the configuration file.
  * @param plugins A list of plugin paths.
  */
 Raytracer::ParserConfigFile::ParserConfigFile(
     const std::string &filename, const std::vector<std::string> &plugins)
-    : _plugins(plugins), _currentFilePath(filename) {
+    : ParserConfigFile(filename, plugins,
+                       std::make_shared<SceneCache>(filename)) {
+}
+
+/**
+ * @brief Constructor for ParserConfigFile, sharing the scene cache of the
+ * scene importing the file.
+ *
+ * @param filename The path to the configuration file.
+ * @param plugins A list of plugin paths.
+ * @param sceneCache The scene cache of the top-level scene.
+ */
+Raytracer::ParserConfigFile::ParserConfigFile(
+    const std::string &filename, const std::vector<std::string> &plugins,
+    std::shared_ptr<SceneCache> sceneCache)
+    : _plugins(plugins), _currentFilePath(filename),
+      _sceneCache(std::move(sceneCache)) {
   if (!filename.ends_with(".cfg")) {
     throw ParseError(
         "Config file isn't in correct format (needs to be a *.cfg)");
   }
+  if (_sceneCache->getScene())
+    return;
   try {
+    Trace::Scope scope("read config", "parse", filename);
     _cfg.readFile(filename.c_str());
   } catch (const libconfig::FileIOException &fioex) {
     throw ConfigError(
@@ -140,6 +507,7 @@ Raytracer::ParserConfigFile::ParserConfigFile(
 /**
  * @brief Parses the camera settings from the configuration.
  *
+ * The camera is recorded in the flattened scene, then applied.
  * @param camera The Camera object to populate.
  * @param root The root setting of the configuration file.
  */
@@ -161,16 +529,15 @@ void Raytracer::ParserConfigFile::parseCamera(Camera &camera,
     rotY = rotationInfo.lookup("y");
     rotZ = rotationInfo.lookup("z");
     fov = fovInfo.lookup("fieldOfView");
-    camera.setHeight(height);
-    camera.setWidth(width);
-    camera.origin.x = posX;
-    camera.origin.y = posY;
-    camera.origin.z = posZ;
+    _view.width = width;
+    _view.height = height;
+    _view.origin = Math::Point3D(posX, posY, posZ);
     (void)rotX;  // [TODO]: Implement rotation
     (void)rotY;  // [TODO]: Implement rotation
     (void)rotZ;  // [TODO]: Implement rotation
     // camera.setRotation(rotX, rotY, rotZ); # [TODO]: Implement rotation
-    camera.setFieldOfView(fov);
+    _view.fieldOfView = fov;
+    setCamera(camera, _view);
   } catch (const libconfig::SettingNotFoundException &nfex) {
     throw ParseError(std::string("Camera config: ") + nfex.getPath() +
                      " not found or invalid.");
@@ -180,6 +547,22 @@ void Raytracer::ParserConfigFile::parseCamera(Camera &camera,
   }
 }
 
+/**
+ * @brief Applies the camera of a flattened scene.
+ *
+ * @param camera The Camera object to populate.
+ * @param view The camera of the scene.
+ */
+void Raytracer::ParserConfigFile::setCamera(Camera &camera,
+                                            const SceneCache::View &view) {
+  camera.setHeight(view.height);
+  camera.setWidth(view.width);
+  camera.origin.x = view.origin.x;
+  camera.origin.y = view.origin.y;
+  camera.origin.z = view.origin.z;
+  camera.setFieldOfView(view.fieldOfView);
+}
+
 /**
  * @brief Parses coordinates (x, y, z) from a setting.
  *
@@ -221,21 +604,53 @@ Math::Vector3D Raytracer::ParserConfigFile::parseVector3D(
   return {x, y, z};
 }
 /**
- * @brief Parse une rotation à partir d'un setting et l'applique à une forme.
+ * @brief Parse une rotation à partir d'un setting et l'enregistre dans une
+ * primitive.
  * @param setting Le setting contenant les informations de rotation.
- * @param shape La forme à laquelle appliquer la rotation.
+ * @param primitive La primitive à laquelle appliquer la rotation.
  * @throws ParseError si les informations de rotation sont incomplètes ou
  * invalides.
  */
 void Raytracer::ParserConfigFile::parseRotation(
-    const libconfig::Setting &setting, std::shared_ptr<IShape> shape) {
+    const libconfig::Setting &setting, SceneCache::Primitive &primitive) {
   if (!setting.exists("axis") || !setting.exists("angle"))
     throw ParseError(
         std::string("Rotation requires both 'axis' and 'angle' fields at ") +
         setting.getPath());
-  Math::Vector3D axis = parseVector3D(setting["axis"]);
-  double angle = setting["angle"];
-  shape->rotate(axis, angle);
+  primitive.axis = parseVector3D(setting["axis"]);
+  primitive.angle = setting["angle"];
+  primitive.flags |= SceneCache::Primitive::Rotated;
+}
+
+/**
+ * @brief Parses the optional translation, rotation and material of a
+ * primitive. The fields a primitive list does not allow were already
+ * rejected by checkSettings().
+ * @param setting The setting of the primitive.
+ * @param primitive The primitive to record them in.
+ * @throws ParseError if one of them is invalid.
+ */
+void Raytracer::ParserConfigFile::parseOptions(
+    const libconfig::Setting &setting, SceneCache::Primitive &primitive) {
+  if (setting.exists("translate")) {
+    primitive.translation = parseVector3D(setting["translate"]);
+    primitive.flags |= SceneCache::Primitive::Translated;
+  }
+  if (setting.exists("rotate"))
+    parseRotation(setting["rotate"], primitive);
+  if (setting.exists("material")) {
+    std::string materialName = parseString(setting["material"]);
+    if (materialName == "reflective") {
+      primitive.material = SceneCache::Primitive::Reflective;
+    } else if (materialName == "refractive") {
+      primitive.material = SceneCache::Primitive::Refractive;
+    } else if (materialName == "transparent") {
+      primitive.material = SceneCache::Primitive::Transparent;
+    } else {
+      throw ParseError(std::string("[ERROR] - Unknown material type: ") +
+                       materialName);
+    }
+  }
 }
 
 /**
@@ -292,44 +707,23 @@ void Raytracer::ParserConfigFile::parseSpheres(
     Raytracer::ShapeComposite &sc, const libconfig::Setting &spheresSetting) {
   for (int i = 0; i < spheresSetting.getLength(); i++) {
     const libconfig::Setting &sphere = spheresSetting[i];
-    auto newSphere = _factory.create<Raytracer::Sphere>("sphere");
-    if (!newSphere)
-      throw ParseError("Failed to create sphere object from factory.");
     if (!sphere.exists("r"))
       throw ParseError(std::string("Sphere radius not found at ") +
                        sphere.getPath());
     if (!sphere.exists("color"))
       throw ParseError(std::string("Sphere color not found at ") +
                        sphere.getPath());
-    newSphere->setCenter(parsePoint3D(sphere));
+    auto newSphere = newPrimitive(SceneCache::Primitive::Sphere, sphere);
+    newSphere.center = parsePoint3D(sphere);
     if (sphere.lookup("r").operator double() <= 0)
       throw ParseError(std::string("Sphere radius must be positive at ") +
                        sphere.getPath());
-    newSphere->setRadius(sphere.lookup("r").operator double());
-    newSphere->setColor(parseColor(sphere["color"]));
+    newSphere.radius = sphere.lookup("r").operator double();
+    newSphere.color = parseColor(sphere["color"]);
 
     // Optional options
-    if (sphere.exists("translate")) {
-      Math::Vector3D translation = parseVector3D(sphere["translate"]);
-      newSphere->translate(translation);
-    }
-    if (sphere.exists("material")) {
-      std::string materialName = parseString(sphere["material"]);
-      if (materialName == "reflective") {
-        newSphere->setMaterial(
-            _factory.create<Raytracer::Reflections>("reflection"));
-      } else if (materialName == "refractive") {
-        newSphere->setMaterial(
-            _factory.create<Raytracer::Refractions>("refraction"));
-      } else if (materialName == "transparent") {
-        newSphere->setMaterial(
-            _factory.create<Raytracer::Transparency>("transparent"));
-      } else {
-        throw ParseError(std::string("[ERROR] - Unknown material type: ") +
-                         materialName);
-      }
-    }
-    sc.addShape(newSphere);
+    parseOptions(sphere, newSphere);
+    addPrimitive(sc, newSphere);
   }
 }
 
@@ -349,9 +743,6 @@ void Raytracer::ParserConfigFile::parseCylinders(
     Raytracer::ShapeComposite &sc, const libconfig::Setting &cylindersSetting) {
   for (int i = 0; i < cylindersSetting.getLength(); i++) {
     const libconfig::Setting &cylinder = cylindersSetting[i];
-    auto newCylinder = _factory.create<Raytracer::Cylinder>("cylinder");
-    if (!newCylinder)
-      throw ParseError("Failed to create cylinder object from factory.");
     if (!cylinder.exists("r"))
       throw ParseError(std::string("Cylinder radius not found at ") +
                        cylinder.getPath());
@@ -362,39 +753,19 @@ void Raytracer::ParserConfigFile::parseCylinders(
       throw ParseError(std::string("Cylinder color not found at ") +
                        cylinder.getPath());
 
-    newCylinder->setCenter(parsePoint3D(cylinder));
+    auto newCylinder =
+        newPrimitive(SceneCache::Primitive::Cylinder, cylinder);
+    newCylinder.center = parsePoint3D(cylinder);
     if (cylinder.lookup("r").operator double() <= 0)
       throw ParseError(std::string("Cylinder radius must be positive at ") +
                        cylinder.getPath());
-    newCylinder->setRadius(cylinder.lookup("r").operator double());
-    newCylinder->setHeight(cylinder.lookup("h").operator double());
-    newCylinder->setColor(parseColor(cylinder["color"]));
+    newCylinder.radius = cylinder.lookup("r").operator double();
+    newCylinder.height = cylinder.lookup("h").operator double();
+    newCylinder.color = parseColor(cylinder["color"]);
 
     // Optional options
-    if (cylinder.exists("translate")) {
-      Math::Vector3D translation = parseVector3D(cylinder["translate"]);
-      newCylinder->translate(translation);
-    }
-    if (cylinder.exists("rotate")) {
-      parseRotation(cylinder["rotate"], newCylinder);
-    }
-    if (cylinder.exists("material")) {
-      std::string materialName = parseString(cylinder["material"]);
-      if (materialName == "reflective") {
-        newCylinder->setMaterial(
-            _factory.create<Raytracer::Reflections>("reflection"));
-      } else if (materialName == "refractive") {
-        newCylinder->setMaterial(
-            _factory.create<Raytracer::Refractions>("refraction"));
-      } else if (materialName == "transparent") {
-        newCylinder->setMaterial(
-            _factory.create<Raytracer::Transparency>("transparent"));
-      } else {
-        throw ParseError(std::string("[ERROR] - Unknown material type: ") +
-                         materialName);
-      }
-    }
-    sc.addShape(newCylinder);
+    parseOptions(cylinder, newCylinder);
+    addPrimitive(sc, newCylinder);
   }
 }
 
@@ -415,10 +786,6 @@ void Raytracer::ParserConfigFile::parseCylindersInf(
     const libconfig::Setting &cylindersInfSetting) {
   for (int i = 0; i < cylindersInfSetting.getLength(); i++) {
     const libconfig::Setting &cylinderInf = cylindersInfSetting[i];
-    auto newCylinderInf =
-        _factory.create<Raytracer::CylinderInf>("cylinderInf");
-    if (!newCylinderInf)
-      throw ParseError("Failed to create cylinderInf object from factory.");
     if (!cylinderInf.exists("r"))
       throw ParseError(std::string("CylinderInf radius not found at ") +
                        cylinderInf.getPath());
@@ -426,38 +793,18 @@ void Raytracer::ParserConfigFile::parseCylindersInf(
       throw ParseError(std::string("CylinderInf color not found at ") +
                        cylinderInf.getPath());
 
-    newCylinderInf->setCenter(parsePoint3D(cylinderInf));
+    auto newCylinderInf =
+        newPrimitive(SceneCache::Primitive::CylinderInf, cylinderInf);
+    newCylinderInf.center = parsePoint3D(cylinderInf);
     if (cylinderInf.lookup("r").operator double() <= 0)
       throw ParseError(std::string("CylinderInf radius must be positive at ") +
                        cylinderInf.getPath());
-    newCylinderInf->setRadius(cylinderInf.lookup("r").operator double());
-    newCylinderInf->setColor(parseColor(cylinderInf["color"]));
+    newCylinderInf.radius = cylinderInf.lookup("r").operator double();
+    newCylinderInf.color = parseColor(cylinderInf["color"]);
 
     // Optional options
-    if (cylinderInf.exists("translate")) {
-      Math::Vector3D translation = parseVector3D(cylinderInf["translate"]);
-      newCylinderInf->translate(translation);
-    }
-    if (cylinderInf.exists("rotate")) {
-      parseRotation(cylinderInf["rotate"], newCylinderInf);
-    }
-    if (cylinderInf.exists("material")) {
-      std::string materialName = parseString(cylinderInf["material"]);
-      if (materialName == "reflective") {
-        newCylinderInf->setMaterial(
-            _factory.create<Raytracer::Reflections>("reflection"));
-      } else if (materialName == "refractive") {
-        newCylinderInf->setMaterial(
-            _factory.create<Raytracer::Refractions>("refraction"));
-      } else if (materialName == "transparent") {
-        newCylinderInf->setMaterial(
-            _factory.create<Raytracer::Transparency>("transparent"));
-      } else {
-        throw ParseError(std::string("[ERROR] - Unknown material type: ") +
-                         materialName);
-      }
-    }
-    sc.addShape(newCylinderInf);
+    parseOptions(cylinderInf, newCylinderInf);
+    addPrimitive(sc, newCylinderInf);
   }
 }
 
@@ -477,9 +824,6 @@ void Raytracer::ParserConfigFile::parseCones(
     Raytracer::ShapeComposite &sc, const libconfig::Setting &conesSetting) {
   for (int i = 0; i < conesSetting.getLength(); i++) {
     const libconfig::Setting &cone = conesSetting[i];
-    auto newCone = _factory.create<Raytracer::Cone>("cone");
-    if (!newCone)
-      throw ParseError("Failed to create cone object from factory.");
     if (!cone.exists("r"))
       throw ParseError(std::string("Cone radius not found at ") +
                        cone.getPath());
@@ -490,39 +834,18 @@ void Raytracer::ParserConfigFile::parseCones(
       throw ParseError(std::string("Cone color not found at ") +
                        cone.getPath());
 
-    newCone->setCenter(parsePoint3D(cone));
+    auto newCone = newPrimitive(SceneCache::Primitive::Cone, cone);
+    newCone.center = parsePoint3D(cone);
     if (cone.lookup("r").operator double() <= 0)
       throw ParseError(std::string("Cone radius must be positive at ") +
                        cone.getPath());
-    newCone->setRadius(cone.lookup("r").operator double());
-    newCone->setHeight(cone.lookup("h").operator double());
-    newCone->setColor(parseColor(cone["color"]));
+    newCone.radius = cone.lookup("r").operator double();
+    newCone.height = cone.lookup("h").operator double();
+    newCone.color = parseColor(cone["color"]);
 
     // Optional options
-    if (cone.exists("translate")) {
-      Math::Vector3D translation = parseVector3D(cone["translate"]);
-      newCone->translate(translation);
-    }
-    if (cone.exists("rotate")) {
-      parseRotation(cone["rotate"], newCone);
-    }
-    if (cone.exists("material")) {
-      std::string materialName = parseString(cone["material"]);
-      if (materialName == "reflective") {
-        newCone->setMaterial(
-            _factory.create<Raytracer::Reflections>("reflection"));
-      } else if (materialName == "refractive") {
-        newCone->setMaterial(
-            _factory.create<Raytracer::Refractions>("refraction"));
-      } else if (materialName == "transparent") {
-        newCone->setMaterial(
-            _factory.create<Raytracer::Transparency>("transparent"));
-      } else {
-        throw ParseError(std::string("[ERROR] - Unknown material type: ") +
-                         materialName);
-      }
-    }
-    sc.addShape(newCone);
+    parseOptions(cone, newCone);
+    addPrimitive(sc, newCone);
   }
 }
 
@@ -542,9 +865,6 @@ void Raytracer::ParserConfigFile::parseConesInf(
     Raytracer::ShapeComposite &sc, const libconfig::Setting &conesInfSetting) {
   for (int i = 0; i < conesInfSetting.getLength(); i++) {
     const libconfig::Setting &coneInf = conesInfSetting[i];
-    auto newConeInf = _factory.create<Raytracer::ConeInf>("coneInf");
-    if (!newConeInf)
-      throw ParseError("Failed to create coneInf object from factory.");
     if (!coneInf.exists("a"))
       throw ParseError(std::string("ConeInf angle not found at ") +
                        coneInf.getPath());
@@ -552,38 +872,17 @@ void Raytracer::ParserConfigFile::parseConesInf(
       throw ParseError(std::string("ConeInf color not found at ") +
                        coneInf.getPath());
 
-    newConeInf->setCenter(parsePoint3D(coneInf));
+    auto newConeInf = newPrimitive(SceneCache::Primitive::ConeInf, coneInf);
+    newConeInf.center = parsePoint3D(coneInf);
     if (coneInf.lookup("a").operator double() <= 0)
       throw ParseError(std::string("Cone angle must be positive at ") +
                        coneInf.getPath());
-    newConeInf->setAngle(coneInf.lookup("a").operator double());
-    newConeInf->setColor(parseColor(coneInf["color"]));
+    newConeInf.radius = coneInf.lookup("a").operator double();
+    newConeInf.color = parseColor(coneInf["color"]);
 
     // Optional options
-    if (coneInf.exists("translate")) {
-      Math::Vector3D translation = parseVector3D(coneInf["translate"]);
-      newConeInf->translate(translation);
-    }
-    if (coneInf.exists("rotate")) {
-      parseRotation(coneInf["rotate"], newConeInf);
-    }
-    if (coneInf.exists("material")) {
-      std::string materialName = parseString(coneInf["material"]);
-      if (materialName == "reflective") {
-        newConeInf->setMaterial(
-            _factory.create<Raytracer::Reflections>("reflection"));
-      } else if (materialName == "refractive") {
-        newConeInf->setMaterial(
-            _factory.create<Raytracer::Refractions>("refraction"));
-      } else if (materialName == "transparent") {
-        newConeInf->setMaterial(
-            _factory.create<Raytracer::Transparency>("transparent"));
-      } else {
-        throw ParseError(std::string("[ERROR] - Unknown material type: ") +
-                         materialName);
-      }
-    }
-    sc.addShape(newConeInf);
+    parseOptions(coneInf, newConeInf);
+    addPrimitive(sc, newConeInf);
   }
 }
 
@@ -603,9 +902,6 @@ void Raytracer::ParserConfigFile::parsePlanes(
     Raytracer::ShapeComposite &sc, const libconfig::Setting &planesSettings) {
   for (int i = 0; i < planesSettings.getLength(); i++) {
     const libconfig::Setting &plane = planesSettings[i];
-    auto newPlane = _factory.create<Raytracer::Plane>("plane");
-    if (!newPlane)
-      throw ParseError("Failed to create plane object from factory.");
     if (!plane.exists("normal"))
       throw ParseError(std::string("Plane normal not found at ") +
                        plane.getPath());
@@ -616,70 +912,76 @@ void Raytracer::ParserConfigFile::parsePlanes(
       throw ParseError(std::string("Plane color not found at ") +
                        plane.getPath());
 
-    Math::Vector3D normal = {0, 0, 0};
+    auto newPlane = newPrimitive(SceneCache::Primitive::Plane, plane);
     std::string newNormal = plane.lookup("normal").operator std::string();
     if (newNormal == "X" || newNormal == "x")
-      normal = {1, 0, 0};
+      newPlane.normal = {1, 0, 0};
     else if (newNormal == "Y" || newNormal == "y")
-      normal = {0, 1, 0};
+      newPlane.normal = {0, 1, 0};
     else if (newNormal == "Z" || newNormal == "z")
-      normal = {0, 0, 1};
+      newPlane.normal = {0, 0, 1};
     else
       throw ParseError(std::string("Plane normal must be X, Y, or Z at ") +
                        plane.getPath());
-    newPlane->setNormal(normal);
 
     // Optional options
-    if (plane.exists("translate")) {
-      Math::Vector3D translation = parseVector3D(plane["translate"]);
-      newPlane->translate(translation);
-    }
-    if (plane.exists("material")) {
-      std::string materialName = parseString(plane["material"]);
-      if (materialName == "reflective") {
-        newPlane->setMaterial(
-            _factory.create<Raytracer::Reflections>("reflection"));
-      } else if (materialName == "refractive") {
-        newPlane->setMaterial(
-            _factory.create<Raytracer::Refractions>("refraction"));
-      } else if (materialName == "transparent") {
-        newPlane->setMaterial(
-            _factory.create<Raytracer::Transparency>("transparent"));
-      } else {
-        throw ParseError(std::string("[ERROR] - Unknown material type: ") +
-                         materialName);
-      }
-    }
+    parseOptions(plane, newPlane);
     float center = plane.lookup("offset").operator double();
-    Math::Point3D newCenter = {0, center, 0};
-    newPlane->setCenter({0, center, 0});
-    newPlane->setColor(parseColor(plane["color"]));
-    sc.addShape(newPlane);
+    newPlane.center = {0, center, 0};
+    newPlane.color = parseColor(plane["color"]);
+    addPrimitive(sc, newPlane);
   }
 }
 
 /**
  * @brief Parses object primitives (OBJ files) from the configuration.
  *
- * Iterates through a list of object settings, creates Object instances,
- * and calls parseObj to load geometry from the specified .obj file.
+ * Each OBJ file is loaded once through the mesh cache (from the scene cache
+ * when possible), then every entry places the shared mesh with an Instance
+ * carrying its own optional scale, rotation and translation. The mesh is
+ * part of the signature of the instance, so an instance is only reused on
+ * reload if its mesh was kept too.
  * @param sc The ShapeComposite to add the parsed objects to.
  * @param objectsSetting The libconfig setting containing an array of object
  * configurations (each with an "obj_file" path).
- * @throws ParseError if "obj_file" property is missing.
+ * @throws ParseError if "obj_file" property is missing or if a scale factor
+ * is zero.
  */
 void Raytracer::ParserConfigFile::parseObjects(
     Raytracer::ShapeComposite &sc, const libconfig::Setting &objectsSetting) {
+  // libconfig settings are not safe to read from several threads, so the
+  // paths are read first and only the loads run in parallel.
+  std::vector<std::string> objFiles(objectsSetting.getLength());
   for (int i = 0; i < objectsSetting.getLength(); i++) {
     const libconfig::Setting &object = objectsSetting[i];
-    auto newObject = _factory.create<Raytracer::Object>("object");
-    if (!newObject)
-      throw ParseError("Failed to create object from factory.");
     if (!object.exists("obj_file"))
       throw ParseError(std::string("Object file not found at ") +
                        object.getPath());
-    parseObj(object.lookup("obj_file").operator std::string(), *newObject);
-    sc.addShape(newObject);
+    objFiles[i] = object.lookup("obj_file").operator std::string();
+  }
+  loadMeshes(objFiles);
+  for (const auto &objFile : objFiles)
+    for (const auto &source : _meshCache->getSources(objFile))
+      _dependencies->add(source);
+
+  for (int i = 0; i < objectsSetting.getLength(); i++) {
+    const libconfig::Setting &object = objectsSetting[i];
+    auto newInstance =
+        newPrimitive(SceneCache::Primitive::Instance, object);
+    newInstance.mesh = static_cast<std::uint32_t>(_meshFiles.size());
+    _meshFiles.push_back(objFiles[i]);
+
+    // Optional options
+    if (object.exists("scale")) {
+      Math::Vector3D scale = parseVector3D(object["scale"]);
+      if (scale.x == 0 || scale.y == 0 || scale.z == 0)
+        throw ParseError(std::string("Object scale must be non-zero at ") +
+                         object.getPath());
+      newInstance.scale = scale;
+      newInstance.flags |= SceneCache::Primitive::Scaled;
+    }
+    parseOptions(object, newInstance);
+    addPrimitive(sc, newInstance);
   }
 }
 
@@ -699,9 +1001,6 @@ void Raytracer::ParserConfigFile::parseTriangles(
     Raytracer::ShapeComposite &sc, const libconfig::Setting &trianglesSetting) {
   for (int i = 0; i < trianglesSetting.getLength(); i++) {
     const libconfig::Setting &triangle = trianglesSetting[i];
-    auto newTriangle = _factory.create<Raytracer::Triangle>("triangle");
-    if (!newTriangle)
-      throw ParseError("Failed to create triangle object from factory.");
     if (!triangle.exists("p1"))
       throw ParseError(std::string("Triangle p1 not found at ") +
                        triangle.getPath());
@@ -715,37 +1014,16 @@ void Raytracer::ParserConfigFile::parseTriangles(
       throw ParseError(std::string("Triangle color not found at ") +
                        triangle.getPath());
 
-    newTriangle->setP1(parsePoint3D(triangle["p1"]));
-    newTriangle->setP2(parsePoint3D(triangle["p2"]));
-    newTriangle->setP3(parsePoint3D(triangle["p3"]));
-    newTriangle->setColor(parseColor(triangle["color"]));
+    auto newTriangle =
+        newPrimitive(SceneCache::Primitive::Triangle, triangle);
+    newTriangle.center = parsePoint3D(triangle["p1"]);
+    newTriangle.p2 = parsePoint3D(triangle["p2"]);
+    newTriangle.p3 = parsePoint3D(triangle["p3"]);
+    newTriangle.color = parseColor(triangle["color"]);
 
     // Optional options
-    if (triangle.exists("translate")) {
-      Math::Vector3D translation = parseVector3D(triangle["translate"]);
-      newTriangle->translate(translation);
-    }
-
-    if (triangle.exists("rotate")) {
-      parseRotation(triangle["rotate"], newTriangle);
-    }
-    if (triangle.exists("material")) {
-      std::string materialName = parseString(triangle["material"]);
-      if (materialName == "reflective") {
-        newTriangle->setMaterial(
-            _factory.create<Raytracer::Reflections>("reflection"));
-      } else if (materialName == "refractive") {
-        newTriangle->setMaterial(
-            _factory.create<Raytracer::Refractions>("refraction"));
-      } else if (materialName == "transparent") {
-        newTriangle->setMaterial(
-            _factory.create<Raytracer::Transparency>("transparent"));
-      } else {
-        throw ParseError(std::string("[ERROR] - Unknown material type: ") +
-                         materialName);
-      }
-    }
-    sc.addShape(newTriangle);
+    parseOptions(triangle, newTriangle);
+    addPrimitive(sc, newTriangle);
   }
 }
 
@@ -817,7 +1095,7 @@ void Raytracer::ParserConfigFile::parsePrimitives(
     // OBJECTS
     if (root.exists("primitives") && root["primitives"].exists("objects")) {
       static const std::unordered_set<std::string> allowedSettings = {
-          "obj_file"};
+          "obj_file", "translate", "rotate", "scale"};
       checkSettings(root["primitives"]["objects"], allowedSettings);
       parseObjects(sc, root["primitives"]["objects"]);
     }
@@ -852,21 +1130,16 @@ void Raytracer::ParserConfigFile::parsePrimitives(
 void Raytracer::ParserConfigFile::parseAmbientLight(
     Raytracer::LightComposite &lc, const libconfig::Setting &ambientInfo) {
   const libconfig::Setting &colorInfo = ambientInfo["color"];
-  auto newAmbient = _factory.create<AmbientLight>("ambient");
-  if (newAmbient == nullptr)
-    throw ParseError("Failed to create ambient light object from factory.");
+  SceneCache::Light newAmbient = newLight(SceneCache::Light::Ambient,
+                                          ambientInfo);
 
-  Math::Vector3D color = parseColor(colorInfo);
-  double intensity = ambientInfo.lookup("intensity");
-  if (intensity < 0 || intensity > 1)
+  newAmbient.color = parseColor(colorInfo);
+  newAmbient.intensity = ambientInfo.lookup("intensity");
+  if (newAmbient.intensity < 0 || newAmbient.intensity > 1)
     throw ParseError(
         std::string("Ambient light intensity out of range [0, 1] at ") +
         ambientInfo.getPath());
-
-  newAmbient->setColor(color);
-  newAmbient->setIntensity(intensity);
-  newAmbient->setType("AmbientLight");
-  lc.addLight(newAmbient);
+  addLightEntry(lc, newAmbient);
 }
 
 /**
@@ -885,22 +1158,17 @@ void Raytracer::ParserConfigFile::parsePointLight(
   for (int i = 0; i < pointInfo.getLength(); i++) {
     const libconfig::Setting &point = pointInfo[i];
     const libconfig::Setting &colorInfo = point["color"];
-    auto newPoint = _factory.create<Raytracer::PointLight>("point");
-    if (newPoint == nullptr)
-      throw ParseError("Failed to create point light object from factory.");
-    Math::Point3D position = parsePoint3D(point);
-    Math::Vector3D color = parseColor(colorInfo);
+    SceneCache::Light newPoint = newLight(SceneCache::Light::Point, point);
+    newPoint.position = parsePoint3D(point);
+    newPoint.color = parseColor(colorInfo);
     double intensity = point.lookup("intensity");
     if (intensity < 0) {
       throw ParseError(
           "Failed to set intensity. Intensity must be over 0 but it was : " +
           std::to_string(intensity));
     }
-    newPoint->setIntensity(intensity);
-    newPoint->setPosition(position);
-    newPoint->setColor(color);
-    newPoint->setType("PointLight");
-    lc.addLight(newPoint);
+    newPoint.intensity = intensity;
+    addLightEntry(lc, newPoint);
   }
 }
 
@@ -922,6 +1190,8 @@ void Raytracer::ParserConfigFile::parseDiffuseLight(
         std::string("Diffuse light multiplier out of range [0, 1] at ") +
         diffuseInfo.getPath());
 
+  _hasDiffuse = true;
+  _diffuse = diffuseMultiplier;
   lc.setDiffuse(diffuseMultiplier);
 }
 
@@ -939,16 +1209,12 @@ void Raytracer::ParserConfigFile::parseDirectionalLights(
     Raytracer::LightComposite &lc, const libconfig::Setting &lightsSetting) {
   for (int i = 0; i < lightsSetting.getLength(); i++) {
     const libconfig::Setting &directional = lightsSetting[i];
-    auto newDirectional =
-        _factory.create<Raytracer::DirectionalLight>("directional");
-    if (newDirectional == nullptr)
-      throw ParseError(
-          "Failed to create directional light object from factory.");
+    SceneCache::Light newDirectional =
+        newLight(SceneCache::Light::Directional, directional);
     Math::Vector3D direction = parseVector3D(directional);
 
-    newDirectional->setDirection(direction.normalize());
-    newDirectional->setType("DirectionalLight");
-    lc.addLight(newDirectional);
+    newDirectional.direction = direction.normalize();
+    addLightEntry(lc, newDirectional);
   }
 }
 
@@ -1047,10 +1313,13 @@ void Raytracer::ParserConfigFile::checkSettings(
 /**
  * @brief Parses scene import settings from the configuration.
  *
- * Looks for a "scenes" group and a "scenesPaths" list within it. For each path
- * specified, it creates a new ParserConfigFile instance to parse the imported
- * scene. It maintains a set of already parsed files (_fileAlreadyParse) to
- * detect and prevent import loops.
+ * Looks for a "scenes" group and a "scenesPaths" list within it. The whole
+ * import graph is read first by collectScenes(), which maintains the set of
+ * already parsed files (_fileAlreadyParse) to detect import loops. The
+ * imported scenes are then parsed concurrently on the TaskPool, each into
+ * its own composites, and merged in import order so that the result does
+ * not depend on scheduling. Their primitives and lights are appended to the
+ * flattened scene in the same order.
  * @param sc The ShapeComposite to populate from imported scenes.
  * @param lc The LightComposite to populate from imported scenes.
  * @param root The root libconfig setting of the configuration file.
@@ -1060,40 +1329,99 @@ void Raytracer::ParserConfigFile::checkSettings(
 void Raytracer::ParserConfigFile::parseScenes(ShapeComposite &sc,
                                               LightComposite &lc,
                                               const libconfig::Setting &root) {
-  if (root.exists("scenes")) {
-    static const std::unordered_set<std::string> allowedSettings = {
-        "scenesPaths"};
-    checkSettings(root["scenes"], allowedSettings);
-    const libconfig::Setting &scenes = root["scenes"]["scenesPaths"];
-    for (const auto &scene : scenes) {
-      std::string path = scene.lookup("path");
-      for (const auto &alreadyParsed : _fileAlreadyParse) {
-        if (alreadyParsed == path) {
-          throw ParseError("Import loop detected. File \"" + path +
-                           "\" is already imported into the current scene.");
-        }
-      }
-      _fileAlreadyParse.insert(path);
-      ParserConfigFile parser(path, _plugins);
-      parser._fileAlreadyParse = _fileAlreadyParse;
-      parser.parseConfigFile(sc, lc);
+  std::vector<std::unique_ptr<ParserConfigFile>> scenes;
+  collectScenes(root, scenes);
+  if (scenes.empty())
+    return;
+
+  std::vector<ShapeComposite> shapes(scenes.size());
+  std::vector<LightComposite> lights(scenes.size());
+  TaskPool::global().parallelFor(scenes.size(), [&](std::size_t i) {
+    scenes[i]->parseContent(shapes[i], lights[i], scenes[i]->_cfg.getRoot());
+  });
+
+  for (std::size_t i = 0; i < scenes.size(); i++) {
+    for (const auto &shape : shapes[i].getShapes())
+      sc.addShape(shape);
+    for (const auto &light : lights[i].getLights())
+      lc.addLight(light);
+    if (scenes[i]->_hasDiffuse) {
+      _hasDiffuse = true;
+      _diffuse = scenes[i]->_diffuse;
+      lc.setDiffuse(_diffuse);
     }
+    auto meshOffset = static_cast<std::uint32_t>(_meshFiles.size());
+    for (SceneCache::Primitive primitive : scenes[i]->_primitives) {
+      if (primitive.kind == SceneCache::Primitive::Instance)
+        primitive.mesh += meshOffset;
+      _primitives.push_back(primitive);
+    }
+    _meshFiles.insert(_meshFiles.end(), scenes[i]->_meshFiles.begin(),
+                      scenes[i]->_meshFiles.end());
+    _lights.insert(_lights.end(), scenes[i]->_lights.begin(),
+                   scenes[i]->_lights.end());
   }
 }
 
 /**
- * @brief Internal parsing function for primitives, lights, and scenes.
+ * @brief Reads every scene imported by a file, recursively.
  *
- * This function is a helper called by the public parseConfigFile methods.
- * It orchestrates the parsing of primitives, lights, and imported scenes.
+ * Scenes are listed depth-first, in the order they used to be parsed one
+ * after another, so that merging them in this order keeps the shapes and
+ * lights in the same order. A file imported again below itself or after a
+ * sibling that already imported it is reported as an import loop.
+ * @param root The root setting of the file.
+ * @param scenes Receives one parser per imported scene, with its plugins
+ * loaded and sharing the mesh cache and dependencies of this parser.
+ * @throws ParseError if an import loop is detected.
+ */
+void Raytracer::ParserConfigFile::collectScenes(
+    const libconfig::Setting &root,
+    std::vector<std::unique_ptr<ParserConfigFile>> &scenes) {
+  if (!root.exists("scenes"))
+    return;
+  static const std::unordered_set<std::string> allowedSettings = {
+      "scenesPaths"};
+  checkSettings(root["scenes"], allowedSettings);
+  const libconfig::Setting &paths = root["scenes"]["scenesPaths"];
+  for (const auto &scene : paths) {
+    std::string path = scene.lookup("path");
+    if (_fileAlreadyParse.contains(path)) {
+      throw ParseError("Import loop detected. File \"" + path +
+                       "\" is already imported into the current scene.");
+    }
+    _fileAlreadyParse.insert(path);
+    std::unique_ptr<ParserConfigFile> parser(
+        new ParserConfigFile(path, _plugins, _sceneCache));
+    parser->_fileAlreadyParse = _fileAlreadyParse;
+    parser->_meshCache = _meshCache;
+    parser->_dependencies = _dependencies;
+    parser->_buildLog = _buildLog;
+    parser->_buildQuality = _buildQuality;
+    parser->_previous = _previous;
+    parser->_current = _current;
+    parser->_factory.initFactories(_plugins);
+    _dependencies->add(path);
+
+    ParserConfigFile &imported = *parser;
+    scenes.push_back(std::move(parser));
+    imported.collectScenes(imported._cfg.getRoot(), scenes);
+  }
+}
+
+/**
+ * @brief Parses the primitives and lights of a file, without its imports.
+ *
+ * Only touches this parser and the composites it is given, so the imported
+ * scenes can be parsed concurrently.
  * @param sc The ShapeComposite to populate.
  * @param lc The LightComposite to populate.
  * @param root The root libconfig setting of the configuration file.
- * @throws RaytracerError or libconfig::ConfigException if any parsing step
- * fails.
+ * @throws RaytracerError if any parsing step fails.
  */
-void Raytracer::ParserConfigFile::parseInternal(
+void Raytracer::ParserConfigFile::parseContent(
     ShapeComposite &sc, LightComposite &lc, const libconfig::Setting &root) {
+  Trace::Scope scope("parse content", "parse", _currentFilePath);
   // PRIMITIVES
   try {
     parsePrimitives(sc, root);
@@ -1115,6 +1443,22 @@ void Raytracer::ParserConfigFile::parseInternal(
         std::string("General libconfig error during lights parsing: ") +
         cfgex.what());
   }
+}
+
+/**
+ * @brief Internal parsing function for primitives, lights, and scenes.
+ *
+ * This function is a helper called by the public parseConfigFile methods.
+ * It orchestrates the parsing of primitives, lights, and imported scenes.
+ * @param sc The ShapeComposite to populate.
+ * @param lc The LightComposite to populate.
+ * @param root The root libconfig setting of the configuration file.
+ * @throws RaytracerError or libconfig::ConfigException if any parsing step
+ * fails.
+ */
+void Raytracer::ParserConfigFile::parseInternal(
+    ShapeComposite &sc, LightComposite &lc, const libconfig::Setting &root) {
+  parseContent(sc, lc, root);
 
   try {
     parseScenes(sc, lc, root);
@@ -1134,6 +1478,14 @@ void Raytracer::ParserConfigFile::parseInternal(
  * This is the main entry point for parsing a configuration file when a Camera
  * object also needs to be configured. It initializes the factory with plugins,
  * then parses the camera, primitives, lights, and any imported scenes.
+ *
+ * When none of the files of the scene changed since the scene cache was
+ * written, the scene is created from the cache instead, see loadScene().
+ * Otherwise meshes that are not in the mesh cache yet are still read from
+ * the scene cache when their own files did not change, and the scene cache
+ * is written again for the next start-up if the scene was parsed with the
+ * SAH preset. The time spent building mesh BVHs is logged once for the
+ * whole scene.
  * @param camera The Camera object to populate.
  * @param sc The ShapeComposite to populate.
  * @param lc The LightComposite to populate.
@@ -1143,8 +1495,15 @@ void Raytracer::ParserConfigFile::parseInternal(
 void Raytracer::ParserConfigFile::parseConfigFile(Camera &camera,
                                                   ShapeComposite &sc,
                                                   LightComposite &lc) {
+  Trace::Scope scope("parse scene", "parse", _currentFilePath);
   const libconfig::Setting &root = _cfg.getRoot();
   _factory.initFactories(_plugins);
+  if (const SceneCache::Scene *scene = _sceneCache->getScene()) {
+    loadScene(*scene, &camera, sc, lc);
+    saveScene(*scene);
+    return;
+  }
+  _dependencies->add(_currentFilePath);
 
   // CAMERA
   try {
@@ -1158,6 +1517,69 @@ void Raytracer::ParserConfigFile::parseConfigFile(Camera &camera,
   }
 
   parseInternal(sc, lc, root);
+
+  if (_buildLog->meshes > 0)
+    std::cout << "[BVH] - scene " << _currentFilePath << ": "
+              << _buildLog->meshes << " meshes, " << _buildLog->triangles
+              << " triangles in " << _buildLog->ms << " ms" << std::endl;
+  if (_buildQuality == BVH::QualitySah)
+    _sceneCache->markDirty();
+  SceneCache::Scene scene;
+  scene.camera = _view;
+  scene.hasDiffuse = _hasDiffuse;
+  scene.diffuse = _diffuse;
+  scene.files = getDependencies();
+  scene.meshes = _meshFiles;
+  scene.primitives = std::move(_primitives);
+  scene.lights = std::move(_lights);
+  saveScene(scene);
+}
+
+/**
+ * @brief Creates a scene flattened by a previous parse.
+ *
+ * The meshes are loaded first, in parallel, then the shapes and lights are
+ * created in the order the parser created them, so the result is the one
+ * parsing the files would give.
+ * @param scene The flattened scene.
+ * @param camera The Camera object to populate, nullptr to skip it.
+ * @param sc The ShapeComposite to populate.
+ * @param lc The LightComposite to populate.
+ * @throws RaytracerError if a plugin fails to create an object or a mesh
+ * cannot be loaded.
+ */
+void Raytracer::ParserConfigFile::loadScene(const SceneCache::Scene &scene,
+                                            Camera *camera, ShapeComposite &sc,
+                                            LightComposite &lc) {
+  Trace::Scope scope("load cached scene", "parse", _currentFilePath);
+  _meshFiles = scene.meshes;
+  if (camera)
+    setCamera(*camera, scene.camera);
+  loadMeshes(_meshFiles);
+  for (const auto &primitive : scene.primitives)
+    createPrimitive(sc, primitive);
+  for (const auto &light : scene.lights)
+    createLight(lc, light);
+  if (scene.hasDiffuse)
+    lc.setDiffuse(scene.diffuse);
+  for (const auto &file : scene.files)
+    _dependencies->add(file);
+}
+
+/**
+ * @brief Writes the scene cache again if the scene or one of its meshes
+ * had to be read from its files.
+ *
+ * @param scene The flattened scene.
+ */
+void Raytracer::ParserConfigFile::saveScene(const SceneCache::Scene &scene) {
+  if (!_sceneCache->isDirty())
+    return;
+  try {
+    SceneCache::save(_currentFilePath, scene, *_meshCache);
+  } catch (const std::runtime_error &e) {
+    std::cerr << "[WARNING] - " << e.what() << std::endl;
+  }
 }
 
 /**
@@ -1177,6 +1599,10 @@ void Raytracer::ParserConfigFile::parseConfigFile(ShapeComposite &sc,
                                                   LightComposite &lc) {
   const libconfig::Setting &root = _cfg.getRoot();
   _factory.initFactories(_plugins);
+  if (const SceneCache::Scene *scene = _sceneCache->getScene()) {
+    loadScene(*scene, nullptr, sc, lc);
+    return;
+  }
 
   parseInternal(sc, lc, root);
 }
@@ -1,13 +1,20 @@
 #pragma once
 
 #include <libconfig.h++>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_set>
 #include "Camera.hpp"
 #include "Factory.hpp"
 #include "LightComposite.hpp"
+#include "MeshCache.hpp"
 #include "Object.hpp"
+#include "SceneCache.hpp"
+#include "SceneIndex.hpp"
 #include "ShapeComposite.hpp"
+#include "exceptions/RaytracerException.hpp"
 #include "string"
 
 namespace Raytracer {
@@ -24,7 +31,8 @@ namespace Raytracer {
   class ParserConfigFile {
     public:
       /**
-       * @brief Constructor for ParserConfigFile.
+       * @brief Constructor for ParserConfigFile. The file is not read when
+       * its scene cache holds the whole scene and none of its files changed.
        * @param filename The path to the configuration file to parse.
        * @param plugins A list of plugin paths (used by the factory).
        * @throws ParseError if the filename does not end with ".cfg".
@@ -41,7 +49,9 @@ namespace Raytracer {
 
       /**
        * @brief Main parsing function.
-       * Parses camera, primitives, lights, and scenes from the config file.
+       * Parses camera, primitives, lights, and scenes from the config file,
+       * or creates them from the compiled scene cache when none of their
+       * files changed. The cache is rewritten otherwise.
        * @param camera Reference to the Camera object to populate.
        * @param sc Reference to the ShapeComposite object to populate.
        * @param lc Reference to the LightComposite object to populate.
@@ -79,6 +89,8 @@ namespace Raytracer {
       void parseLights(LightComposite &, const libconfig::Setting &);
       /**
        * @brief Parses scene import directives from a libconfig setting.
+       * The whole import graph is resolved first, then the imported scenes
+       * are parsed concurrently and merged in import order.
        * @param sc Reference to the ShapeComposite object to populate from
        * imported scenes.
        * @param lc Reference to the LightComposite object to populate from
@@ -94,12 +106,81 @@ namespace Raytracer {
        * @brief Parses an OBJ file and populates an Object instance.
        * @param obj_file The path to the .obj file.
        * @param object Reference to the Object to populate.
-       * @throws std::runtime_error if TinyObjLoader encounters an error or
-       * fails to load the file.
+       * @return std::vector<std::string> The files the mesh was built from:
+       * the OBJ file and its material libraries.
+       * @throws std::runtime_error if the file cannot be read or is
+       * malformed.
        */
-      void parseObj(const std::string &obj_file, Object &object);
+      std::vector<std::string> parseObj(const std::string &obj_file,
+                                        Object &object);
+
+      /**
+       * @brief Shares a mesh cache with this parser, typically one kept
+       * between reloads so that unchanged meshes are not loaded again.
+       * @param meshCache The mesh cache.
+       */
+      void setMeshCache(std::shared_ptr<MeshCache> meshCache) {
+        _meshCache = std::move(meshCache);
+      }
+
+      /**
+       * @brief Sets the preset of the BVHs built over meshes loaded from
+       * their OBJ files.
+       * @param quality BVH::QualityFast for quick reloads, BVH::QualitySah
+       * (the default) for final renders. Only SAH-built meshes are written
+       * to the scene cache.
+       */
+      void setBuildQuality(BVH::Quality quality) {
+        _buildQuality = quality;
+      }
+
+      /**
+       * @brief Gives the index of the live scene, whose shapes and lights
+       * are reused when their setting did not change.
+       *
+       * The parser takes the objects it reuses out of a copy of the index,
+       * so the live one is left whole if the parse fails and the next
+       * reload can still reuse everything.
+       * @param previous The index returned by getSceneIndex() after the
+       * previous parse.
+       */
+      void setPreviousScene(const std::shared_ptr<SceneIndex> &previous) {
+        _previous = previous ? std::make_shared<SceneIndex>(*previous)
+                             : nullptr;
+      }
+
+      /**
+       * @brief Gets the index of the shapes and lights parsed so far.
+       * @return std::shared_ptr<SceneIndex> The index, to pass to
+       * setPreviousScene() on the next reload.
+       */
+      std::shared_ptr<SceneIndex> getSceneIndex() const {
+        return _current;
+      }
+
+      /**
+       * @brief Gets the files the scene was built from: the configuration
+       * files, imported scenes, OBJ files and their material libraries.
+       * @return std::vector<std::string> The files, possibly repeated.
+       */
+      std::vector<std::string> getDependencies() const {
+        std::lock_guard<std::mutex> lock(_dependencies->mutex);
+        return _dependencies->files;
+      }
 
     private:
+      /**
+       * @brief Constructor for the parser of an imported scene.
+       * @param filename The path to the configuration file to parse.
+       * @param plugins A list of plugin paths (used by the factory).
+       * @param sceneCache The scene cache of the top-level scene.
+       * @throws ParseError if the filename does not end with ".cfg".
+       * @throws ConfigError if the file cannot be read or parsed.
+       */
+      ParserConfigFile(const std::string &filename,
+                       const std::vector<std::string> &plugins,
+                       std::shared_ptr<SceneCache> sceneCache);
+
       libconfig::Config _cfg;             ///< libconfig Config object.
       std::vector<std::string> _plugins;  ///< List of plugin paths.
       std::unordered_set<std::string>
@@ -109,6 +190,208 @@ namespace Raytracer {
           Factory();  ///< Factory for creating shapes and materials.
       std::string _currentFilePath;  ///< Path of the currently parsed
                                      ///< configuration file.
+      std::shared_ptr<MeshCache> _meshCache =
+          std::make_shared<MeshCache>();  ///< Meshes shared with imported
+                                          ///< scenes.
+      /**
+       * @brief Files a scene is built from, recorded by parsers that may
+       * run concurrently.
+       */
+      struct Dependencies {
+        std::mutex mutex;                ///< Guards files.
+        std::vector<std::string> files;  ///< Recorded files, in order.
+
+        /**
+         * @brief Records a file.
+         * @param file The path of the file.
+         */
+        void add(const std::string &file) {
+          std::lock_guard<std::mutex> lock(mutex);
+          files.push_back(file);
+        }
+      };
+      std::shared_ptr<Dependencies> _dependencies =
+          std::make_shared<Dependencies>();  ///< Files the scene is built
+                                             ///< from.
+      /**
+       * @brief Time spent building mesh BVHs, summed over the parsers of a
+       * scene that may run concurrently.
+       */
+      struct BuildLog {
+        std::mutex mutex;           ///< Guards the totals.
+        std::size_t meshes = 0;     ///< Meshes built.
+        std::size_t triangles = 0;  ///< Triangles in them.
+        double ms = 0.0;            ///< Build time in milliseconds.
+
+        /**
+         * @brief Records the build of one mesh.
+         * @param meshTriangles The triangles of the mesh.
+         * @param meshMs The build time in milliseconds.
+         */
+        void add(std::size_t meshTriangles, double meshMs) {
+          std::lock_guard<std::mutex> lock(mutex);
+          meshes++;
+          triangles += meshTriangles;
+          ms += meshMs;
+        }
+      };
+      std::shared_ptr<BuildLog> _buildLog =
+          std::make_shared<BuildLog>();  ///< Mesh BVH builds of the scene.
+      BVH::Quality _buildQuality =
+          BVH::QualitySah;  ///< Preset of the mesh BVHs.
+      std::shared_ptr<SceneCache>
+          _sceneCache;  ///< Compiled scene of the top-level scene.
+      std::shared_ptr<SceneIndex>
+          _previous;  ///< Live scene to reuse objects from, if reloading.
+      std::shared_ptr<SceneIndex> _current =
+          std::make_shared<SceneIndex>();  ///< Objects parsed so far.
+      SceneCache::View _view{};  ///< Camera of the flattened scene.
+      bool _hasDiffuse = false;  ///< Whether a parsed file sets diffuse.
+      double _diffuse = 0.0;     ///< Last diffuse multiplier parsed.
+      std::vector<SceneCache::Primitive>
+          _primitives;  ///< Primitives parsed so far, with the imports'.
+      std::vector<SceneCache::Light>
+          _lights;  ///< Lights parsed so far, with the imports'.
+      std::vector<std::string>
+          _meshFiles;  ///< OBJ files of the instances in _primitives.
+
+      /**
+       * @brief Creates a shape from its plugin.
+       * @tparam T The type of the shape.
+       * @param name The name of the plugin.
+       * @return std::shared_ptr<T> The new shape.
+       * @throws ParseError if the plugin fails to create it.
+       */
+      template <typename T>
+      std::shared_ptr<T> createShape(const std::string &name) {
+        auto shape = _factory.create<T>(name);
+        if (!shape)
+          throw ParseError("Failed to create " + name +
+                           " object from factory.");
+        return shape;
+      }
+
+      /**
+       * @brief Hashes a setting and everything below it.
+       * @param setting The libconfig setting.
+       * @return std::uint64_t The signature of the setting.
+       */
+      static std::uint64_t hashSetting(const libconfig::Setting &setting);
+
+      /**
+       * @brief Adds a created shape to a composite, or the live shape
+       * created from an identical setting when reloading.
+       * @param sc ShapeComposite to add the shape to.
+       * @param shape The freshly created shape.
+       * @param signature The signature of the setting it was created from.
+       */
+      void addShape(ShapeComposite &sc, std::shared_ptr<IShape> shape,
+                    std::uint64_t signature);
+
+      /**
+       * @brief Adds a created light to a composite, or the live light
+       * created from an identical setting when reloading.
+       * @param lc LightComposite to add the light to.
+       * @param light The freshly created light.
+       * @param signature The signature of the setting it was created from.
+       */
+      void addLight(LightComposite &lc, std::shared_ptr<ILight> light,
+                    std::uint64_t signature);
+
+      /**
+       * @brief Starts the record of a primitive read from a setting.
+       * @param kind The SceneCache::Primitive::Kind of the primitive.
+       * @param setting The setting.
+       * @return SceneCache::Primitive The zeroed record.
+       */
+      static SceneCache::Primitive newPrimitive(
+          std::uint32_t kind, const libconfig::Setting &setting);
+
+      /**
+       * @brief Starts the record of a light read from a setting.
+       * @param kind The SceneCache::Light::Kind of the light.
+       * @param setting The setting.
+       * @return SceneCache::Light The zeroed record.
+       */
+      static SceneCache::Light newLight(std::uint32_t kind,
+                                        const libconfig::Setting &setting);
+
+      /**
+       * @brief Records a parsed primitive in the flattened scene and creates
+       * its shape.
+       * @param sc ShapeComposite to add the shape to.
+       * @param primitive The primitive.
+       */
+      void addPrimitive(ShapeComposite &sc,
+                        const SceneCache::Primitive &primitive);
+
+      /**
+       * @brief Records a parsed light in the flattened scene and creates it.
+       * @param lc LightComposite to add the light to.
+       * @param light The light.
+       */
+      void addLightEntry(LightComposite &lc, const SceneCache::Light &light);
+
+      /**
+       * @brief Creates the material of a primitive.
+       * @param material The SceneCache::Primitive::Material.
+       * @return std::shared_ptr<IMaterials> The material, nullptr for none.
+       */
+      std::shared_ptr<IMaterials> createMaterial(std::uint32_t material);
+
+      /**
+       * @brief Creates the shape of a primitive and adds it to a composite.
+       * @param sc ShapeComposite to add the shape to.
+       * @param primitive The primitive.
+       * @throws ParseError if a plugin fails to create the shape.
+       */
+      void createPrimitive(ShapeComposite &sc,
+                           const SceneCache::Primitive &primitive);
+
+      /**
+       * @brief Creates a light and adds it to a composite.
+       * @param lc LightComposite to add the light to.
+       * @param light The light.
+       * @throws ParseError if a plugin fails to create the light.
+       */
+      void createLight(LightComposite &lc, const SceneCache::Light &light);
+
+      /**
+       * @brief Gets the shared mesh of an OBJ file, from the mesh cache, the
+       * scene cache or the file itself. Safe to call from several threads.
+       * @param objFile The path of the OBJ file.
+       * @return std::shared_ptr<const Object> The mesh.
+       */
+      std::shared_ptr<const Object> acquireMesh(const std::string &objFile);
+
+      /**
+       * @brief Loads meshes ahead of their instances, in parallel.
+       * @param objFiles The paths of the OBJ files.
+       */
+      void loadMeshes(const std::vector<std::string> &objFiles);
+
+      /**
+       * @brief Creates a scene flattened by a previous parse.
+       * @param scene The flattened scene.
+       * @param camera The Camera to populate, nullptr to skip it.
+       * @param sc ShapeComposite to populate.
+       * @param lc LightComposite to populate.
+       */
+      void loadScene(const SceneCache::Scene &scene, Camera *camera,
+                     ShapeComposite &sc, LightComposite &lc);
+
+      /**
+       * @brief Writes the scene cache if it is dirty.
+       * @param scene The flattened scene.
+       */
+      void saveScene(const SceneCache::Scene &scene);
+
+      /**
+       * @brief Applies the camera of a flattened scene.
+       * @param camera The Camera to populate.
+       * @param view The camera of the scene.
+       */
+      static void setCamera(Camera &camera, const SceneCache::View &view);
 
       /**
        * @brief Parses (x, y, z) coordinates from a libconfig setting.
@@ -134,11 +417,21 @@ namespace Raytracer {
       /**
        * @brief Parses a rotation (axis and angle) from a libconfig setting.
        * @param setting The libconfig setting.
-       * @return std::tuple<Math::Vector3D, float> The parsed rotation axis and
-       * angle.
+       * @param primitive The primitive to record the rotation in.
+       * @throws ParseError if the axis or the angle is missing.
        */
       static void parseRotation(const libconfig::Setting &setting,
-                                std::shared_ptr<IShape> shape);
+                                SceneCache::Primitive &primitive);
+
+      /**
+       * @brief Parses the optional translation, rotation and material of a
+       * primitive.
+       * @param setting The libconfig setting of the primitive.
+       * @param primitive The primitive to record them in.
+       * @throws ParseError if one of them is invalid.
+       */
+      static void parseOptions(const libconfig::Setting &setting,
+                               SceneCache::Primitive &primitive);
 
       /**
        * @brief Parses a color (r, g, b) from a libconfig setting.
@@ -169,12 +462,26 @@ namespace Raytracer {
                          const libconfig::Setting &);
 
       /**
-       * @brief Parses an MTL file associated with an OBJ file. (Currently not
-       * fully implemented within this snippet)
-       * @param mtl_file The path to the .mtl file.
-       * @param object Reference to the Object to populate with material data.
+       * @brief Parses the primitives and lights of this file only, without
+       * its imported scenes.
+       * @param sc ShapeComposite to populate.
+       * @param lc LightComposite to populate.
+       * @param setting The root libconfig setting.
        */
-      void parseMtl(const std::string &mtl_file, Object &object);
+      void parseContent(ShapeComposite &, LightComposite &,
+                        const libconfig::Setting &);
+
+      /**
+       * @brief Reads every scene imported by a file, recursively, and checks
+       * for import loops.
+       * @param setting The root libconfig setting of the file.
+       * @param scenes Receives one ready-to-parse parser per imported scene,
+       * in the order the scenes would be parsed one after another.
+       * @throws ParseError if an import loop is detected.
+       */
+      void collectScenes(
+          const libconfig::Setting &setting,
+          std::vector<std::unique_ptr<ParserConfigFile>> &scenes);
 
       /**
        * @brief Parses sphere definitions from a libconfig setting.
@@ -221,6 +528,8 @@ namespace Raytracer {
                        const libconfig::Setting &planesSetting);
       /**
        * @brief Parses object (OBJ file) definitions from a libconfig setting.
+       * Each object becomes an Instance of a mesh shared through the
+       * MeshCache, with its own translate/rotate/scale.
        * @param sc ShapeComposite to add objects to.
        * @param objectsSetting The libconfig setting for objects.
        */
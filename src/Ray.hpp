@@ -1,28 +1,69 @@
 #pragma once
 
+#include <limits>
 #include "Point3D.hpp"
 #include "Vector3D.hpp"
 
 namespace Raytracer {
 
+  class RayStats;
+
   /**
    * @brief Represents a ray in 3D space, defined by an origin and a direction.
    *
    * A ray is typically used for ray casting and ray tracing algorithms to determine
    * intersections with objects in a scene. The ray is parameterized as P(t) = origin + t * direction.
+   * Only the hits with tMin < t < tMax count: ShapeComposite lowers tMax to
+   * the closest hit found so far, so that shapes can give up on farther
+   * candidates early.
    */
   class Ray {
     public:
+      /**
+       * @brief Why a ray is traced, used to break render statistics down.
+       */
+      enum Kind {
+        Primary,   ///< Cast from the camera through a pixel.
+        Shadow,    ///< Cast from a hit point towards a light.
+        Secondary, ///< Reflected, refracted or transmitted by a material.
+        KindCount  ///< Number of kinds.
+      };
+
+      /**
+       * @brief tMin of the rays leaving a surface (shadows, reflections,
+       * refractions), so that rounding errors do not make them hit the
+       * surface they start from.
+       */
+      static constexpr double surfaceOffset = 0.001;
+
       Math::Point3D origin;    ///< The origin point of the ray.
       Math::Vector3D direction; ///< The direction vector of the ray (should ideally be normalized).
+      Kind kind;               ///< Why the ray is traced.
+      double tMin;             ///< Hits at or before this distance are ignored.
+      double tMax;             ///< Hits at or past this distance are ignored.
+      /**
+       * @brief Counters of the tracing thread, set by ShapeComposite.
+       * Declared whether or not RAYTRACER_STATS is defined, so that plugins
+       * built either way see the same layout; left null without it.
+       */
+      RayStats *stats = nullptr;
 
       /**
        * @brief Constructs a Ray object with a specified origin and direction.
        * @param origin The starting point of the ray.
        * @param direction The direction vector of the ray.
+       * @param kind Why the ray is traced.
+       * @param tMin The start of the interval of valid hits.
+       * @param tMax The end of the interval of valid hits.
        */
-      Ray(const Math::Point3D &origin, const Math::Vector3D &direction)
-          : origin(origin), direction(direction) {
+      Ray(const Math::Point3D &origin, const Math::Vector3D &direction,
+          Kind kind = Primary, double tMin = 0.0,
+          double tMax = std::numeric_limits<double>::infinity())
+          : origin(origin),
+            direction(direction),
+            kind(kind),
+            tMin(tMin),
+            tMax(tMax) {
       }
 
       /**
@@ -30,7 +71,21 @@ namespace Raytracer {
        * Initializes the ray with origin at (0,0,0) and direction vector (0,0,0).
        * Note: A zero direction vector is generally not valid for a ray.
        */
-      Ray() : origin(Math::Point3D()), direction(Math::Vector3D()) {
+      Ray()
+          : origin(Math::Point3D()),
+            direction(Math::Vector3D()),
+            kind(Primary),
+            tMin(0.0),
+            tMax(std::numeric_limits<double>::infinity()) {
+      }
+
+      /**
+       * @brief Checks whether a distance is within the interval of the ray.
+       * @param t The distance along the ray.
+       * @return true if tMin < t < tMax.
+       */
+      bool contains(double t) const {
+        return t > tMin && t < tMax;
       }
 
       /**
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include "Ray.hpp"
+
+namespace Raytracer {
+
+  class IShape;
+
+  /**
+   * @brief A block of rays traced together, one array per coordinate so
+   * that SIMD intersectors load four rays at once.
+   *
+   * Primary rays through a 4x4 block of pixels leave from the same point in
+   * almost the same direction: they cross the same BVH nodes and hit the
+   * same primitives, so tracing them together shares node fetches, stack
+   * operations and virtual calls between them. Every ray keeps its own
+   * interval and closest hit: tMax shrinks as hits are found, like the tMax
+   * of a single Ray. Functions taking a packet also take a mask of the rays
+   * to trace, bit i standing for ray i.
+   */
+  struct RayPacket {
+    static constexpr int side = 4;           ///< Pixels per side of a block.
+    static constexpr int size = side * side; ///< Rays per packet.
+
+    alignas(16) float originX[size]; ///< Origin x of each ray.
+    alignas(16) float originY[size]; ///< Origin y of each ray.
+    alignas(16) float originZ[size]; ///< Origin z of each ray.
+    alignas(16) float dirX[size];    ///< Direction x of each ray.
+    alignas(16) float dirY[size];    ///< Direction y of each ray.
+    alignas(16) float dirZ[size];    ///< Direction z of each ray.
+    alignas(16) float tMin[size];    ///< Start of the interval of each ray.
+    alignas(16) float tMax[size];    ///< Closest hit so far, or end of the interval.
+    Math::Vector3D color[size];      ///< Colour of the closest hit.
+    const IShape *shape[size];       ///< Shape of the closest hit, nullptr if none.
+    Ray::Kind kind = Ray::Primary;   ///< Why the rays are traced.
+    /**
+     * @brief Counters of the tracing thread, set by ShapeComposite.
+     * Declared in every build, like Ray::stats, and left null without
+     * RAYTRACER_STATS.
+     */
+    RayStats *stats = nullptr;
+
+    /**
+     * @brief Sets ray i and clears its hit.
+     * @param i The index of the ray.
+     * @param ray The ray, whose interval is kept.
+     */
+    void set(int i, const Ray &ray) {
+      set(i, ray.origin, ray.direction, ray.tMin, ray.tMax);
+    }
+
+    /**
+     * @brief Sets ray i and clears its hit.
+     * @param i The index of the ray.
+     * @param origin The origin of the ray.
+     * @param direction The direction of the ray.
+     * @param start The start of the interval of valid hits.
+     * @param end The end of the interval of valid hits.
+     */
+    void set(int i, const Math::Point3D &origin,
+             const Math::Vector3D &direction, double start, double end) {
+      originX[i] = origin.x;
+      originY[i] = origin.y;
+      originZ[i] = origin.z;
+      dirX[i] = direction.x;
+      dirY[i] = direction.y;
+      dirZ[i] = direction.z;
+      tMin[i] = static_cast<float>(start);
+      tMax[i] = static_cast<float>(end);
+      shape[i] = nullptr;
+    }
+
+    /**
+     * @brief Gets ray i as a single ray, its interval ending at the closest
+     * hit found so far.
+     * @param i The index of the ray.
+     * @return Ray The ray.
+     */
+    Ray ray(int i) const {
+      Ray r(Math::Point3D(originX[i], originY[i], originZ[i]),
+            Math::Vector3D(dirX[i], dirY[i], dirZ[i]), kind, tMin[i],
+            tMax[i]);
+      r.stats = stats;
+      return r;
+    }
+
+    /**
+     * @brief Keeps a hit of ray i if it is closer than the current one.
+     * @param i The index of the ray.
+     * @param t The distance of the hit.
+     * @param hitColor The colour of the hit.
+     * @param hitShape The shape hit, nullptr for a miss.
+     * @return true if the hit was kept.
+     */
+    bool record(int i, double t, const Math::Vector3D &hitColor,
+                const IShape *hitShape) {
+      if (!hitShape || t <= tMin[i] || t >= tMax[i])
+        return false;
+      tMax[i] = static_cast<float>(t);
+      color[i] = hitColor;
+      shape[i] = hitShape;
+      return true;
+    }
+  };
+
+}  // namespace Raytracer
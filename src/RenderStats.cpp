@@ -0,0 +1,72 @@
+#include "RenderStats.hpp"
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+  std::atomic<Raytracer::RayStats *> threads{nullptr}; ///< Registry head.
+
+}  // namespace
+
+/**
+ * @brief Gets the counters of the calling thread.
+ *
+ * On first use, the counters are created and pushed on the registry with a
+ * compare-and-swap; they are never freed so that total() can walk the list
+ * without locking.
+ * @return Raytracer::RayStats& The counters of the thread.
+ */
+Raytracer::RayStats &Raytracer::RenderStats::local() {
+  thread_local RayStats *stats = [] {
+    auto *created = new RayStats();
+    RayStats *head = threads.load(std::memory_order_relaxed);
+    do {
+      created->_next = head;
+    } while (!threads.compare_exchange_weak(head, created,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed));
+    return created;
+  }();
+  return *stats;
+}
+
+/**
+ * @brief Sums the counters of every thread.
+ *
+ * Counters are read while their threads may still be writing them, so a
+ * total taken during a frame is only approximately consistent across
+ * counters; one taken after the frame is exact.
+ * @return Raytracer::RenderStats::Snapshot The totals.
+ */
+Raytracer::RenderStats::Snapshot Raytracer::RenderStats::total() {
+  Snapshot snapshot;
+
+  for (RayStats *stats = threads.load(std::memory_order_acquire); stats;
+       stats = stats->_next) {
+    for (std::size_t i = 0; i < snapshot.values.size(); i++)
+      snapshot.values[i] += stats->_values[i].load(std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+/**
+ * @brief Formats the statistics of a frame on one line.
+ *
+ * @param frame The work done during the frame.
+ * @param ms The duration of the frame in milliseconds.
+ * @return std::string The counters and rays per second.
+ */
+std::string Raytracer::RenderStats::format(const Snapshot &frame, double ms) {
+  std::ostringstream out;
+  double rays = static_cast<double>(frame.rays());
+
+  out << std::fixed << std::setprecision(1) << ms << " ms, "
+      << std::setprecision(2) << (ms > 0 ? rays / ms / 1000.0 : 0.0)
+      << " Mrays/s | primary " << frame[RayStats::PrimaryRays] << ", shadow "
+      << frame[RayStats::ShadowRays] << ", secondary "
+      << frame[RayStats::SecondaryRays] << " | shape tests "
+      << frame[RayStats::ShapeTests] << ", triangle tests "
+      << frame[RayStats::TriangleTests] << ", BVH nodes "
+      << frame[RayStats::BvhNodes];
+  return out.str();
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "Ray.hpp"
+
+namespace Raytracer {
+
+  /**
+   * @brief Counters of the work done by one thread while rendering.
+   *
+   * Only the owning thread writes them, with relaxed load/store pairs rather
+   * than atomic read-modify-writes, so counting costs about as much as
+   * incrementing a plain integer; other threads may read them at any time.
+   * Shapes tested through a ShapeComposite find the counters of the current
+   * thread in Ray::stats, which lets plugins count without sharing any
+   * symbol with the executable.
+   *
+   * Counting only happens in builds with RAYTRACER_STATS defined (the
+   * ENABLE_STATS CMake option); otherwise every hook compiles out.
+   */
+  class RayStats {
+    public:
+      /**
+       * @brief What is counted. The ray counters follow Ray::Kind.
+       */
+      enum Counter {
+        PrimaryRays,   ///< Rays cast from the camera.
+        ShadowRays,    ///< Rays cast towards lights.
+        SecondaryRays, ///< Reflected, refracted or transmitted rays.
+        ShapeTests,    ///< Shapes tested by a ShapeComposite.
+        TriangleTests, ///< Mesh triangles tested.
+        BvhNodes,      ///< BVH nodes visited, at both levels.
+        CounterCount   ///< Number of counters.
+      };
+
+      /**
+       * @brief Adds to a counter. Must be called by the owning thread.
+       * @param counter The counter.
+       * @param count The amount to add.
+       */
+      void add(Counter counter, std::uint64_t count = 1) {
+        std::atomic<std::uint64_t> &value = _values[counter];
+        value.store(value.load(std::memory_order_relaxed) + count,
+                    std::memory_order_relaxed);
+      }
+
+      /**
+       * @brief Reads a counter, from any thread.
+       * @param counter The counter.
+       * @return std::uint64_t Its value.
+       */
+      std::uint64_t get(Counter counter) const {
+        return _values[counter].load(std::memory_order_relaxed);
+      }
+
+    private:
+      friend class RenderStats;
+
+      std::array<std::atomic<std::uint64_t>, CounterCount>
+          _values{};              ///< Counter values.
+      RayStats *_next = nullptr;  ///< Next thread in the registry.
+  };
+
+  static_assert(static_cast<int>(RayStats::PrimaryRays) == Ray::Primary &&
+                    static_cast<int>(RayStats::ShadowRays) == Ray::Shadow &&
+                    static_cast<int>(RayStats::SecondaryRays) ==
+                        Ray::Secondary,
+                "Ray counters are indexed by Ray::Kind");
+
+  /**
+   * @brief Registry of the counters of every thread.
+   *
+   * Each thread gets its counters on first use; they are pushed on a
+   * lock-free list and never freed, so totals survive the thread. Frame
+   * statistics are the difference between two totals, which is why nothing
+   * ever needs to be reset while threads are counting.
+   */
+  class RenderStats {
+    public:
+#ifdef RAYTRACER_STATS
+      static constexpr bool enabled = true;  ///< Whether anything is counted.
+#else
+      static constexpr bool enabled = false; ///< Whether anything is counted.
+#endif
+
+      /**
+       * @brief Sum of the counters of every thread at one point in time.
+       */
+      struct Snapshot {
+        std::array<std::uint64_t, RayStats::CounterCount>
+            values{};  ///< Counter values.
+
+        /**
+         * @brief Gets a counter.
+         * @param counter The counter.
+         * @return std::uint64_t Its value.
+         */
+        std::uint64_t operator[](RayStats::Counter counter) const {
+          return values[counter];
+        }
+
+        /**
+         * @brief Gets the work done between two snapshots.
+         * @param since The earlier snapshot.
+         * @return Snapshot The difference of every counter.
+         */
+        Snapshot operator-(const Snapshot &since) const {
+          Snapshot diff;
+          for (std::size_t i = 0; i < values.size(); i++)
+            diff.values[i] = values[i] - since.values[i];
+          return diff;
+        }
+
+        /**
+         * @brief Gets the number of rays of every kind.
+         * @return std::uint64_t The number of rays.
+         */
+        std::uint64_t rays() const {
+          return values[RayStats::PrimaryRays] +
+                 values[RayStats::ShadowRays] +
+                 values[RayStats::SecondaryRays];
+        }
+      };
+
+      /**
+       * @brief Gets the counters of the calling thread.
+       * @return RayStats& The counters, registered on first use.
+       */
+      static RayStats &local();
+
+      /**
+       * @brief Sums the counters of every thread, without locking.
+       * @return Snapshot The totals since the start of the program.
+       */
+      static Snapshot total();
+
+      /**
+       * @brief Formats the statistics of a frame on one line.
+       * @param frame The work done during the frame.
+       * @param ms The duration of the frame in milliseconds.
+       * @return std::string The counters and rays per second.
+       */
+      static std::string format(const Snapshot &frame, double ms);
+  };
+
+}  // namespace Raytracer
@@ -1,42 +1,326 @@
 #include "Renderer.hpp"
 #include <dlfcn.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
 #include <memory>
 #include "Camera.hpp"
+#include "Factory.hpp"
 #include "ParserConfigFile.hpp"
 #include "Ray.hpp"
 #include "ShapeComposite.hpp"
+#include "TaskPool.hpp"
+#include "Trace.hpp"
+#include "exceptions/RaytracerException.hpp"
+
+namespace {
+
+  constexpr std::array<const char *, Raytracer::Renderer::HeatmapCount>
+      heatmapNames = {"off", "time", "tests", "bounces"};
+  constexpr std::array<const char *, Raytracer::Renderer::StageCount>
+      stageNames = {"generate", "extend", "shadow", "shade"};
+
+  /**
+   * @brief Adds the time spent in its scope to a stage of the wavefront
+   * pipeline, and records the scope as a trace event.
+   */
+  class StageTimer {
+    public:
+      /**
+       * @brief Starts timing.
+       * @param stage The stage.
+       * @param ms The total time of the stage, grown when the timer ends.
+       */
+      StageTimer(Raytracer::Renderer::Stage stage, double &ms)
+          : _scope(stageNames[stage], "wavefront"),
+            _ms(ms),
+            _start(std::chrono::steady_clock::now()) {
+      }
+
+      ~StageTimer() {
+        _ms += std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - _start).count();
+      }
+
+      StageTimer(const StageTimer &) = delete;
+      StageTimer &operator=(const StageTimer &) = delete;
+
+    private:
+      Raytracer::Trace::Scope _scope;
+      double &_ms;
+      std::chrono::steady_clock::time_point _start;
+  };
+
+  /**
+   * @brief Runs `fn(chunk, begin, end)` over chunks of packets, in parallel
+   * on the task pool.
+   * @param packets The number of packets.
+   * @param chunkSize The number of packets per chunk.
+   * @param fn Callable as fn(std::size_t, std::size_t, std::size_t).
+   */
+  template <typename Fn>
+  void forEachChunk(std::size_t packets, std::size_t chunkSize, Fn &&fn) {
+    std::size_t chunks = (packets + chunkSize - 1) / chunkSize;
+    if (chunks == 0)
+      return;
+    Raytracer::TaskPool::global().parallelFor(chunks, [&](std::size_t chunk) {
+      std::size_t begin = chunk * chunkSize;
+      fn(chunk, begin, std::min(begin + chunkSize, packets));
+    });
+  }
+
+  /**
+   * @brief Maps a cost to a false colour.
+   * @param t The cost, 0 for the cheapest pixel and 1 for the most expensive.
+   * @return sf::Color Blue, cyan, green, yellow then red as t grows.
+   */
+  sf::Color heatColor(double t) {
+    static constexpr std::array<std::array<double, 3>, 5> ramp = {{
+        {0, 0, 255}, {0, 255, 255}, {0, 255, 0}, {255, 255, 0}, {255, 0, 0}}};
+    t = std::clamp(t, 0.0, 1.0) * (ramp.size() - 1);
+    std::size_t i = std::min(static_cast<std::size_t>(t), ramp.size() - 2);
+    double f = t - i;
+    auto mix = [&](int c) {
+      return static_cast<sf::Uint8>(ramp[i][c] +
+                                    (ramp[i + 1][c] - ramp[i][c]) * f);
+    };
+    return sf::Color(mix(0), mix(1), mix(2));
+  }
+
+  /**
+   * @brief Gets the colour of the sky in a direction.
+   * @param direction The unit direction of a ray that hit nothing.
+   * @return Math::Vector3D White towards the horizon, blue upwards.
+   */
+  Math::Vector3D skyColor(const Math::Vector3D &direction) {
+    double a = 0.5 * (direction.y + 1.0);
+    return Math::Vector3D(1.0, 1.0, 1.0) * (1.0 - a) +
+           Math::Vector3D(0.5, 0.7, 1.0) * a;
+  }
+
+  /**
+   * @brief Tells whether a colour is black, such as the weight of a material
+   * that has no secondary ray to trace.
+   * @param color The colour.
+   * @return true if every component is 0.
+   */
+  bool isBlack(const Math::Vector3D &color) {
+    return color.x == 0 && color.y == 0 && color.z == 0;
+  }
+
+  /**
+   * @brief Tells whether a pixel belongs to the subset re-traced by a
+   * reprojected frame.
+   *
+   * A 4x4 Bayer matrix spreads the 16 subsets evenly over the image, so that
+   * every pixel is traced again at least once every 16 frames.
+   * @param x The column of the pixel.
+   * @param y The row of the pixel.
+   * @param frame The index of the frame.
+   * @return true if the pixel is refreshed during this frame.
+   */
+  bool isRefreshed(int x, int y, unsigned frame) {
+    static constexpr int bayer[4][4] = {
+        {0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+    return static_cast<unsigned>(bayer[y & 3][x & 3]) == frame % 16;
+  }
+
+  /**
+   * @brief Tells whether a reprojected pixel lies behind one of its 3x3
+   * neighbours.
+   *
+   * A surface uncovered by the camera motion shows through the gaps between
+   * the reprojected points of the closer surface in front of it, leaving a
+   * fringe of stale background along its edges. A pixel whose neighbour is
+   * much closer is likely such a gap.
+   * @param depths The reprojected depth of each pixel, 0 where empty.
+   * @param width The width of the image.
+   * @param height The height of the image.
+   * @param x The column of the pixel.
+   * @param y The row of the pixel.
+   * @return true if a neighbour is closer than 0.9 times the pixel depth.
+   */
+  bool isBehindNeighbour(const std::vector<float> &depths, int width,
+                         int height, int x, int y) {
+    float limit = depths[static_cast<std::size_t>(y) * width + x] * 0.9f;
+    for (int j = std::max(y - 1, 0); j <= std::min(y + 1, height - 1); j++) {
+      for (int i = std::max(x - 1, 0); i <= std::min(x + 1, width - 1); i++) {
+        float depth = depths[static_cast<std::size_t>(j) * width + i];
+        if (depth > 0.0f && depth < limit)
+          return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Projects a point onto the image plane of a camera.
+   * @param cam The camera, with its view up to date.
+   * @param point The point.
+   * @param x Receives the column of the pixel the point falls in.
+   * @param y Receives the row of the pixel the point falls in.
+   * @return false if the point is behind the camera.
+   */
+  bool project(const Raytracer::Camera &cam, const Math::Point3D &point,
+               double &x, double &y) {
+    const Math::Vector3D &du = cam.getPixelDeltaU();
+    const Math::Vector3D &dv = cam.getPixelDeltaV();
+    Math::Vector3D normal = Math::cross(du, dv);
+    Math::Vector3D toPlane = cam.getPixel0Location() - cam.origin;
+    Math::Vector3D toPoint = point - cam.origin;
+    double along = toPoint.dot(normal);
+    if (along * toPlane.dot(normal) <= 0.0)
+      return false;
+    Math::Point3D onPlane = cam.origin + toPoint * (toPlane.dot(normal) / along);
+    Math::Vector3D offset = onPlane - cam.getPixel0Location();
+    x = offset.dot(du) / du.dot(du);
+    y = offset.dot(dv) / dv.dot(dv);
+    return true;
+  }
+
+}  // namespace
+
+/**
+ * @brief Gets the name of a heatmap mode.
+ *
+ * @param heatmap The mode.
+ * @return const char* Its name, as accepted by parseHeatmap().
+ */
+const char *Raytracer::Renderer::heatmapName(Heatmap heatmap) {
+  return heatmapNames[heatmap];
+}
+
+/**
+ * @brief Parses the name of a heatmap mode.
+ *
+ * @param name The name of the mode.
+ * @return Raytracer::Renderer::Heatmap The mode.
+ * @throw RaytracerError if the name is unknown, or if the mode counts
+ * intersection tests or rays and the build has no statistics.
+ */
+Raytracer::Renderer::Heatmap Raytracer::Renderer::parseHeatmap(
+    const std::string &name) {
+  for (int i = 0; i < HeatmapCount; i++) {
+    if (name != heatmapNames[i])
+      continue;
+    if (!RenderStats::enabled && i != HeatmapOff && i != HeatmapTime)
+      throw RaytracerError("Heatmap \"" + name +
+                           "\" needs a build with ENABLE_STATS");
+    return static_cast<Heatmap>(i);
+  }
+  throw RaytracerError("Unknown heatmap \"" + name +
+                       "\", expected off, time, tests or bounces");
+}
+
+/**
+ * @brief Gets the name of a stage of the wavefront pipeline.
+ * @param stage The stage.
+ * @return const char* The name, as shown in traces and by render_bench.
+ */
+const char *Raytracer::Renderer::stageName(Stage stage) {
+  return stageNames[stage];
+}
 
 /**
  * @brief Calculates the color of a ray.
  *
+ * Normalizes the direction of the ray, finds its closest hit and shades it
+ * with shade().
  * @param r The ray to calculate the color for.
  * @param shape The composite shape in the scene.
  * @param light The composite light in the scene.
  * @param cameraPos The camera position.
  * @param depth The current recursion depth for reflections/refractions.
+ * @param surface Receives the distance, normal and colour of the surface the
+ * ray hit, a distance of 0 if it missed. May be nullptr.
  * @return Math::Vector3D The calculated color of the ray.
  */
 Math::Vector3D Raytracer::Renderer::rayColor(Ray &r,
                                              const ShapeComposite &shape,
                                              const LightComposite &light,
                                              const Camera &cameraPos,
-                                             int depth) {
-  Math::Vector3D unit_direction = r.direction.normalize();
-  double a = 0.5 * (unit_direction.y + 1.0);
-  Math::Vector3D sky(Math::Vector3D(1.0, 1.0, 1.0) * (1.0 - a) +
-                     Math::Vector3D(0.5, 0.7, 1.0) * a);
+                                             int depth, Surface *surface) {
+  r.direction.normalize();
   if (depth <= 0) {
-    return sky;
+    if (surface)
+      *surface = Surface();
+    return skyColor(r.direction);
   }
   auto [t, color, hitShape] = shape.hits(r);
+  return shade(r, t, color, hitShape, shape, light, cameraPos, depth,
+               surface);
+}
 
+/**
+ * @brief Calculates the color of a ray whose closest hit is known, from the
+ * lights and the material of the surface, or from the sky for a miss.
+ *
+ * @param r The ray, with a unit direction.
+ * @param t The distance of the hit, 0 for a miss.
+ * @param color The colour of the surface hit.
+ * @param hitShape The shape hit, nullptr for a miss.
+ * @param shape The composite shape in the scene.
+ * @param light The composite light in the scene.
+ * @param cameraPos The camera position.
+ * @param depth The current recursion depth for reflections/refractions.
+ * @param surface Receives the distance, normal and colour of the surface the
+ * ray hit, a distance of 0 if it missed. May be nullptr.
+ * @param bounce If not nullptr, receives the secondary ray of the material
+ * instead of tracing it, the color returned being then the part that does
+ * not depend on it; its weight is zero when there is no ray to trace, and
+ * for the materials of plugins without a MaterialAbi, which trace it at once.
+ * @param occluded If not nullptr, whether the shadow ray of each light of
+ * LightComposite::getShadingOrder() hit a shape, so that they are not traced
+ * again.
+ * @return Math::Vector3D The calculated color of the ray.
+ */
+Math::Vector3D Raytracer::Renderer::shade(Ray &r, double t,
+                                          const Math::Vector3D &color,
+                                          const IShape *hitShape,
+                                          const ShapeComposite &shape,
+                                          const LightComposite &light,
+                                          const Camera &cameraPos, int depth,
+                                          Surface *surface,
+                                          IMaterials::Scatter *bounce,
+                                          const unsigned char *occluded) {
+  if (surface)
+    *surface = Surface();
+  if (bounce)
+    bounce->weight = Math::Vector3D(0, 0, 0);
   if (t > 0.0 && hitShape) {
     Math::Point3D hitPoint = r.at(t);
     Math::Vector3D normal = hitShape->getNormal(hitPoint);
+    if (surface)
+      *surface = {t, normal, color};
     Math::Vector3D viewDir = (cameraPos.origin - hitPoint).normalized();
     Math::Vector3D computeColor =
-        light.computeLighting(normal, color, hitPoint, viewDir, shape);
+        occluded ? light.computeLighting(normal, color, hitPoint, viewDir,
+                                         occluded, shape)
+                 : light.computeLighting(normal, color, hitPoint, viewDir,
+                                         shape);
     if (auto material = hitShape->getMaterial()) {
+      const MaterialAbi *abi = Factory::getMaterialAbi(*material);
+      if (!hasMaterialEntry(abi, 1, MaterialScatter) || !abi->scatter) {
+        Math::Vector3D result = material->computeMaterial(
+            normal, viewDir, hitPoint, computeColor,
+            LegacyShapes(shape, Ray::Secondary), light, cameraPos, depth - 1,
+            [this, &shape](Raytracer::Ray &r, const Raytracer::ShapeComposite &,
+                           const Raytracer::LightComposite &l,
+                           const Raytracer::Camera &c, int d) {
+              Ray ray(r.origin, r.direction, Ray::Secondary);
+              return this->rayColor(ray, shape, l, c, d);
+            });
+        if (bounce)
+          bounce->base = result;
+        return result;
+      }
+      if (bounce) {
+        if (!abi->scatter(material.get(), &normal, &viewDir, &hitPoint,
+                          &computeColor, depth - 1, bounce))
+          bounce->weight = Math::Vector3D(0, 0, 0);
+        return bounce->base;
+      }
       return material->computeMaterial(
           normal, viewDir, hitPoint, computeColor, shape, light, cameraPos,
           depth - 1,
@@ -46,51 +330,739 @@ Math::Vector3D Raytracer::Renderer::rayColor(Ray &r,
     }
     return computeColor;
   }
-  return sky;
+  return skyColor(r.direction);
 }
 
 /**
- * @brief Initializes the scene by parsing the configuration file.
+ * @brief Initializes the scene by parsing the configuration file, then
+ * builds the top-level BVH over the parsed shapes.
  *
  * @param camera The camera object to be initialized.
  */
 void Raytracer::Renderer::initScene(Camera &camera) {
   ParserConfigFile parser(_inputFilePath, _plugins);
+  parser.setMeshCache(_meshCache);
+  parser.setBuildQuality(_buildQuality);
   parser.parseConfigFile(camera, _shapes, _lights);
+  _sceneIndex = parser.getSceneIndex();
+  _dependencies = parser.getDependencies();
+  _shapes.build();
+}
+
+/**
+ * @brief Parses the configuration file again and updates the scene in place.
+ *
+ * Meshes whose files changed are evicted first. The parser then reuses every
+ * live shape and light whose setting is unchanged, so the new shape list only
+ * differs from the live one where the file was edited: those slots are
+ * swapped and the top-level BVH refitted. Meshes no longer used by any shape
+ * are released once the previous scene is gone. Meshes loaded again get
+ * the fast BVH preset, so that an edited OBJ file shows up quickly.
+ * @param camera The camera object to be configured.
+ * @return std::size_t The number of shapes that changed.
+ */
+std::size_t Raytracer::Renderer::reload(Camera &camera) {
+  Trace::Scope scope("reload scene", "load", _inputFilePath);
+  std::size_t changed = 0;
+
+  _meshCache->evictStale();
+  {
+    ParserConfigFile parser(_inputFilePath, _plugins);
+    ShapeComposite shapes;
+    LightComposite lights;
+
+    parser.setMeshCache(_meshCache);
+    parser.setBuildQuality(BVH::QualityFast);
+    parser.setPreviousScene(_sceneIndex);
+    parser.parseConfigFile(camera, shapes, lights);
+    changed = _shapes.update(shapes.getShapes());
+    _lights = std::move(lights);
+    _sceneIndex = parser.getSceneIndex();
+    _dependencies = parser.getDependencies();
+  }
+  _meshCache->prune();
+  _hasHistory = false;
+  return changed;
 }
 
 /**
  * @brief Renders the scene to a framebuffer.
  *
+ * The scene is traced on a grid of scale times the resolution on each axis,
+ * split in tiles rendered in parallel, then upscaled to the framebuffer by
+ * present(). Frames that do not draw a heatmap are kept for
+ * renderReprojected(), whatever their scale. The
+ * work done and the time taken are kept for getFrameStats() and
+ * getFrameMs(). In a heatmap mode, the cost of every sample is measured
+ * around its primary ray, and the image is replaced by drawHeatmap().
  * @param framebuffer The framebuffer to render to.
  * @param cam The camera used for rendering.
- * @param isHighQuality Whether to render in high quality or not.
+ * @param scale The fraction of the resolution traced, 1 for every pixel.
  */
 void Raytracer::Renderer::renderToBuffer(std::vector<sf::Color> &framebuffer,
                                          Raytracer::Camera &cam,
-                                         bool isHighQuality) {
+                                         double scale) {
+  scale = std::clamp(scale, 0.0, 1.0);
+  Trace::Scope frame("frame", "render", "scale " + std::to_string(scale));
+  auto start = std::chrono::steady_clock::now();
+  RenderStats::Snapshot before = RenderStats::total();
   cam.updateView();
 
-  int step = isHighQuality ? 1 : 5;
-
-  for (double j = 0; j < _height; j += step) {
-    for (double i = 0; i < _width; i += step) {
-      Math::Point3D pixel_center =
-          cam.getPixel0Location() +
-          cam.getPixelDeltaU() * static_cast<float>(i) +
-          cam.getPixelDeltaV() * static_cast<float>(j);
-      Math::Vector3D ray_direction = (pixel_center - cam.origin).normalize();
-      Raytracer::Ray ray(cam.origin, ray_direction);
-      Math::Vector3D color = rayColor(ray, _shapes, _lights, cam, _maxDepth);
-      sf::Color pixel_color(static_cast<sf::Uint8>(color.x * 255),
-                            static_cast<sf::Uint8>(color.y * 255),
-                            static_cast<sf::Uint8>(color.z * 255));
-      int endY = j + step;
-      int endX = i + step;
-      for (int blockY = j; blockY < endY; blockY++) {
-        for (int blockX = i; blockX < endX; blockX++)
-          framebuffer[blockY * _width + blockX] = pixel_color;
+  _samplesWidth = std::max(1, static_cast<int>(std::lround(_width * scale)));
+  _samplesHeight =
+      std::max(1, static_cast<int>(std::lround(_height * scale)));
+  _samples.resize(static_cast<std::size_t>(_samplesWidth) * _samplesHeight);
+  _depths.resize(_samples.size());
+  _positions.resize(_samples.size());
+  _normals.resize(_samples.size());
+  _albedo.resize(_samples.size());
+  if (_heatmap != HeatmapOff)
+    _cost.assign(_samples.size(), 0.0);
+
+  renderTiles(cam, start, nullptr);
+  _hasHistory = _heatmap == HeatmapOff;
+  _reused = 0.0;
+  if (_heatmap != HeatmapOff)
+    drawHeatmap(framebuffer);
+  else
+    present(framebuffer);
+  _frameStats = RenderStats::total() - before;
+  _frameMs = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Renders the scene reusing the previous frame where possible.
+ *
+ * The frame is traced on a grid of scale times the resolution, like
+ * renderToBuffer(), so that it can be combined with the dynamic
+ * resolution. Every surface point seen by the previous frame, whatever its
+ * scale, is projected into the new view and kept if it is the closest one
+ * landing on its sample. The samples left empty (disocclusions, the borders
+ * uncovered by a rotation, the sky) are traced, as well as the samples
+ * lying behind a much closer neighbour, where the background shows through
+ * the gaps of a nearer surface, and a different sixteenth of the grid every
+ * frame so that view-dependent shading and reprojection errors do not
+ * linger. The grid is then upscaled by present(). Falls back to
+ * renderToBuffer() when there is no frame to reuse.
+ * @param framebuffer The framebuffer to render to.
+ * @param cam The camera used for rendering.
+ * @param scale The fraction of the resolution traced on each axis.
+ */
+void Raytracer::Renderer::renderReprojected(
+    std::vector<sf::Color> &framebuffer, Raytracer::Camera &cam,
+    double scale) {
+  if (!_hasHistory || _heatmap != HeatmapOff) {
+    renderToBuffer(framebuffer, cam, scale);
+    return;
+  }
+  scale = std::clamp(scale, 0.0, 1.0);
+  Trace::Scope frame("frame", "render",
+                     "reprojected, scale " + std::to_string(scale));
+  auto start = std::chrono::steady_clock::now();
+  RenderStats::Snapshot before = RenderStats::total();
+  cam.updateView();
+
+  _samplesWidth = std::max(1, static_cast<int>(std::lround(_width * scale)));
+  _samplesHeight =
+      std::max(1, static_cast<int>(std::lround(_height * scale)));
+  std::size_t count = static_cast<std::size_t>(_samplesWidth) * _samplesHeight;
+  double toSampleX = static_cast<double>(_samplesWidth) / _width;
+  double toSampleY = static_cast<double>(_samplesHeight) / _height;
+  std::vector<Math::Vector3D> samples(count);
+  std::vector<float> depths(count, 0.0f);
+  std::vector<Math::Point3D> positions(count);
+  std::vector<Math::Vector3D> normals(count);
+  std::vector<Math::Vector3D> albedo(count);
+  {
+    Trace::Scope scope("reproject", "render");
+    for (std::size_t k = 0; k < _samples.size(); k++) {
+      if (_depths[k] <= 0.0f)
+        continue;
+      double x = 0;
+      double y = 0;
+      if (!project(cam, _positions[k], x, y))
+        continue;
+      long i = std::lround((x + 0.5) * toSampleX - 0.5);
+      long j = std::lround((y + 0.5) * toSampleY - 0.5);
+      if (i < 0 || j < 0 || i >= _samplesWidth || j >= _samplesHeight)
+        continue;
+      std::size_t index = static_cast<std::size_t>(j) * _samplesWidth + i;
+      float depth = static_cast<float>((_positions[k] - cam.origin).length());
+      if (depths[index] > 0.0f && depths[index] <= depth)
+        continue;
+      samples[index] = _samples[k];
+      depths[index] = depth;
+      positions[index] = _positions[k];
+      normals[index] = _normals[k];
+      albedo[index] = _albedo[k];
+    }
+  }
+  _samples = std::move(samples);
+  _depths = std::move(depths);
+  _positions = std::move(positions);
+  _normals = std::move(normals);
+  _albedo = std::move(albedo);
+
+  std::vector<unsigned char> retrace(_samples.size());
+  std::size_t traced = 0;
+  for (int j = 0; j < _samplesHeight; j++) {
+    for (int i = 0; i < _samplesWidth; i++) {
+      std::size_t index = static_cast<std::size_t>(j) * _samplesWidth + i;
+      retrace[index] =
+          _depths[index] <= 0.0f || isRefreshed(i, j, _frame) ||
+          isBehindNeighbour(_depths, _samplesWidth, _samplesHeight, i, j);
+      traced += retrace[index];
+    }
+  }
+  _frame++;
+  renderTiles(cam, start, &retrace);
+  _reused = 1.0 - static_cast<double>(traced) / _samples.size();
+  present(framebuffer);
+  _frameStats = RenderStats::total() - before;
+  _frameMs = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Traces the tiles of the sample grid in parallel on the task pool.
+ *
+ * The calling thread renders tiles too while it waits. Frames of the
+ * wavefront pipeline are handed to renderWavefront() instead, unless they
+ * draw a heatmap.
+ * @param cam The camera, already updated for the frame.
+ * @param start The start of the frame, origin of the time heatmap.
+ * @param retrace Which samples to trace, every one if nullptr.
+ */
+void Raytracer::Renderer::renderTiles(
+    const Camera &cam, std::chrono::steady_clock::time_point start,
+    const std::vector<unsigned char> *retrace) {
+  _stageMs.fill(0.0);
+  if (_wavefront && _heatmap == HeatmapOff) {
+    renderWavefront(cam, retrace);
+    return;
+  }
+  int tilesX = (_samplesWidth + tileSize - 1) / tileSize;
+  int tilesY = (_samplesHeight + tileSize - 1) / tileSize;
+  TaskPool::global().parallelFor(
+      static_cast<std::size_t>(tilesX) * tilesY, [&](std::size_t tile) {
+        int x = static_cast<int>(tile % tilesX) * tileSize;
+        int y = static_cast<int>(tile / tilesX) * tileSize;
+        Trace::Scope scope("tile", "render",
+                           std::to_string(x) + "," + std::to_string(y));
+        renderTile(cam, x, y, start, retrace);
+      });
+}
+
+/**
+ * @brief Traces one tile of the sample grid.
+ *
+ * Every tile writes its own samples only, so tiles can be rendered by
+ * several threads at once. Sample (i, j) is traced through the point of the
+ * image it stands for, which is pixel (i, j) itself at full resolution. Its
+ * color and the surface hit (distance, point, normal and albedo) are kept
+ * for the reprojection of the next frame and for the denoiser.
+ *
+ * The tile is walked in 4x4 blocks. The primary rays of a block are traced
+ * as one packet, then shaded one by one, their reflections and refractions
+ * being queued and traced by traceBounces() once the whole tile is done;
+ * blocks with only a few samples to
+ * trace (the edges of a reprojected frame) and heatmap frames, which measure
+ * every sample, trace them one at a time.
+ * @param cam The camera, already updated for the frame.
+ * @param x0 The left column of the tile in the sample grid.
+ * @param y0 The top row of the tile in the sample grid.
+ * @param start The start of the frame, origin of the time heatmap.
+ * @param retrace Which samples to trace, every one if nullptr.
+ */
+void Raytracer::Renderer::renderTile(
+    const Camera &cam, int x0, int y0,
+    std::chrono::steady_clock::time_point start,
+    const std::vector<unsigned char> *retrace) {
+#ifdef RAYTRACER_STATS
+  RayStats &stats = RenderStats::local();
+#endif
+  auto measure = [&]() -> double {
+    switch (_heatmap) {
+      case HeatmapTime:
+        return std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count();
+#ifdef RAYTRACER_STATS
+      case HeatmapTests:
+        return static_cast<double>(stats.get(RayStats::ShapeTests) +
+                                   stats.get(RayStats::TriangleTests));
+      case HeatmapBounces:
+        return static_cast<double>(stats.get(RayStats::SecondaryRays));
+#endif
+      default:
+        return 0.0;
+    }
+  };
+  double toPixelX = static_cast<double>(_width) / _samplesWidth;
+  double toPixelY = static_cast<double>(_height) / _samplesHeight;
+  int x1 = std::min(x0 + tileSize, _samplesWidth);
+  int y1 = std::min(y0 + tileSize, _samplesHeight);
+
+  auto primaryRay = [&](int i, int j) {
+    return cam.pixelRay((i + 0.5) * toPixelX - 0.5,
+                        (j + 0.5) * toPixelY - 0.5);
+  };
+  bool packets = _packets && _heatmap == HeatmapOff;
+  std::vector<Bounce> bounces;
+
+  for (int by = y0; by < y1; by += RayPacket::side) {
+    for (int bx = x0; bx < x1; bx += RayPacket::side) {
+      std::uint32_t mask = 0;
+      std::size_t indices[RayPacket::size];
+      for (int k = 0; k < RayPacket::size; k++) {
+        int i = bx + k % RayPacket::side;
+        int j = by + k / RayPacket::side;
+        if (i >= x1 || j >= y1)
+          continue;
+        indices[k] = static_cast<std::size_t>(j) * _samplesWidth + i;
+        if (!retrace || (*retrace)[indices[k]])
+          mask |= 1u << k;
+      }
+
+      if (packets && __builtin_popcount(mask) >= minPacketRays) {
+        RayPacket packet;
+        Raytracer::Ray rays[RayPacket::size];
+        for (std::uint32_t m = mask; m; m &= m - 1) {
+          int k = __builtin_ctz(m);
+          rays[k] = primaryRay(bx + k % RayPacket::side,
+                               by + k / RayPacket::side);
+          packet.set(k, rays[k]);
+        }
+        _shapes.hitsPacket(packet, mask);
+        for (std::uint32_t m = mask; m; m &= m - 1) {
+          int k = __builtin_ctz(m);
+          double t = packet.shape[k] ? packet.tMax[k] : 0.0;
+          Surface surface;
+          IMaterials::Scatter bounce;
+          Math::Vector3D color =
+              shade(rays[k], t, packet.color[k], packet.shape[k], _shapes,
+                    _lights, cam, _maxDepth, &surface, &bounce);
+          store(indices[k], rays[k], color, surface);
+          if (!isBlack(bounce.weight))
+            bounces.push_back({bounce.ray, bounce.weight, indices[k],
+                               _maxDepth - 2, 0});
+        }
+        continue;
+      }
+
+      for (std::uint32_t m = mask; m; m &= m - 1) {
+        int k = __builtin_ctz(m);
+        double costBefore = _heatmap != HeatmapOff ? measure() : 0.0;
+        Raytracer::Ray ray =
+            primaryRay(bx + k % RayPacket::side, by + k / RayPacket::side);
+        Surface surface;
+        Math::Vector3D color =
+            rayColor(ray, _shapes, _lights, cam, _maxDepth, &surface);
+        store(indices[k], ray, color, surface);
+        if (_heatmap != HeatmapOff)
+          _cost[indices[k]] = measure() - costBefore;
+      }
+    }
+  }
+  traceBounces(cam, bounces);
+}
+
+/**
+ * @brief Keeps the colour of a primary ray and the surface it hit, for the
+ * reprojection of the next frame and for the denoiser.
+ * @param index The sample of the ray.
+ * @param ray The ray.
+ * @param color Its colour.
+ * @param surface What it hit, a distance of 0 for a miss.
+ */
+void Raytracer::Renderer::store(std::size_t index, const Ray &ray,
+                                const Math::Vector3D &color,
+                                const Surface &surface) {
+  _samples[index] = color;
+  _depths[index] = static_cast<float>(surface.t);
+  _positions[index] = ray.at(surface.t);
+  _normals[index] = surface.normal;
+  _albedo[index] = surface.albedo;
+}
+
+/**
+ * @brief Sorts rays so that neighbours cross the same BVH nodes.
+ *
+ * The key is the octant of the direction, then the cell of the origin on a
+ * Z-order curve through the box of all the origins: rays leaving the same
+ * surface in the same general direction end up in the same packets.
+ * @param queue The rays, whose directions are normalized.
+ */
+void Raytracer::Renderer::sortBounces(std::vector<Bounce> &queue) {
+  Math::AABB origins;
+  for (auto &bounce : queue) {
+    bounce.ray.direction.normalize();
+    origins.expand(bounce.ray.origin);
+  }
+  for (auto &bounce : queue) {
+    const Math::Vector3D &d = bounce.ray.direction;
+    std::uint32_t octant = (d.x < 0) | (d.y < 0) << 1 | (d.z < 0) << 2;
+    bounce.key = octant << 30 | origins.mortonCode(bounce.ray.origin);
+  }
+  std::sort(queue.begin(), queue.end(),
+            [](const Bounce &a, const Bounce &b) { return a.key < b.key; });
+}
+
+/**
+ * @brief Traces the secondary rays of a tile, one bounce at a time.
+ *
+ * Reflected and refracted rays leave in scattered directions, so tracing
+ * each one right after the ray that spawned it jumps all over the BVH.
+ * Instead, the rays of a bounce are sorted by sortBounces() and traced in
+ * packets: neighbouring rays in the queue then cross the same nodes. Each
+ * hit adds the part of its colour that does not depend on the next bounce
+ * to the sample, scaled by the product of the weights of the materials
+ * along the path, and queues its own secondary ray for the next pass. The
+ * colours are the ones rayColor() computes recursively.
+ * @param cam The camera, already updated for the frame.
+ * @param queue The rays of the first bounce; emptied.
+ */
+void Raytracer::Renderer::traceBounces(const Camera &cam,
+                                       std::vector<Bounce> &queue) {
+  std::vector<Bounce> next;
+  while (!queue.empty()) {
+    sortBounces(queue);
+
+    for (std::size_t first = 0; first < queue.size();
+         first += RayPacket::size) {
+      int count = static_cast<int>(
+          std::min<std::size_t>(RayPacket::size, queue.size() - first));
+      RayPacket packet;
+      packet.kind = Ray::Secondary;
+      std::uint32_t mask = 0;
+      for (int k = 0; k < count; k++) {
+        Bounce &bounce = queue[first + k];
+        if (bounce.depth <= 0) {
+          _samples[bounce.index] +=
+              bounce.throughput * skyColor(bounce.ray.direction);
+          continue;
+        }
+        packet.set(k, bounce.ray);
+        mask |= 1u << k;
+      }
+      if (!mask)
+        continue;
+      _shapes.hitsPacket(packet, mask);
+      for (std::uint32_t m = mask; m; m &= m - 1) {
+        int k = __builtin_ctz(m);
+        Bounce &bounce = queue[first + k];
+        double t = packet.shape[k] ? packet.tMax[k] : 0.0;
+        IMaterials::Scatter scatter;
+        Math::Vector3D color =
+            shade(bounce.ray, t, packet.color[k], packet.shape[k], _shapes,
+                  _lights, cam, bounce.depth, nullptr, &scatter);
+        _samples[bounce.index] += bounce.throughput * color;
+        if (!isBlack(scatter.weight))
+          next.push_back({scatter.ray, bounce.throughput * scatter.weight,
+                          bounce.index, bounce.depth - 2, 0});
+      }
+    }
+    queue.swap(next);
+    next.clear();
+  }
+}
+
+/**
+ * @brief Traces the samples of the frame with the wavefront pipeline.
+ *
+ * The recursive path follows every sample through its primary ray, shadow
+ * rays and bounces before moving to the next, so the BVH nodes, shapes and
+ * materials each step needs keep evicting each other from the caches. Here
+ * the frame goes through in waves of waveBlocks 4x4 blocks of samples, and
+ * every stage runs over a whole wave, in parallel chunks of chunkPackets
+ * packets: generate(), then extend(), shadow() and shadeWave() until no
+ * bounce is left. Every stage works on the same queue of packets, whose
+ * rays are stored coordinate by coordinate, and its time is kept in
+ * _stageMs and recorded as a trace event. The colours are the ones of
+ * rayColor().
+ * @param cam The camera, already updated for the frame.
+ * @param retrace Which samples to trace, every one if nullptr.
+ */
+void Raytracer::Renderer::renderWavefront(
+    const Camera &cam, const std::vector<unsigned char> *retrace) {
+  std::size_t blocksX = (_samplesWidth + RayPacket::side - 1) / RayPacket::side;
+  std::size_t blocksY =
+      (_samplesHeight + RayPacket::side - 1) / RayPacket::side;
+  std::size_t blocks = blocksX * blocksY;
+  for (std::size_t first = 0; first < blocks; first += waveBlocks) {
+    generate(cam, first, std::min(waveBlocks, blocks - first), retrace);
+    int depth = _maxDepth;
+    for (bool primary = true; _wavePackets > 0; primary = false) {
+      if (depth > 0) {
+        extend();
+        shadow();
+      }
+      shadeWave(cam, depth, primary);
+      depth -= 2;
+    }
+  }
+}
+
+/**
+ * @brief Fills _wave with the primary rays of a range of 4x4 blocks of
+ * samples, one packet per block.
+ * @param cam The camera, already updated for the frame.
+ * @param firstBlock The first block, row by row.
+ * @param blocks The number of blocks.
+ * @param retrace Which samples to trace, every one if nullptr.
+ */
+void Raytracer::Renderer::generate(const Camera &cam, std::size_t firstBlock,
+                                   std::size_t blocks,
+                                   const std::vector<unsigned char> *retrace) {
+  StageTimer timer(StageGenerate, _stageMs[StageGenerate]);
+  std::size_t blocksX = (_samplesWidth + RayPacket::side - 1) / RayPacket::side;
+  double toPixelX = static_cast<double>(_width) / _samplesWidth;
+  double toPixelY = static_cast<double>(_height) / _samplesHeight;
+  _wavePackets = blocks;
+  if (_wave.size() < blocks)
+    _wave.resize(blocks);
+  forEachChunk(blocks, chunkPackets,
+               [&](std::size_t, std::size_t begin, std::size_t end) {
+    for (std::size_t p = begin; p < end; p++) {
+      WaveLanes &lanes = _wave[p];
+      int bx = static_cast<int>((firstBlock + p) % blocksX) * RayPacket::side;
+      int by = static_cast<int>((firstBlock + p) / blocksX) * RayPacket::side;
+      lanes.mask = 0;
+      lanes.rays.kind = Ray::Primary;
+      for (int k = 0; k < RayPacket::size; k++) {
+        int i = bx + k % RayPacket::side;
+        int j = by + k / RayPacket::side;
+        if (i >= _samplesWidth || j >= _samplesHeight)
+          continue;
+        std::size_t index = static_cast<std::size_t>(j) * _samplesWidth + i;
+        if (retrace && !(*retrace)[index])
+          continue;
+        lanes.rays.set(k, cam.pixelRay((i + 0.5) * toPixelX - 0.5,
+                                       (j + 0.5) * toPixelY - 0.5));
+        lanes.sample[k] = index;
+        lanes.throughput[k] = Math::Vector3D(1, 1, 1);
+        lanes.mask |= 1u << k;
       }
     }
+  });
+}
+
+/**
+ * @brief Finds the closest hit of every ray of _wave, a packet at a time.
+ */
+void Raytracer::Renderer::extend() {
+  StageTimer timer(StageExtend, _stageMs[StageExtend]);
+  forEachChunk(_wavePackets, chunkPackets,
+               [&](std::size_t, std::size_t begin, std::size_t end) {
+    for (std::size_t p = begin; p < end; p++) {
+      if (_wave[p].mask)
+        _shapes.hitsPacket(_wave[p].rays, _wave[p].mask);
+    }
+  });
+}
+
+/**
+ * @brief Traces the shadow rays of every hit of _wave into _occluded.
+ *
+ * The shadow rays of one packet towards one light leave from neighbouring
+ * points in the same direction, so they are traced as one packet too.
+ * Lights that cast no shadow ray leave their flags at 0, and so do the
+ * lights of plugins without a LightAbi, which trace their own when shaded.
+ */
+void Raytracer::Renderer::shadow() {
+  StageTimer timer(StageShadow, _stageMs[StageShadow]);
+  const auto &lights = _lights.getShadingOrder();
+  std::size_t count = lights.size();
+  _occluded.assign(_wavePackets * RayPacket::size * count, 0);
+  forEachChunk(_wavePackets, chunkPackets,
+               [&](std::size_t, std::size_t begin, std::size_t end) {
+    RayPacket packet;
+    packet.kind = Ray::Shadow;
+    for (std::size_t p = begin; p < end; p++) {
+      const RayPacket &rays = _wave[p].rays;
+      for (std::size_t l = 0; l < count; l++) {
+        std::uint32_t mask = 0;
+        for (std::uint32_t m = _wave[p].mask; m; m &= m - 1) {
+          int k = __builtin_ctz(m);
+          Ray ray;
+          if (rays.shape[k] &&
+              _lights.castShadowRay(l, rays.ray(k).at(rays.tMax[k]), ray)) {
+            packet.set(k, ray);
+            mask |= 1u << k;
+          }
+        }
+        if (!mask)
+          continue;
+        _shapes.hitsPacket(packet, mask);
+        for (std::uint32_t m = mask; m; m &= m - 1) {
+          int k = __builtin_ctz(m);
+          _occluded[(p * RayPacket::size + k) * count + l] =
+              packet.shape[k] != nullptr;
+        }
+      }
+    }
+  });
+}
+
+/**
+ * @brief Adds the colour of every ray of _wave to its sample, scaled by its
+ * throughput, then replaces _wave with the secondary rays of the materials
+ * hit, sorted by sortBounces() and packed 16 by 16.
+ * @param cam The camera, already updated for the frame.
+ * @param depth The depth of the rays, as passed to rayColor().
+ * @param primary Whether the rays are primary rays, whose colour replaces
+ * the sample and whose surface is kept.
+ */
+void Raytracer::Renderer::shadeWave(const Camera &cam, int depth,
+                                    bool primary) {
+  StageTimer timer(StageShade, _stageMs[StageShade]);
+  std::size_t count = _lights.getShadingOrder().size();
+  _waveBounces.resize((_wavePackets + chunkPackets - 1) / chunkPackets);
+  forEachChunk(_wavePackets, chunkPackets,
+               [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+    std::vector<Bounce> &bounces = _waveBounces[chunk];
+    bounces.clear();
+    for (std::size_t p = begin; p < end; p++) {
+      WaveLanes &lanes = _wave[p];
+      for (std::uint32_t m = lanes.mask; m; m &= m - 1) {
+        int k = __builtin_ctz(m);
+        Ray ray = lanes.rays.ray(k);
+        const IShape *shape = lanes.rays.shape[k];
+        double t = shape ? lanes.rays.tMax[k] : 0.0;
+        const unsigned char *occluded =
+            shape ? _occluded.data() + (p * RayPacket::size + k) * count
+                  : nullptr;
+        Surface surface;
+        IMaterials::Scatter bounce;
+        Math::Vector3D color =
+            shade(ray, t, lanes.rays.color[k], shape, _shapes, _lights, cam,
+                  depth, &surface, &bounce, occluded);
+        if (primary)
+          store(lanes.sample[k], ray, color, surface);
+        else
+          _samples[lanes.sample[k]] += lanes.throughput[k] * color;
+        if (!isBlack(bounce.weight))
+          bounces.push_back({bounce.ray, lanes.throughput[k] * bounce.weight,
+                             lanes.sample[k], depth - 2, 0});
+      }
+    }
+  });
+
+  _waveQueue.clear();
+  for (const auto &bounces : _waveBounces)
+    _waveQueue.insert(_waveQueue.end(), bounces.begin(), bounces.end());
+  sortBounces(_waveQueue);
+  _wavePackets =
+      (_waveQueue.size() + RayPacket::size - 1) / RayPacket::size;
+  if (_wave.size() < _wavePackets)
+    _wave.resize(_wavePackets);
+  for (std::size_t i = 0; i < _waveQueue.size(); i++) {
+    WaveLanes &lanes = _wave[i / RayPacket::size];
+    int k = static_cast<int>(i % RayPacket::size);
+    if (k == 0) {
+      lanes.mask = 0;
+      lanes.rays.kind = Ray::Secondary;
+    }
+    lanes.rays.set(k, _waveQueue[i].ray);
+    lanes.sample[k] = _waveQueue[i].index;
+    lanes.throughput[k] = _waveQueue[i].throughput;
+    lanes.mask |= 1u << k;
+  }
+}
+
+/**
+ * @brief Writes the samples of the frame to the framebuffer.
+ *
+ * When denoising, a copy of the samples is filtered, guided by the normal,
+ * depth and albedo of every sample, so the next frame still reprojects the
+ * traced colours rather than filtering them again and again.
+ * @param framebuffer The framebuffer to write to.
+ */
+void Raytracer::Renderer::present(std::vector<sf::Color> &framebuffer) {
+  if (!_denoise) {
+    resolve(framebuffer, _samples);
+    return;
+  }
+  std::vector<Math::Vector3D> filtered = _samples;
+  _denoiser.filter(filtered, {_normals, _depths, _albedo}, _samplesWidth,
+                   _samplesHeight);
+  resolve(framebuffer, filtered);
+}
+
+/**
+ * @brief Writes a sample grid to the framebuffer.
+ *
+ * At full resolution the samples are copied. Otherwise every pixel is
+ * bilinearly interpolated between the four samples around the point it
+ * stands for in the sample grid, which smooths the reduced image instead of
+ * showing it as blocks. Bands of rows are resolved in parallel.
+ * @param framebuffer The framebuffer to write to.
+ * @param samples The colours of the sample grid.
+ */
+void Raytracer::Renderer::resolve(std::vector<sf::Color> &framebuffer,
+                                  const std::vector<Math::Vector3D> &samples) {
+  auto toColor = [](const Math::Vector3D &color) {
+    return sf::Color(static_cast<sf::Uint8>(color.x * 255),
+                     static_cast<sf::Uint8>(color.y * 255),
+                     static_cast<sf::Uint8>(color.z * 255));
+  };
+  double toSampleX = static_cast<double>(_samplesWidth) / _width;
+  double toSampleY = static_cast<double>(_samplesHeight) / _height;
+  bool fullResolution = _samplesWidth == _width && _samplesHeight == _height;
+
+  int bands = (_height + tileSize - 1) / tileSize;
+  TaskPool::global().parallelFor(bands, [&](std::size_t band) {
+    int y0 = static_cast<int>(band) * tileSize;
+    int y1 = std::min(y0 + tileSize, _height);
+    for (int y = y0; y < y1; y++) {
+      if (fullResolution) {
+        for (int x = 0; x < _width; x++)
+          framebuffer[y * _width + x] = toColor(samples[y * _width + x]);
+        continue;
+      }
+      double v = std::clamp((y + 0.5) * toSampleY - 0.5, 0.0,
+                            _samplesHeight - 1.0);
+      int j0 = static_cast<int>(v);
+      int j1 = std::min(j0 + 1, _samplesHeight - 1);
+      double fy = v - j0;
+      for (int x = 0; x < _width; x++) {
+        double u = std::clamp((x + 0.5) * toSampleX - 0.5, 0.0,
+                              _samplesWidth - 1.0);
+        int i0 = static_cast<int>(u);
+        int i1 = std::min(i0 + 1, _samplesWidth - 1);
+        double fx = u - i0;
+        const Math::Vector3D *row0 = &samples[j0 * _samplesWidth];
+        const Math::Vector3D *row1 = &samples[j1 * _samplesWidth];
+        Math::Vector3D top = row0[i0] * (1.0 - fx) + row0[i1] * fx;
+        Math::Vector3D bottom = row1[i0] * (1.0 - fx) + row1[i1] * fx;
+        framebuffer[y * _width + x] = toColor(top * (1.0 - fy) + bottom * fy);
+      }
+    }
+  });
+}
+
+/**
+ * @brief Turns the cost of every sample into false colours.
+ *
+ * Costs are scaled to the 99th percentile rather than the maximum, so that a
+ * few samples interrupted by the system do not flatten the rest of a time
+ * heatmap; anything above is drawn red. Each pixel shows the cost of the
+ * nearest sample, so reduced frames keep sharp cost boundaries.
+ * @param framebuffer The framebuffer to draw into.
+ */
+void Raytracer::Renderer::drawHeatmap(std::vector<sf::Color> &framebuffer) {
+  std::vector<double> sorted = _cost;
+  auto percentile = sorted.begin() + sorted.size() * 99 / 100;
+  std::nth_element(sorted.begin(), percentile, sorted.end());
+  _heatmapMax = percentile != sorted.end() ? *percentile : 0.0;
+
+  double scale = _heatmapMax > 0 ? 1.0 / _heatmapMax : 0.0;
+  for (int y = 0; y < _height; y++) {
+    int j = std::min(y * _samplesHeight / _height, _samplesHeight - 1);
+    for (int x = 0; x < _width; x++) {
+      int i = std::min(x * _samplesWidth / _width, _samplesWidth - 1);
+      framebuffer[y * _width + x] =
+          heatColor(_cost[j * _samplesWidth + i] * scale);
+    }
   }
 }
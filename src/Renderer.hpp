@@ -1,9 +1,17 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <array>
+#include <chrono>
 #include "Camera.hpp"
+#include "Denoiser.hpp"
+#include "IMaterials.hpp"
 #include "LightComposite.hpp"
+#include "MeshCache.hpp"
 #include "Ray.hpp"
+#include "RayPacket.hpp"
+#include "RenderStats.hpp"
+#include "SceneIndex.hpp"
 #include "ShapeComposite.hpp"
 
 namespace Raytracer {
@@ -16,6 +24,62 @@ namespace Raytracer {
    */
   class Renderer {
     public:
+      /**
+       * @brief What renderToBuffer() draws: the shaded image, or the cost of
+       * each pixel in false colour, from blue (cheapest) to red.
+       */
+      enum Heatmap {
+        HeatmapOff,     ///< Shaded image.
+        HeatmapTime,    ///< Wall time spent on the pixel.
+        HeatmapTests,   ///< Shape and triangle intersection tests.
+        HeatmapBounces, ///< Secondary rays (reflections, refractions...).
+        HeatmapCount    ///< Number of modes.
+      };
+
+      /**
+       * @brief Stages of the wavefront pipeline, see setWavefront().
+       */
+      enum Stage {
+        StageGenerate, ///< Primary rays of a wave.
+        StageExtend,   ///< Closest hit of every ray.
+        StageShadow,   ///< Shadow rays of every hit.
+        StageShade,    ///< Lighting, materials and the next bounce.
+        StageCount     ///< Number of stages.
+      };
+
+      /**
+       * @brief What a primary ray hit, as kept in the guide buffers of the
+       * reprojection and of the denoiser.
+       */
+      struct Surface {
+        double t = 0.0;        ///< Distance to the surface, 0 for a miss.
+        Math::Vector3D normal; ///< Normal at the hit point.
+        Math::Vector3D albedo; ///< Colour of the surface, before lighting.
+      };
+
+      /**
+       * @brief Gets the name of a heatmap mode, as accepted by
+       * parseHeatmap().
+       * @param heatmap The mode.
+       * @return const char* "off", "time", "tests" or "bounces".
+       */
+      static const char *heatmapName(Heatmap heatmap);
+
+      /**
+       * @brief Gets the name of a stage of the wavefront pipeline.
+       * @param stage The stage.
+       * @return const char* "generate", "extend", "shadow" or "shade".
+       */
+      static const char *stageName(Stage stage);
+
+      /**
+       * @brief Parses the name of a heatmap mode.
+       * @param name "off", "time", "tests" or "bounces".
+       * @return Heatmap The mode.
+       * @throw RaytracerError if the name is unknown.
+       */
+      static Heatmap parseHeatmap(const std::string &name);
+
       /**
        * @brief Default constructor for Renderer.
        */
@@ -27,15 +91,18 @@ namespace Raytracer {
        * @param inputFilePath The path to the scene configuration file.
        * @param cam A reference to the camera object.
        * @param plugins A list of plugin file paths.
+       * @param buildQuality The preset of the mesh BVHs built at start-up.
        */
       Renderer(int width, int height, const std::string &inputFilePath,
-               Camera &cam, const std::vector<std::string> &plugins)
+               Camera &cam, const std::vector<std::string> &plugins,
+               BVH::Quality buildQuality = BVH::QualitySah)
           : _width(width),
             _height(height),
             _inputFilePath(inputFilePath),
             _shapes(ShapeComposite()),
             _lights(LightComposite()),
-            _plugins(plugins) {
+            _plugins(plugins),
+            _buildQuality(buildQuality) {
         initScene(cam);
       }
 
@@ -51,6 +118,25 @@ namespace Raytracer {
        */
       void initScene(Camera &camera);
 
+      /**
+       * @brief Parses the configuration file again and updates the scene in
+       * place, keeping every primitive, light and mesh that did not change.
+       * @param camera A reference to the camera to be configured.
+       * @return std::size_t The number of shapes that changed.
+       * @throw ParseError if the file is invalid; the scene is then left
+       * untouched.
+       */
+      std::size_t reload(Camera &camera);
+
+      /**
+       * @brief Gets the files the scene was built from, as of the last
+       * successful parse.
+       * @return const std::vector<std::string>& The files.
+       */
+      const std::vector<std::string> &getDependencies() const {
+        return _dependencies;
+      }
+
       /**
        * @brief Calculates the color of a ray after interacting with the scene.
        * @param r The ray to trace.
@@ -58,11 +144,13 @@ namespace Raytracer {
        * @param light The composite of lights in the scene.
        * @param cameraPos The camera object (used for view-dependent effects like specular highlights).
        * @param depth The current recursion depth for reflections/refractions.
+       * @param surface Receives what the ray hit, if not nullptr.
        * @return Math::Vector3D The calculated color for the ray.
        */
       Math::Vector3D rayColor(Ray &r, const ShapeComposite &s,
                               const LightComposite &light,
-                              const Camera &cameraPos, int depth);
+                              const Camera &cameraPos, int depth,
+                              Surface *surface = nullptr);
 
       /**
        * @brief Gets the input file path for the scene configuration.
@@ -76,10 +164,134 @@ namespace Raytracer {
        * @brief Renders the scene to a framebuffer.
        * @param framebuffer A reference to the vector of SFML colors representing the framebuffer.
        * @param cam A reference to the camera used for rendering.
-       * @param isHighQuality A boolean indicating whether to render in high quality.
+       * @param scale The fraction of the resolution traced on each axis, 1
+       * for every pixel; reduced frames are upscaled bilinearly.
        */
       void renderToBuffer(std::vector<sf::Color> &framebuffer,
-                          Raytracer::Camera &cam, bool isHighQuality);
+                          Raytracer::Camera &cam, double scale = 1.0);
+
+      /**
+       * @brief Renders the scene by reprojecting the previous frame into the
+       * new view, tracing only the samples it does not cover and a rotating
+       * subset of the others.
+       * @param framebuffer The framebuffer to render to.
+       * @param cam The camera used for rendering.
+       * @param scale The fraction of the resolution traced on each axis, as
+       * for renderToBuffer().
+       */
+      void renderReprojected(std::vector<sf::Color> &framebuffer,
+                             Raytracer::Camera &cam, double scale = 1.0);
+
+      /**
+       * @brief Gets the share of the last frame reused from the previous one.
+       * @return double 0 for a fully traced frame, up to 1.
+       */
+      double getReusedRatio() const {
+        return _reused;
+      }
+
+      /**
+       * @brief Gets the work done by the last call to renderToBuffer().
+       * @return const RenderStats::Snapshot& The counters of every thread
+       * over the frame, all zero unless built with statistics.
+       */
+      const RenderStats::Snapshot &getFrameStats() const {
+        return _frameStats;
+      }
+
+      /**
+       * @brief Gets the duration of the last call to renderToBuffer().
+       * @return double The wall time in milliseconds.
+       */
+      double getFrameMs() const {
+        return _frameMs;
+      }
+
+      /**
+       * @brief Sets what the next frames draw.
+       * @param heatmap The heatmap mode, HeatmapOff for the shaded image.
+       * The tests and bounces modes need a build with statistics.
+       */
+      void setHeatmap(Heatmap heatmap) {
+        _heatmap = heatmap;
+      }
+
+      /**
+       * @brief Gets what the frames draw.
+       * @return Heatmap The heatmap mode.
+       */
+      Heatmap getHeatmap() const {
+        return _heatmap;
+      }
+
+      /**
+       * @brief Gets the cost drawn in red by the last heatmap frame.
+       * @return double Nanoseconds, tests or bounces, depending on the mode.
+       */
+      double getHeatmapMax() const {
+        return _heatmapMax;
+      }
+
+      /**
+       * @brief Sets whether the frames are denoised before being displayed.
+       * The traced samples, and so the reprojection, are left untouched.
+       * @param denoise true to filter the frames.
+       */
+      void setDenoise(bool denoise) {
+        _denoise = denoise;
+      }
+
+      /**
+       * @brief Gets whether the frames are denoised.
+       * @return true if they are.
+       */
+      bool getDenoise() const {
+        return _denoise;
+      }
+
+      /**
+       * @brief Sets whether primary rays are traced in packets.
+       * Heatmap frames always trace them one by one, to measure each pixel.
+       * @param packets true to trace 4x4 blocks of pixels together.
+       */
+      void setPackets(bool packets) {
+        _packets = packets;
+      }
+
+      /**
+       * @brief Gets whether primary rays are traced in packets.
+       * @return true if they are.
+       */
+      bool getPackets() const {
+        return _packets;
+      }
+
+      /**
+       * @brief Sets whether the frames go through the wavefront pipeline
+       * rather than being traced tile by tile. Heatmap frames are always
+       * traced tile by tile, to measure each pixel.
+       * @param wavefront true to run every stage over whole waves of rays.
+       */
+      void setWavefront(bool wavefront) {
+        _wavefront = wavefront;
+      }
+
+      /**
+       * @brief Gets whether the frames go through the wavefront pipeline.
+       * @return true if they do.
+       */
+      bool getWavefront() const {
+        return _wavefront;
+      }
+
+      /**
+       * @brief Gets the time the last frame spent in each stage of the
+       * wavefront pipeline, all 0 if it was traced tile by tile.
+       * @return Milliseconds by stage, summed over the waves and threads.
+       */
+      const std::array<double, StageCount> &getStageMs() const {
+        return _stageMs;
+      }
 
       /**
        * @brief Sets the width of the rendering viewport.
@@ -103,6 +315,205 @@ namespace Raytracer {
       ShapeComposite _shapes; ///< Composite object holding all shapes in the scene.
       LightComposite _lights; ///< Composite object holding all lights in the scene.
       std::vector<std::string> _plugins; ///< List of plugin file paths.
+      BVH::Quality _buildQuality = BVH::QualitySah; ///< Preset of the mesh BVHs built by initScene().
+      std::shared_ptr<MeshCache> _meshCache =
+          std::make_shared<MeshCache>(); ///< Meshes kept across reloads.
+      std::shared_ptr<SceneIndex> _sceneIndex; ///< Live shapes and lights by signature.
+      std::vector<std::string> _dependencies; ///< Files the scene is built from.
+      RenderStats::Snapshot _frameStats; ///< Work done by the last frame.
+      double _frameMs = 0;    ///< Duration of the last frame in milliseconds.
       int _maxDepth = 5;      ///< Maximum recursion depth for ray tracing (e.g., for reflections).
+      Heatmap _heatmap = HeatmapOff; ///< What the frames draw.
+      double _heatmapMax = 0; ///< Cost drawn in red by the last heatmap frame.
+      std::vector<double> _cost; ///< Cost of each sample of a heatmap frame.
+      std::vector<Math::Vector3D> _samples; ///< Colors traced by the last frame.
+      int _samplesWidth = 0;  ///< Columns of _samples.
+      int _samplesHeight = 0; ///< Rows of _samples.
+      std::vector<float> _depths; ///< Distance to the surface behind each sample, 0 for none.
+      std::vector<Math::Point3D> _positions; ///< Surface point behind each sample.
+      std::vector<Math::Vector3D> _normals; ///< Surface normal behind each sample.
+      std::vector<Math::Vector3D> _albedo; ///< Surface colour behind each sample.
+      bool _hasHistory = false; ///< Whether the samples can be reprojected.
+      unsigned _frame = 0;    ///< Reprojected frames, selects the refreshed pixels.
+      double _reused = 0;     ///< Share of the last frame reused.
+      bool _denoise = false;  ///< Whether the frames are denoised.
+      bool _packets = true;   ///< Whether primary rays are traced in packets.
+      bool _wavefront = false; ///< Whether frames go through the wavefront pipeline.
+      Denoiser _denoiser;     ///< Filter of the denoised frames.
+
+      /**
+       * @brief A secondary ray waiting in the bounce queue of a tile or of
+       * a wave.
+       */
+      struct Bounce {
+        Ray ray;                   ///< The ray, with a unit direction.
+        Math::Vector3D throughput; ///< Share of its colour added to the sample.
+        std::size_t index;         ///< Sample the ray contributes to.
+        int depth;                 ///< Depth left, as passed to rayColor().
+        std::uint32_t key;         ///< Direction octant and origin cell.
+      };
+
+      /**
+       * @brief A packet of rays of the current wave of the wavefront
+       * pipeline, with the samples they contribute to.
+       */
+      struct WaveLanes {
+        RayPacket rays;                             ///< The rays and their hits.
+        std::uint32_t mask = 0;                     ///< Rays in use.
+        std::size_t sample[RayPacket::size];        ///< Sample of each ray.
+        Math::Vector3D throughput[RayPacket::size]; ///< Share of its colour added to the sample.
+      };
+
+      std::vector<WaveLanes> _wave; ///< Rays of the current bounce of the wave.
+      std::size_t _wavePackets = 0; ///< Packets of _wave in use.
+      std::vector<unsigned char> _occluded; ///< Per ray of _wave and per light, whether its shadow ray hit.
+      std::vector<std::vector<Bounce>> _waveBounces; ///< Rays of the next bounce, per chunk of shade.
+      std::vector<Bounce> _waveQueue; ///< Rays of the next bounce, sorted.
+      std::array<double, StageCount> _stageMs{}; ///< Time of each stage in the last frame.
+
+      static constexpr int tileSize = 40; ///< Side of the tiles of samples.
+      static constexpr std::size_t waveBlocks =
+          4096; ///< 4x4 blocks of samples per wave.
+      static constexpr std::size_t chunkPackets =
+          32; ///< Packets per task of a stage.
+      static constexpr int minPacketRays =
+          4; ///< Blocks with fewer samples to trace are traced ray by ray.
+
+      /**
+       * @brief Calculates the color of a ray whose closest hit is known.
+       * @param r The ray.
+       * @param t The distance of the hit, 0 for a miss.
+       * @param color The colour of the surface hit.
+       * @param hitShape The shape hit, nullptr for a miss.
+       * @param s The composite of shapes in the scene.
+       * @param light The composite of lights in the scene.
+       * @param cameraPos The camera.
+       * @param depth The current recursion depth.
+       * @param surface Receives what the ray hit, if not nullptr.
+       * @param bounce Receives the secondary ray instead of tracing it, if
+       * not nullptr.
+       * @param occluded Whether each shadow ray hit, if already traced.
+       * @return Math::Vector3D The calculated color for the ray.
+       */
+      Math::Vector3D shade(Ray &r, double t, const Math::Vector3D &color,
+                           const IShape *hitShape, const ShapeComposite &s,
+                           const LightComposite &light,
+                           const Camera &cameraPos, int depth,
+                           Surface *surface,
+                           IMaterials::Scatter *bounce = nullptr,
+                           const unsigned char *occluded = nullptr);
+
+      /**
+       * @brief Traces the secondary rays of a tile, one bounce at a time, in
+       * packets of rays sorted by direction and origin, adding their colours
+       * to the samples.
+       * @param cam The camera, already updated for the frame.
+       * @param queue The rays of the first bounce; emptied.
+       */
+      void traceBounces(const Camera &cam, std::vector<Bounce> &queue);
+
+      /**
+       * @brief Sorts rays by the octant of their direction, then by their
+       * origin along a Z-order curve, so that neighbours cross the same
+       * nodes. Normalizes their directions.
+       * @param queue The rays.
+       */
+      static void sortBounces(std::vector<Bounce> &queue);
+
+      /**
+       * @brief Keeps the colour and the surface of a primary ray.
+       * @param index The sample of the ray.
+       * @param ray The ray.
+       * @param color Its colour.
+       * @param surface What it hit.
+       */
+      void store(std::size_t index, const Ray &ray,
+                 const Math::Vector3D &color, const Surface &surface);
+
+      /**
+       * @brief Traces the samples of the frame with the wavefront pipeline.
+       * @param cam The camera, already updated for the frame.
+       * @param retrace Which samples to trace, every one if nullptr.
+       */
+      void renderWavefront(const Camera &cam,
+                           const std::vector<unsigned char> *retrace);
+
+      /**
+       * @brief Generate stage: fills _wave with the primary rays of a range
+       * of 4x4 blocks of samples.
+       * @param cam The camera, already updated for the frame.
+       * @param firstBlock The first block, row by row.
+       * @param blocks The number of blocks.
+       * @param retrace Which samples to trace, every one if nullptr.
+       */
+      void generate(const Camera &cam, std::size_t firstBlock,
+                    std::size_t blocks,
+                    const std::vector<unsigned char> *retrace);
+
+      /**
+       * @brief Extend stage: finds the closest hit of every ray of _wave.
+       */
+      void extend();
+
+      /**
+       * @brief Shadow stage: traces the shadow ray of every hit of _wave
+       * towards every light into _occluded.
+       */
+      void shadow();
+
+      /**
+       * @brief Shade stage: adds the colour of every ray of _wave to its
+       * sample, then replaces _wave with the secondary rays, sorted.
+       * @param cam The camera, already updated for the frame.
+       * @param depth The depth of the rays, as passed to rayColor().
+       * @param primary Whether the rays are primary rays, whose surface is
+       * kept.
+       */
+      void shadeWave(const Camera &cam, int depth, bool primary);
+
+      /**
+       * @brief Traces one tile of the sample grid; safe to call concurrently
+       * for different tiles.
+       * @param cam The camera, already updated for the frame.
+       * @param x0 The left column of the tile.
+       * @param y0 The top row of the tile.
+       * @param start The start of the frame, origin of the time heatmap.
+       * @param retrace Which samples to trace, every one if nullptr.
+       */
+      void renderTile(const Camera &cam, int x0, int y0,
+                      std::chrono::steady_clock::time_point start,
+                      const std::vector<unsigned char> *retrace);
+
+      /**
+       * @brief Traces the tiles of the sample grid in parallel.
+       * @param cam The camera, already updated for the frame.
+       * @param start The start of the frame, origin of the time heatmap.
+       * @param retrace Which samples to trace, every one if nullptr.
+       */
+      void renderTiles(const Camera &cam,
+                       std::chrono::steady_clock::time_point start,
+                       const std::vector<unsigned char> *retrace);
+
+      /**
+       * @brief Writes the samples to the framebuffer, denoised if enabled,
+       * upscaling them bilinearly if the frame was traced at a reduced scale.
+       * @param framebuffer The framebuffer to write to.
+       */
+      void present(std::vector<sf::Color> &framebuffer);
+
+      /**
+       * @brief Writes a sample grid to the framebuffer, upscaling it
+       * bilinearly if the frame was traced at a reduced scale.
+       * @param framebuffer The framebuffer to write to.
+       * @param samples The colours of the sample grid.
+       */
+      void resolve(std::vector<sf::Color> &framebuffer,
+                   const std::vector<Math::Vector3D> &samples);
+
+      /**
+       * @brief Turns the cost of every sample into false colours.
+       * @param framebuffer The framebuffer to draw into.
+       */
+      void drawHeatmap(std::vector<sf::Color> &framebuffer);
   };
 }  // namespace Raytracer
@@ -1,10 +1,12 @@
 #include "Scene.hpp"
 #include <dlfcn.h>
+#include <exception>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include "Renderer.hpp"
+#include "Trace.hpp"
 #include "exceptions/RaytracerException.hpp"
 
 #define EXTENSION_LENGTH 4
@@ -22,12 +24,12 @@ Raytracer::Scene::Scene(int width, int height, const std::string &inputPath)
   _window.setFramerateLimit(60);
   _window.setVerticalSyncEnabled(true);
   _lastMovement = std::chrono::steady_clock::now();
-  _ftime = std::filesystem::last_write_time(inputPath);
   init();
   try {
     parsePlugins();
     _renderer = std::make_unique<Raytracer::Renderer>(
         _width, _height, _inputFilePath, _camera, _plugins);
+    _watcher.watch(_renderer->getDependencies());
   } catch (const std::exception &e) {
     std::cerr << "[ERROR] - Failed to parse plugins: " << e.what() << std::endl;
     throw;
@@ -130,26 +132,86 @@ void Raytracer::Scene::createPPMFile() {
   outputFile.close();
 }
 
+/**
+ * @brief Reloads the scene if the file watcher reported a change in the
+ * configuration file or any file it depends on.
+ * The set of watched files is then updated, since imports and OBJ files may
+ * have been added or removed. A failed reload keeps the previous scene and
+ * its files.
+ */
 void Raytracer::Scene::checkFileChange() {
-  std::filesystem::file_time_type updateTime = std::filesystem::last_write_time(_inputFilePath);
-
-  if (updateTime == _ftime) {
+  if (!_watcher.poll()) {
     return;
   }
-  _ftime = updateTime;
   try {
-    _renderer = std::make_unique<Raytracer::Renderer>(_width, _height, _inputFilePath, _camera, _plugins);
+    _renderer->reload(_camera);
   } catch (const Raytracer::ParseError &e) {
     std::cerr << "[ERROR] - Failed to update renderer: " << e.what() << std::endl;
   } catch (const Raytracer::RaytracerError &e) {
     std::cerr << "[ERROR] - Failed to update renderer: " << e.what() << std::endl;
+  } catch (const std::exception &e) {
+    std::cerr << "[ERROR] - Failed to update renderer: " << e.what() << std::endl;
   }
+  _watcher.watch(_renderer->getDependencies());
+}
+
+/**
+ * @brief Shows the statistics of the last frame when enabled with F3.
+ *
+ * There is no font to draw text over the image with, so the statistics go
+ * in the window title. Without RAYTRACER_STATS only the frame time is
+ * meaningful; the counters stay at zero.
+ */
+void Raytracer::Scene::showStats() {
+  if (!_showStats)
+    return;
+  std::string line = RenderStats::format(_renderer->getFrameStats(),
+                                         _renderer->getFrameMs());
+  if (!_isHighQuality)
+    line += " | scale " + std::to_string(_resolution.getScale());
+  if (!_isHighQuality && _reproject)
+    line += " | reused " +
+            std::to_string(static_cast<int>(_renderer->getReusedRatio() * 100)) +
+            "%";
+  if (_renderer->getDenoise())
+    line += " | denoised";
+  if (_renderer->getHeatmap() != Renderer::HeatmapOff)
+    line += std::string(" | heatmap ") +
+            Renderer::heatmapName(_renderer->getHeatmap()) + ", red >= " +
+            std::to_string(_renderer->getHeatmapMax());
+  _window.setTitle("Raytracer | " + line);
+
+  auto now = std::chrono::steady_clock::now();
+  if (now - _lastStatsPrint >= std::chrono::seconds(1)) {
+    std::cout << "[STATS] - " << line << std::endl;
+    _lastStatsPrint = now;
+  }
+}
+
+/**
+ * @brief Switches to the next heatmap mode.
+ *
+ * Off, time, tests, bounces, then off again. The tests and bounces modes
+ * are skipped in builds without statistics.
+ */
+void Raytracer::Scene::cycleHeatmap() {
+  auto heatmap = _renderer->getHeatmap();
+  do {
+    heatmap = static_cast<Renderer::Heatmap>((heatmap + 1) %
+                                             Renderer::HeatmapCount);
+  } while (!RenderStats::enabled && heatmap != Renderer::HeatmapOff &&
+           heatmap != Renderer::HeatmapTime);
+  _renderer->setHeatmap(heatmap);
+  std::cout << "[HEATMAP] - " << Renderer::heatmapName(heatmap) << std::endl;
 }
 
 /**
  * @brief Handles user input for camera movement and other interactions.
  * This includes moving/rotating the camera, taking screenshots (Y key),
- * and quitting (Escape key).
+ * and quitting (Escape key). F3, which toggles the frame statistics, F4,
+ * which cycles the heatmap modes, F5, which switches how moving frames are
+ * rendered, F6, which toggles the denoiser, and F7, which toggles the
+ * wavefront pipeline, are handled as key press events in render().
  */
 void Raytracer::Scene::handleInput() {
   const float moveSpeed = 5.0f;
@@ -199,7 +261,9 @@ void Raytracer::Scene::handleInput() {
 
 /**
  * @brief Manages camera rendering quality based on movement.
- * If the camera has moved, it switches to low quality. If the camera
+ * If the camera has moved, it switches to low quality, where frames are
+ * traced at the scale picked by the dynamic resolution and, unless turned
+ * off with F5, reuse the previous one through reprojection. If the camera
  * has been stationary for a certain duration (_qualityUpdateDelay),
  * it switches back to high quality.
  */
@@ -223,6 +287,7 @@ void Raytracer::Scene::changeCamQuality() {
  * Warnings are printed if a plugin fails to load.
  */
 void Raytracer::Scene::parsePlugins() {
+  Trace::Scope scope("load plugins", "plugins");
   for (const auto &entry : std::filesystem::directory_iterator("./plugins")) {
     if (entry.path().extension() == ".so")
       _plugins.push_back(entry.path().string());
@@ -255,6 +320,34 @@ void Raytracer::Scene::render() {
           (event.type == sf::Event::KeyPressed &&
            event.key.code == sf::Keyboard::Escape))
         _window.close();
+      if (event.type == sf::Event::KeyPressed &&
+          event.key.code == sf::Keyboard::F3) {
+        _showStats = !_showStats;
+        if (!_showStats)
+          _window.setTitle("Raytracer");
+      }
+      if (event.type == sf::Event::KeyPressed &&
+          event.key.code == sf::Keyboard::F4)
+        cycleHeatmap();
+      if (event.type == sf::Event::KeyPressed &&
+          event.key.code == sf::Keyboard::F5) {
+        _reproject = !_reproject;
+        std::cout << "[MOTION] - "
+                  << (_reproject ? "reprojection on" : "reprojection off")
+                  << std::endl;
+      }
+      if (event.type == sf::Event::KeyPressed &&
+          event.key.code == sf::Keyboard::F6) {
+        _renderer->setDenoise(!_renderer->getDenoise());
+        std::cout << "[DENOISE] - "
+                  << (_renderer->getDenoise() ? "on" : "off") << std::endl;
+      }
+      if (event.type == sf::Event::KeyPressed &&
+          event.key.code == sf::Keyboard::F7) {
+        _renderer->setWavefront(!_renderer->getWavefront());
+        std::cout << "[WAVEFRONT] - "
+                  << (_renderer->getWavefront() ? "on" : "off") << std::endl;
+      }
     }
     checkFileChange();
     handleInput();
@@ -262,8 +355,19 @@ void Raytracer::Scene::render() {
       return;
     changeCamQuality();
     std::fill(_framebuffer.begin(), _framebuffer.end(), sf::Color::White);
-    _renderer->renderToBuffer(_framebuffer, _camera, _isHighQuality);
+    if (_isHighQuality) {
+      _renderer->renderToBuffer(_framebuffer, _camera);
+    } else {
+      if (_reproject)
+        _renderer->renderReprojected(_framebuffer, _camera,
+                                     _resolution.getScale());
+      else
+        _renderer->renderToBuffer(_framebuffer, _camera,
+                                  _resolution.getScale());
+      _resolution.update(_renderer->getFrameMs());
+    }
     updateImage();
+    showStats();
     _window.clear(sf::Color::White);
     _window.draw(_sprite);
     _window.display();
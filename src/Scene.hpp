@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 #include "Camera.hpp"
+#include "DynamicResolution.hpp"
+#include "FileWatcher.hpp"
 #include "Renderer.hpp"
 
 namespace Raytracer {
@@ -54,6 +56,23 @@ namespace Raytracer {
        */
       void parsePlugins();
 
+      /**
+       * @brief Sets the frame time interactive frames aim for while the
+       * camera moves.
+       * @param budgetMs The target frame time in milliseconds.
+       */
+      void setFrameBudget(double budgetMs) {
+        _resolution.setBudget(budgetMs);
+      }
+
+      /**
+       * @brief Sets whether frames go through the wavefront pipeline (F7).
+       * @param wavefront true to render stage by stage.
+       */
+      void setWavefront(bool wavefront) {
+        _renderer->setWavefront(wavefront);
+      }
+
     private:
       /**
        * @brief Creates the output PPM file with the rendered image.
@@ -73,11 +92,23 @@ namespace Raytracer {
       void createOutputFileName();
 
       /*
-       * This function is used to check if the input file has been updated
-       * during the program to update scene 
+       * This function is used to check if the input file or one of its
+       * dependencies has been updated during the program to update scene
       */
       void checkFileChange();
 
+      /**
+       * @brief Shows the statistics of the last frame when enabled (F3): in
+       * the window title every frame, and on the console once per second.
+       */
+      void showStats();
+
+      /**
+       * @brief Switches to the next heatmap mode (F4), skipping the modes
+       * the build cannot measure.
+       */
+      void cycleHeatmap();
+
       /*
        * This attribut is used to keep the input file during the program.
        */
@@ -88,7 +119,6 @@ namespace Raytracer {
        */
       std::string _outputFilePath; ///< Path to the output image file.
 
-      std::filesystem::file_time_type _ftime;
       int _width; ///< Width of the scene/window.
       int _height; ///< Height of the scene/window.
       sf::RenderWindow _window; ///< SFML render window.
@@ -98,9 +128,12 @@ namespace Raytracer {
       std::vector<sf::Color> _framebuffer; ///< Framebuffer storing pixel colors.
       std::chrono::time_point<std::chrono::steady_clock> _lastMovement; ///< Timestamp of the last camera movement.
       bool _isHighQuality = true; ///< Flag indicating if rendering is in high quality.
+      Raytracer::DynamicResolution _resolution; ///< Scale of the frames rendered while moving.
+      bool _reproject = true; ///< Whether moving frames also reuse the previous one (F5).
       std::vector<std::string> _plugins; ///< List of plugin file paths.
       std::vector<void *> _pluginHandles; ///< Handles to loaded plugins.
       std::unique_ptr<Raytracer::Renderer> _renderer;
+      Raytracer::FileWatcher _watcher; ///< Watches the files of the scene.
       Raytracer::Camera _camera; ///< The scene camera.
 
       /**
@@ -115,5 +148,7 @@ namespace Raytracer {
       bool _cameraMoved = false; ///< Flag indicating if the camera has moved recently.
       const std::chrono::duration<float> _qualityUpdateDelay{0.5f}; ///< Delay before updating to high quality after movement.
       bool _userQuit = false; ///< Flag indicating if the user has requested to quit.
+      bool _showStats = false; ///< Whether frame statistics are shown (F3).
+      std::chrono::time_point<std::chrono::steady_clock> _lastStatsPrint; ///< Last time statistics were printed.
   };
 }  // namespace Raytracer
@@ -0,0 +1,510 @@
+#include "SceneCache.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include "MappedFile.hpp"
+#include "Trace.hpp"
+
+namespace {
+
+  constexpr char magic[8] = {'R', 'T', 'S', 'C', 'A', 'C', 'H', 'E'};
+
+  using Raytracer::BVH;
+  using Raytracer::Object;
+  using Raytracer::SceneCache;
+
+  template <typename... T>
+  constexpr bool rawBytes =
+      ((std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T>) &&
+       ...);
+
+  static_assert(rawBytes<Math::Point3D, Math::Vector3D, Object::Face,
+                         Object::FaceEdges, BVH::Node, BVH::WideNode,
+                         SceneCache::Primitive, SceneCache::Light,
+                         SceneCache::View>,
+                "Scene cache buffers are stored and mapped as raw bytes");
+
+  /**
+   * @brief Signature of the layout of every record stored as raw bytes.
+   *
+   * Mixes the size, alignment and field offsets of the records, so that a
+   * cache written by a build where any of them differs is ignored instead of
+   * being traced as garbage.
+   * @return std::uint64_t The signature.
+   */
+  constexpr std::uint64_t layout() {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (std::uint64_t value : std::initializer_list<std::uint64_t>{
+             sizeof(Math::Point3D), sizeof(Math::Vector3D),
+             sizeof(Object::Face), offsetof(Object::Face, normal),
+             offsetof(Object::Face, material), sizeof(Object::FaceEdges),
+             offsetof(Object::FaceEdges, edge1),
+             offsetof(Object::FaceEdges, edge2), sizeof(BVH::Node),
+             offsetof(BVH::Node, first), offsetof(BVH::Node, count),
+             sizeof(BVH::WideNode), alignof(BVH::WideNode),
+             offsetof(BVH::WideNode, child), offsetof(BVH::WideNode, count),
+             offsetof(BVH::WideNode, size), sizeof(SceneCache::Primitive),
+             offsetof(SceneCache::Primitive, setting),
+             offsetof(SceneCache::Primitive, center),
+             offsetof(SceneCache::Primitive, scale),
+             offsetof(SceneCache::Primitive, angle),
+             sizeof(SceneCache::Light),
+             offsetof(SceneCache::Light, position),
+             offsetof(SceneCache::Light, intensity), sizeof(SceneCache::View),
+             offsetof(SceneCache::View, fieldOfView)})
+      hash = (hash ^ value) * 0x100000001b3ULL;
+    return hash;
+  }
+
+  /**
+   * @brief Bounds-checked cursor over the mapped cache.
+   */
+  class Reader {
+    public:
+      Reader(const std::shared_ptr<const Raytracer::MappedFile> &file,
+             const char *data, std::size_t size)
+          : _file(file), _p(data), _end(data + size) {}
+
+      template <typename T>
+      T read() {
+        T value;
+        take(&value, sizeof(T));
+        return value;
+      }
+
+      std::string readString() {
+        std::string value(read<std::uint64_t>(), '\0');
+        take(value.data(), value.size());
+        return value;
+      }
+
+      /**
+       * @brief Reads an array in place: the result points into the mapping,
+       * which it keeps alive.
+       */
+      template <typename T>
+      Raytracer::SharedArray<T> readArray() {
+        std::uint64_t count = read<std::uint64_t>();
+        align(alignof(T));
+        if (count > static_cast<std::size_t>(_end - _p) / sizeof(T))
+          throw std::runtime_error("truncated cache");
+        const T *values = reinterpret_cast<const T *>(_p);
+        _p += count * sizeof(T);
+        return {_file, values, count};
+      }
+
+      const char *position() const {
+        return _p;
+      }
+
+      void skip(std::size_t size) {
+        if (size > static_cast<std::size_t>(_end - _p))
+          throw std::runtime_error("truncated cache");
+        _p += size;
+      }
+
+    private:
+      std::shared_ptr<const Raytracer::MappedFile> _file;
+      const char *_p;
+      const char *_end;
+
+      void take(void *out, std::size_t size) {
+        if (size > static_cast<std::size_t>(_end - _p))
+          throw std::runtime_error("truncated cache");
+        if (size > 0)
+          std::memcpy(out, _p, size);
+        _p += size;
+      }
+
+      /**
+       * @brief Skips the padding the writer put before an array. Offsets
+       * are relative to the start of the file, which is page-aligned.
+       */
+      void align(std::size_t alignment) {
+        std::size_t offset = static_cast<std::size_t>(_p - _file->data());
+        skip((alignment - offset % alignment) % alignment);
+      }
+  };
+
+  /**
+   * @brief Appends values to the cache file being written.
+   */
+  class Writer {
+    public:
+      explicit Writer(std::ofstream &out) : _out(out) {}
+
+      template <typename T>
+      void write(const T &value) {
+        _out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+      }
+
+      void writeString(const std::string &value) {
+        write<std::uint64_t>(value.size());
+        _out.write(value.data(), value.size());
+      }
+
+      /**
+       * @brief Writes an array, padded so that it can be read in place.
+       */
+      template <typename Array>
+      void writeArray(const Array &values) {
+        using T = std::remove_cvref_t<decltype(*values.data())>;
+        write<std::uint64_t>(values.size());
+        std::size_t offset = static_cast<std::size_t>(_out.tellp());
+        for (std::size_t i = offset % alignof(T); i && i < alignof(T); i++)
+          _out.put('\0');
+        _out.write(reinterpret_cast<const char *>(values.data()),
+                   values.size() * sizeof(T));
+      }
+
+      /**
+       * @brief Writes a file as it is now. A file modified within the last
+       * seconds is recorded without write time, so that it is always hashed:
+       * an edit in the same clock tick would leave its write time as is.
+       */
+      void writeSource(const std::string &path) {
+        std::error_code sizeError;
+        std::error_code timeError;
+        auto size = std::filesystem::file_size(path, sizeError);
+        auto mtime = std::filesystem::last_write_time(path, timeError);
+        bool recent = std::filesystem::file_time_type::clock::now() - mtime <
+                      std::chrono::seconds(2);
+        write<std::uint64_t>(SceneCache::hashFile(path));
+        writeString(path);
+        write<std::uint64_t>(sizeError ? 0 : size);
+        write<std::int64_t>(timeError || recent
+                                ? 0
+                                : mtime.time_since_epoch().count());
+      }
+
+    private:
+      std::ofstream &_out;
+  };
+
+}  // namespace
+
+/**
+ * @brief Hashes the content of a file.
+ *
+ * FNV-1a over 64-bit words (then the remaining bytes). Only needed for the
+ * files whose write time changed since the cache was written.
+ * @param path The path of the file.
+ * @return std::uint64_t The hash, 0 if the file cannot be read.
+ */
+std::uint64_t Raytracer::SceneCache::hashFile(const std::string &path) {
+  constexpr std::uint64_t prime = 0x100000001b3ULL;
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+
+  try {
+    MappedFile file(path);
+    const char *data = file.data();
+    std::size_t size = file.size();
+    std::size_t i = 0;
+
+    for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+      std::uint64_t word;
+      std::memcpy(&word, data + i, sizeof(word));
+      hash = (hash ^ word) * prime;
+    }
+    for (; i < size; i++)
+      hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+    hash = (hash ^ size) * prime;
+  } catch (const std::runtime_error &) {
+    return 0;
+  }
+  return hash;
+}
+
+/**
+ * @brief Checks whether a file is the one a record was built from.
+ *
+ * A different size means the file changed, the same size and write time
+ * that it did not; the content is only hashed when the write time alone
+ * moved, as after a checkout or a save without edits.
+ * @param source The file as it was recorded.
+ * @return true if the file did not change.
+ */
+bool Raytracer::SceneCache::unchanged(const Source &source) {
+  std::error_code ec;
+  auto size = std::filesystem::file_size(source.path, ec);
+  if (ec || size != source.size)
+    return false;
+  auto mtime = std::filesystem::last_write_time(source.path, ec);
+  if (ec)
+    return false;
+  if (mtime.time_since_epoch().count() == source.mtime)
+    return true;
+  return hashFile(source.path) == source.hash;
+}
+
+/**
+ * @brief Opens the cache of a scene.
+ *
+ * Only the index is read: the files of the scene, which are checked at
+ * once, then the source files of each mesh record and where its buffers
+ * are. The primitives and lights of the scene stay in the mapping. A
+ * missing cache or one from another version or layout is silently ignored;
+ * a corrupted one produces a warning.
+ * @param scenePath The path of the .cfg file.
+ */
+Raytracer::SceneCache::SceneCache(const std::string &scenePath) {
+  std::string path = pathFor(scenePath);
+  if (!std::filesystem::exists(path))
+    return;
+
+  Trace::Scope scope("open scene cache", "load", path);
+  try {
+    auto file = std::make_shared<const MappedFile>(path, MappedFile::Random);
+    Reader reader(file, file->data(), file->size());
+
+    char header[sizeof(magic)];
+    for (char &c : header)
+      c = reader.read<char>();
+    if (std::memcmp(header, magic, sizeof(magic)) != 0 ||
+        reader.read<std::uint32_t>() != version ||
+        reader.read<std::uint64_t>() != layout())
+      return;
+
+    std::uint64_t sceneSize = reader.read<std::uint64_t>();
+    Reader sceneReader(file, reader.position(), sceneSize);
+    reader.skip(sceneSize);
+    if (sceneSize > 0) {
+      auto scene = std::make_unique<Scene>();
+      bool valid = true;
+      std::uint64_t fileCount = sceneReader.read<std::uint64_t>();
+      for (std::uint64_t i = 0; i < fileCount; i++) {
+        Source source;
+        source.hash = sceneReader.read<std::uint64_t>();
+        source.path = sceneReader.readString();
+        source.size = sceneReader.read<std::uint64_t>();
+        source.mtime = sceneReader.read<std::int64_t>();
+        valid = valid && unchanged(source);
+        scene->files.push_back(std::move(source.path));
+      }
+      if (valid) {
+        scene->camera = sceneReader.read<View>();
+        scene->hasDiffuse = sceneReader.read<std::uint8_t>() != 0;
+        scene->diffuse = sceneReader.read<double>();
+        scene->meshes.resize(sceneReader.read<std::uint64_t>());
+        for (auto &mesh : scene->meshes)
+          mesh = sceneReader.readString();
+        scene->primitives = sceneReader.readArray<Primitive>();
+        scene->lights = sceneReader.readArray<Light>();
+        for (const auto &primitive : scene->primitives) {
+          if (primitive.kind == Primitive::Instance &&
+              primitive.mesh >= scene->meshes.size())
+            throw std::runtime_error("bad mesh index");
+        }
+        _scene = std::move(scene);
+      }
+    }
+
+    std::uint64_t meshCount = reader.read<std::uint64_t>();
+    for (std::uint64_t i = 0; i < meshCount; i++) {
+      std::string key = reader.readString();
+      Record record;
+      std::uint64_t sourceCount = reader.read<std::uint64_t>();
+      for (std::uint64_t j = 0; j < sourceCount; j++) {
+        Source source;
+        source.hash = reader.read<std::uint64_t>();
+        source.path = reader.readString();
+        source.size = reader.read<std::uint64_t>();
+        source.mtime = reader.read<std::int64_t>();
+        record.sources.push_back(std::move(source));
+      }
+      record.size = reader.read<std::uint64_t>();
+      record.data = reader.position();
+      reader.skip(record.size);
+      _records.emplace(std::move(key), std::move(record));
+    }
+    _file = std::move(file);
+  } catch (const std::runtime_error &e) {
+    _scene.reset();
+    _records.clear();
+    std::cerr << "[WARNING] - Ignoring scene cache " << path << ": "
+              << e.what() << std::endl;
+  }
+}
+
+/**
+ * @brief Reads the mesh of an OBJ file out of the cache.
+ *
+ * The source files of the record are checked first, so a mesh is only used
+ * if none of them changed since the cache was written. Vertices, faces,
+ * face edges and the BVH point into the mapping: nothing is copied or
+ * recomputed, the pages are read as rays reach them.
+ * @param objFile The path of the OBJ file.
+ * @param create Creates the empty object the mesh is read into.
+ * @param sources Receives the files the mesh was built from.
+ * @return std::shared_ptr<Raytracer::Object> The mesh, or nullptr.
+ */
+std::shared_ptr<Raytracer::Object> Raytracer::SceneCache::find(
+    const std::string &objFile, const MeshCache::Loader &create,
+    std::vector<std::string> &sources) const {
+  auto it = _records.find(MeshCache::key(objFile));
+  if (it == _records.end())
+    return nullptr;
+  Trace::Scope scope("read cached mesh", "load", objFile);
+  const Record &record = it->second;
+  for (const auto &source : record.sources) {
+    if (!unchanged(source))
+      return nullptr;
+  }
+
+  std::shared_ptr<Object> mesh = create();
+  try {
+    Reader reader(_file, record.data, record.size);
+    mesh->setObjFile(reader.readString());
+    mesh->setVertices(reader.readArray<Math::Point3D>());
+    mesh->setNormals(reader.readArray<Math::Vector3D>());
+    mesh->setFaces(reader.readArray<Object::Face>());
+
+    std::vector<Object::Mtl> materials(reader.read<std::uint64_t>());
+    for (auto &material : materials) {
+      material.name = reader.readString();
+      material.ambient = reader.read<Math::Vector3D>();
+      material.diffuse = reader.read<Math::Vector3D>();
+      material.specular = reader.read<Math::Vector3D>();
+      material.shininess = reader.read<double>();
+      material.transparency = reader.read<double>();
+      material.illumination = reader.read<std::int32_t>();
+    }
+    mesh->setMaterials(std::move(materials));
+
+    auto edges = reader.readArray<Object::FaceEdges>();
+    auto nodes = reader.readArray<BVH::Node>();
+    auto indices = reader.readArray<std::uint32_t>();
+    auto wide = reader.readArray<BVH::WideNode>();
+    auto lanes = reader.readArray<std::uint32_t>();
+    double cost = reader.read<double>();
+    if (edges.size() != mesh->getFaces().size() ||
+        lanes.size() != wide.size() * BVH::width)
+      throw std::runtime_error("inconsistent mesh buffers");
+    BVH bvh;
+    bvh.assign(std::move(nodes), std::move(indices), std::move(wide),
+               std::move(lanes), cost);
+    mesh->setAccel(std::move(bvh), std::move(edges));
+  } catch (const std::runtime_error &e) {
+    std::cerr << "[WARNING] - Ignoring cached mesh " << objFile << ": "
+              << e.what() << std::endl;
+    return nullptr;
+  }
+  sources.clear();
+  for (const auto &source : record.sources)
+    sources.push_back(source.path);
+  return mesh;
+}
+
+/**
+ * @brief Writes the cache of a scene.
+ *
+ * The file is written under a temporary name then renamed, so that a
+ * concurrent start-up never maps a half-written cache, and the meshes
+ * still mapped from the previous cache keep reading the old file. Meshes
+ * without recorded source files are skipped since they could never be
+ * validated.
+ * @param scenePath The path of the .cfg file.
+ * @param scene The flattened scene.
+ * @param meshes The meshes of the scene.
+ * @throws std::runtime_error if the cache cannot be written.
+ */
+void Raytracer::SceneCache::save(const std::string &scenePath,
+                                 const Scene &scene, const MeshCache &meshes) {
+  Trace::Scope scope("write scene cache", "load", scenePath);
+  std::string path = pathFor(scenePath);
+  std::string temporary = path + ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out)
+      throw std::runtime_error("Cannot write scene cache: " + path);
+    Writer writer(out);
+
+    // Sizes of the sections are patched once they are written.
+    auto beginSection = [&]() {
+      std::streampos sizePosition = out.tellp();
+      writer.write<std::uint64_t>(0);
+      return sizePosition;
+    };
+    auto endSection = [&](std::streampos sizePosition) {
+      std::streampos end = out.tellp();
+      std::streampos start = sizePosition + std::streamoff(sizeof(std::uint64_t));
+      out.seekp(sizePosition);
+      writer.write<std::uint64_t>(static_cast<std::uint64_t>(end - start));
+      out.seekp(end);
+    };
+
+    out.write(magic, sizeof(magic));
+    writer.write<std::uint32_t>(version);
+    writer.write<std::uint64_t>(layout());
+
+    std::streampos sceneSize = beginSection();
+    writer.write<std::uint64_t>(scene.files.size());
+    for (const auto &file : scene.files)
+      writer.writeSource(file);
+    writer.write(scene.camera);
+    writer.write<std::uint8_t>(scene.hasDiffuse);
+    writer.write(scene.diffuse);
+    writer.write<std::uint64_t>(scene.meshes.size());
+    for (const auto &mesh : scene.meshes)
+      writer.writeString(mesh);
+    writer.writeArray(scene.primitives);
+    writer.writeArray(scene.lights);
+    endSection(sceneSize);
+
+    std::vector<std::pair<std::string, std::vector<std::string>>> records;
+    for (const auto &[key, mesh] : meshes.getMeshes()) {
+      std::vector<std::string> sources = meshes.getSources(key);
+      if (!sources.empty())
+        records.emplace_back(key, std::move(sources));
+    }
+    writer.write<std::uint64_t>(records.size());
+    for (const auto &[key, sources] : records) {
+      const auto &mesh = meshes.getMeshes().at(key);
+      writer.writeString(key);
+      writer.write<std::uint64_t>(sources.size());
+      for (const auto &source : sources)
+        writer.writeSource(source);
+
+      std::streampos meshSize = beginSection();
+      writer.writeString(mesh->getObjFile());
+      writer.writeArray(mesh->getVertices());
+      writer.writeArray(mesh->getNormals());
+      writer.writeArray(mesh->getFaces());
+
+      writer.write<std::uint64_t>(mesh->getMaterials().size());
+      for (const auto &material : mesh->getMaterials()) {
+        writer.writeString(material.name);
+        writer.write(material.ambient);
+        writer.write(material.diffuse);
+        writer.write(material.specular);
+        writer.write(material.shininess);
+        writer.write(material.transparency);
+        writer.write<std::int32_t>(material.illumination);
+      }
+
+      const BVH &bvh = mesh->getAccel();
+      writer.writeArray(mesh->getEdges());
+      writer.writeArray(bvh.getNodes());
+      writer.writeArray(bvh.getIndices());
+      writer.writeArray(bvh.getWideNodes());
+      writer.writeArray(bvh.getLanes());
+      writer.write(bvh.getCost());
+      endSection(meshSize);
+    }
+    if (!out)
+      throw std::runtime_error("Cannot write scene cache: " + path);
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(temporary, path, ec);
+  if (ec) {
+    std::filesystem::remove(temporary, ec);
+    throw std::runtime_error("Cannot write scene cache: " + path);
+  }
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "MappedFile.hpp"
+#include "MeshCache.hpp"
+#include "Point3D.hpp"
+#include "SharedArray.hpp"
+#include "Vector3D.hpp"
+
+namespace Raytracer {
+
+  /**
+   * @brief Compiled binary form of a scene.
+   *
+   * The cache is written next to the scene (`scene.cfg.cache`) and holds
+   * the flattened scene, camera, primitives and lights of the file and of
+   * every scene it imports, together with the mesh buffers of every OBJ file
+   * it uses and their prebuilt face BVH. A start-up whose files did not
+   * change creates the scene from the cache without reading any of them.
+   *
+   * The scene and each mesh record list the files they were built from
+   * (configuration files, OBJ files, MTL libraries) with their size, write
+   * time and content hash. A file whose size and write time are unchanged
+   * is trusted as is; only a file whose write time moved is hashed again,
+   * to tell a touched file from an edited one. A stale scene is parsed
+   * from its files again, reusing the meshes whose records are still
+   * valid, and the cache is rewritten.
+   *
+   * Opening a cache maps the file and reads its index only. Primitives,
+   * vertices, faces and BVH nodes are never copied: the objects created
+   * from the cache point into the mapping, which they keep alive.
+   */
+  class SceneCache {
+    public:
+      /**
+       * @brief Version of what the file holds, bumped whenever a section is
+       * added or changes. The in-memory layout of the records the file
+       * stores as raw bytes is checked separately, so a change of Face,
+       * FaceEdges, BVH nodes or the records below is caught without a bump.
+       * Caches of another version or layout are ignored.
+       */
+      static constexpr std::uint32_t version = 3;
+
+      /**
+       * @brief A primitive of the flattened scene: what the parser read for
+       * one entry of a primitive list, in the order it applies it.
+       * Trivially copyable, so the primitives of a cached scene are read
+       * straight from the mapping.
+       */
+      struct Primitive {
+        /**
+         * @brief The list the entry comes from.
+         */
+        enum Kind : std::uint32_t {
+          Sphere,
+          Cylinder,
+          CylinderInf,
+          Cone,
+          ConeInf,
+          Plane,
+          Triangle,
+          Instance
+        };
+
+        /**
+         * @brief The `material` field of the entry.
+         */
+        enum Material : std::uint32_t {
+          NoMaterial,
+          Reflective,
+          Refractive,
+          Transparent
+        };
+
+        /**
+         * @brief Optional fields present in the entry, as bits of flags.
+         */
+        enum Flag : std::uint32_t {
+          Translated = 1u << 0, ///< translation is set.
+          Rotated = 1u << 1,    ///< axis and angle are set.
+          Scaled = 1u << 2      ///< scale is set.
+        };
+
+        std::uint32_t kind;       ///< Kind of the primitive.
+        std::uint32_t material;   ///< Material of the primitive.
+        std::uint32_t flags;      ///< Flag bits.
+        std::uint32_t mesh;       ///< OBJ file of an Instance in Scene::meshes.
+        std::uint64_t setting;    ///< Hash of the setting, for reloads.
+        Math::Point3D center;     ///< Center, or first vertex of a triangle.
+        Math::Point3D p2;         ///< Second vertex of a triangle.
+        Math::Point3D p3;         ///< Third vertex of a triangle.
+        Math::Vector3D color;     ///< Color.
+        Math::Vector3D normal;    ///< Normal of a plane.
+        Math::Vector3D translation; ///< Translation, if Translated.
+        Math::Vector3D axis;      ///< Rotation axis, if Rotated.
+        Math::Vector3D scale;     ///< Scale of an Instance, if Scaled.
+        double angle;             ///< Rotation angle in degrees, if Rotated.
+        double radius;            ///< Radius, or aperture of a ConeInf.
+        double height;            ///< Height of a Cylinder or Cone.
+      };
+
+      /**
+       * @brief A light of the flattened scene.
+       */
+      struct Light {
+        /**
+         * @brief The list the entry comes from.
+         */
+        enum Kind : std::uint32_t { Ambient, Point, Directional };
+
+        std::uint32_t kind;       ///< Kind of the light.
+        std::uint32_t padding;    ///< Unused, keeps the layout explicit.
+        std::uint64_t setting;    ///< Hash of the setting, for reloads.
+        Math::Point3D position;   ///< Position of a Point light.
+        Math::Vector3D color;     ///< Color.
+        Math::Vector3D direction; ///< Normalized direction of a Directional.
+        double intensity;         ///< Intensity.
+      };
+
+      /**
+       * @brief The camera of the flattened scene.
+       */
+      struct View {
+        std::int32_t width;    ///< Image width.
+        std::int32_t height;   ///< Image height.
+        Math::Point3D origin;  ///< Position.
+        double fieldOfView;    ///< Field of view in degrees.
+      };
+
+      /**
+       * @brief A scene flattened with the scenes it imports, in the order
+       * the parser creates its shapes and lights.
+       */
+      struct Scene {
+        View camera{};                   ///< The camera of the root file.
+        bool hasDiffuse = false;         ///< Whether a file sets diffuse.
+        double diffuse = 0.0;            ///< The last diffuse multiplier set.
+        std::vector<std::string> files;  ///< Files the scene is built from.
+        std::vector<std::string> meshes; ///< OBJ files of the instances.
+        SharedArray<Primitive> primitives; ///< Primitives, in order.
+        SharedArray<Light> lights;         ///< Lights, in order.
+      };
+
+      /**
+       * @brief Opens the cache of a scene, if there is a usable one.
+       * @param scenePath The path of the .cfg file.
+       */
+      explicit SceneCache(const std::string &scenePath);
+
+      /**
+       * @brief Default destructor. Objects read from the cache keep the
+       * mapping alive.
+       */
+      ~SceneCache() = default;
+
+      SceneCache(const SceneCache &) = delete;
+      SceneCache &operator=(const SceneCache &) = delete;
+
+      /**
+       * @brief Gets the path of the cache of a scene.
+       * @param scenePath The path of the .cfg file.
+       * @return std::string The path of the cache file.
+       */
+      static std::string pathFor(const std::string &scenePath) {
+        return scenePath + ".cache";
+      }
+
+      /**
+       * @brief Hashes the content of a file.
+       * @param path The path of the file.
+       * @return std::uint64_t The hash, 0 if the file cannot be read.
+       */
+      static std::uint64_t hashFile(const std::string &path);
+
+      /**
+       * @brief Gets the flattened scene, if none of its files changed since
+       * the cache was written.
+       * @return const Scene* The scene, or nullptr if the scene must be
+       * parsed from its files.
+       */
+      const Scene *getScene() const {
+        return _scene.get();
+      }
+
+      /**
+       * @brief Reads the mesh of an OBJ file out of the cache. Safe to call
+       * from several threads.
+       * @param objFile The path of the OBJ file.
+       * @param create Creates the empty object the mesh is read into.
+       * @param sources Receives the files the mesh was built from.
+       * @return std::shared_ptr<Object> The mesh, or nullptr if the cache has
+       * no record for this file or one of its source files changed.
+       */
+      std::shared_ptr<Object> find(const std::string &objFile,
+                                   const MeshCache::Loader &create,
+                                   std::vector<std::string> &sources) const;
+
+      /**
+       * @brief Gets the number of mesh records of the cache.
+       * @return std::size_t The number of records.
+       */
+      std::size_t size() const {
+        return _records.size();
+      }
+
+      /**
+       * @brief Notes that the scene or a mesh had to be read from its files,
+       * so the cache should be written again.
+       */
+      void markDirty() {
+        _dirty = true;
+      }
+
+      /**
+       * @brief Checks whether the cache should be written again.
+       * @return true if the scene or a mesh was read without the cache.
+       */
+      bool isDirty() const {
+        return _dirty;
+      }
+
+      /**
+       * @brief Writes the cache of a scene.
+       * @param scenePath The path of the .cfg file.
+       * @param scene The flattened scene.
+       * @param meshes The meshes of the scene, with their source files.
+       * @throw std::runtime_error if the cache cannot be written.
+       */
+      static void save(const std::string &scenePath, const Scene &scene,
+                       const MeshCache &meshes);
+
+    private:
+      /**
+       * @brief A file a record was built from, as it was when the cache was
+       * written.
+       */
+      struct Source {
+        std::string path;   ///< Path of the file.
+        std::uint64_t size; ///< Size in bytes.
+        std::int64_t mtime; ///< Write time, in ticks of the file clock.
+        std::uint64_t hash; ///< Content hash, see hashFile().
+      };
+
+      /**
+       * @brief Checks whether a file is the one a record was built from:
+       * same size and write time, or same size and content.
+       * @param source The file as it was recorded.
+       * @return true if the file did not change.
+       */
+      static bool unchanged(const Source &source);
+
+      /**
+       * @brief Location of a mesh in the mapped cache.
+       */
+      struct Record {
+        std::vector<Source> sources; ///< Source files at save time.
+        const char *data;            ///< First byte of the mesh buffers.
+        std::size_t size;            ///< Size of the mesh buffers in bytes.
+      };
+
+      std::shared_ptr<const MappedFile>
+          _file; ///< Mapped cache, null if unusable.
+      std::unique_ptr<Scene> _scene; ///< Flattened scene, null if stale.
+      std::unordered_map<std::string, Record>
+          _records;                      ///< Mesh records by canonical path.
+      std::atomic<bool> _dirty = false;  ///< Set by markDirty().
+  };
+
+}  // namespace Raytracer
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "ILight.hpp"
+#include "IShape.hpp"
+
+namespace Raytracer {
+
+  /**
+   * @brief Shapes and lights of a parsed scene, indexed by the signature of
+   * the setting each one was created from.
+   *
+   * On reload, the parser looks every new setting up in the index of the live
+   * scene: when the signature matches, the live object is reused instead of
+   * the freshly parsed one, so everything it holds (meshes, transforms,
+   * acceleration structures) is kept. Several parsers fill the same index
+   * concurrently, hence the lock.
+   */
+  class SceneIndex {
+    public:
+      /**
+       * @brief Creates an empty index.
+       */
+      SceneIndex() = default;
+
+      /**
+       * @brief Copies the shapes and lights of another index.
+       * @param other The index to copy.
+       */
+      SceneIndex(const SceneIndex &other) {
+        std::lock_guard<std::mutex> lock(other._mutex);
+        _shapes = other._shapes;
+        _lights = other._lights;
+      }
+
+      /**
+       * @brief Records a shape.
+       * @param signature The signature of its setting.
+       * @param shape The shape.
+       */
+      void addShape(std::uint64_t signature, std::shared_ptr<IShape> shape) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _shapes.emplace(signature, std::move(shape));
+      }
+
+      /**
+       * @brief Removes a shape with a given signature from the index.
+       * @param signature The signature of the setting being parsed.
+       * @return std::shared_ptr<IShape> The shape, or nullptr if none has
+       * this signature.
+       */
+      std::shared_ptr<IShape> takeShape(std::uint64_t signature) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _shapes.find(signature);
+        if (it == _shapes.end())
+          return nullptr;
+        auto shape = std::move(it->second);
+        _shapes.erase(it);
+        return shape;
+      }
+
+      /**
+       * @brief Records a light.
+       * @param signature The signature of its setting.
+       * @param light The light.
+       */
+      void addLight(std::uint64_t signature, std::shared_ptr<ILight> light) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _lights.emplace(signature, std::move(light));
+      }
+
+      /**
+       * @brief Removes a light with a given signature from the index.
+       * @param signature The signature of the setting being parsed.
+       * @return std::shared_ptr<ILight> The light, or nullptr if none has
+       * this signature.
+       */
+      std::shared_ptr<ILight> takeLight(std::uint64_t signature) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _lights.find(signature);
+        if (it == _lights.end())
+          return nullptr;
+        auto light = std::move(it->second);
+        _lights.erase(it);
+        return light;
+      }
+
+    private:
+      std::unordered_multimap<std::uint64_t, std::shared_ptr<IShape>>
+          _shapes; ///< Shapes by signature.
+      std::unordered_multimap<std::uint64_t, std::shared_ptr<ILight>>
+          _lights; ///< Lights by signature.
+      mutable std::mutex _mutex; ///< Guards both maps.
+  };
+
+}  // namespace Raytracer
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Raytracer {
+
+  /**
+   * @brief Read-only array that either owns its elements or points into
+   * memory owned by someone else, such as a mapped scene cache.
+   *
+   * A view keeps its owner alive through a shared pointer, so a mesh read
+   * out of a cache can outlive the cache object that mapped it. Element
+   * access does not depend on which of the two the array is. The elements
+   * of a view are never written: mutableData() copies them into an owned
+   * buffer first.
+   */
+  template <typename T>
+  class SharedArray {
+    public:
+      /**
+       * @brief Creates an empty array.
+       */
+      SharedArray() = default;
+
+      /**
+       * @brief Takes ownership of a vector. Not explicit, so that setters
+       * taking a SharedArray still accept a moved vector.
+       * @param values The elements.
+       */
+      SharedArray(std::vector<T> values)
+          : _owned(std::move(values)), _data(_owned.data()),
+            _size(_owned.size()) {}
+
+      /**
+       * @brief Points into memory kept alive by owner.
+       * @param owner Whatever keeps the elements alive.
+       * @param data The first element.
+       * @param size The number of elements.
+       */
+      SharedArray(std::shared_ptr<const void> owner, const T *data,
+                  std::size_t size)
+          : _owner(std::move(owner)), _data(data), _size(size) {}
+
+      /**
+       * @brief Copies an array: owned elements are copied, a view shares
+       * the same memory and owner.
+       * @param other The array to copy.
+       */
+      SharedArray(const SharedArray &other)
+          : _owned(other._owned), _owner(other._owner),
+            _data(other._owner ? other._data : _owned.data()),
+            _size(other._size) {}
+
+      /**
+       * @brief Moves an array, leaving it empty.
+       * @param other The array to move.
+       */
+      SharedArray(SharedArray &&other) noexcept
+          : _owned(std::move(other._owned)), _owner(std::move(other._owner)),
+            _data(std::exchange(other._data, nullptr)),
+            _size(std::exchange(other._size, 0)) {}
+
+      SharedArray &operator=(const SharedArray &other) {
+        if (this != &other)
+          *this = SharedArray(other);
+        return *this;
+      }
+
+      SharedArray &operator=(SharedArray &&other) noexcept {
+        _owned = std::move(other._owned);
+        _owner = std::move(other._owner);
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0);
+        return *this;
+      }
+
+      /**
+       * @brief Default destructor. Releases the owner of a view.
+       */
+      ~SharedArray() = default;
+
+      /**
+       * @brief Gets the first element.
+       * @return const T* The elements, nullptr if there are none.
+       */
+      const T *data() const {
+        return _data;
+      }
+
+      /**
+       * @brief Gets the number of elements.
+       * @return std::size_t The size.
+       */
+      std::size_t size() const {
+        return _size;
+      }
+
+      /**
+       * @brief Checks whether there is no element.
+       * @return true if the array is empty.
+       */
+      bool empty() const {
+        return _size == 0;
+      }
+
+      /**
+       * @brief Gets an element, without bounds check.
+       * @param i The index of the element.
+       * @return const T& The element.
+       */
+      const T &operator[](std::size_t i) const {
+        return _data[i];
+      }
+
+      /**
+       * @brief Gets the first element, for range-based loops.
+       * @return const T* The first element.
+       */
+      const T *begin() const {
+        return _data;
+      }
+
+      /**
+       * @brief Gets past the last element, for range-based loops.
+       * @return const T* Past the last element.
+       */
+      const T *end() const {
+        return _data + _size;
+      }
+
+      /**
+       * @brief Checks whether the elements live in memory owned by someone
+       * else.
+       * @return true for a view.
+       */
+      bool isView() const {
+        return _owner != nullptr;
+      }
+
+      /**
+       * @brief Gets the elements for writing in place, copying them out of
+       * their owner first for a view. The size cannot change.
+       * @return T* The first element.
+       */
+      T *mutableData() {
+        if (_owner) {
+          _owned.assign(_data, _data + _size);
+          _owner.reset();
+          _data = _owned.data();
+        }
+        return _owned.data();
+      }
+
+    private:
+      std::vector<T> _owned;              ///< Elements, when owned.
+      std::shared_ptr<const void> _owner; ///< Owner of the elements of a view.
+      const T *_data = nullptr;           ///< First element.
+      std::size_t _size = 0;              ///< Number of elements.
+  };
+
+}  // namespace Raytracer
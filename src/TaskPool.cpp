@@ -0,0 +1,90 @@
+#include "TaskPool.hpp"
+#include <algorithm>
+
+/**
+ * @brief Starts the workers.
+ *
+ * @param threads The number of worker threads. 0 (an unknown hardware
+ * concurrency) is treated as 1.
+ */
+Raytracer::TaskPool::TaskPool(std::size_t threads) {
+  threads = std::max<std::size_t>(1, threads);
+  _workers.reserve(threads);
+  for (std::size_t i = 0; i < threads; i++)
+    _workers.emplace_back([this]() { work(); });
+}
+
+/**
+ * @brief Runs the remaining tasks, then stops and joins the workers.
+ */
+Raytracer::TaskPool::~TaskPool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _ready.notify_all();
+  for (auto &worker : _workers)
+    worker.join();
+}
+
+/**
+ * @brief Gets the pool shared by the whole program.
+ *
+ * Created on first use so that programs which never load anything in
+ * parallel do not start any thread.
+ * @return Raytracer::TaskPool& The shared pool.
+ */
+Raytracer::TaskPool &Raytracer::TaskPool::global() {
+  static TaskPool pool;
+  return pool;
+}
+
+/**
+ * @brief Queues a type-erased task and wakes a worker.
+ *
+ * @param task The task.
+ */
+void Raytracer::TaskPool::push(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _tasks.push_back(std::move(task));
+  }
+  _ready.notify_one();
+}
+
+/**
+ * @brief Runs one queued task on the calling thread, if there is one.
+ *
+ * @return true if a task was run.
+ */
+bool Raytracer::TaskPool::runOne() {
+  std::function<void()> task;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_tasks.empty())
+      return false;
+    task = std::move(_tasks.front());
+    _tasks.pop_front();
+  }
+  task();
+  return true;
+}
+
+/**
+ * @brief Loop of each worker thread: runs tasks until the pool is stopping
+ * and the queue is empty.
+ */
+void Raytracer::TaskPool::work() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _ready.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+      if (_tasks.empty())
+        return;
+      task = std::move(_tasks.front());
+      _tasks.pop_front();
+    }
+    task();
+  }
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Raytracer {
+
+  /**
+   * @brief Fixed set of worker threads running queued tasks.
+   *
+   * Tasks may themselves submit tasks and wait for them: a thread waiting
+   * through wait() or parallelFor() runs queued tasks instead of blocking,
+   * so nested parallelism (a sub-scene task loading its meshes, a mesh load
+   * splitting its file in chunks...) cannot exhaust the workers.
+   */
+  class TaskPool {
+    public:
+      /**
+       * @brief Starts the workers.
+       * @param threads The number of worker threads, at least 1.
+       */
+      explicit TaskPool(std::size_t threads =
+                            std::thread::hardware_concurrency());
+
+      /**
+       * @brief Runs the remaining tasks, then stops and joins the workers.
+       */
+      ~TaskPool();
+
+      TaskPool(const TaskPool &) = delete;
+      TaskPool &operator=(const TaskPool &) = delete;
+
+      /**
+       * @brief Queues a task.
+       * @param fn The callable to run.
+       * @return std::future The result of the task, or the exception it
+       * threw.
+       */
+      template <typename Fn>
+      std::future<std::invoke_result_t<Fn>> submit(Fn &&fn) {
+        using Result = std::invoke_result_t<Fn>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(
+            std::forward<Fn>(fn));
+        std::future<Result> future = task->get_future();
+        push([task]() { (*task)(); });
+        return future;
+      }
+
+      /**
+       * @brief Waits for a task, running queued tasks in the meantime.
+       * @param future The future returned by submit().
+       * @return The result of the task.
+       * @throw Whatever the task threw.
+       */
+      template <typename T>
+      T wait(std::future<T> &future) {
+        while (future.wait_for(std::chrono::seconds(0)) !=
+               std::future_status::ready) {
+          if (!runOne())
+            future.wait_for(std::chrono::microseconds(100));
+        }
+        return future.get();
+      }
+
+      /**
+       * @brief Runs `fn(i)` for every i in [0, count) and waits for all of
+       * them.
+       *
+       * Every call runs even if some throw; the exception of the lowest index
+       * is then rethrown, so errors are reported deterministically.
+       * @param count The number of calls.
+       * @param fn Callable as fn(std::size_t).
+       */
+      template <typename Fn>
+      void parallelFor(std::size_t count, Fn &&fn) {
+        if (count == 1) {
+          fn(std::size_t(0));
+          return;
+        }
+        std::vector<std::future<void>> futures;
+        futures.reserve(count);
+        for (std::size_t i = 0; i < count; i++)
+          futures.push_back(submit([&fn, i]() { fn(i); }));
+
+        std::exception_ptr error;
+        for (auto &future : futures) {
+          try {
+            wait(future);
+          } catch (...) {
+            if (!error)
+              error = std::current_exception();
+          }
+        }
+        if (error)
+          std::rethrow_exception(error);
+      }
+
+      /**
+       * @brief Gets the number of worker threads.
+       * @return std::size_t The number of workers.
+       */
+      std::size_t size() const {
+        return _workers.size();
+      }
+
+      /**
+       * @brief Gets the pool shared by the whole program.
+       * @return TaskPool& A pool with one worker per hardware thread.
+       */
+      static TaskPool &global();
+
+    private:
+      std::vector<std::thread> _workers;        ///< Worker threads.
+      std::deque<std::function<void()>> _tasks; ///< Queued tasks, FIFO.
+      std::mutex _mutex;                        ///< Guards _tasks and _stopping.
+      std::condition_variable _ready;           ///< Signals new tasks or stop.
+      bool _stopping = false;                   ///< Set by the destructor.
+
+      /**
+       * @brief Queues a type-erased task and wakes a worker.
+       * @param task The task.
+       */
+      void push(std::function<void()> task);
+
+      /**
+       * @brief Runs one queued task on the calling thread, if there is one.
+       * @return true if a task was run.
+       */
+      bool runOne();
+
+      /**
+       * @brief Loop of each worker thread.
+       */
+      void work();
+  };
+
+}  // namespace Raytracer
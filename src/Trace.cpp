@@ -0,0 +1,155 @@
+#include "Trace.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+  /**
+   * @brief A complete event, in microseconds since the start of the trace.
+   */
+  struct Event {
+    const char *name;
+    const char *category;
+    std::string detail;
+    double ts;
+    double dur;
+    int tid;
+  };
+
+  constexpr std::size_t maxEvents = 1 << 21; ///< About 200 MB of JSON.
+
+  std::mutex mutex;                      ///< Guards everything below.
+  std::vector<Event> events;             ///< Events recorded so far.
+  std::string output;                    ///< File written by stop().
+  std::chrono::steady_clock::time_point origin; ///< Time 0 of the trace.
+  int mainThread = 0;                    ///< Track of the thread that started.
+  int threadCount = 0;                   ///< Tracks handed out so far.
+  std::size_t dropped = 0;               ///< Events past maxEvents.
+
+  /**
+   * @brief Gets the track of the calling thread. Called with mutex held.
+   * @return int A small id, stable for the life of the thread.
+   */
+  int threadId() {
+    thread_local int id = 0;
+    if (id == 0)
+      id = ++threadCount;
+    return id;
+  }
+
+  /**
+   * @brief Escapes a string for a JSON document.
+   * @param value The string.
+   * @return std::string The quoted, escaped string.
+   */
+  std::string quote(const std::string &value) {
+    std::string out = "\"";
+    for (char c : value) {
+      if (c == '"' || c == '\\') {
+        out += '\\';
+        out += c;
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        out += escaped;
+      } else {
+        out += c;
+      }
+    }
+    return out + "\"";
+  }
+
+}  // namespace
+
+/**
+ * @brief Starts recording.
+ *
+ * @param path The JSON file written by stop().
+ */
+void Raytracer::Trace::start(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mutex);
+  events.clear();
+  dropped = 0;
+  output = path;
+  origin = std::chrono::steady_clock::now();
+  mainThread = threadId();
+  _enabled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Stops recording and writes the trace.
+ *
+ * The file uses the JSON object format: complete events in "traceEvents",
+ * preceded by metadata naming the process and one track per thread.
+ * @throw std::runtime_error if the file cannot be written.
+ */
+void Raytracer::Trace::stop() {
+  if (!_enabled.exchange(false))
+    return;
+  std::lock_guard<std::mutex> lock(mutex);
+  std::ofstream out(output, std::ios::trunc);
+  if (!out)
+    throw std::runtime_error("Cannot write trace: " + output);
+
+  int pid = static_cast<int>(getpid());
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid
+      << ", \"tid\": " << mainThread
+      << ", \"args\": {\"name\": \"raytracer\"}}";
+  for (int tid = 1; tid <= threadCount; tid++) {
+    out << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid
+        << ", \"tid\": " << tid << ", \"args\": {\"name\": \""
+        << (tid == mainThread ? std::string("main")
+                              : "thread " + std::to_string(tid))
+        << "\"}}";
+  }
+  for (const auto &event : events) {
+    out << ",\n{\"name\": " << quote(event.name) << ", \"cat\": "
+        << quote(event.category) << ", \"ph\": \"X\", \"pid\": " << pid
+        << ", \"tid\": " << event.tid << ", \"ts\": " << event.ts
+        << ", \"dur\": " << event.dur;
+    if (!event.detail.empty())
+      out << ", \"args\": {\"detail\": " << quote(event.detail) << "}";
+    out << "}";
+  }
+  out << "\n]}\n";
+  if (!out)
+    throw std::runtime_error("Cannot write trace: " + output);
+  if (dropped > 0)
+    std::cerr << "[WARNING] - Trace full, " << dropped
+              << " events were dropped" << std::endl;
+  events.clear();
+  events.shrink_to_fit();
+}
+
+/**
+ * @brief Records a complete event.
+ *
+ * Events past maxEvents are counted and dropped, so that an interactive
+ * session left running does not grow the trace without bound.
+ * @param name The name of the event.
+ * @param category The category of the event.
+ * @param detail The "detail" argument, omitted if empty.
+ * @param start When the event started.
+ * @param end When the event ended.
+ */
+void Raytracer::Trace::record(const char *name, const char *category,
+                              const std::string &detail,
+                              std::chrono::steady_clock::time_point start,
+                              std::chrono::steady_clock::time_point end) {
+  using Micro = std::chrono::duration<double, std::micro>;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!enabled())
+    return;
+  if (events.size() >= maxEvents) {
+    dropped++;
+    return;
+  }
+  events.push_back({name, category, detail, Micro(start - origin).count(),
+                    Micro(end - start).count(), threadId()});
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace Raytracer {
+
+  /**
+   * @brief Records a timeline of the program as a Chrome trace_event file,
+   * viewable in chrome://tracing or Perfetto.
+   *
+   * Recording is off until start() is called; a Scope then costs a single
+   * relaxed load. Events are kept in memory and written by stop(), one track
+   * per thread. Only the core records events: plugins are traced at their
+   * call sites.
+   */
+  class Trace {
+    public:
+      /**
+       * @brief Times a block as one complete ("X") event, from construction
+       * to destruction.
+       */
+      class Scope {
+        public:
+          /**
+           * @brief Starts the event if a trace is being recorded.
+           * @param name The name of the event. Must outlive the trace, such as
+           * a string literal.
+           * @param category The category of the event, also a literal.
+           * @param detail Shown as the "detail" argument of the event.
+           */
+          Scope(const char *name, const char *category,
+                std::string detail = {})
+              : _name(name), _category(category) {
+            if (!enabled())
+              return;
+            _detail = std::move(detail);
+            _start = std::chrono::steady_clock::now();
+            _active = true;
+          }
+
+          /**
+           * @brief Records the event.
+           */
+          ~Scope() {
+            if (_active)
+              record(_name, _category, _detail, _start,
+                     std::chrono::steady_clock::now());
+          }
+
+          Scope(const Scope &) = delete;
+          Scope &operator=(const Scope &) = delete;
+
+        private:
+          const char *_name;     ///< Name of the event.
+          const char *_category; ///< Category of the event.
+          std::string _detail;   ///< Argument shown with the event.
+          std::chrono::steady_clock::time_point _start; ///< Start time.
+          bool _active = false;  ///< Whether a trace was being recorded.
+      };
+
+      /**
+       * @brief Starts recording. Events recorded before are dropped.
+       * @param path The JSON file written by stop().
+       */
+      static void start(const std::string &path);
+
+      /**
+       * @brief Stops recording and writes the trace, if one was started.
+       * @throw std::runtime_error if the file cannot be written.
+       */
+      static void stop();
+
+      /**
+       * @brief Checks whether a trace is being recorded.
+       * @return true between start() and stop().
+       */
+      static bool enabled() {
+        return _enabled.load(std::memory_order_relaxed);
+      }
+
+      /**
+       * @brief Records a complete event.
+       * @param name The name of the event.
+       * @param category The category of the event.
+       * @param detail The "detail" argument, omitted if empty.
+       * @param start When the event started.
+       * @param end When the event ended.
+       */
+      static void record(const char *name, const char *category,
+                         const std::string &detail,
+                         std::chrono::steady_clock::time_point start,
+                         std::chrono::steady_clock::time_point end);
+
+    private:
+      static inline std::atomic<bool> _enabled{false}; ///< Recording.
+  };
+
+}  // namespace Raytracer
@@ -0,0 +1,552 @@
+#include "BVH.hpp"
+#include <algorithm>
+#include <array>
+#include "exceptions/RaytracerException.hpp"
+
+namespace {
+
+  const char *qualityNames[] = {"fast", "sah"}; ///< Indexed by BVH::Quality.
+
+  /**
+   * @brief Runs `fn(begin, end)` over chunks of a range, in parallel if the
+   * range is large enough, and merges the results.
+   * @param parallelFor Runs the chunks, or empty to run serially.
+   * @param first The start of the range.
+   * @param count The size of the range.
+   * @param minChunk The smallest chunk worth a task.
+   * @param fn Callable as T fn(std::uint32_t, std::uint32_t).
+   * @param merge Callable as merge(T &into, const T &from).
+   * @return T The merged result.
+   */
+  template <typename T, typename Fn, typename Merge>
+  T reduceChunks(const Raytracer::BVH::ParallelFor &parallelFor,
+                 std::uint32_t first, std::uint32_t count,
+                 std::uint32_t minChunk, Fn &&fn, Merge &&merge) {
+    std::uint32_t chunks = std::min<std::uint32_t>(count / minChunk, 64);
+    if (!parallelFor || chunks < 2)
+      return fn(first, first + count);
+    std::uint32_t size = (count + chunks - 1) / chunks;
+    std::vector<T> results(chunks);
+    parallelFor(chunks, [&](std::size_t chunk) {
+      std::uint32_t begin = first + static_cast<std::uint32_t>(chunk) * size;
+      results[chunk] = fn(begin, std::min(begin + size, first + count));
+    });
+    for (std::uint32_t chunk = 1; chunk < chunks; chunk++)
+      merge(results[0], results[chunk]);
+    return results[0];
+  }
+
+  /**
+   * @brief Grows a box to contain another one, inline unlike
+   * AABB::expand() since binning calls it for every primitive and level.
+   * @param box The box to grow.
+   * @param min The minimum corner of the other box.
+   * @param max The maximum corner of the other box.
+   */
+  inline void grow(Math::AABB &box, const Math::Point3D &min,
+                   const Math::Point3D &max) {
+    box.min.x = std::min(box.min.x, min.x);
+    box.min.y = std::min(box.min.y, min.y);
+    box.min.z = std::min(box.min.z, min.z);
+    box.max.x = std::max(box.max.x, max.x);
+    box.max.y = std::max(box.max.y, max.y);
+    box.max.z = std::max(box.max.z, max.z);
+  }
+
+  /**
+   * @brief Copies a subtree built in its own array into a slot of another
+   * array, appending its descendants after the current end.
+   * @param nodes The array receiving the subtree.
+   * @param slot The node the root of the subtree replaces.
+   * @param subtree The subtree, root first.
+   */
+  void attach(std::vector<Raytracer::BVH::Node> &nodes, std::uint32_t slot,
+              const std::vector<Raytracer::BVH::Node> &subtree) {
+    std::uint32_t base = static_cast<std::uint32_t>(nodes.size());
+    auto relocate = [base](Raytracer::BVH::Node node) {
+      if (node.count == 0)
+        node.first = base + node.first - 1;
+      return node;
+    };
+    nodes[slot] = relocate(subtree[0]);
+    for (std::size_t i = 1; i < subtree.size(); i++)
+      nodes.push_back(relocate(subtree[i]));
+  }
+
+}  // namespace
+
+/**
+ * @brief The state shared by every node of a build.
+ *
+ * Nodes partition the references themselves rather than indices into the
+ * primitive boxes, so that every level reads them in order.
+ */
+struct Raytracer::BVH::Builder {
+  /**
+   * @brief A primitive being sorted into the tree.
+   */
+  struct Reference {
+    Math::AABB bounds;      ///< Box of the primitive.
+    Math::Point3D centroid; ///< Centre of the box.
+    std::uint32_t index;    ///< Index of the primitive.
+  };
+
+  std::vector<Reference> references; ///< Primitives, in leaf order once built.
+  std::vector<std::uint32_t> codes;  ///< Morton code of each reference.
+  Quality quality;                   ///< The build preset.
+  const ParallelFor &parallelFor;    ///< Runs tasks, may be empty.
+};
+
+/**
+ * @brief Gets the name of a preset.
+ *
+ * @param quality The preset.
+ * @return const char* Its name.
+ */
+const char *Raytracer::BVH::qualityName(Quality quality) {
+  return quality >= 0 && quality < QualityCount ? qualityNames[quality]
+                                                : "unknown";
+}
+
+/**
+ * @brief Parses the name of a preset.
+ *
+ * @param name The name.
+ * @return Quality The preset.
+ * @throw RaytracerError if the name is unknown.
+ */
+Raytracer::BVH::Quality Raytracer::BVH::parseQuality(const std::string &name) {
+  for (int i = 0; i < QualityCount; i++) {
+    if (name == qualityNames[i])
+      return static_cast<Quality>(i);
+  }
+  throw RaytracerError("Unknown BVH quality \"" + name +
+                       "\", expected fast or sah");
+}
+
+/**
+ * @brief Builds the hierarchy from the bounds of each primitive.
+ *
+ * Any previous content is discarded. Primitives with an empty box are kept
+ * out of the tree since no ray can reach them. The fast preset first sorts
+ * the primitives along a Morton curve, in parallel chunks merged pairwise.
+ * Nodes large enough build their two subtrees as parallel tasks, each in its
+ * own array, attached to the main one once done.
+ * @param primitiveBounds One box per primitive.
+ * @param quality The build preset.
+ * @param parallelFor Runs tasks, or empty to build on the calling thread.
+ */
+void Raytracer::BVH::build(const std::vector<Math::AABB> &primitiveBounds,
+                           Quality quality, const ParallelFor &parallelFor) {
+  _nodes = {};
+  _indices = {};
+  _wide = {};
+  _lanes = {};
+  _cost = _builtCost = 0.0;
+
+  Builder builder{{}, {}, quality, parallelFor};
+  Math::AABB centroidBounds;
+  for (std::uint32_t i = 0; i < primitiveBounds.size(); i++) {
+    if (primitiveBounds[i].isEmpty())
+      continue;
+    Math::Point3D centroid = primitiveBounds[i].centroid();
+    centroidBounds.expand(centroid);
+    builder.references.push_back({primitiveBounds[i], centroid, i});
+  }
+  if (builder.references.empty())
+    return;
+
+  if (quality == QualityFast) {
+    std::vector<std::uint64_t> keys(builder.references.size());
+    for (std::uint32_t i = 0; i < keys.size(); i++)
+      keys[i] = static_cast<std::uint64_t>(centroidBounds.mortonCode(
+                    builder.references[i].centroid))
+                    << 32 | i;
+    std::size_t chunks = parallelFor && keys.size() >= 2 * parallelThreshold
+                             ? 16 : 1;
+    std::size_t size = (keys.size() + chunks - 1) / chunks;
+    auto bound = [&](std::size_t chunk) {
+      return keys.begin() + std::min(chunk * size, keys.size());
+    };
+    auto sortChunks = [&](std::size_t chunk) {
+      std::sort(bound(chunk), bound(chunk + 1));
+    };
+    if (chunks > 1)
+      parallelFor(chunks, sortChunks);
+    else
+      sortChunks(0);
+    for (std::size_t width = 1; width < chunks; width *= 2) {
+      parallelFor(chunks / (2 * width), [&](std::size_t pair) {
+        std::size_t left = pair * 2 * width;
+        std::inplace_merge(bound(left), bound(left + width),
+                           bound(left + 2 * width));
+      });
+    }
+    std::vector<Builder::Reference> sorted(keys.size());
+    builder.codes.resize(keys.size());
+    for (std::size_t i = 0; i < keys.size(); i++) {
+      builder.codes[i] = static_cast<std::uint32_t>(keys[i] >> 32);
+      sorted[i] = builder.references[static_cast<std::uint32_t>(keys[i])];
+    }
+    builder.references = std::move(sorted);
+  }
+
+  std::uint32_t count = static_cast<std::uint32_t>(builder.references.size());
+  std::vector<Node> nodes;
+  nodes.reserve(2 * count);
+  nodes.push_back({Math::AABB(), 0, count});
+  subdivide(nodes, 0, builder, 0, centroidBounds);
+  nodes.shrink_to_fit();
+  _nodes = std::move(nodes);
+  _builtCost = _cost = cost();
+  std::vector<std::uint32_t> indices(count);
+  for (std::uint32_t i = 0; i < count; i++)
+    indices[i] = builder.references[i].index;
+  _indices = std::move(indices);
+  collapse();
+}
+
+/**
+ * @brief Recomputes the node bounds bottom-up.
+ *
+ * Children are always stored after their parent, so walking the node array
+ * backwards visits every child before its parent. The cost of the tree is
+ * summed along the way, and the wide nodes are updated in place, once
+ * copied out of the scene cache they may have been read from.
+ * @param primitiveBounds The new box of each primitive.
+ */
+void Raytracer::BVH::refit(const std::vector<Math::AABB> &primitiveBounds) {
+  double area = 0.0;
+  Node *nodes = _nodes.mutableData();
+  for (std::size_t i = _nodes.size(); i-- > 0;) {
+    Node &node = nodes[i];
+    Math::AABB bounds;
+
+    if (node.count > 0) {
+      for (std::uint32_t j = 0; j < node.count; j++)
+        bounds.expand(primitiveBounds[_indices[node.first + j]]);
+    } else {
+      bounds.expand(nodes[node.first].bounds);
+      bounds.expand(nodes[node.first + 1].bounds);
+    }
+    node.bounds = bounds;
+    area += bounds.surfaceArea() * std::max<std::uint32_t>(node.count, 1);
+  }
+  double rootArea = _nodes.empty() ? 0.0 : _nodes[0].bounds.surfaceArea();
+  _cost = rootArea > 0 ? area / rootArea : 0.0;
+  refitWide();
+}
+
+/**
+ * @brief Computes the surface area heuristic cost of the binary tree.
+ *
+ * @return double The cost relative to the area of the root.
+ */
+double Raytracer::BVH::cost() const {
+  if (_nodes.empty())
+    return 0.0;
+  double rootArea = _nodes[0].bounds.surfaceArea();
+  if (rootArea <= 0)
+    return 0.0;
+  double area = 0.0;
+  for (const Node &node : _nodes)
+    area += node.bounds.surfaceArea() * std::max<std::uint32_t>(node.count, 1);
+  return area / rootArea;
+}
+
+/**
+ * @brief Updates the boxes of the 4-wide tree from the binary one.
+ *
+ * Every lane remembers the binary node it was collapsed from, so this is a
+ * copy with no allocation.
+ */
+void Raytracer::BVH::refitWide() {
+  WideNode *wide = _wide.mutableData();
+  for (std::size_t i = 0; i < _wide.size(); i++) {
+    WideNode &node = wide[i];
+    for (int lane = 0; lane < node.size; lane++) {
+      const Math::AABB &bounds = _nodes[_lanes[i * width + lane]].bounds;
+      node.minX[lane] = bounds.min.x;
+      node.minY[lane] = bounds.min.y;
+      node.minZ[lane] = bounds.min.z;
+      node.maxX[lane] = bounds.max.x;
+      node.maxY[lane] = bounds.max.y;
+      node.maxZ[lane] = bounds.max.z;
+    }
+  }
+}
+
+/**
+ * @brief Rebuilds the 4-wide tree from the binary one.
+ *
+ * A binary tree that is a single leaf becomes a wide root with one child.
+ */
+void Raytracer::BVH::collapse() {
+  _wide = {};
+  _lanes = {};
+  if (_nodes.empty())
+    return;
+  std::vector<WideNode> wide;
+  std::vector<std::uint32_t> lanes;
+  wide.reserve(_nodes.size() / 2 + 1);
+  lanes.reserve(wide.capacity() * width);
+  if (_nodes[0].count > 0) {
+    WideNode root{};
+    const Node &leaf = _nodes[0];
+    root.minX[0] = leaf.bounds.min.x;
+    root.minY[0] = leaf.bounds.min.y;
+    root.minZ[0] = leaf.bounds.min.z;
+    root.maxX[0] = leaf.bounds.max.x;
+    root.maxY[0] = leaf.bounds.max.y;
+    root.maxZ[0] = leaf.bounds.max.z;
+    root.child[0] = leaf.first;
+    root.count[0] = leaf.count;
+    root.size = 1;
+    wide.push_back(root);
+    lanes.resize(width, 0);
+  } else {
+    collapseNode(0, wide, lanes);
+  }
+  _wide = std::move(wide);
+  _lanes = std::move(lanes);
+}
+
+/**
+ * @brief Collapses the subtree under an interior binary node.
+ *
+ * The two children of the node are taken, then the interior child with the
+ * largest surface area is replaced by its own two children until there are
+ * four: the large boxes are the ones most rays cross, so opening them first
+ * saves the most node visits. The remaining interior children are collapsed
+ * in turn.
+ * @param nodeIndex The binary node, which must not be a leaf.
+ * @param wide The wide nodes being built.
+ * @param wideLanes The binary node of each of their lanes.
+ * @return std::uint32_t The index of the wide node.
+ */
+std::uint32_t Raytracer::BVH::collapseNode(
+    std::uint32_t nodeIndex, std::vector<WideNode> &wide,
+    std::vector<std::uint32_t> &wideLanes) const {
+  std::uint32_t lanes[width] = {_nodes[nodeIndex].first,
+                                _nodes[nodeIndex].first + 1};
+  int size = 2;
+
+  while (size < width) {
+    int widest = -1;
+    double widestArea = -1.0;
+    for (int lane = 0; lane < size; lane++) {
+      const Node &child = _nodes[lanes[lane]];
+      double area = child.bounds.surfaceArea();
+      if (child.count == 0 && area > widestArea) {
+        widest = lane;
+        widestArea = area;
+      }
+    }
+    if (widest < 0)
+      break;
+    std::uint32_t first = _nodes[lanes[widest]].first;
+    lanes[widest] = first;
+    lanes[size++] = first + 1;
+  }
+
+  std::uint32_t wideIndex = static_cast<std::uint32_t>(wide.size());
+  wide.emplace_back();
+  wideLanes.resize(wide.size() * width, 0);
+  for (int lane = 0; lane < size; lane++) {
+    wideLanes[wideIndex * width + lane] = lanes[lane];
+    const Node &child = _nodes[lanes[lane]];
+    std::uint32_t target =
+        child.count > 0 ? child.first : collapseNode(lanes[lane], wide, wideLanes);
+    WideNode &node = wide[wideIndex];
+    node.minX[lane] = child.bounds.min.x;
+    node.minY[lane] = child.bounds.min.y;
+    node.minZ[lane] = child.bounds.min.z;
+    node.maxX[lane] = child.bounds.max.x;
+    node.maxY[lane] = child.bounds.max.y;
+    node.maxZ[lane] = child.bounds.max.z;
+    node.child[lane] = target;
+    node.count[lane] = child.count;
+  }
+  wide[wideIndex].size = size;
+  return wideIndex;
+}
+
+/**
+ * @brief Splits a node, then recurses in both halves.
+ *
+ * Ranges of at most maxLeafSize primitives become leaves. The fast preset
+ * splits where the highest bit of the Morton codes changes, which keeps
+ * primitives close on the curve together. The SAH preset sorts the centroids
+ * in binCount bins per axis and picks the plane between two bins that
+ * minimizes the area of each side times its number of primitives, the
+ * expected cost of tracing a ray through it; the bins also give the centroid
+ * bounds of both sides. Below maxSahDepth, or when all the centroids
+ * coincide, the range is halved at the median centroid along its longest
+ * axis instead, which bounds the depth for the fixed traversal stack. Bounds
+ * are merged bottom-up, so no level scans its whole range for them.
+ * @param nodes The array the node and its descendants are stored in.
+ * @param nodeIndex The node to split.
+ * @param builder The inputs of the build.
+ * @param depth The depth of the node.
+ * @param centroidBounds The box of the centroids of the range.
+ */
+void Raytracer::BVH::subdivide(std::vector<Node> &nodes,
+                               std::uint32_t nodeIndex,
+                               Builder &builder, int depth,
+                               const Math::AABB &centroidBounds) {
+  std::uint32_t first = nodes[nodeIndex].first;
+  std::uint32_t count = nodes[nodeIndex].count;
+  if (count <= maxLeafSize) {
+    Math::AABB bounds;
+    for (std::uint32_t i = first; i < first + count; i++)
+      bounds.expand(builder.references[i].bounds);
+    nodes[nodeIndex].bounds = bounds;
+    return;
+  }
+
+  std::uint32_t half = 0;
+  Math::Vector3D extent = centroidBounds.extent();
+  bool degenerate = extent.x <= 0 && extent.y <= 0 && extent.z <= 0;
+  if (builder.quality == QualityFast) {
+    std::uint32_t firstCode = builder.codes[first];
+    std::uint32_t lastCode = builder.codes[first + count - 1];
+    if (firstCode != lastCode) {
+      std::uint32_t bit = 1u << (31 - __builtin_clz(firstCode ^ lastCode));
+      auto begin = builder.codes.begin() + first;
+      half = static_cast<std::uint32_t>(
+          std::partition_point(begin, begin + count,
+                               [&](std::uint32_t code) {
+                                 return !(code & bit);
+                               }) -
+          begin);
+    }
+  } else if (depth < maxSahDepth && count > minSahSize && !degenerate) {
+    struct Bin {
+      Math::AABB bounds;       ///< Boxes of the primitives in the bin.
+      std::uint32_t count = 0; ///< Primitives in the bin.
+    };
+    using Bins = std::array<Bin, 3 * binCount>;
+    float scale[3];
+    for (int axis = 0; axis < 3; axis++) {
+      float size = axis == 0 ? extent.x : (axis == 1 ? extent.y : extent.z);
+      scale[axis] = size > 0 ? binCount / size : 0.0f;
+    }
+    auto binOf = [&](const Builder::Reference &reference, int axis) {
+      float offset = Math::AABB::axisOf(reference.centroid, axis) -
+                     Math::AABB::axisOf(centroidBounds.min, axis);
+      return std::min(static_cast<int>(offset * scale[axis]), binCount - 1);
+    };
+    Bins bins = reduceChunks<Bins>(
+        builder.parallelFor, first, count, parallelThreshold,
+        [&](std::uint32_t begin, std::uint32_t end) {
+          Bins local;
+          for (std::uint32_t i = begin; i < end; i++) {
+            const Builder::Reference &reference = builder.references[i];
+            for (int axis = 0; axis < 3; axis++) {
+              Bin &bin = local[axis * binCount + binOf(reference, axis)];
+              grow(bin.bounds, reference.bounds.min, reference.bounds.max);
+              bin.count++;
+            }
+          }
+          return local;
+        },
+        [](Bins &into, const Bins &from) {
+          for (std::size_t i = 0; i < into.size(); i++) {
+            into[i].bounds.expand(from[i].bounds);
+            into[i].count += from[i].count;
+          }
+        });
+
+    double bestCost = -1.0;
+    int bestAxis = 0;
+    int bestSplit = 0;
+    for (int axis = 0; axis < 3; axis++) {
+      if (scale[axis] <= 0)
+        continue;
+      const Bin *axisBins = &bins[axis * binCount];
+      double rightCost[binCount] = {};
+      Math::AABB right;
+      std::uint32_t rightCount = 0;
+      for (int split = binCount - 1; split > 0; split--) {
+        right.expand(axisBins[split].bounds);
+        rightCount += axisBins[split].count;
+        rightCost[split] =
+            rightCount > 0 ? right.surfaceArea() * rightCount : 0.0;
+      }
+      Math::AABB left;
+      std::uint32_t leftCount = 0;
+      for (int split = 1; split < binCount; split++) {
+        left.expand(axisBins[split - 1].bounds);
+        leftCount += axisBins[split - 1].count;
+        if (leftCount == 0 || leftCount == count)
+          continue;
+        double cost = left.surfaceArea() * leftCount + rightCost[split];
+        if (bestCost < 0 || cost < bestCost) {
+          bestCost = cost;
+          bestAxis = axis;
+          bestSplit = split;
+        }
+      }
+    }
+    if (bestCost >= 0) {
+      auto begin = builder.references.begin() + first;
+      half = static_cast<std::uint32_t>(
+          std::partition(begin, begin + count,
+                         [&](const Builder::Reference &reference) {
+                           return binOf(reference, bestAxis) < bestSplit;
+                         }) -
+          begin);
+    }
+  }
+  if (half == 0 || half == count) {
+    half = count / 2;
+    if (builder.quality != QualityFast) {
+      int axis = centroidBounds.longestAxis();
+      auto begin = builder.references.begin() + first;
+      std::nth_element(begin, begin + half, begin + count,
+                       [&](const Builder::Reference &a,
+                           const Builder::Reference &b) {
+                         return Math::AABB::axisOf(a.centroid, axis) <
+                                Math::AABB::axisOf(b.centroid, axis);
+                       });
+    }
+  }
+  Math::AABB childCentroids[2];
+  if (builder.quality != QualityFast) {
+    for (int side = 0; side < 2; side++) {
+      childCentroids[side] = reduceChunks<Math::AABB>(
+          builder.parallelFor, side ? first + half : first,
+          side ? count - half : half, parallelThreshold,
+          [&](std::uint32_t begin, std::uint32_t end) {
+            Math::AABB box;
+            for (std::uint32_t i = begin; i < end; i++)
+              grow(box, builder.references[i].centroid,
+                   builder.references[i].centroid);
+            return box;
+          },
+          [](Math::AABB &into, const Math::AABB &from) { into.expand(from); });
+    }
+  }
+
+  std::uint32_t left = static_cast<std::uint32_t>(nodes.size());
+  nodes.push_back({Math::AABB(), first, half});
+  nodes.push_back({Math::AABB(), first + half, count - half});
+  nodes[nodeIndex].first = left;
+  nodes[nodeIndex].count = 0;
+  if (builder.parallelFor && half >= parallelThreshold &&
+      count - half >= parallelThreshold) {
+    std::vector<Node> subtrees[2] = {{nodes[left]}, {nodes[left + 1]}};
+    builder.parallelFor(2, [&](std::size_t side) {
+      subtrees[side].reserve(2 * subtrees[side][0].count);
+      subdivide(subtrees[side], 0, builder, depth + 1, childCentroids[side]);
+    });
+    attach(nodes, left, subtrees[0]);
+    attach(nodes, left + 1, subtrees[1]);
+  } else {
+    subdivide(nodes, left, builder, depth + 1, childCentroids[0]);
+    subdivide(nodes, left + 1, builder, depth + 1, childCentroids[1]);
+  }
+  Math::AABB bounds = nodes[left].bounds;
+  bounds.expand(nodes[left + 1].bounds);
+  nodes[nodeIndex].bounds = bounds;
+}
@@ -0,0 +1,614 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "AABB.hpp"
+#include "Ray.hpp"
+#include "RayPacket.hpp"
+#include "RenderStats.hpp"
+#include "SharedArray.hpp"
+
+namespace Raytracer {
+
+  /**
+   * @brief Bounding volume hierarchy over an indexed set of primitives.
+   *
+   * The BVH only knows the bounds of each primitive: the owner (a mesh, a
+   * shape composite...) builds it from one box per primitive and supplies the
+   * exact intersection test as a callback during traversal. Nodes are stored
+   * in a flat array; the two children of an interior node are adjacent.
+   *
+   * The binary tree is what gets built, refitted and cached. Traversal runs
+   * on a 4-wide copy of it, collapsed after every change: each wide node
+   * keeps the boxes of its four children as separate arrays of coordinates,
+   * so that one ray is tested against all of them at once with SSE.
+   *
+   * The arrays of a hierarchy read back from a scene cache point into the
+   * mapped file instead of being copied, see SharedArray.
+   */
+  class BVH {
+    public:
+      /**
+       * @brief How much time build() spends on the quality of the tree.
+       */
+      enum Quality {
+        QualityFast, ///< Morton-ordered splits, for interactive reloads.
+        QualitySah,  ///< Binned surface area heuristic, for final renders.
+        QualityCount ///< Number of presets.
+      };
+
+      /**
+       * @brief Runs fn(i) for every i in [0, count) and returns once they
+       * all ran, possibly in parallel. Supplied by the owner, so that the
+       * BVH does not depend on a particular thread pool.
+       */
+      using ParallelFor = std::function<void(
+          std::size_t count, const std::function<void(std::size_t)> &fn)>;
+
+      /**
+       * @brief Gets the name of a preset, as accepted by parseQuality().
+       * @param quality The preset.
+       * @return const char* "fast" or "sah".
+       */
+      static const char *qualityName(Quality quality);
+
+      /**
+       * @brief Parses the name of a preset.
+       * @param name "fast" or "sah".
+       * @return Quality The preset.
+       * @throw RaytracerError if the name is unknown.
+       */
+      static Quality parseQuality(const std::string &name);
+
+      /**
+       * @brief A node of the hierarchy.
+       * For a leaf, `first` is the offset in the primitive index array and
+       * `count` the number of primitives. For an interior node, `count` is 0
+       * and `first` is the index of the left child (right child is first + 1).
+       */
+      struct Node {
+        Math::AABB bounds;   ///< Bounds of everything below this node.
+        std::uint32_t first; ///< First primitive or left child index.
+        std::uint32_t count; ///< Number of primitives, 0 for interior nodes.
+      };
+
+      static constexpr int width = 4; ///< Children per wide node.
+
+      /**
+       * @brief A node of the 4-wide tree used for traversal. Child `lane` is
+       * a leaf of `count[lane]` primitives starting at `child[lane]` in the
+       * index array, or when `count[lane]` is 0 the wide node `child[lane]`.
+       * Lanes past `size` are unused.
+       */
+      struct alignas(16) WideNode {
+        float minX[width]; ///< Minimum x of each child box.
+        float minY[width]; ///< Minimum y of each child box.
+        float minZ[width]; ///< Minimum z of each child box.
+        float maxX[width]; ///< Maximum x of each child box.
+        float maxY[width]; ///< Maximum y of each child box.
+        float maxZ[width]; ///< Maximum z of each child box.
+        std::uint32_t child[width]; ///< First primitive or wide node index.
+        std::uint32_t count[width]; ///< Primitives, 0 for a wide node.
+        int size;                   ///< Number of children.
+      };
+
+      /**
+       * @brief Default constructor. Creates an empty hierarchy.
+       */
+      BVH() = default;
+
+      /**
+       * @brief Default destructor.
+       */
+      ~BVH() = default;
+
+      /**
+       * @brief Builds the hierarchy from the bounds of each primitive.
+       * @param primitiveBounds One box per primitive, indexed like the
+       * primitives of the owner.
+       * @param quality The build preset.
+       * @param parallelFor Runs the splits of large nodes and the subtrees
+       * below them in parallel; everything runs on the calling thread if
+       * empty.
+       */
+      void build(const std::vector<Math::AABB> &primitiveBounds,
+                 Quality quality = QualitySah,
+                 const ParallelFor &parallelFor = nullptr);
+
+      /**
+       * @brief Recomputes the node bounds bottom-up without changing the
+       * tree structure. Much cheaper than build() when primitives only moved,
+       * but the tree gets slower to trace as they move away from where they
+       * were built; see getDegradation().
+       * @param primitiveBounds The new box of each primitive, indexed like
+       * the bounds given to build().
+       */
+      void refit(const std::vector<Math::AABB> &primitiveBounds);
+
+      /**
+       * @brief Gets how much slower the tree is expected to trace than when
+       * it was built.
+       *
+       * The ratio of the surface area heuristic cost of the tree to its cost
+       * right after build(): 1 until refit() stretches boxes over primitives
+       * that moved apart. Moving or scaling everything together keeps it at 1.
+       * @return double The ratio, 1 for an empty tree.
+       */
+      double getDegradation() const {
+        return _builtCost > 0 ? _cost / _builtCost : 1.0;
+      }
+
+      /**
+       * @brief Replaces the hierarchy with nodes built earlier, for instance
+       * read back from a scene cache.
+       * @param nodes The flat node array, root first.
+       * @param indices The primitive indices referenced by the leaves.
+       */
+      void assign(SharedArray<Node> nodes, SharedArray<std::uint32_t> indices) {
+        _nodes = std::move(nodes);
+        _indices = std::move(indices);
+        _builtCost = _cost = cost();
+        collapse();
+      }
+
+      /**
+       * @brief Replaces the hierarchy with a complete one saved earlier,
+       * 4-wide tree included, so that nothing is recomputed: the arrays of
+       * a scene cache are traced straight from the mapping.
+       * @param nodes The flat node array, root first.
+       * @param indices The primitive indices referenced by the leaves.
+       * @param wide The 4-wide tree collapsed from the nodes, see
+       * getWideNodes().
+       * @param lanes The binary node of each wide lane, see getLanes().
+       * @param cost The cost of the tree, see getCost().
+       */
+      void assign(SharedArray<Node> nodes, SharedArray<std::uint32_t> indices,
+                  SharedArray<WideNode> wide, SharedArray<std::uint32_t> lanes,
+                  double cost) {
+        _nodes = std::move(nodes);
+        _indices = std::move(indices);
+        _wide = std::move(wide);
+        _lanes = std::move(lanes);
+        _builtCost = _cost = cost;
+      }
+
+      /**
+       * @brief Gets the bounds of the whole hierarchy.
+       * @return Math::AABB The root bounds, empty if nothing was built.
+       */
+      Math::AABB getBounds() const {
+        return _nodes.empty() ? Math::AABB() : _nodes[0].bounds;
+      }
+
+      /**
+       * @brief Checks whether the hierarchy contains any primitive.
+       * @return true if nothing was built.
+       */
+      bool empty() const {
+        return _nodes.empty();
+      }
+
+      /**
+       * @brief Gets the nodes of the hierarchy.
+       * @return const SharedArray<Node>& The flat node array, root first.
+       */
+      const SharedArray<Node> &getNodes() const {
+        return _nodes;
+      }
+      /**
+       * @brief Gets the primitive indices referenced by the leaves.
+       * @return const SharedArray<std::uint32_t>& The reordered indices.
+       */
+      const SharedArray<std::uint32_t> &getIndices() const {
+        return _indices;
+      }
+      /**
+       * @brief Gets the 4-wide tree traversal runs on.
+       * @return const SharedArray<WideNode>& The wide nodes, root first.
+       */
+      const SharedArray<WideNode> &getWideNodes() const {
+        return _wide;
+      }
+      /**
+       * @brief Gets the binary node each lane of the wide tree was collapsed
+       * from, `width` entries per wide node.
+       * @return const SharedArray<std::uint32_t>& The binary node indices.
+       */
+      const SharedArray<std::uint32_t> &getLanes() const {
+        return _lanes;
+      }
+      /**
+       * @brief Gets the surface area heuristic cost of the tree, relative
+       * to the area of its root.
+       * @return double The cost, 0 for an empty or flat tree.
+       */
+      double getCost() const {
+        return _cost;
+      }
+
+      /**
+       * @brief Walks the nodes hit by a ray within its [tMin, tMax] interval
+       * and calls `intersect` on each primitive of the leaves reached.
+       *
+       * The children of a node are visited nearest first, so that the first
+       * hits found are close and prune the rest of the tree.
+       * @param ray The ray to trace.
+       * @param intersect Callable as intersect(primitiveIndex, tMax), tMax
+       * starting at ray.tMax. The callback shrinks it when it finds a closer
+       * hit, which prunes the remaining nodes.
+       * Visited nodes are counted in ray.stats when statistics are enabled.
+       */
+      template <typename Intersect>
+      void traverse(const Ray &ray, Intersect &&intersect) const {
+        if (_wide.empty())
+          return;
+        double tMax = ray.tMax;
+        Math::Vector3D invDir(1.0f / ray.direction.x, 1.0f / ray.direction.y,
+                              1.0f / ray.direction.z);
+        if (!_nodes[0].bounds.intersects(ray.origin, invDir, ray.tMin, tMax))
+          return;
+        std::uint64_t visited =
+            walk(RaySlabs(ray.origin, invDir, ray.tMin),
+                 {0, 0, static_cast<float>(ray.tMin)}, tMax, intersect);
+#ifdef RAYTRACER_STATS
+        if (ray.stats)
+          ray.stats->add(RayStats::BvhNodes, visited);
+#else
+        (void)visited;
+#endif
+      }
+
+      /**
+       * @brief Walks the nodes hit by any ray of a packet and calls
+       * `intersect` on each primitive of the leaves reached, with the rays
+       * that reached them.
+       *
+       * Every entry of the stack carries the rays that crossed its box, so a
+       * node is fetched once for the whole packet and each of its rays is
+       * tested against the four children with SSE, as traverse() does. Once
+       * a single ray is left in a subtree, the packet has diverged there and
+       * the subtree is walked as by traverse(). Children are visited nearest
+       * first, by the closest of their rays.
+       * @param packet The rays. Their tMax prune the walk and are lowered by
+       * the callback when it finds closer hits.
+       * @param mask The rays to trace.
+       * @param intersect Callable as intersect(primitiveIndex, rays), rays
+       * being the mask of the rays that reached the primitive.
+       * Node tests are counted once per ray in packet.stats when statistics
+       * are enabled.
+       */
+      template <typename Intersect>
+      void traversePacket(RayPacket &packet, std::uint32_t mask,
+                          Intersect &&intersect) const {
+        if (_wide.empty())
+          return;
+        RaySlabs slabs[RayPacket::size];
+        std::uint32_t live = 0;
+        float tMin = std::numeric_limits<float>::infinity();
+        for (std::uint32_t rays = mask; rays; rays &= rays - 1) {
+          int i = __builtin_ctz(rays);
+          Math::Point3D origin(packet.originX[i], packet.originY[i],
+                               packet.originZ[i]);
+          Math::Vector3D invDir(1.0f / packet.dirX[i], 1.0f / packet.dirY[i],
+                                1.0f / packet.dirZ[i]);
+          double tMax = packet.tMax[i];
+          if (!_nodes[0].bounds.intersects(origin, invDir, packet.tMin[i],
+                                           tMax))
+            continue;
+          slabs[i] = RaySlabs(origin, invDir, packet.tMin[i]);
+          live |= 1u << i;
+          tMin = std::min(tMin, packet.tMin[i]);
+        }
+        if (!live)
+          return;
+        PacketEntry stack[maxStackSize];
+        int top = 0;
+        std::uint64_t visited = 0;
+
+        stack[top++] = {0, 0, tMin, live};
+        while (top > 0) {
+          PacketEntry entry = stack[--top];
+          std::uint32_t rays = 0;
+          for (std::uint32_t r = entry.rays; r; r &= r - 1) {
+            int i = __builtin_ctz(r);
+            if (entry.tNear <= packet.tMax[i])
+              rays |= 1u << i;
+          }
+          if (!rays)
+            continue;
+          if (entry.count > 0) {
+            for (std::uint32_t i = 0; i < entry.count; i++)
+              intersect(_indices[entry.child + i], rays);
+            continue;
+          }
+          if (!(rays & (rays - 1))) {
+            int i = __builtin_ctz(rays);
+            double tMax = packet.tMax[i];
+            visited += walk(slabs[i], {entry.child, 0, entry.tNear}, tMax,
+                            [&](std::uint32_t index, double &t) {
+                              intersect(index, rays);
+                              t = packet.tMax[i];
+                            });
+            continue;
+          }
+          const WideNode &node = _wide[entry.child];
+          std::uint32_t laneRays[width] = {};
+          float laneNear[width];
+          std::fill(laneNear, laneNear + width,
+                    std::numeric_limits<float>::infinity());
+          for (std::uint32_t r = rays; r; r &= r - 1) {
+            int i = __builtin_ctz(r);
+            alignas(16) float tNear[width];
+            int hit = slabs[i].intersect(node, packet.tMax[i], tNear);
+#ifdef RAYTRACER_STATS
+            visited++;
+#endif
+            for (int lane = 0; lane < node.size; lane++) {
+              if (!(hit & (1 << lane)))
+                continue;
+              laneRays[lane] |= 1u << i;
+              laneNear[lane] = std::min(laneNear[lane], tNear[lane]);
+            }
+          }
+          PacketEntry hit[width];
+          int hits = 0;
+          for (int lane = 0; lane < node.size; lane++) {
+            if (!laneRays[lane])
+              continue;
+            PacketEntry child = {node.child[lane], node.count[lane],
+                                 laneNear[lane], laneRays[lane]};
+            int k = hits++;
+            for (; k > 0 && hit[k - 1].tNear < child.tNear; k--)
+              hit[k] = hit[k - 1];
+            hit[k] = child;
+          }
+          for (int k = 0; k < hits; k++)
+            stack[top++] = hit[k];
+        }
+#ifdef RAYTRACER_STATS
+        if (packet.stats)
+          packet.stats->add(RayStats::BvhNodes, visited);
+#else
+        (void)visited;
+#endif
+      }
+
+    private:
+      static constexpr std::uint32_t maxLeafSize = 4; ///< Primitives per leaf.
+      static constexpr int binCount = 16; ///< SAH candidate splits per axis + 1.
+      static constexpr int maxSahDepth = 40; ///< Deeper nodes are halved.
+      static constexpr std::uint32_t minSahSize =
+          16; ///< Smaller ranges are halved, binning them costs more.
+      static constexpr std::uint32_t parallelThreshold =
+          1 << 14; ///< Smallest range split or built as parallel tasks.
+      static constexpr int maxStackSize = 256; ///< Traversal stack entries.
+
+      /**
+       * @brief A child waiting on the traversal stack.
+       */
+      struct Entry {
+        std::uint32_t child; ///< Wide node or first primitive.
+        std::uint32_t count; ///< Primitives, 0 for a wide node.
+        float tNear;         ///< Where the ray enters the child box.
+      };
+
+      /**
+       * @brief A child waiting on the stack of a packet traversal.
+       */
+      struct PacketEntry {
+        std::uint32_t child; ///< Wide node or first primitive.
+        std::uint32_t count; ///< Primitives, 0 for a wide node.
+        float tNear;         ///< Where the closest of its rays enters the box.
+        std::uint32_t rays;  ///< Rays of the packet that cross the box.
+      };
+
+      /**
+       * @brief A ray laid out for the slab test of four boxes at once.
+       */
+      struct RaySlabs {
+#if defined(__SSE2__)
+        __m128 originX, originY, originZ; ///< Origin, on every lane.
+        __m128 invDirX, invDirY, invDirZ; ///< Inverse direction, on every lane.
+        __m128 tMin;                      ///< Start of the interval.
+#else
+        float origin[3]; ///< Origin of the ray.
+        float invDir[3]; ///< Inverse direction of the ray.
+        float tMin;      ///< Start of the interval.
+#endif
+
+        /**
+         * @brief Leaves the ray unset, to be assigned later.
+         */
+        RaySlabs() = default;
+
+        /**
+         * @brief Prepares a ray.
+         * @param start The origin of the ray.
+         * @param inverse The component-wise inverse of its direction.
+         * @param near The start of its interval.
+         */
+        RaySlabs(const Math::Point3D &start, const Math::Vector3D &inverse,
+                 double near) {
+#if defined(__SSE2__)
+          originX = _mm_set1_ps(start.x);
+          originY = _mm_set1_ps(start.y);
+          originZ = _mm_set1_ps(start.z);
+          invDirX = _mm_set1_ps(inverse.x);
+          invDirY = _mm_set1_ps(inverse.y);
+          invDirZ = _mm_set1_ps(inverse.z);
+          tMin = _mm_set1_ps(static_cast<float>(near));
+#else
+          origin[0] = start.x;
+          origin[1] = start.y;
+          origin[2] = start.z;
+          invDir[0] = inverse.x;
+          invDir[1] = inverse.y;
+          invDir[2] = inverse.z;
+          tMin = static_cast<float>(near);
+#endif
+        }
+
+        /**
+         * @brief Slab test against the four child boxes of a node.
+         * @param node The node.
+         * @param tMax The farthest distance still of interest.
+         * @param tNear Receives where the ray enters each box.
+         * @return int A bit per lane, set if the ray crosses the box within
+         * [tMin, tMax]. The bits of unused lanes are meaningless.
+         */
+        int intersect(const WideNode &node, double tMax, float *tNear) const {
+#if defined(__SSE2__)
+          auto slab = [](const float *bound, __m128 origin, __m128 invDir) {
+            return _mm_mul_ps(_mm_sub_ps(_mm_load_ps(bound), origin), invDir);
+          };
+          __m128 t0x = slab(node.minX, originX, invDirX);
+          __m128 t1x = slab(node.maxX, originX, invDirX);
+          __m128 t0y = slab(node.minY, originY, invDirY);
+          __m128 t1y = slab(node.maxY, originY, invDirY);
+          __m128 t0z = slab(node.minZ, originZ, invDirZ);
+          __m128 t1z = slab(node.maxZ, originZ, invDirZ);
+          __m128 enter = _mm_max_ps(
+              _mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)),
+              _mm_max_ps(_mm_min_ps(t0z, t1z), tMin));
+          __m128 exit = _mm_min_ps(
+              _mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)),
+              _mm_min_ps(_mm_max_ps(t0z, t1z),
+                         _mm_set1_ps(static_cast<float>(tMax))));
+          _mm_store_ps(tNear, enter);
+          return _mm_movemask_ps(_mm_cmple_ps(enter, exit));
+#else
+          const float *mins[3] = {node.minX, node.minY, node.minZ};
+          const float *maxs[3] = {node.maxX, node.maxY, node.maxZ};
+          int mask = 0;
+          for (int lane = 0; lane < width; lane++) {
+            float enter = tMin;
+            float exit = static_cast<float>(tMax);
+            for (int axis = 0; axis < 3; axis++) {
+              float t0 = (mins[axis][lane] - origin[axis]) * invDir[axis];
+              float t1 = (maxs[axis][lane] - origin[axis]) * invDir[axis];
+              enter = std::max(enter, std::min(t0, t1));
+              exit = std::min(exit, std::max(t0, t1));
+            }
+            tNear[lane] = enter;
+            if (enter <= exit)
+              mask |= 1 << lane;
+          }
+          return mask;
+#endif
+        }
+      };
+
+      /**
+       * @brief Walks the subtree under a stack entry with a single ray.
+       * @param slabs The ray.
+       * @param root The entry of the subtree.
+       * @param tMax The end of the interval of the ray, lowered by
+       * `intersect` as it finds hits.
+       * @param intersect Callable as intersect(primitiveIndex, tMax).
+       * @return std::uint64_t The number of wide nodes visited, 0 when
+       * statistics are disabled.
+       */
+      template <typename Intersect>
+      std::uint64_t walk(const RaySlabs &slabs, Entry root, double &tMax,
+                         Intersect &&intersect) const {
+        Entry stack[maxStackSize];
+        int top = 0;
+        std::uint64_t visited = 0;
+
+        stack[top++] = root;
+        while (top > 0) {
+          Entry entry = stack[--top];
+          if (entry.tNear > tMax)
+            continue;
+          if (entry.count > 0) {
+            for (std::uint32_t i = 0; i < entry.count; i++)
+              intersect(_indices[entry.child + i], tMax);
+            continue;
+          }
+#ifdef RAYTRACER_STATS
+          visited++;
+#endif
+          const WideNode &node = _wide[entry.child];
+          alignas(16) float tNear[width];
+          int mask = slabs.intersect(node, tMax, tNear);
+          Entry hit[width];
+          int hits = 0;
+          for (int lane = 0; lane < node.size; lane++) {
+            if (!(mask & (1 << lane)))
+              continue;
+            Entry child = {node.child[lane], node.count[lane], tNear[lane]};
+            int k = hits++;
+            for (; k > 0 && hit[k - 1].tNear < child.tNear; k--)
+              hit[k] = hit[k - 1];
+            hit[k] = child;
+          }
+          for (int k = 0; k < hits; k++)
+            stack[top++] = hit[k];
+        }
+        return visited;
+      }
+
+      SharedArray<Node> _nodes;            ///< Flat node array, root first.
+      SharedArray<std::uint32_t> _indices; ///< Primitive indices of leaves.
+      SharedArray<WideNode> _wide;         ///< 4-wide tree, root first.
+      SharedArray<std::uint32_t> _lanes;   ///< Binary node of each wide lane.
+      double _cost = 0.0;                  ///< SAH cost of the tree.
+      double _builtCost = 0.0;             ///< SAH cost when it was built.
+
+      /**
+       * @brief Computes the surface area heuristic cost of the binary tree:
+       * the area of every node relative to the root, times one for interior
+       * nodes and times the number of primitives for leaves.
+       * @return double The cost, 0 for an empty or flat tree.
+       */
+      double cost() const;
+
+      /**
+       * @brief Copies the bounds of the binary nodes into the lanes of the
+       * 4-wide tree, whose structure did not change.
+       */
+      void refitWide();
+
+      /**
+       * @brief Rebuilds the 4-wide tree from the binary one.
+       */
+      void collapse();
+
+      /**
+       * @brief Collapses the subtree under an interior binary node into a
+       * wide node and its descendants.
+       * @param nodeIndex The binary node.
+       * @param wide The wide nodes being built.
+       * @param wideLanes The binary node of each of their lanes.
+       * @return std::uint32_t The index of the wide node.
+       */
+      std::uint32_t collapseNode(std::uint32_t nodeIndex,
+                                 std::vector<WideNode> &wide,
+                                 std::vector<std::uint32_t> &wideLanes) const;
+
+      struct Builder;
+
+      /**
+       * @brief Recursively splits the range of primitives of a node, then
+       * sets its bounds from those of its children.
+       * @param nodes The array the node and its descendants are stored in.
+       * @param nodeIndex The node covering the range.
+       * @param builder The inputs of the build.
+       * @param depth The depth of the node.
+       * @param centroidBounds The box of the centroids of the range, only
+       * used by the SAH preset.
+       */
+      void subdivide(std::vector<Node> &nodes, std::uint32_t nodeIndex,
+                     Builder &builder, int depth,
+                     const Math::AABB &centroidBounds);
+  };
+
+}  // namespace Raytracer
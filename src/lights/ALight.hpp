@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ILight.hpp"
+#include "LightAbi.hpp"
 #include "ShapeComposite.hpp"
 #include "Vector3D.hpp"
 
@@ -11,6 +12,10 @@ namespace Raytracer {
    * This class implements the ILight interface and provides common
    * properties and methods for lights, such as intensity, color,
    * direction (for directional lights), and type.
+   *
+   * It also declares shadowRay() and computeDirectLighting(), added since
+   * the vtable of ILight was frozen, which the host reaches through the
+   * LightAbi table the plugin exports, see lightAbiOf().
    */
   class ALight : public ILight {
     public:
@@ -20,7 +25,8 @@ namespace Raytracer {
       virtual ~ALight() = default;
 
       /**
-       * @brief Pure virtual method to compute the lighting contribution of this light.
+       * @brief Computes the lighting contribution of this light, tracing its
+       * shadow ray through the scene.
        * @param normal The surface normal at the hit point.
        * @param objectColor The color of the object at the hit point.
        * @param hitPoint The point on the surface where the light is being calculated.
@@ -31,7 +37,43 @@ namespace Raytracer {
       virtual Math::Vector3D computeLighting(
           const Math::Vector3D &normal, const Math::Vector3D &objectColor,
           const Math::Point3D &hitPoint, const Math::Vector3D &viewDir,
-          const ShapeComposite &shapes) const override = 0;
+          const ShapeComposite &shapes) const override {
+        Ray ray;
+        bool occluded = false;
+        if (shadowRay(hitPoint, ray)) {
+          auto [t, color, shape] = shapes.hits(ray);
+          occluded = t > 0.0 && shape != nullptr;
+        }
+        return computeDirectLighting(normal, objectColor, hitPoint, viewDir,
+                                     occluded);
+      }
+
+      /**
+       * @brief Gets the ray cast from a point to find out whether it is in
+       * the shadow of this light. The default light casts no shadow.
+       * @param hitPoint The point on the surface.
+       * @param ray Receives the shadow ray.
+       * @return true if the light casts a shadow ray.
+       */
+      virtual bool shadowRay(__attribute__((unused)) const Math::Point3D &hitPoint,
+                             __attribute__((unused)) Ray &ray) const {
+        return false;
+      }
+
+      /**
+       * @brief Pure virtual method to compute the lighting contribution of
+       * this light once its shadow ray has been traced.
+       * @param normal The surface normal at the hit point.
+       * @param objectColor The color of the object at the hit point.
+       * @param hitPoint The point on the surface where the light is being calculated.
+       * @param viewDir The direction from the hit point to the camera.
+       * @param occluded Whether the shadow ray hit a shape.
+       * @return Math::Vector3D The calculated color contribution from this light.
+       */
+      virtual Math::Vector3D computeDirectLighting(
+          const Math::Vector3D &normal, const Math::Vector3D &objectColor,
+          const Math::Point3D &hitPoint, const Math::Vector3D &viewDir,
+          bool occluded) const = 0;
 
       /**
        * @brief Sets the intensity of the light.
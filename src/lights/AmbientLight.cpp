@@ -3,14 +3,14 @@
 #include "Point3D.hpp"
 #include "Vector3D.hpp"
 
-Math::Vector3D Raytracer::AmbientLight::computeLighting(
+Math::Vector3D Raytracer::AmbientLight::computeDirectLighting(
     const Math::Vector3D &normal, const Math::Vector3D &objectColor,
     const Math::Point3D &hitPoint, const Math::Vector3D &viewDir,
-    const ShapeComposite &shapes) const {
+    bool occluded) const {
   (void)normal;
   (void)viewDir;
   (void)hitPoint;
-  (void)shapes;
+  (void)occluded;
 
   return objectColor * (_color * _intensity);
 }
@@ -25,4 +25,10 @@ Raytracer::ILight *addLight() {
     return nullptr;
   }
 }
+
+const Raytracer::LightAbi *lightAbi() {
+  static const Raytracer::LightAbi abi =
+      Raytracer::lightAbiOf<Raytracer::AmbientLight>();
+  return &abi;
+}
 }
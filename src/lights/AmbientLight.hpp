@@ -31,12 +31,12 @@ namespace Raytracer {
        * @param objectColor The color of the object at the hit point.
        * @param hitPoint The point on the surface (unused for ambient light).
        * @param viewDir The direction from the hit point to the camera (unused for ambient light).
-       * @param shapes A composite of all shapes in the scene (unused for ambient light).
+       * @param occluded Unused: ambient light casts no shadow ray.
        * @return Math::Vector3D The calculated color contribution from this ambient light.
        */
-      Math::Vector3D computeLighting(
+      Math::Vector3D computeDirectLighting(
           const Math::Vector3D &normal, const Math::Vector3D &objectColor,
           const Math::Point3D &hitPoint, const Math::Vector3D &viewDir,
-          const ShapeComposite &shapes) const override;
+          bool occluded) const override;
   };
 }  // namespace Raytracer
@@ -3,32 +3,43 @@
 #include <iostream>
 #include "Vector3D.hpp"
 
+/**
+ * @brief Gets the ray cast from a hit point towards the light source, to
+ * check whether the point is in shadow.
+ *
+ * @param hitPoint The point on the surface where the light is being calculated.
+ * @param ray Receives the shadow ray.
+ * @return true, a directional light always casts shadows.
+ */
+bool Raytracer::DirectionalLight::shadowRay(const Math::Point3D &hitPoint,
+                                            Raytracer::Ray &ray) const {
+  ray = Raytracer::Ray(hitPoint, -getDirection().normalize(),
+                       Raytracer::Ray::Shadow, Raytracer::Ray::surfaceOffset);
+  return true;
+}
+
 /**
  * @brief Computes the lighting contribution of this directional light at a given hit point.
  *
  * Calculates diffuse lighting based on the angle between the surface normal and the
- * light direction. It also performs a shadow check by casting a ray from the hit point
- * towards the light source. If an object is hit, the point is considered in shadow,
+ * light direction. If the shadow ray hit an object, the point is considered in shadow,
  * and only a minimal light intensity is applied.
  *
  * @param normal The surface normal at the hit point.
  * @param objectColor The color of the object at the hit point.
- * @param hitPoint The point on the surface where the light is being calculated.
+ * @param hitPoint The point on the surface (unused for this light type).
  * @param viewDir The direction from the hit point to the camera (unused for this light type).
- * @param shapes A composite of all shapes in the scene, used for shadow checking.
+ * @param occluded Whether the shadow ray hit an object.
  * @return Math::Vector3D The calculated color contribution from this light.
  */
-Math::Vector3D Raytracer::DirectionalLight::computeLighting(
+Math::Vector3D Raytracer::DirectionalLight::computeDirectLighting(
     const Math::Vector3D &normal, const Math::Vector3D &objectColor,
-    const Math::Point3D &hitPoint,
+    __attribute__((unused)) const Math::Point3D &hitPoint,
     __attribute__((unused)) const Math::Vector3D &viewDir,
-    const ShapeComposite &shapes) const {
-  Math::Point3D shadowOrigin = hitPoint + normal * 0.001;
-  Raytracer::Ray shadowRay(shadowOrigin, -getDirection().normalize());
-  auto [shadow, _, shadowShape] = shapes.hits(shadowRay);
+    bool occluded) const {
   float lightIntensity;
 
-  if (shadow > 0.0 && shadowShape != nullptr) {
+  if (occluded) {
     lightIntensity = 0.1f;
   } else {
     lightIntensity = 0.1f + 0.9f * std::max(0.0, normal.dot(-getDirection()));
@@ -52,4 +63,15 @@ Raytracer::ILight *addLight() {
     return nullptr;
   }
 }
+
+/**
+ * @brief Gives the extended entry points of the DirectionalLight plugin, see
+ * LightAbi.hpp.
+ * @return const Raytracer::LightAbi* The entry points.
+ */
+const Raytracer::LightAbi *lightAbi() {
+  static const Raytracer::LightAbi abi =
+      Raytracer::lightAbiOf<Raytracer::DirectionalLight>();
+  return &abi;
+}
 }
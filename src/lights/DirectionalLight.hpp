@@ -9,9 +9,11 @@ namespace Raytracer {
       DirectionalLight() = default;
       ~DirectionalLight() = default;
 
-      Math::Vector3D computeLighting(
+      bool shadowRay(const Math::Point3D &hitPoint, Ray &ray) const override;
+
+      Math::Vector3D computeDirectLighting(
           const Math::Vector3D &normal, const Math::Vector3D &objectColor,
           const Math::Point3D &hitPoint, const Math::Vector3D &viewDir,
-          const ShapeComposite &shapes) const override;
+          bool occluded) const override;
   };
 }  // namespace Raytracer
@@ -4,6 +4,13 @@
 #include "Vector3D.hpp"
 
 namespace Raytracer {
+  /**
+   * @brief Interface for all light sources in the Raytracer.
+   *
+   * Frozen like the vtable of IShape: shadowRay() and
+   * computeDirectLighting() are virtual functions of ALight, reached by the
+   * host through the optional table of LightAbi.hpp.
+   */
   class ILight {
     public:
       virtual ~ILight() = default;
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include "ILight.hpp"
+#include "Ray.hpp"
+#include "ShapeComposite.hpp"
+#include "Vector3D.hpp"
+
+namespace Raytracer {
+
+  /**
+   * @brief Version of the LightAbi table described in this file.
+   *
+   * Like ShapeAbi, the table carries the entry points added to lights since
+   * the vtable of ILight was frozen. A light plugin without lightAbi()
+   * (version 0) is shaded through ILight::computeLighting(), which traces
+   * its own shadow ray. Later versions only append fields.
+   */
+  constexpr std::uint32_t lightAbiVersion = 1;
+
+  /**
+   * @brief Entry points a plugin implements, as bits of
+   * LightAbi::capabilities.
+   */
+  enum LightCapability : std::uint32_t {
+    LightShadowRays = 1u << 0, ///< LightAbi::shadowRay and directLighting are set.
+  };
+
+  /**
+   * @brief Extended entry points of a light plugin, returned by its
+   * lightAbi() export. The functions take the light created by the
+   * addLight() of the same plugin and are called from several threads at
+   * once.
+   */
+  struct LightAbi {
+    std::uint32_t version;      ///< lightAbiVersion the plugin was built with.
+    std::uint32_t capabilities; ///< LightCapability bits.
+
+    /**
+     * @brief Gets the ray cast from a point to find out whether it is in the
+     * shadow of the light, as ALight::shadowRay() does.
+     * @return Non-zero if the light casts a shadow ray.
+     */
+    int (*shadowRay)(const ILight *light, const Math::Point3D *hitPoint,
+                     Ray *ray);
+
+    /**
+     * @brief Computes the lighting of the light once its shadow ray has been
+     * traced, as ALight::computeDirectLighting() does.
+     */
+    void (*directLighting)(const ILight *light, const Math::Vector3D *normal,
+                           const Math::Vector3D *objectColor,
+                           const Math::Point3D *hitPoint,
+                           const Math::Vector3D *viewDir, int occluded,
+                           Math::Vector3D *result);
+  };
+
+  /**
+   * @brief Checks whether a table provides an entry point.
+   * @param abi The table, nullptr for a plugin without one.
+   * @param version The version that added the entry point.
+   * @param capability The bit of the entry point.
+   */
+  inline bool hasLightEntry(const LightAbi *abi, std::uint32_t version,
+                            LightCapability capability) {
+    return abi && abi->version >= version && (abi->capabilities & capability);
+  }
+
+  /**
+   * @brief Builds the table of a light plugin whose lights derive from
+   * ALight, every entry point calling the member function of T.
+   * @tparam T The concrete light type of the plugin.
+   * @return LightAbi The table, to be kept alive by the plugin.
+   */
+  template <typename T>
+  LightAbi lightAbiOf() {
+    LightAbi abi = {};
+    abi.version = lightAbiVersion;
+    abi.capabilities = LightShadowRays;
+    abi.shadowRay = [](const ILight *light, const Math::Point3D *hitPoint,
+                       Ray *ray) -> int {
+      return static_cast<const T *>(light)->T::shadowRay(*hitPoint, *ray);
+    };
+    abi.directLighting = [](const ILight *light, const Math::Vector3D *normal,
+                            const Math::Vector3D *objectColor,
+                            const Math::Point3D *hitPoint,
+                            const Math::Vector3D *viewDir, int occluded,
+                            Math::Vector3D *result) {
+      *result = static_cast<const T *>(light)->T::computeDirectLighting(
+          *normal, *objectColor, *hitPoint, *viewDir, occluded != 0);
+    };
+    return abi;
+  }
+
+  /**
+   * @brief Gets the shadow ray of a light through its plugin. Lights
+   * without the entry point trace their own and cast none here.
+   * @param abi The table of the plugin of the light, may be nullptr.
+   * @param light The light.
+   * @param hitPoint The point on the surface.
+   * @param ray Receives the shadow ray.
+   * @return true if a shadow ray must be traced.
+   */
+  inline bool lightShadowRay(const LightAbi *abi, const ILight &light,
+                             const Math::Point3D &hitPoint, Ray &ray) {
+    if (!hasLightEntry(abi, 1, LightShadowRays) || !abi->shadowRay)
+      return false;
+    return abi->shadowRay(&light, &hitPoint, &ray) != 0;
+  }
+
+  /**
+   * @brief Computes the lighting of a light whose shadow ray was traced by
+   * the caller. Lights without the entry point are shaded through
+   * ILight::computeLighting(), tracing their shadow ray through shapes.
+   * @param abi The table of the plugin of the light, may be nullptr.
+   * @param light The light.
+   * @param occluded Whether the shadow ray of lightShadowRay() hit a shape.
+   * @param shapes The shapes of the scene.
+   * @return Math::Vector3D The contribution of the light.
+   */
+  inline Math::Vector3D lightDirectLighting(
+      const LightAbi *abi, const ILight &light, const Math::Vector3D &normal,
+      const Math::Vector3D &objectColor, const Math::Point3D &hitPoint,
+      const Math::Vector3D &viewDir, bool occluded,
+      const ShapeComposite &shapes) {
+    if (!hasLightEntry(abi, 1, LightShadowRays) || !abi->directLighting)
+      return light.computeLighting(normal, objectColor, hitPoint, viewDir,
+                                   LegacyShapes(shapes, Ray::Shadow));
+    Math::Vector3D result;
+    abi->directLighting(&light, &normal, &objectColor, &hitPoint, &viewDir,
+                        occluded, &result);
+    return result;
+  }
+
+}  // namespace Raytracer
+
+extern "C" {
+/**
+ * @brief Optional export of a light plugin giving its extended entry points.
+ * The returned table must live as long as the plugin is loaded.
+ */
+const Raytracer::LightAbi *lightAbi();
+}
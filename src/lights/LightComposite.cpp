@@ -1,6 +1,7 @@
 #include "LightComposite.hpp"
 #include <cmath>
 #include <memory>
+#include "Factory.hpp"
 #include "Vector3D.hpp"
 
 const Math::Vector3D Raytracer::LightComposite::reflect(
@@ -14,42 +15,49 @@ Math::Vector3D Raytracer::LightComposite::computeLighting(
     const Math::Point3D &hitPoint, const Math::Vector3D &viewDir,
     const ShapeComposite &shapes) const {
   Math::Vector3D result(0, 0, 0);
-  std::shared_ptr<ILight> ambientLight;
-  std::shared_ptr<ILight> directionalLight;
-
-  for (auto &light : _lights) {
-    if (light->getType() == "AmbientLight") {
-      ambientLight = light;
-      result = result + light->computeLighting(normal, objectColor, hitPoint,
-                                               viewDir, shapes);
-      break;
-    }
-  }
+  for (const ILight *light : _shading)
+    result = result + light->computeLighting(normal, objectColor, hitPoint,
+                                             viewDir, shapes);
+  return addSpecular(result, normal, viewDir);
+}
 
-  for (const auto &light : _lights) {
-    if (light->getType() == "DirectionalLight") {
-      directionalLight = light;
-      result = result + light->computeLighting(normal, objectColor, hitPoint,
-                                               viewDir, shapes);
-    }
-  }
+Math::Vector3D Raytracer::LightComposite::computeLighting(
+    const Math::Vector3D &normal, const Math::Vector3D &objectColor,
+    const Math::Point3D &hitPoint, const Math::Vector3D &viewDir,
+    const unsigned char *occluded, const ShapeComposite &shapes) const {
+  Math::Vector3D result(0, 0, 0);
+  for (std::size_t i = 0; i < _shading.size(); i++)
+    result = result + lightDirectLighting(_abis[i], *_shading[i], normal,
+                                          objectColor, hitPoint, viewDir,
+                                          occluded[i], shapes);
+  return addSpecular(result, normal, viewDir);
+}
 
-  for (const auto &light : _lights) {
-    if (light->getType() == "PointLight") {
-      result = result + light->computeLighting(normal, objectColor, hitPoint,
-                                               viewDir, shapes);
-    }
-  }
+Math::Vector3D Raytracer::LightComposite::computeDirectLighting(
+    const Math::Vector3D &normal, const Math::Vector3D &objectColor,
+    const Math::Point3D &hitPoint, const Math::Vector3D &viewDir,
+    bool occluded) const {
+  const ShapeComposite none;
+  Math::Vector3D result(0, 0, 0);
+  for (std::size_t i = 0; i < _shading.size(); i++)
+    result = result + lightDirectLighting(_abis[i], *_shading[i], normal,
+                                          objectColor, hitPoint, viewDir,
+                                          occluded, none);
+  return addSpecular(result, normal, viewDir);
+}
 
-  if (directionalLight.get() && ambientLight.get()) {
+Math::Vector3D Raytracer::LightComposite::addSpecular(
+    const Math::Vector3D &result, const Math::Vector3D &normal,
+    const Math::Vector3D &viewDir) const {
+  if (_directional && _ambient) {
     Math::Vector3D reflectSource =
-        reflect(-directionalLight->getDirection(), normal);
+        reflect(-_directional->getDirection(), normal);
     double specularStrength = std::max(0.0, viewDir.dot(reflectSource));
     specularStrength = std::pow(specularStrength, 32.);
-    Math::Vector3D specular = ambientLight->getColor() * specularStrength;
-    Math::Vector3D diffuse = ambientLight->getColor() * _diffuse;
+    Math::Vector3D specular = _ambient->getColor() * specularStrength;
+    Math::Vector3D diffuse = _ambient->getColor() * _diffuse;
     return result *
-           ((diffuse * 0.5 + specular * 0.5) * ambientLight->getIntensity());
+           ((diffuse * 0.5 + specular * 0.5) * _ambient->getIntensity());
   }
   return result;
 }
@@ -57,4 +65,27 @@ Math::Vector3D Raytracer::LightComposite::computeLighting(
 void Raytracer::LightComposite::addLight(
     const std::shared_ptr<ILight> &newLight) {
   _lights.push_back(newLight);
+  _shading.clear();
+  _ambient = nullptr;
+  _directional = nullptr;
+  for (const auto &light : _lights) {
+    if (light->getType() == "AmbientLight") {
+      _ambient = light.get();
+      _shading.push_back(light.get());
+      break;
+    }
+  }
+  for (const auto &light : _lights) {
+    if (light->getType() == "DirectionalLight") {
+      _directional = light.get();
+      _shading.push_back(light.get());
+    }
+  }
+  for (const auto &light : _lights) {
+    if (light->getType() == "PointLight")
+      _shading.push_back(light.get());
+  }
+  _abis.clear();
+  for (const ILight *light : _shading)
+    _abis.push_back(Factory::getLightAbi(*light));
 }
@@ -2,6 +2,7 @@
 #include <memory>
 #include <vector>
 #include "ALight.hpp"
+#include "LightAbi.hpp"
 #include "ShapeComposite.hpp"
 #include "Vector3D.hpp"
 
@@ -18,10 +19,56 @@ namespace Raytracer {
           const Math::Point3D &hitPoint, const Math::Vector3D &viewDir,
           const ShapeComposite &shapes) const override;
 
+      /**
+       * @brief Computes the lighting at a point whose shadow rays were
+       * traced by the caller.
+       * @param occluded Whether the shadow ray of each light of
+       * getShadingOrder() hit a shape, in the same order.
+       * @param shapes The shapes of the scene, through which the lights
+       * without a LightAbi trace their own shadow ray.
+       */
+      Math::Vector3D computeLighting(
+          const Math::Vector3D &normal, const Math::Vector3D &objectColor,
+          const Math::Point3D &hitPoint, const Math::Vector3D &viewDir,
+          const unsigned char *occluded, const ShapeComposite &shapes) const;
+
+      /**
+       * @brief Computes the lighting as if the shadow ray of every light had
+       * the same outcome. Lights without a LightAbi are lit as if nothing
+       * stood in their way.
+       */
+      Math::Vector3D computeDirectLighting(
+          const Math::Vector3D &normal, const Math::Vector3D &objectColor,
+          const Math::Point3D &hitPoint, const Math::Vector3D &viewDir,
+          bool occluded) const override;
+
       const std::vector<std::shared_ptr<ILight>> &getLights() const {
         return _lights;
       };
 
+      /**
+       * @brief Gets the lights computeLighting() adds up, in order: the
+       * first ambient light, the directional lights, then the point lights.
+       */
+      const std::vector<const ILight *> &getShadingOrder() const {
+        return _shading;
+      }
+
+      /**
+       * @brief Gets the shadow ray of light i of getShadingOrder(), through
+       * its plugin.
+       * @param i The index of the light.
+       * @param hitPoint The point on the surface.
+       * @param ray Receives the shadow ray.
+       * @return true if the light casts a shadow ray the caller must trace.
+       * Lights without a LightAbi cast none here and trace their own in
+       * computeLighting().
+       */
+      bool castShadowRay(std::size_t i, const Math::Point3D &hitPoint,
+                         Ray &ray) const {
+        return lightShadowRay(_abis[i], *_shading[i], hitPoint, ray);
+      }
+
       void setDiffuse(double diffuse) {
         _diffuse = diffuse;
       }
@@ -32,7 +79,19 @@ namespace Raytracer {
                                    const Math::Vector3D &normal) const;
 
     private:
+      /**
+       * @brief Adds the specular highlight of the last directional light,
+       * tinted by the ambient light, to the sum of the lights.
+       */
+      Math::Vector3D addSpecular(const Math::Vector3D &result,
+                                 const Math::Vector3D &normal,
+                                 const Math::Vector3D &viewDir) const;
+
       std::vector<std::shared_ptr<ILight>> _lights;
+      std::vector<const ILight *> _shading; ///< Lights shaded, in order.
+      std::vector<const LightAbi *> _abis;  ///< Plugin entry points of each light of _shading.
+      const ILight *_ambient = nullptr;     ///< First ambient light.
+      const ILight *_directional = nullptr; ///< Last directional light.
       double _diffuse = 0;
   };
 };  // namespace Raytracer
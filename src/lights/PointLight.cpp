@@ -4,19 +4,23 @@
 #include <algorithm>
 #include <iostream>
 
-Math::Vector3D Raytracer::PointLight::computeLighting(
+bool Raytracer::PointLight::shadowRay(const Math::Point3D &hitPoint,
+                                      Raytracer::Ray &ray) const {
+  ray = Raytracer::Ray(hitPoint, -getDirection().normalize(),
+                       Raytracer::Ray::Shadow, Raytracer::Ray::surfaceOffset);
+  return true;
+}
+
+Math::Vector3D Raytracer::PointLight::computeDirectLighting(
     const Math::Vector3D &normal,
     const Math::Vector3D &objectColor,
     const Math::Point3D &hitPoint,
     __attribute__((unused))const Math::Vector3D &viewDir,
-    const Raytracer::ShapeComposite &shapes) const {
+    bool occluded) const {
   Math::Vector3D lightDir = (_position - hitPoint).normalize();
-  Math::Point3D shadowOrigin = hitPoint + normal * 0.001;
-  Raytracer::Ray shadowRay(shadowOrigin, -getDirection().normalize());
-  auto [shadow, _, shadowShape] = shapes.hits(shadowRay);
   double lightIntensity;
 
-  if (shadow > 0.0 && shadowShape != nullptr) {
+  if (occluded) {
     lightIntensity = 0.1f * getIntensity();
   } else {
     lightIntensity = (0.1f + 0.9f * std::max(0.0, normal.dot(lightDir))) * getIntensity();
@@ -34,4 +38,10 @@ Raytracer::ILight *addLight() {
     return nullptr;
   }
 }
+
+const Raytracer::LightAbi *lightAbi() {
+  static const Raytracer::LightAbi abi =
+      Raytracer::lightAbiOf<Raytracer::PointLight>();
+  return &abi;
+}
 }
@@ -20,6 +20,15 @@ class PointLight : public ALight {
      */
     ~PointLight() = default;
 
+    /**
+     * @brief Gets the shadow ray cast from a hit point.
+     *
+     * @param hitPoint The point on the surface where the light is being calculated.
+     * @param ray Receives the shadow ray.
+     * @return true, a point light always casts shadows.
+     */
+    bool shadowRay(const Math::Point3D &hitPoint, Ray &ray) const override;
+
     /**
      * @brief Computes the lighting contribution of this point light at a given hit point.
      *
@@ -27,13 +36,13 @@ class PointLight : public ALight {
      * @param objectColor The color of the object at the hit point.
      * @param hitPoint The point on the surface where the light is being calculated.
      * @param viewDir The direction from the hit point to the camera.
-     * @param shapes A composite of all shapes in the scene, used for shadow checking.
+     * @param occluded Whether the shadow ray hit an object.
      * @return Math::Vector3D The calculated color contribution from this light.
      */
-    Math::Vector3D computeLighting(
+    Math::Vector3D computeDirectLighting(
       const Math::Vector3D &normal, const Math::Vector3D &objectColor,
       const Math::Point3D &hitPoint, const Math::Vector3D &viewDir,
-      const ShapeComposite &shapes) const override;
+      bool occluded) const override;
 
     /**
      * @brief Sets the position of the point light.
@@ -1,13 +1,20 @@
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <string>
 #include "Scene.hpp"
+#include "Trace.hpp"
 
 /**
  * @brief The main entry point for the Raytracer application.
  *
  * This function handles command-line arguments, initializes the scene,
  * and starts the rendering process.
- * It expects one argument: the path to a scene configuration file (*.cfg).
+ * It expects one argument: the path to a scene configuration file (*.cfg),
+ * optionally preceded by `--trace <file.json>` to record a Chrome trace of
+ * the loading and of every frame, written when the program exits, and by
+ * `--budget <ms>` to set the frame time aimed for while the camera moves,
+ * and by `--wavefront on|off` to render through the wavefront pipeline.
  * The -h flag can be used to display usage information.
  *
  * @param ac The number of command-line arguments.
@@ -16,6 +23,22 @@
  * @return int Returns 0 on successful execution, 84 on error (e.g., incorrect arguments, file not found, rendering error).
  */
 int main(int ac, char **av) {
+  std::string tracePath;
+  double budgetMs = 16.0;
+  bool wavefront = false;
+  while (ac >= 4 && av && strncmp(av[1], "--", 2) == 0) {
+    if (strcmp(av[1], "--trace") == 0)
+      tracePath = av[2];
+    else if (strcmp(av[1], "--budget") == 0 && std::atof(av[2]) > 0)
+      budgetMs = std::atof(av[2]);
+    else if (strcmp(av[1], "--wavefront") == 0 &&
+             (strcmp(av[2], "on") == 0 || strcmp(av[2], "off") == 0))
+      wavefront = strcmp(av[2], "on") == 0;
+    else
+      break;
+    av += 2;
+    ac -= 2;
+  }
   if (ac != 2 || !av) {
     std::cerr << "[ERROR] - You need only two arguments to start this "
                  "project.\nUse -h flag to have more information.\n"
@@ -24,21 +47,36 @@ int main(int ac, char **av) {
   }
   if (strcmp(av[1], "-h") == 0) {
     std::string helpMessage =
-        "USAGE:\t./raytracer <SCENE_FILE>\n  SCENE_FILE: scene configuration "
-        "(*.cfg)";
+        "USAGE:\t./raytracer [--trace TRACE_FILE] [--budget MS] "
+        "[--wavefront on|off] <SCENE_FILE>\n"
+        "  SCENE_FILE: scene configuration (*.cfg)\n"
+        "  TRACE_FILE: Chrome trace written on exit (*.json)\n"
+        "  MS: frame time aimed for while moving, 16 by default\n"
+        "  --wavefront: render stage by stage (F7), off by default";
     std::cout << helpMessage << std::endl;
     return 0;
   }
 
+  int status = 0;
+  if (!tracePath.empty())
+    Raytracer::Trace::start(tracePath);
   try {
     Raytracer::Scene scene(800, 600, av[1]);
+    scene.setFrameBudget(budgetMs);
+    scene.setWavefront(wavefront);
     scene.render();
   } catch (const std::exception &e) {
     std::cerr << e.what() << std::endl;
-    return 84;
+    status = 84;
   } catch (...) {
     std::cerr << "[ERROR] - Unknown error occurred." << std::endl;
-    return 84;
+    status = 84;
+  }
+  try {
+    Raytracer::Trace::stop();
+  } catch (const std::exception &e) {
+    std::cerr << "[ERROR] - " << e.what() << std::endl;
+    status = 84;
   }
-  return 0;
+  return status;
 }
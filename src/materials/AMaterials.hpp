@@ -1,6 +1,7 @@
 #pragma once
 
 #include "IMaterials.hpp"
+#include "MaterialAbi.hpp"
 
 namespace Raytracer {
 
@@ -8,9 +9,14 @@ namespace Raytracer {
    * @brief Abstract base class for materials.
    *
    * This class implements the IMaterials interface and serves as a base
-   * for concrete material implementations. It provides default constructor
-   * and destructor. The `computeMaterial` method remains pure virtual,
-   * requiring derived classes to implement their specific shading logic.
+   * for concrete material implementations. It implements `computeMaterial`
+   * on top of `scatter`, which remains pure virtual: derived classes only
+   * describe their secondary ray, and the renderer can queue it instead of
+   * tracing it at once.
+   *
+   * `scatter` was added since the vtable of IMaterials was frozen, so the
+   * renderer reaches it through the MaterialAbi table the plugin exports,
+   * see materialAbiOf().
    */
   class AMaterials : public IMaterials {
     public:
@@ -24,15 +30,13 @@ namespace Raytracer {
       virtual ~AMaterials() = default;
 
       /**
-       * @brief Pure virtual method to compute the material's color at a hit point.
-       *
-       * Derived classes must implement this method to define their specific
-       * appearance and interaction with light and the scene.
+       * @brief Computes the material's color at a hit point by tracing the
+       * ray described by scatter() through rayColorFunc.
        *
        * @param normal The surface normal vector at the hit point.
        * @param viewDir The direction vector from the hit point towards the camera.
        * @param hitPoint The 3D coordinates of the point on the surface.
-       * @param color The intrinsic base color of the material.
+       * @param color The lit color of the surface.
        * @param shapes A composite object containing all shapes in the scene.
        * @param lights A composite object containing all light sources in the scene.
        * @param camera The scene's camera.
@@ -46,7 +50,33 @@ namespace Raytracer {
           const Raytracer::ShapeComposite &shapes,
           const Raytracer::LightComposite &lights,
           const Raytracer::Camera &camera, int depth,
-          RayColorFunc rayColorFunc) const override = 0;
+          RayColorFunc rayColorFunc) const override {
+        Scatter bounce;
+        if (!scatter(normal, viewDir, hitPoint, color, depth, bounce))
+          return bounce.base;
+        return bounce.base +
+               bounce.weight *
+                   rayColorFunc(bounce.ray, shapes, lights, camera, depth - 1);
+      }
+
+      /**
+       * @brief Pure virtual method to describe the secondary ray of the
+       * material. Derived classes must implement it to define their specific
+       * appearance and interaction with the scene.
+       *
+       * @param normal The surface normal vector at the hit point.
+       * @param viewDir The direction vector from the hit point towards the camera.
+       * @param hitPoint The 3D coordinates of the point on the surface.
+       * @param color The lit color of the surface.
+       * @param depth The current recursion depth for ray tracing.
+       * @param bounce Receives the ray and how its color is mixed in.
+       * @return true if the ray must be traced.
+       */
+      virtual bool scatter(const Math::Vector3D &normal,
+                           const Math::Vector3D &viewDir,
+                           const Math::Point3D &hitPoint,
+                           const Math::Vector3D &color, int depth,
+                           Scatter &bounce) const = 0;
   };
 
 }  // namespace Raytracer
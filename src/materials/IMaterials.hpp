@@ -3,6 +3,7 @@
 #include <functional>
 #include "Camera.hpp"
 #include "Point3D.hpp"
+#include "Ray.hpp"
 #include "Vector3D.hpp"
 
 namespace Raytracer {
@@ -10,7 +11,6 @@ namespace Raytracer {
   class ShapeComposite;
   class LightComposite;
   class Camera;
-  class Ray;
 
   /**
    * @brief Interface for materials in the Raytracer.
@@ -18,6 +18,10 @@ namespace Raytracer {
    * Defines the contract for how different materials (e.g., diffuse, reflective,
    * refractive, transparent) compute their appearance based on lighting,
    * view direction, and scene context.
+   *
+   * Frozen like the vtable of IShape: scatter() is a virtual function of
+   * AMaterials, reached by the host through the optional table of
+   * MaterialAbi.hpp.
    */
   class IMaterials {
     public:
@@ -26,6 +30,17 @@ namespace Raytracer {
        */
       virtual ~IMaterials() = default;
 
+      /**
+       * @brief The secondary ray a material sends from a surface point, and
+       * how its color is mixed into the color of the point: base + weight *
+       * color of the ray, component by component.
+       */
+      struct Scatter {
+        Raytracer::Ray ray;    ///< The secondary ray.
+        Math::Vector3D base;   ///< Part of the color that does not depend on the ray.
+        Math::Vector3D weight; ///< Share of the color of the ray.
+      };
+
       /**
        * @brief Type alias for a function that computes the color of a ray.
        *
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include "IMaterials.hpp"
+#include "Point3D.hpp"
+#include "Vector3D.hpp"
+
+namespace Raytracer {
+
+  /**
+   * @brief Version of the MaterialAbi table described in this file.
+   *
+   * Like ShapeAbi, the table carries the entry points added to materials
+   * since the vtable of IMaterials was frozen. A material plugin without
+   * materialAbi() (version 0) is shaded through
+   * IMaterials::computeMaterial(), which traces its secondary ray at once
+   * instead of queueing it. Later versions only append fields.
+   */
+  constexpr std::uint32_t materialAbiVersion = 1;
+
+  /**
+   * @brief Entry points a plugin implements, as bits of
+   * MaterialAbi::capabilities.
+   */
+  enum MaterialCapability : std::uint32_t {
+    MaterialScatter = 1u << 0, ///< MaterialAbi::scatter is set.
+  };
+
+  /**
+   * @brief Extended entry points of a material plugin, returned by its
+   * materialAbi() export. The functions take the material created by the
+   * addMaterial() of the same plugin and are called from several threads at
+   * once.
+   */
+  struct MaterialAbi {
+    std::uint32_t version;      ///< materialAbiVersion the plugin was built with.
+    std::uint32_t capabilities; ///< MaterialCapability bits.
+
+    /**
+     * @brief Describes the secondary ray of the material at a surface point
+     * instead of tracing it, as AMaterials::scatter() does.
+     * @return Non-zero if the ray must be traced.
+     */
+    int (*scatter)(const IMaterials *material, const Math::Vector3D *normal,
+                   const Math::Vector3D *viewDir,
+                   const Math::Point3D *hitPoint, const Math::Vector3D *color,
+                   int depth, IMaterials::Scatter *bounce);
+  };
+
+  /**
+   * @brief Checks whether a table provides an entry point.
+   * @param abi The table, nullptr for a plugin without one.
+   * @param version The version that added the entry point.
+   * @param capability The bit of the entry point.
+   */
+  inline bool hasMaterialEntry(const MaterialAbi *abi, std::uint32_t version,
+                               MaterialCapability capability) {
+    return abi && abi->version >= version && (abi->capabilities & capability);
+  }
+
+  /**
+   * @brief Builds the table of a material plugin whose materials derive
+   * from AMaterials, every entry point calling the member function of T.
+   * @tparam T The concrete material type of the plugin.
+   * @return MaterialAbi The table, to be kept alive by the plugin.
+   */
+  template <typename T>
+  MaterialAbi materialAbiOf() {
+    MaterialAbi abi = {};
+    abi.version = materialAbiVersion;
+    abi.capabilities = MaterialScatter;
+    abi.scatter = [](const IMaterials *material, const Math::Vector3D *normal,
+                     const Math::Vector3D *viewDir,
+                     const Math::Point3D *hitPoint, const Math::Vector3D *color,
+                     int depth, IMaterials::Scatter *bounce) -> int {
+      return static_cast<const T *>(material)->T::scatter(
+          *normal, *viewDir, *hitPoint, *color, depth, *bounce);
+    };
+    return abi;
+  }
+
+}  // namespace Raytracer
+
+extern "C" {
+/**
+ * @brief Optional export of a material plugin giving its extended entry
+ * points. The returned table must live as long as the plugin is loaded.
+ */
+const Raytracer::MaterialAbi *materialAbi();
+}
@@ -3,43 +3,40 @@
 #include "Vector3D.hpp"
 
 /**
- * @brief Computes the color for a reflective material.
+ * @brief Describes the reflected ray of a mirror-like surface.
  *
- * If the recursion depth is not exhausted, it calculates the reflection direction
- * and casts a new ray from the hit point (slightly offset) in that direction.
- * The color obtained from this reflected ray is then blended with the object's
- * own color using a fixed reflectivity factor (0.9 for reflected, 0.1 for base color).
+ * If the recursion depth is not exhausted, the reflection direction is
+ * computed and the ray starts from the hit point, slightly offset. Its color
+ * is blended with the object's own color using a fixed reflectivity factor
+ * (0.9 for reflected, 0.1 for base color).
  *
  * @param normal The surface normal at the hit point.
  * @param viewDir The direction from the hit point to the camera.
  * @param hitPoint The point of intersection on the surface.
- * @param color The base color of the reflective material.
- * @param shapes The collection of shapes in the scene.
- * @param lights The collection of lights in the scene.
- * @param camera The camera used for rendering.
+ * @param color The lit color of the reflective surface.
  * @param depth The current recursion depth for ray tracing.
- * @param rayColorFunc A function to compute the color of a ray.
- * @return Math::Vector3D The blended color of the reflective surface.
+ * @param bounce Receives the reflected ray and the blend.
+ * @return true unless the depth is exhausted.
  */
-Math::Vector3D Raytracer::Reflections::computeMaterial(
-    const Math::Vector3D &normal, const Math::Vector3D &viewDir,
-    const Math::Point3D &hitPoint, const Math::Vector3D &color,
-    const Raytracer::ShapeComposite &shapes,
-    const Raytracer::LightComposite &lights, const Raytracer::Camera &camera,
-    int depth, RayColorFunc rayColorFunc) const {
+bool Raytracer::Reflections::scatter(const Math::Vector3D &normal,
+                                     const Math::Vector3D &viewDir,
+                                     const Math::Point3D &hitPoint,
+                                     const Math::Vector3D &color, int depth,
+                                     Scatter &bounce) const {
   if (depth <= 0) {
-    return color;
+    bounce.base = color;
+    return false;
   }
 
   Math::Vector3D reflectedDir = -viewDir + normal * (2 * viewDir.dot(normal));
   reflectedDir.normalize();
 
-  Raytracer::Ray reflectedRay(hitPoint + reflectedDir * 0.001, reflectedDir);
-
-  Math::Vector3D reflectedColor =
-      rayColorFunc(reflectedRay, shapes, lights, camera, depth - 1);
-
-  return color * (1.0f - 0.9f) + reflectedColor * 0.9f;
+  bounce.ray = Raytracer::Ray(hitPoint, reflectedDir,
+                               Raytracer::Ray::Secondary,
+                               Raytracer::Ray::surfaceOffset);
+  bounce.base = color * (1.0f - 0.9f);
+  bounce.weight = Math::Vector3D(0.9f, 0.9f, 0.9f);
+  return true;
 }
 
 extern "C" {
@@ -58,4 +55,15 @@ Raytracer::IMaterials *addMaterial() {
     return nullptr;
   }
 }
+
+/**
+ * @brief Gives the extended entry points of the Reflections plugin, see
+ * MaterialAbi.hpp.
+ * @return const Raytracer::MaterialAbi* The entry points.
+ */
+const Raytracer::MaterialAbi *materialAbi() {
+  static const Raytracer::MaterialAbi abi =
+      Raytracer::materialAbiOf<Raytracer::Reflections>();
+  return &abi;
+}
 }
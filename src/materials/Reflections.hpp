@@ -24,30 +24,21 @@ namespace Raytracer {
       ~Reflections() override = default;
 
       /**
-       * @brief Computes the color for a reflective material.
+       * @brief Describes the reflected ray of a mirror-like surface.
        *
-       * Calculates the reflection direction based on the surface normal and view direction.
-       * A new ray is traced in this reflection direction, and its color is blended
-       * with the material's base color using a fixed reflectivity factor.
+       * The ray leaves in the reflection direction; 90% of the final color
+       * comes from it and 10% from the surface.
        *
        * @param normal The normal vector at the hit point.
        * @param viewDir The direction from the hit point towards the camera.
        * @param hitPoint The point of intersection on the surface.
-       * @param color The base color of the reflective material.
-       * @param shapes The composite of all shapes in the scene.
-       * @param lights The composite of all lights in the scene.
-       * @param camera The scene camera.
-       * @param depth The current recursion depth for ray tracing.
-       * @param rayColorFunc A callback function to compute the color of a new ray.
-       * @return Math::Vector3D The final computed color, blending the material's color with the reflected color.
+       * @param color The lit color of the surface.
+       * @param depth The current recursion depth, no ray being sent at 0.
+       * @param bounce Receives the ray and how its color is mixed in.
+       * @return true if the ray must be traced.
        */
-      Math::Vector3D computeMaterial(const Math::Vector3D &normal,
-                                     const Math::Vector3D &viewDir,
-                                     const Math::Point3D &hitPoint,
-                                     const Math::Vector3D &color,
-                                     const Raytracer::ShapeComposite &shapes,
-                                     const Raytracer::LightComposite &lights,
-                                     const Raytracer::Camera &camera, int depth,
-                                     RayColorFunc rayColorFunc) const override;
+      bool scatter(const Math::Vector3D &normal, const Math::Vector3D &viewDir,
+                   const Math::Point3D &hitPoint, const Math::Vector3D &color,
+                   int depth, Scatter &bounce) const override;
   };
 }  // namespace Raytracer
@@ -4,32 +4,28 @@
 #include <iostream>
 
 /**
- * @brief Computes the color for a refractive material using Snell's Law.
+ * @brief Describes the refracted ray of the surface, using Snell's Law.
  *
  * Handles entering and exiting the material by adjusting the normal and refractive indices.
- * If total internal reflection occurs, it computes a purely reflected ray. Otherwise,
- * it computes the refracted ray. The color from the new ray (refracted or reflected)
- * is then blended with the object's base color.
+ * If total internal reflection occurs, the ray is purely reflected and makes the whole
+ * color. Otherwise, the color of the refracted ray is blended with the object's base color.
  *
  * @param normal The surface normal at the hit point.
  * @param viewDir The direction from the hit point to the camera.
  * @param hitPoint The point of intersection on the surface.
- * @param color The base color of the refractive material.
- * @param shapes The collection of shapes in the scene.
- * @param lights The collection of lights in the scene.
- * @param camera The camera used for rendering.
+ * @param color The lit color of the refractive surface.
  * @param depth The current recursion depth for ray tracing.
- * @param rayColorFunc A function to compute the color of a ray.
- * @return Math::Vector3D The blended color resulting from refraction/reflection.
+ * @param bounce Receives the refracted or reflected ray and the blend.
+ * @return true unless the depth is exhausted.
  */
-Math::Vector3D Raytracer::Refractions::computeMaterial(
-    const Math::Vector3D &normal, const Math::Vector3D &viewDir,
-    const Math::Point3D &hitPoint, const Math::Vector3D &color,
-    const Raytracer::ShapeComposite &shapes,
-    const Raytracer::LightComposite &lights, const Raytracer::Camera &camera,
-    int depth, RayColorFunc rayColorFunc) const {
+bool Raytracer::Refractions::scatter(const Math::Vector3D &normal,
+                                     const Math::Vector3D &viewDir,
+                                     const Math::Point3D &hitPoint,
+                                     const Math::Vector3D &color, int depth,
+                                     Scatter &bounce) const {
   if (depth <= 0) {
-      return color;
+      bounce.base = color;
+      return false;
   }
   const float n1 = 1.0f;
   const float n2 = 1.5f;
@@ -50,16 +46,20 @@ Math::Vector3D Raytracer::Refractions::computeMaterial(
   if (cosT2 < 0.0f) {
       Math::Vector3D reflectedDir = incidentDir - refractiveNormal * 2.0f * cosI;
       reflectedDir.normalize();
-      Raytracer::Ray reflectedRay(hitPoint + reflectedDir * 0.001f, reflectedDir);
-      return rayColorFunc(reflectedRay, shapes, lights, camera, depth - 1);
+      bounce.ray = Raytracer::Ray(hitPoint, reflectedDir, Raytracer::Ray::Secondary, Raytracer::Ray::surfaceOffset);
+      bounce.base = Math::Vector3D(0, 0, 0);
+      bounce.weight = Math::Vector3D(1, 1, 1);
+      return true;
   }
   float cosT = std::sqrt(cosT2);
   Math::Vector3D refractedDir = incidentDir * refractionRatio + refractiveNormal * (refractionRatio * cosI - cosT);
   refractedDir.normalize();
-  Raytracer::Ray refractedRay(hitPoint + refractedDir * 0.001f, refractedDir);
-  Math::Vector3D refractedColor = rayColorFunc(refractedRay, shapes, lights, camera, depth - 1);
+  bounce.ray = Raytracer::Ray(hitPoint, refractedDir, Raytracer::Ray::Secondary, Raytracer::Ray::surfaceOffset);
   const float baseColorRatio = getBaseColorRatio();
-  return color * baseColorRatio + refractedColor * (1.0f - baseColorRatio);
+  bounce.base = color * baseColorRatio;
+  bounce.weight = Math::Vector3D(1.0f - baseColorRatio, 1.0f - baseColorRatio,
+                                  1.0f - baseColorRatio);
+  return true;
 }
 
 extern "C" {
@@ -78,4 +78,15 @@ Raytracer::IMaterials *addMaterial() {
     return nullptr;
   }
 }
+
+/**
+ * @brief Gives the extended entry points of the Refractions plugin, see
+ * MaterialAbi.hpp.
+ * @return const Raytracer::MaterialAbi* The entry points.
+ */
+const Raytracer::MaterialAbi *materialAbi() {
+  static const Raytracer::MaterialAbi abi =
+      Raytracer::materialAbiOf<Raytracer::Refractions>();
+  return &abi;
+}
 }
@@ -31,31 +31,22 @@ namespace Raytracer {
       float getBaseColorRatio() const { return 0.1f; }
 
       /**
-       * @brief Computes the color for a refractive material.
+       * @brief Describes the refracted ray of the surface, following Snell's law.
        *
-       * Calculates the refracted ray direction using Snell's Law. If total internal
-       * reflection occurs, it computes a reflected ray instead. A new ray is traced
-       * in the calculated direction, and its color is blended with the material's
-       * base color.
+       * Rays entering and leaving the material are bent both ways. On total
+       * internal reflection, the reflected ray is sent instead and makes the
+       * whole color; otherwise the refracted ray makes 90% of it.
        *
        * @param normal The normal vector at the hit point.
        * @param viewDir The direction from the hit point towards the camera.
        * @param hitPoint The point of intersection on the surface.
-       * @param color The base color of the refractive material.
-       * @param shapes The composite of all shapes in the scene.
-       * @param lights The composite of all lights in the scene.
-       * @param camera The scene camera.
-       * @param depth The current recursion depth for ray tracing.
-       * @param rayColorFunc A callback function to compute the color of a new ray.
-       * @return Math::Vector3D The final computed color.
+       * @param color The lit color of the surface.
+       * @param depth The current recursion depth, no ray being sent at 0.
+       * @param bounce Receives the ray and how its color is mixed in.
+       * @return true if the ray must be traced.
        */
-      Math::Vector3D computeMaterial(const Math::Vector3D &normal,
-                                     const Math::Vector3D &viewDir,
-                                     const Math::Point3D &hitPoint,
-                                     const Math::Vector3D &color,
-                                     const Raytracer::ShapeComposite &shapes,
-                                     const Raytracer::LightComposite &lights,
-                                     const Raytracer::Camera &camera, int depth,
-                                     RayColorFunc rayColorFunc) const override;
+      bool scatter(const Math::Vector3D &normal, const Math::Vector3D &viewDir,
+                   const Math::Point3D &hitPoint, const Math::Vector3D &color,
+                   int depth, Scatter &bounce) const override;
   };
 }  // namespace Raytracer
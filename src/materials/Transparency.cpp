@@ -1,43 +1,39 @@
 #include "Transparency.hpp"
 #include <iostream>
-#include "Camera.hpp"
-#include "LightComposite.hpp"
-#include "ShapeComposite.hpp"
 #include "Vector3D.hpp"
 
 /**
- * @brief Computes the color for a transparent material.
+ * @brief Describes the ray passing through a transparent surface.
  *
- * If the recursion depth is not exhausted, it casts a new ray from the hit point
- * in the direction opposite to the view vector (as if looking through the object).
- * The color obtained from this new ray is then blended with the object's own color
- * using a fixed transparency factor.
+ * If the recursion depth is not exhausted, the ray starts from the hit point
+ * in the direction opposite to the view vector (as if looking through the
+ * object). Its color is blended with the object's own color using a fixed
+ * transparency factor.
  *
  * @param normal The surface normal at the hit point (marked as unused).
  * @param viewDir The direction from the hit point to the camera.
  * @param hitPoint The point of intersection on the surface.
- * @param color The base color of the transparent material.
- * @param shapes The collection of shapes in the scene.
- * @param lights The collection of lights in the scene.
- * @param camera The camera used for rendering.
+ * @param color The lit color of the transparent surface.
  * @param depth The current recursion depth for ray tracing.
- * @param rayColorFunc A function to compute the color of a ray.
- * @return Math::Vector3D The blended color of the transparent surface.
+ * @param bounce Receives the ray and the blend.
+ * @return true unless the depth is exhausted.
  */
-Math::Vector3D Raytracer::Transparency::computeMaterial(
+bool Raytracer::Transparency::scatter(
     __attribute__((unused)) const Math::Vector3D &normal,
     const Math::Vector3D &viewDir, const Math::Point3D &hitPoint,
-    const Math::Vector3D &color, const Raytracer::ShapeComposite &shapes,
-    const Raytracer::LightComposite &lights, const Raytracer::Camera &camera,
-    int depth, RayColorFunc rayColorFunc) const {
-  if (depth <= 0)
-    return color;
+    const Math::Vector3D &color, int depth, Scatter &bounce) const {
+  if (depth <= 0) {
+    bounce.base = color;
+    return false;
+  }
 
-  Raytracer::Ray Ray(hitPoint + -viewDir.normalized() * 0.001f,
-                     -viewDir.normalized());
-  Math::Vector3D Object = rayColorFunc(Ray, shapes, lights, camera, depth - 1);
+  bounce.ray = Raytracer::Ray(hitPoint, -viewDir.normalized(),
+                               Raytracer::Ray::Secondary,
+                               Raytracer::Ray::surfaceOffset);
   float transparency = 0.7f;
-  return color * (1.0f - transparency) + Object * transparency;
+  bounce.base = color * (1.0f - transparency);
+  bounce.weight = Math::Vector3D(transparency, transparency, transparency);
+  return true;
 }
 
 extern "C" {
@@ -56,4 +52,15 @@ Raytracer::IMaterials *addMaterial() {
     return nullptr;
   }
 }
+
+/**
+ * @brief Gives the extended entry points of the Transparency plugin, see
+ * MaterialAbi.hpp.
+ * @return const Raytracer::MaterialAbi* The entry points.
+ */
+const Raytracer::MaterialAbi *materialAbi() {
+  static const Raytracer::MaterialAbi abi =
+      Raytracer::materialAbiOf<Raytracer::Transparency>();
+  return &abi;
+}
 }
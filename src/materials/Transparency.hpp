@@ -23,31 +23,21 @@ namespace Raytracer {
       ~Transparency() override = default;
 
       /**
-       * @brief Computes the color for a transparent material.
+       * @brief Describes the ray passing through the surface.
        *
-       * It calculates the color by tracing a new ray in the view direction
-       * from the hit point (slightly offset) to find the color of the object behind.
-       * This color is then blended with the material's base color based on a
-       * fixed transparency factor.
+       * The ray goes on in the view direction, from the other side of the
+       * surface; 70% of the final color comes from what it hits.
        *
-       * @param normal The normal vector at the hit point (unused in this simple implementation).
+       * @param normal The normal vector at the hit point.
        * @param viewDir The direction from the hit point towards the camera.
        * @param hitPoint The point of intersection on the surface.
-       * @param color The base color of the transparent material.
-       * @param shapes The composite of all shapes in the scene.
-       * @param lights The composite of all lights in the scene.
-       * @param camera The scene camera.
-       * @param depth The current recursion depth for ray tracing.
-       * @param rayColorFunc A callback function to compute the color of a new ray.
-       * @return Math::Vector3D The final computed color, blending the material's color with the background color.
+       * @param color The lit color of the surface.
+       * @param depth The current recursion depth, no ray being sent at 0.
+       * @param bounce Receives the ray and how its color is mixed in.
+       * @return true if the ray must be traced.
        */
-      Math::Vector3D computeMaterial(const Math::Vector3D &normal,
-                                     const Math::Vector3D &viewDir,
-                                     const Math::Point3D &hitPoint,
-                                     const Math::Vector3D &color,
-                                     const Raytracer::ShapeComposite &shapes,
-                                     const Raytracer::LightComposite &lights,
-                                     const Raytracer::Camera &camera, int depth,
-                                     RayColorFunc rayColorFunc) const override;
+      bool scatter(const Math::Vector3D &normal, const Math::Vector3D &viewDir,
+                   const Math::Point3D &hitPoint, const Math::Vector3D &color,
+                   int depth, Scatter &bounce) const override;
   };
 }  // namespace Raytracer
@@ -0,0 +1,119 @@
+#include "AABB.hpp"
+#include <algorithm>
+
+namespace {
+
+  /**
+   * @brief Spreads the 10 low bits of a value so that there are two zero
+   * bits between each of them.
+   * @param value The value.
+   * @return std::uint32_t The spread bits.
+   */
+  std::uint32_t spreadBits(std::uint32_t value) {
+    value = (value * 0x00010001u) & 0xFF0000FFu;
+    value = (value * 0x00000101u) & 0x0F00F00Fu;
+    value = (value * 0x00000011u) & 0xC30C30C3u;
+    value = (value * 0x00000005u) & 0x49249249u;
+    return value;
+  }
+
+}  // namespace
+
+/**
+ * @brief Grows the box so that it contains a point.
+ * @param point The point to include.
+ */
+void Math::AABB::expand(const Point3D &point) {
+  min = Point3D(std::min(min.x, point.x), std::min(min.y, point.y),
+                std::min(min.z, point.z));
+  max = Point3D(std::max(max.x, point.x), std::max(max.y, point.y),
+                std::max(max.z, point.z));
+}
+
+/**
+ * @brief Grows the box so that it contains another box.
+ * Expanding by an empty box leaves this box unchanged.
+ * @param box The box to include.
+ */
+void Math::AABB::expand(const AABB &box) {
+  if (box.isEmpty())
+    return;
+  expand(box.min);
+  expand(box.max);
+}
+
+/**
+ * @brief Grows the box so that it contains a disc.
+ * Along each axis, the disc reaches radius * sqrt(1 - n * n) from its
+ * center, n being the component of its normal along that axis: a disc
+ * facing an axis is flat along it, one lying along it reaches the radius.
+ * @param center The center of the disc.
+ * @param normal The unit normal of the disc.
+ * @param radius The radius of the disc.
+ */
+void Math::AABB::expandDisc(const Point3D &center, const Vector3D &normal,
+                            double radius) {
+  radius = std::abs(radius);
+  Vector3D reach(radius * std::sqrt(std::max(0.0, 1.0 - normal.x * normal.x)),
+                 radius * std::sqrt(std::max(0.0, 1.0 - normal.y * normal.y)),
+                 radius * std::sqrt(std::max(0.0, 1.0 - normal.z * normal.z)));
+  expand(center - reach);
+  expand(center + reach);
+}
+
+/**
+ * @brief Gets the center of the box.
+ * @return Math::Point3D The point halfway between min and max.
+ */
+Math::Point3D Math::AABB::centroid() const {
+  return Point3D((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f,
+                 (min.z + max.z) * 0.5f);
+}
+
+/**
+ * @brief Gets the size of the box along each axis.
+ * @return Math::Vector3D The vector from min to max.
+ */
+Math::Vector3D Math::AABB::extent() const {
+  return max - min;
+}
+
+/**
+ * @brief Gets the surface area of the box.
+ * @return double The surface area, or 0 if the box is empty.
+ */
+double Math::AABB::surfaceArea() const {
+  if (isEmpty())
+    return 0.0;
+  Vector3D e = extent();
+  return 2.0 * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+/**
+ * @brief Gets the axis along which the box is the largest.
+ * @return int 0 for x, 1 for y, 2 for z.
+ */
+int Math::AABB::longestAxis() const {
+  Vector3D e = extent();
+  if (e.x >= e.y && e.x >= e.z)
+    return 0;
+  return e.y >= e.z ? 1 : 2;
+}
+
+/**
+ * @brief Gets the 30-bit Morton code of a point: its position on a Z-order
+ * curve through a 1024^3 grid over the box.
+ * @param point The point, clamped to the box.
+ * @return std::uint32_t The code, 0 along the axes where the box is flat.
+ */
+std::uint32_t Math::AABB::mortonCode(const Point3D &point) const {
+  Vector3D size = extent();
+  auto cell = [](float value, float lower, float length) {
+    float unit = length > 0 ? (value - lower) / length : 0.0f;
+    return static_cast<std::uint32_t>(
+        std::clamp(unit * 1024.0f, 0.0f, 1023.0f));
+  };
+  return spreadBits(cell(point.x, min.x, size.x)) << 2 |
+         spreadBits(cell(point.y, min.y, size.y)) << 1 |
+         spreadBits(cell(point.z, min.z, size.z));
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include "Point3D.hpp"
+#include "Vector3D.hpp"
+
+namespace Math {
+
+  /**
+   * @brief Axis-aligned bounding box defined by a minimum and maximum corner.
+   *
+   * A default-constructed box is empty (min = +inf, max = -inf) so that it
+   * can be grown with expand() without special-casing the first point.
+   */
+  class AABB {
+    public:
+      Point3D min; ///< The minimum corner of the box.
+      Point3D max; ///< The maximum corner of the box.
+
+      /**
+       * @brief Constructs an empty box.
+       */
+      AABB()
+          : min(std::numeric_limits<float>::infinity(),
+                std::numeric_limits<float>::infinity(),
+                std::numeric_limits<float>::infinity()),
+            max(-std::numeric_limits<float>::infinity(),
+                -std::numeric_limits<float>::infinity(),
+                -std::numeric_limits<float>::infinity()) {
+      }
+
+      /**
+       * @brief Constructs a box from its two corners.
+       * @param min The minimum corner.
+       * @param max The maximum corner.
+       */
+      AABB(const Point3D &min, const Point3D &max) : min(min), max(max) {
+      }
+
+      /**
+       * @brief Default destructor.
+       */
+      ~AABB() = default;
+
+      /**
+       * @brief Grows the box so that it contains a point.
+       * @param point The point to include.
+       */
+      void expand(const Point3D &point);
+      /**
+       * @brief Grows the box so that it contains another box.
+       * @param box The box to include.
+       */
+      void expand(const AABB &box);
+      /**
+       * @brief Grows the box so that it contains a disc.
+       * @param center The center of the disc.
+       * @param normal The unit normal of the disc.
+       * @param radius The radius of the disc.
+       */
+      void expandDisc(const Point3D &center, const Vector3D &normal,
+                      double radius);
+
+      /**
+       * @brief Checks whether the box contains no point at all.
+       * @return true if the box is empty.
+       */
+      bool isEmpty() const {
+        return min.x > max.x || min.y > max.y || min.z > max.z;
+      }
+
+      /**
+       * @brief Builds a box covering all of space, used by shapes that have
+       * no finite bounds (planes, infinite cylinders...).
+       * @return AABB The infinite box.
+       */
+      static AABB infinite() {
+        float inf = std::numeric_limits<float>::infinity();
+        return AABB(Point3D(-inf, -inf, -inf), Point3D(inf, inf, inf));
+      }
+
+      /**
+       * @brief Checks whether the box extends to infinity along any axis.
+       * @return true if a bound is infinite.
+       */
+      bool isInfinite() const {
+        return std::isinf(min.x) || std::isinf(min.y) || std::isinf(min.z) ||
+               std::isinf(max.x) || std::isinf(max.y) || std::isinf(max.z);
+      }
+
+      /**
+       * @brief Gets the center of the box.
+       * @return Point3D The centroid.
+       */
+      Point3D centroid() const;
+      /**
+       * @brief Gets the size of the box along each axis.
+       * @return Vector3D The extent (max - min).
+       */
+      Vector3D extent() const;
+      /**
+       * @brief Gets the surface area of the box.
+       * @return double The surface area, 0 for an empty box.
+       */
+      double surfaceArea() const;
+      /**
+       * @brief Gets the axis along which the box is the largest.
+       * @return int 0 for x, 1 for y, 2 for z.
+       */
+      int longestAxis() const;
+      /**
+       * @brief Gets the 30-bit Morton code of a point: its position on a
+       * Z-order curve through a 1024^3 grid over the box.
+       * @param point The point, clamped to the box.
+       * @return std::uint32_t The code.
+       */
+      std::uint32_t mortonCode(const Point3D &point) const;
+
+      /**
+       * @brief Slab test against a ray.
+       * @param origin The ray origin.
+       * @param invDir The component-wise inverse of the ray direction.
+       * @param tMin The nearest distance of interest.
+       * @param tMax The farthest distance still of interest.
+       * @return true if the ray crosses the box within [tMin, tMax].
+       */
+      bool intersects(const Point3D &origin, const Vector3D &invDir,
+                      double tMin, double tMax) const {
+        float t0x = (min.x - origin.x) * invDir.x;
+        float t1x = (max.x - origin.x) * invDir.x;
+        float t0y = (min.y - origin.y) * invDir.y;
+        float t1y = (max.y - origin.y) * invDir.y;
+        float t0z = (min.z - origin.z) * invDir.z;
+        float t1z = (max.z - origin.z) * invDir.z;
+        float tNear = std::max(std::max(std::min(t0x, t1x), std::min(t0y, t1y)),
+                               std::min(t0z, t1z));
+        float tFar = std::min(std::min(std::max(t0x, t1x), std::max(t0y, t1y)),
+                              std::max(t0z, t1z));
+        return tNear <= tFar && tFar >= tMin && tNear <= tMax;
+      }
+
+      /**
+       * @brief Gets one coordinate of a point by axis index.
+       * @param point The point.
+       * @param axis 0 for x, 1 for y, 2 for z.
+       * @return float The coordinate.
+       */
+      static float axisOf(const Point3D &point, int axis) {
+        return axis == 0 ? point.x : (axis == 1 ? point.y : point.z);
+      }
+  };
+
+}  // namespace Math
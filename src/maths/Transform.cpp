@@ -0,0 +1,172 @@
+#include "Transform.hpp"
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @brief Constructs the identity transform.
+ */
+Math::Transform::Transform() : _m{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}} {
+}
+
+/**
+ * @brief Builds a translation.
+ * @param offset The translation vector.
+ * @return Math::Transform The translation matrix.
+ */
+Math::Transform Math::Transform::translation(const Vector3D &offset) {
+  Transform t;
+  t._m[0][3] = offset.x;
+  t._m[1][3] = offset.y;
+  t._m[2][3] = offset.z;
+  return t;
+}
+
+/**
+ * @brief Builds a rotation around an arbitrary axis (Rodrigues' formula).
+ * The angle is in degrees, like every other rotation in the scene files.
+ * @param axis The rotation axis.
+ * @param angle The rotation angle in degrees.
+ * @return Math::Transform The rotation matrix.
+ */
+Math::Transform Math::Transform::rotation(const Vector3D &axis, double angle) {
+  Transform t;
+  Vector3D a = axis.normalized();
+  double radians = angle * M_PI / 180.0;
+  double c = std::cos(radians);
+  double s = std::sin(radians);
+  double k = 1.0 - c;
+
+  t._m[0][0] = c + a.x * a.x * k;
+  t._m[0][1] = a.x * a.y * k - a.z * s;
+  t._m[0][2] = a.x * a.z * k + a.y * s;
+  t._m[1][0] = a.y * a.x * k + a.z * s;
+  t._m[1][1] = c + a.y * a.y * k;
+  t._m[1][2] = a.y * a.z * k - a.x * s;
+  t._m[2][0] = a.z * a.x * k - a.y * s;
+  t._m[2][1] = a.z * a.y * k + a.x * s;
+  t._m[2][2] = c + a.z * a.z * k;
+  return t;
+}
+
+/**
+ * @brief Builds a scaling.
+ * @param factors The scale factor along each axis.
+ * @return Math::Transform The scaling matrix.
+ */
+Math::Transform Math::Transform::scaling(const Vector3D &factors) {
+  Transform t;
+  t._m[0][0] = factors.x;
+  t._m[1][1] = factors.y;
+  t._m[2][2] = factors.z;
+  return t;
+}
+
+/**
+ * @brief Composes two transforms. The result applies `other` first.
+ * @param other The transform applied first.
+ * @return Math::Transform The composed transform.
+ */
+Math::Transform Math::Transform::operator*(const Transform &other) const {
+  Transform r;
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 4; j++) {
+      double sum = j == 3 ? _m[i][3] : 0.0;
+      for (int k = 0; k < 3; k++)
+        sum += _m[i][k] * other._m[k][j];
+      r._m[i][j] = sum;
+    }
+  }
+  return r;
+}
+
+/**
+ * @brief Computes the inverse of the affine transform.
+ * The linear part is inverted with its adjugate and the translation is
+ * recomputed as -inverse(linear) * translation.
+ * @return Math::Transform The inverse transform.
+ * @throws std::runtime_error if the linear part is singular.
+ */
+Math::Transform Math::Transform::inverse() const {
+  double c00 = _m[1][1] * _m[2][2] - _m[1][2] * _m[2][1];
+  double c01 = _m[1][2] * _m[2][0] - _m[1][0] * _m[2][2];
+  double c02 = _m[1][0] * _m[2][1] - _m[1][1] * _m[2][0];
+  double det = _m[0][0] * c00 + _m[0][1] * c01 + _m[0][2] * c02;
+
+  if (std::fabs(det) < 1e-12)
+    throw std::runtime_error("Transform is not invertible");
+  double invDet = 1.0 / det;
+
+  Transform r;
+  r._m[0][0] = c00 * invDet;
+  r._m[0][1] = (_m[0][2] * _m[2][1] - _m[0][1] * _m[2][2]) * invDet;
+  r._m[0][2] = (_m[0][1] * _m[1][2] - _m[0][2] * _m[1][1]) * invDet;
+  r._m[1][0] = c01 * invDet;
+  r._m[1][1] = (_m[0][0] * _m[2][2] - _m[0][2] * _m[2][0]) * invDet;
+  r._m[1][2] = (_m[0][2] * _m[1][0] - _m[0][0] * _m[1][2]) * invDet;
+  r._m[2][0] = c02 * invDet;
+  r._m[2][1] = (_m[0][1] * _m[2][0] - _m[0][0] * _m[2][1]) * invDet;
+  r._m[2][2] = (_m[0][0] * _m[1][1] - _m[0][1] * _m[1][0]) * invDet;
+  for (int i = 0; i < 3; i++) {
+    r._m[i][3] = -(r._m[i][0] * _m[0][3] + r._m[i][1] * _m[1][3] +
+                   r._m[i][2] * _m[2][3]);
+  }
+  return r;
+}
+
+/**
+ * @brief Transforms a point.
+ * @param point The point to transform.
+ * @return Math::Point3D The transformed point.
+ */
+Math::Point3D Math::Transform::applyToPoint(const Point3D &point) const {
+  return Point3D(
+      _m[0][0] * point.x + _m[0][1] * point.y + _m[0][2] * point.z + _m[0][3],
+      _m[1][0] * point.x + _m[1][1] * point.y + _m[1][2] * point.z + _m[1][3],
+      _m[2][0] * point.x + _m[2][1] * point.y + _m[2][2] * point.z + _m[2][3]);
+}
+
+/**
+ * @brief Transforms a direction, ignoring the translation.
+ * @param vec The vector to transform.
+ * @return Math::Vector3D The transformed vector.
+ */
+Math::Vector3D Math::Transform::applyToVector(const Vector3D &vec) const {
+  return Vector3D(_m[0][0] * vec.x + _m[0][1] * vec.y + _m[0][2] * vec.z,
+                  _m[1][0] * vec.x + _m[1][1] * vec.y + _m[1][2] * vec.z,
+                  _m[2][0] * vec.x + _m[2][1] * vec.y + _m[2][2] * vec.z);
+}
+
+/**
+ * @brief Transforms a normal by the transpose of the linear part.
+ * @param normal The normal to transform.
+ * @return Math::Vector3D The transformed normal.
+ */
+Math::Vector3D Math::Transform::applyToNormal(const Vector3D &normal) const {
+  return Vector3D(
+      _m[0][0] * normal.x + _m[1][0] * normal.y + _m[2][0] * normal.z,
+      _m[0][1] * normal.x + _m[1][1] * normal.y + _m[2][1] * normal.z,
+      _m[0][2] * normal.x + _m[1][2] * normal.y + _m[2][2] * normal.z);
+}
+
+/**
+ * @brief Transforms a box (Arvo's method): each output axis is built from
+ * the min/max contribution of every input axis instead of the 8 corners.
+ * @param box The box to transform.
+ * @return Math::AABB The box enclosing the transformed input.
+ */
+Math::AABB Math::Transform::applyToBounds(const AABB &box) const {
+  if (box.isEmpty())
+    return box;
+  float lo[3] = {_m[0][3], _m[1][3], _m[2][3]};
+  float hi[3] = {_m[0][3], _m[1][3], _m[2][3]};
+
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      float a = _m[i][j] * AABB::axisOf(box.min, j);
+      float b = _m[i][j] * AABB::axisOf(box.max, j);
+      lo[i] += a < b ? a : b;
+      hi[i] += a < b ? b : a;
+    }
+  }
+  return AABB(Point3D(lo[0], lo[1], lo[2]), Point3D(hi[0], hi[1], hi[2]));
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "AABB.hpp"
+#include "Point3D.hpp"
+#include "Vector3D.hpp"
+
+namespace Math {
+
+  /**
+   * @brief Affine transformation stored as a 3x4 row-major matrix.
+   *
+   * The last row of the homogeneous matrix is implicitly (0, 0, 0, 1), so the
+   * transform covers translation, rotation and (non-uniform) scaling.
+   */
+  class Transform {
+    public:
+      /**
+       * @brief Constructs the identity transform.
+       */
+      Transform();
+
+      /**
+       * @brief Default destructor.
+       */
+      ~Transform() = default;
+
+      /**
+       * @brief Builds a translation.
+       * @param offset The translation vector.
+       * @return Transform The translation matrix.
+       */
+      static Transform translation(const Vector3D &offset);
+      /**
+       * @brief Builds a rotation around an arbitrary axis.
+       * @param axis The rotation axis (does not need to be normalized).
+       * @param angle The rotation angle in degrees.
+       * @return Transform The rotation matrix.
+       */
+      static Transform rotation(const Vector3D &axis, double angle);
+      /**
+       * @brief Builds a scaling.
+       * @param factors The scale factor along each axis.
+       * @return Transform The scaling matrix.
+       */
+      static Transform scaling(const Vector3D &factors);
+
+      /**
+       * @brief Composes two transforms: (A * B) applies B first, then A.
+       * @param other The transform applied first.
+       * @return Transform The composed transform.
+       */
+      Transform operator*(const Transform &other) const;
+
+      /**
+       * @brief Computes the inverse transform.
+       * @return Transform The inverse.
+       * @throw std::runtime_error if the matrix is singular.
+       */
+      Transform inverse() const;
+
+      /**
+       * @brief Transforms a point (rotation, scale and translation).
+       * @param point The point to transform.
+       * @return Point3D The transformed point.
+       */
+      Point3D applyToPoint(const Point3D &point) const;
+      /**
+       * @brief Transforms a direction (rotation and scale only).
+       * @param vec The vector to transform.
+       * @return Vector3D The transformed vector, not normalized.
+       */
+      Vector3D applyToVector(const Vector3D &vec) const;
+      /**
+       * @brief Transforms a normal by the transpose of this matrix.
+       * Call it on the inverse of the object-to-world transform to move a
+       * normal from object space to world space.
+       * @param normal The normal to transform.
+       * @return Vector3D The transformed normal, not normalized.
+       */
+      Vector3D applyToNormal(const Vector3D &normal) const;
+      /**
+       * @brief Transforms a box and returns the box enclosing the result.
+       * @param box The box to transform.
+       * @return AABB The world-space bounding box.
+       */
+      AABB applyToBounds(const AABB &box) const;
+
+    private:
+      float _m[3][4]; ///< Row-major matrix, last column is the translation.
+  };
+
+}  // namespace Math
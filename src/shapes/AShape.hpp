@@ -1,8 +1,11 @@
 #pragma once
 
+#include "AABB.hpp"
 #include "IShape.hpp"
 #include "Point3D.hpp"
 #include "Ray.hpp"
+#include "RayPacket.hpp"
+#include "ShapeAbi.hpp"
 #include "Vector3D.hpp"
 
 constexpr float EPS = 1e-6;
@@ -15,6 +18,12 @@ namespace Raytracer {
    * This class implements the IShape interface and provides common
    * properties and methods for shapes, such as center, color, material,
    * shininess, and translation.
+   *
+   * It also declares the entry points added since the vtable of IShape was
+   * frozen: hitsPacket(), commit() and getBounds(). The host does not call
+   * them through this class, which plugins of earlier versions do not
+   * derive from with the same layout, but through the ShapeAbi table the
+   * plugin exports, see shapeAbiOf().
    */
   class AShape : public IShape {
     public:
@@ -32,6 +41,23 @@ namespace Raytracer {
       virtual std::tuple<double, Math::Vector3D, const IShape *> hits(
           const Raytracer::Ray &ray) const override = 0;
 
+      /**
+       * @brief Intersects several rays of a packet with the shape, one at a
+       * time with hits() by default. Shapes with a SIMD intersector override
+       * it.
+       * @param packet The rays. For each one hit within its (tMin, tMax)
+       * interval, tMax, color and shape are set to the hit, as
+       * RayPacket::record() does; shape being the one hits() would return.
+       * @param mask The rays to test, bit i for ray i.
+       */
+      virtual void hitsPacket(RayPacket &packet, std::uint32_t mask) const {
+        for (; mask; mask &= mask - 1) {
+          int i = __builtin_ctz(mask);
+          auto [t, color, shape] = hits(packet.ray(i));
+          packet.record(i, t, color, shape);
+        }
+      }
+
       /**
        * @brief Pure virtual method to get the normal vector at a hit point.
        * @param hitPoint The point on the shape's surface.
@@ -40,6 +66,18 @@ namespace Raytracer {
       virtual Math::Vector3D getNormal(
           const Math::Point3D &hitPoint) const override = 0;
 
+      /**
+       * @brief Precomputes everything the shape needs that does not depend
+       * on the ray: normalised axes, squared radii, edges, bounds...
+       *
+       * Must be called once the shape is configured and after every
+       * transform or setter, before hits(), getNormal() or getBounds(); the
+       * intersectors only read the values baked here. Constructors commit
+       * the shape they create. Nothing to do by default.
+       */
+      virtual void commit() {
+      }
+
       /**
        * @brief Translates the shape by a given offset.
        * @param offset The vector by which to translate the shape's center.
@@ -116,6 +154,28 @@ namespace Raytracer {
         _material = material;
       }
 
+      /**
+       * @brief Gets the world-space bounding box of the shape, as of the
+       * last commit(), so after every transform applied before it.
+       * Used to build the scene acceleration structure. Defaults to an
+       * infinite box, which is always correct but keeps the shape out of the
+       * BVH and tested on every ray: bounded shapes should override it.
+       * @return Math::AABB The bounding box.
+       */
+      virtual Math::AABB getBounds() const {
+        return Math::AABB::infinite();
+      }
+
+      /**
+       * @brief Checks whether the shape has no finite extent (planes,
+       * infinite cylinders and cones...), in which case spatial structures
+       * keep it apart and test it against every ray.
+       * @return true if getBounds() is infinite.
+       */
+      bool isInfinite() const {
+        return getBounds().isInfinite();
+      }
+
     protected:
       Math::Point3D _center;  ///< The center point of the shape.
       Math::Vector3D _color;  ///< The color of the shape.
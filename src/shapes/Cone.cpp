@@ -1,6 +1,8 @@
 #include "Cone.hpp"
 #include <cmath>
+#include <initializer_list>
 #include <iostream>
+#include <utility>
 #include "Point3D.hpp"
 #include "Vector3D.hpp"
 
@@ -12,20 +14,15 @@ const double eps = 1e-6;  // Epsilon for floating point comparisons
  * @param ray The ray to test for intersection.
  * @return A tuple containing:
  *         - double: The distance from the ray's origin to the closest valid
- * intersection point (t). Returns 0.0 if there is no hit or if hits are behind
- * the ray origin.
+ * intersection point (t). Returns 0.0 if there is no hit or if no hit is within
+ * [ray.tMin, ray.tMax].
  *         - Math::Vector3D: The color of the cone.
  *         - const Raytracer::IShape*: A pointer to this cone object.
  */
 std::tuple<double, Math::Vector3D, const Raytracer::IShape *>
 Raytracer::Cone::hits(const Raytracer::Ray &ray) const {
-  double cone_height = _height;
-  Math::Vector3D cone_axis = _normal;
-
-  if (_height < 0) {
-    cone_height = -_height;
-    cone_axis = -_normal;
-  }
+  double cone_height = _length;
+  const Math::Vector3D &cone_axis = _axis;
 
   Math::Vector3D oc = ray.origin - _center;
   double oc_dot_normal = oc.dot(cone_axis);
@@ -34,8 +31,7 @@ Raytracer::Cone::hits(const Raytracer::Ray &ray) const {
   double dir_dot_normal = ray.direction.dot(cone_axis);
   Math::Vector3D dir_perp = ray.direction - cone_axis * dir_dot_normal;
 
-  double tan_angle = _radius / cone_height;
-  double tan_angle2 = tan_angle * tan_angle;
+  double tan_angle2 = _tan2;
 
   double a =
       dir_perp.dot(dir_perp) - tan_angle2 * dir_dot_normal * dir_dot_normal;
@@ -52,21 +48,15 @@ Raytracer::Cone::hits(const Raytracer::Ray &ray) const {
     double t1 = (-b - sqrt_disc) / (2.0 * a);
     double t2 = (-b + sqrt_disc) / (2.0 * a);
 
-    if (t1 > 0 && t2 > 0) {
-      t_side = std::min(t1, t2);
-    } else if (t1 > 0) {
-      t_side = t1;
-    } else if (t2 > 0) {
-      t_side = t2;
-    }
-
-    if (t_side > 0) {
-      Math::Point3D hit_point = ray.origin + ray.direction * t_side;
-      Math::Vector3D cp = hit_point - _center;
-      double height_pos = cp.dot(cone_axis);
-
-      if (height_pos < 0 || height_pos > cone_height) {
-        t_side = 0.0;
+    if (t1 > t2)
+      std::swap(t1, t2);
+    for (double t : {t1, t2}) {
+      if (!ray.contains(t))
+        continue;
+      double height_pos = oc_dot_normal + t * dir_dot_normal;
+      if (height_pos >= 0 && height_pos <= cone_height) {
+        t_side = t;
+        break;
       }
     }
   }
@@ -75,12 +65,12 @@ Raytracer::Cone::hits(const Raytracer::Ray &ray) const {
   if (std::abs(dir_dot_normal) > eps) {
     double t_plane = -oc_dot_normal / dir_dot_normal;
 
-    if (t_plane > 0) {
+    if (ray.contains(t_plane) && (t_side <= 0 || t_plane < t_side)) {
       Math::Point3D hit_point = ray.origin + ray.direction * t_plane;
       Math::Vector3D cp = hit_point - _center;
       Math::Vector3D cp_perp = cp - cone_axis * cp.dot(cone_axis);
 
-      if (cp_perp.length() <= _radius) {
+      if (cp_perp.dot(cp_perp) <= _radius2) {
         t_base = t_plane;
       }
     }
@@ -111,12 +101,7 @@ Raytracer::Cone::hits(const Raytracer::Ray &ray) const {
  */
 Math::Vector3D Raytracer::Cone::getNormal(
     const Math::Point3D &hit_point) const {
-  double cone_height = _height;
-  Math::Vector3D cone_axis = _normal;
-  if (_height < 0) {
-    cone_height = -_height;
-    cone_axis = -_normal;
-  }
+  const Math::Vector3D &cone_axis = _axis;
 
   Math::Vector3D cp = hit_point - _center;
 
@@ -134,12 +119,7 @@ Math::Vector3D Raytracer::Cone::getNormal(
 
   radial_dir = radial_dir.normalize();
 
-  double tan_angle = _radius / cone_height;
-  double tan_angle2 = tan_angle * tan_angle;
-  double sin_angle = tan_angle / std::sqrt(1 + tan_angle2);
-  double cos_angle = 1 / std::sqrt(1 + tan_angle2);
-
-  Math::Vector3D side_normal = radial_dir * cos_angle + cone_axis * sin_angle;
+  Math::Vector3D side_normal = radial_dir * _cosAngle + cone_axis * _sinAngle;
   side_normal = side_normal.normalize();
 
   return side_normal;
@@ -161,6 +141,24 @@ void Raytracer::Cone::rotate(const Math::Vector3D &axis, float angle) {
   _normal = newNormal.normalize();
 }
 
+/**
+ * @brief Precomputes the unit axis towards the apex, the squared base radius,
+ * the slope of the side and the bounds, which hold the base and the apex and
+ * so the whole side between them.
+ */
+void Raytracer::Cone::commit() {
+  double tan_angle = _radius / std::abs(_height);
+  _axis = _height < 0 ? -_normal.normalized() : _normal.normalized();
+  _length = std::abs(_height);
+  _radius2 = _radius * _radius;
+  _tan2 = tan_angle * tan_angle;
+  _sinAngle = tan_angle / std::sqrt(1 + _tan2);
+  _cosAngle = 1 / std::sqrt(1 + _tan2);
+  _bounds = Math::AABB();
+  _bounds.expandDisc(_center, _axis, _radius);
+  _bounds.expand(_center + _axis * _length);
+}
+
 extern "C" {
 /**
  * @brief Factory function to create a new Cone instance.
@@ -178,4 +176,15 @@ Raytracer::IShape *addShape() {
     return nullptr;
   }
 }
+
+/**
+ * @brief Gives the extended entry points of the Cone plugin, see
+ * ShapeAbi.hpp.
+ * @return const Raytracer::ShapeAbi* The entry points.
+ */
+const Raytracer::ShapeAbi *shapeAbi() {
+  static const Raytracer::ShapeAbi abi =
+      Raytracer::shapeAbiOf<Raytracer::Cone>();
+  return &abi;
+}
 }
@@ -31,6 +31,7 @@ namespace Raytracer {
           : _normal(normal), _radius(radius), _height(height) {
         _center = center;
         _color = color;
+        commit();
       }
 
       /**
@@ -41,6 +42,7 @@ namespace Raytracer {
       Cone() : _normal(Math::Vector3D(0, 1, 0)), _radius(1.0), _height(2.0) {
         _center = Math::Point3D(0, 0, 0);
         _color = Math::Vector3D(1, 0, 0);
+        commit();
       }
 
       /**
@@ -61,6 +63,21 @@ namespace Raytracer {
 
       void rotate(const Math::Vector3D &axis, float angle) override;
 
+      /**
+       * @brief Precomputes the unit axis from the base to the apex, which
+       * flips with the sign of the height, the squared base radius, the
+       * slope of the side and the bounds.
+       */
+      void commit() override;
+
+      /**
+       * @brief Gets the bounding box of the cone.
+       * @return Math::AABB The box around its base and its apex.
+       */
+      Math::AABB getBounds() const override {
+        return _bounds;
+      }
+
       /**
        * @brief Gets the normal vector at a given point on the cone's surface
        * (body or base).
@@ -98,6 +115,13 @@ namespace Raytracer {
                                ///< (from base to apex).
       double _radius;          ///< The radius of the cone's base.
       double _height;          ///< The height of the cone.
+      Math::Vector3D _axis;    ///< Unit axis towards the apex, set by commit().
+      double _length = 2.0;    ///< Distance from the base to the apex.
+      double _radius2 = 1.0;   ///< Squared radius of the base.
+      double _tan2 = 0.25;     ///< Squared tangent of the half-angle.
+      double _sinAngle = 0.0;  ///< Sine of the half-angle.
+      double _cosAngle = 1.0;  ///< Cosine of the half-angle.
+      Math::AABB _bounds;      ///< Bounds, set by commit().
   };
 
 }  // namespace Raytracer
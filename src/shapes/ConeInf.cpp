@@ -1,5 +1,6 @@
 #include "ConeInf.hpp"
 #include <cmath>
+#include <utility>
 #include <iostream>
 #include "Point3D.hpp"
 #include "Vector3D.hpp"
@@ -9,13 +10,13 @@
  * @param ray The ray to test for intersection.
  * @return A tuple containing:
  *         - double: The distance from the ray's origin to the closest valid intersection point (t).
- *                   Returns 0.0 if there is no hit or if hits are behind the ray origin.
+ *                   Returns 0.0 if there is no hit or if no hit is within [ray.tMin, ray.tMax].
  *         - Math::Vector3D: The color of the cone.
  *         - const Raytracer::IShape*: A pointer to this cone object.
  */
 std::tuple<double, Math::Vector3D, const Raytracer::IShape *>
 Raytracer::ConeInf::hits(const Raytracer::Ray &ray) const {
-  Math::Vector3D cone_axis = _normal;
+  Math::Vector3D cone_axis = _axis;
 
   Math::Vector3D oc = ray.origin - _center;
   double oc_dot_axis = oc.dot(cone_axis);
@@ -24,12 +25,9 @@ Raytracer::ConeInf::hits(const Raytracer::Ray &ray) const {
   double dir_dot_axis = ray.direction.dot(cone_axis);
   Math::Vector3D dir_perp = ray.direction - cone_axis * dir_dot_axis;
 
-  double tan = std::tan(_angle);
-  double tan2 = tan * tan;
-
-  double a = dir_perp.dot(dir_perp) - tan2 * dir_dot_axis * dir_dot_axis;
-  double b = 2.0 * (dir_perp.dot(oc_perp) - tan2 * dir_dot_axis * oc_dot_axis);
-  double c = oc_perp.dot(oc_perp) - tan2 * oc_dot_axis * oc_dot_axis;
+  double a = dir_perp.dot(dir_perp) - _tan2 * dir_dot_axis * dir_dot_axis;
+  double b = 2.0 * (dir_perp.dot(oc_perp) - _tan2 * dir_dot_axis * oc_dot_axis);
+  double c = oc_perp.dot(oc_perp) - _tan2 * oc_dot_axis * oc_dot_axis;
 
   double discriminant = b * b - 4 * a * c;
   if (discriminant < 0.0) {
@@ -40,18 +38,13 @@ Raytracer::ConeInf::hits(const Raytracer::Ray &ray) const {
   double t1 = (-b - sqrt_disc) / (2.0 * a);
   double t2 = (-b + sqrt_disc) / (2.0 * a);
 
-  double final_t = 0.0;
-  if (t1 > EPS && t2 > EPS)
-    final_t = std::min(t1, t2);
-  else if (t1 > EPS)
-    final_t = t1;
-  else if (t2 > EPS)
-    final_t = t2;
-
-  if (final_t <= EPS)
-    return {0.0, _color, this};
-
-  return {final_t, _color, this};
+  if (t1 > t2)
+    std::swap(t1, t2);
+  if (ray.contains(t1))
+    return {t1, _color, this};
+  if (ray.contains(t2))
+    return {t2, _color, this};
+  return {0.0, _color, this};
 }
 
 
@@ -62,15 +55,14 @@ Raytracer::ConeInf::hits(const Raytracer::Ray &ray) const {
  */
 Math::Vector3D Raytracer::ConeInf::getNormal(
     const Math::Point3D &hit_point) const {
-  Math::Vector3D cone_axis = _normal;
+  Math::Vector3D cone_axis = _axis;
   Math::Vector3D cp = hit_point - _center;
 
   double proj = cp.dot(cone_axis);
   Math::Point3D axis_point = _center + cone_axis * proj;
   Math::Vector3D point_to_axis = axis_point - hit_point;
 
-  double cos_angle = cos(_angle);
-  Math::Vector3D normal = point_to_axis - cone_axis * cos_angle;
+  Math::Vector3D normal = point_to_axis - cone_axis * _cosAngle;
 
   normal = normal.normalize();
 
@@ -88,6 +80,17 @@ void Raytracer::ConeInf::rotate(const Math::Vector3D &axis, float angle) {
   _normal = newNormal.normalize();
 }
 
+/**
+ * @brief Precomputes the unit axis and the tangent and cosine of the
+ * half-angle.
+ */
+void Raytracer::ConeInf::commit() {
+  double tan = std::tan(_angle);
+  _axis = _normal.normalized();
+  _tan2 = tan * tan;
+  _cosAngle = std::cos(_angle);
+}
+
 extern "C" {
 /**
  * @brief Factory function to create a new ConeInf instance.
@@ -103,4 +106,15 @@ Raytracer::IShape *addShape() {
     return nullptr;
   }
 }
+
+/**
+ * @brief Gives the extended entry points of the ConeInf plugin, see
+ * ShapeAbi.hpp.
+ * @return const Raytracer::ShapeAbi* The entry points.
+ */
+const Raytracer::ShapeAbi *shapeAbi() {
+  static const Raytracer::ShapeAbi abi =
+      Raytracer::shapeAbiOf<Raytracer::ConeInf>();
+  return &abi;
+}
 }
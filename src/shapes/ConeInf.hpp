@@ -29,6 +29,7 @@ namespace Raytracer {
           : _normal(normal), _angle(angle) {
         _center = center;
         _color = color;
+        commit();
       }
 
       /**
@@ -39,6 +40,7 @@ namespace Raytracer {
       ConeInf() : _normal(Math::Vector3D(0, 1, 0)), _angle(1.0) {
         _center = Math::Point3D(0, 0, 0);
         _color = Math::Vector3D(1, 0, 0);
+        commit();
       }
 
       /**
@@ -84,9 +86,27 @@ namespace Raytracer {
        */
       void rotate(const Math::Vector3D &axis, float angle) override;
 
+      /**
+       * @brief Precomputes the unit axis and the tangent and cosine of the
+       * half-angle.
+       */
+      void commit() override;
+
+      /**
+       * @brief Gets the bounds of the cone, which extends to infinity along
+       * its axis.
+       * @return Math::AABB Math::AABB::infinite().
+       */
+      Math::AABB getBounds() const override {
+        return Math::AABB::infinite();
+      }
+
     private:
       Math::Vector3D _normal; ///< The normal vector defining the cone's axis.
       double _angle;          ///< The half-angle of the cone in radians.
+      Math::Vector3D _axis;   ///< Unit axis, set by commit().
+      double _tan2 = 1.0;     ///< Squared tangent of the half-angle.
+      double _cosAngle = 1.0; ///< Cosine of the half-angle.
 
   };
 
@@ -9,8 +9,8 @@
  * @param ray The ray to test for intersection.
  * @return A tuple containing:
  *         - double: The distance from the ray's origin to the closest valid
- * intersection point (t). Returns 0.0 if there is no hit or if hits are behind
- * the ray origin.
+ * intersection point (t). Returns 0.0 if there is no hit or if no hit is within
+ * [ray.tMin, ray.tMax].
  *         - Math::Vector3D: The color of the cylinder.
  *         - const Raytracer::IShape*: A pointer to this cylinder object.
  */
@@ -18,15 +18,15 @@ std::tuple<double, Math::Vector3D, const Raytracer::IShape *>
 Raytracer::Cylinder::hits(const Raytracer::Ray &ray) const {
   Math::Vector3D oc = ray.origin - _center;
 
-  double oc_dot_normal = oc.dot(_normal);
-  double dir_dot_normal = ray.direction.dot(_normal);
+  double oc_dot_normal = oc.dot(_axis);
+  double dir_dot_normal = ray.direction.dot(_axis);
 
-  Math::Vector3D dir_perp = ray.direction - (_normal * dir_dot_normal);
-  Math::Vector3D oc_perp = oc - (_normal * oc_dot_normal);
+  Math::Vector3D dir_perp = ray.direction - (_axis * dir_dot_normal);
+  Math::Vector3D oc_perp = oc - (_axis * oc_dot_normal);
 
   double a = dir_perp.dot(dir_perp);
   double b = 2.0 * dir_perp.dot(oc_perp);
-  double c = oc_perp.dot(oc_perp) - _radius * _radius;
+  double c = oc_perp.dot(oc_perp) - _radius2;
 
   double discriminant = b * b - 4 * a * c;
 
@@ -50,8 +50,11 @@ Raytracer::Cylinder::hits(const Raytracer::Ray &ray) const {
   double final_t_start = std::max(t1, t3);
   double final_t_end = std::min(t2, t4);
 
-  if (final_t_start < final_t_end && final_t_end >= 0) {
-    return {final_t_start, _color, this};
+  if (final_t_start < final_t_end) {
+    if (ray.contains(final_t_start))
+      return {final_t_start, _color, this};
+    if (ray.contains(final_t_end))
+      return {final_t_end, _color, this};
   }
 
   return {0.0, _color, this};
@@ -67,15 +70,15 @@ Math::Vector3D Raytracer::Cylinder::getNormal(
     const Math::Point3D &point) const {
   Math::Vector3D oc = point - _center;
 
-  double oc_dot_normal = oc.dot(_normal);
+  double oc_dot_normal = oc.dot(_axis);
 
   if (oc_dot_normal <= 0.0001) {
-    return -_normal;
+    return -_axis;
   } else if (oc_dot_normal >= (_height - 0.0001)) {
-    return _normal;
+    return _axis;
   }
 
-  Math::Vector3D oc_perp = (oc - (_normal * oc_dot_normal)) / _radius;
+  Math::Vector3D oc_perp = (oc - (_axis * oc_dot_normal)) / _radius;
   return oc_perp.normalize();
 }
 
@@ -96,6 +99,18 @@ void Raytracer::Cylinder::rotate(const Math::Vector3D &axis, float angle) {
   _normal = newNormal.normalize();
 }
 
+/**
+ * @brief Precomputes the unit axis, the squared radius and the bounds, which
+ * hold the caps at both ends of the axis and so the whole body.
+ */
+void Raytracer::Cylinder::commit() {
+  _axis = _normal.normalized();
+  _radius2 = _radius * _radius;
+  _bounds = Math::AABB();
+  _bounds.expandDisc(_center, _axis, _radius);
+  _bounds.expandDisc(_center + _axis * _height, _axis, _radius);
+}
+
 extern "C" {
 /**
  * @brief Factory function to create a new Cylinder instance.
@@ -114,4 +129,15 @@ Raytracer::IShape *addShape() {
     return nullptr;
   }
 }
+
+/**
+ * @brief Gives the extended entry points of the Cylinder plugin, see
+ * ShapeAbi.hpp.
+ * @return const Raytracer::ShapeAbi* The entry points.
+ */
+const Raytracer::ShapeAbi *shapeAbi() {
+  static const Raytracer::ShapeAbi abi =
+      Raytracer::shapeAbiOf<Raytracer::Cylinder>();
+  return &abi;
+}
 }
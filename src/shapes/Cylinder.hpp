@@ -30,6 +30,7 @@ namespace Raytracer {
           : _normal(normal), _radius(radius), _height(height) {
         _center = center;
         _color = color;
+        commit();
       }
 
       /**
@@ -41,6 +42,7 @@ namespace Raytracer {
           : _normal(Math::Vector3D(0, 1, 0)), _radius(1.0), _height(2.0) {
         _center = Math::Point3D(0, 0, 0);
         _color = Math::Vector3D(1, 0, 0);
+        commit();
       }
 
       /**
@@ -81,6 +83,19 @@ namespace Raytracer {
        */
       void rotate(const Math::Vector3D &axis, float angle) override;
 
+      /**
+       * @brief Precomputes the unit axis, the squared radius and the bounds.
+       */
+      void commit() override;
+
+      /**
+       * @brief Gets the bounding box of the cylinder.
+       * @return Math::AABB The box around its two caps.
+       */
+      Math::AABB getBounds() const override {
+        return _bounds;
+      }
+
       /**
        * @brief Gets the radius of the cylinder.
        * @return double The radius of the cylinder.
@@ -116,6 +131,9 @@ namespace Raytracer {
           _normal;     ///< The normal vector defining the cylinder's axis.
       double _radius;  ///< The radius of the cylinder.
       double _height;  ///< The height of the cylinder.
+      Math::Vector3D _axis;  ///< Unit axis, set by commit().
+      double _radius2 = 1.0; ///< Squared radius, set by commit().
+      Math::AABB _bounds;    ///< Bounds, set by commit().
   };
 
 }  // namespace Raytracer
@@ -8,8 +8,8 @@
  * @param ray The ray to test for intersection.
  * @return A tuple containing:
  *         - double: The distance from the ray's origin to the closest
- * intersection point (t). Returns 0.0 if there is no hit or if hits are behind
- * the ray origin.
+ * intersection point (t). Returns 0.0 if there is no hit or if no hit is within
+ * [ray.tMin, ray.tMax].
  *         - Math::Vector3D: The color of the cylinder.
  *         - const Raytracer::IShape*: A pointer to this cylinder object.
  */
@@ -17,15 +17,15 @@ std::tuple<double, Math::Vector3D, const Raytracer::IShape *>
 Raytracer::CylinderInf::hits(const Raytracer::Ray &ray) const {
   Math::Vector3D oc = ray.origin - _center;
 
-  double oc_dot_normal = oc.dot(_normal);
-  double dir_dot_normal = ray.direction.dot(_normal);
+  double oc_dot_normal = oc.dot(_axis);
+  double dir_dot_normal = ray.direction.dot(_axis);
 
-  Math::Vector3D dir_perp = ray.direction - (_normal * dir_dot_normal);
-  Math::Vector3D oc_perp = oc - (_normal * oc_dot_normal);
+  Math::Vector3D dir_perp = ray.direction - (_axis * dir_dot_normal);
+  Math::Vector3D oc_perp = oc - (_axis * oc_dot_normal);
 
   double a = dir_perp.dot(dir_perp);
   double b = 2.0 * dir_perp.dot(oc_perp);
-  double c = oc_perp.dot(oc_perp) - _radius * _radius;
+  double c = oc_perp.dot(oc_perp) - _radius2;
 
   double discriminant = b * b - 4 * a * c;
 
@@ -40,9 +40,10 @@ Raytracer::CylinderInf::hits(const Raytracer::Ray &ray) const {
     std::swap(t1, t2);
   }
 
-  if (t1 > 0) {
+  if (ray.contains(t1))
     return {t1, _color, this};
-  }
+  if (ray.contains(t2))
+    return {t2, _color, this};
 
   return {0.0, _color, this};
 }
@@ -58,12 +59,12 @@ Math::Vector3D Raytracer::CylinderInf::getNormal(
     const Math::Point3D &point) const {
   Math::Vector3D oc = point - _center;
 
-  double oc_dot_normal = oc.dot(_normal);
+  double oc_dot_normal = oc.dot(_axis);
 
   if (oc_dot_normal <= 0.0001)
-    return -_normal;
+    return -_axis;
 
-  Math::Vector3D oc_perp = (oc - (_normal * oc_dot_normal)) / _radius;
+  Math::Vector3D oc_perp = (oc - (_axis * oc_dot_normal)) / _radius;
   return oc_perp.normalize();
 }
 
@@ -84,6 +85,14 @@ void Raytracer::CylinderInf::rotate(const Math::Vector3D &axis, float angle) {
   _normal = newNormal.normalize();
 }
 
+/**
+ * @brief Precomputes the unit axis and the squared radius.
+ */
+void Raytracer::CylinderInf::commit() {
+  _axis = _normal.normalized();
+  _radius2 = _radius * _radius;
+}
+
 extern "C" {
 /**
  * @brief Factory function to create a new CylinderInf instance.
@@ -102,4 +111,15 @@ Raytracer::IShape *addShape() {
     return nullptr;
   }
 }
+
+/**
+ * @brief Gives the extended entry points of the CylinderInf plugin, see
+ * ShapeAbi.hpp.
+ * @return const Raytracer::ShapeAbi* The entry points.
+ */
+const Raytracer::ShapeAbi *shapeAbi() {
+  static const Raytracer::ShapeAbi abi =
+      Raytracer::shapeAbiOf<Raytracer::CylinderInf>();
+  return &abi;
+}
 }
@@ -30,6 +30,7 @@ namespace Raytracer {
           : _normal(normal), _radius(radius) {
         _center = center;
         _color = color;
+        commit();
       }
 
       /**
@@ -40,6 +41,7 @@ namespace Raytracer {
       CylinderInf() : _normal(Math::Vector3D(0, 1, 0)), _radius(1.0) {
         _center = Math::Point3D(0, 0, 0);
         _color = Math::Vector3D(1, 0, 0);
+        commit();
       }
 
       /**
@@ -82,6 +84,20 @@ namespace Raytracer {
        */
       void rotate(const Math::Vector3D &axis, float angle) override;
 
+      /**
+       * @brief Precomputes the unit axis and the squared radius.
+       */
+      void commit() override;
+
+      /**
+       * @brief Gets the bounds of the cylinder, which extends to infinity
+       * along its axis.
+       * @return Math::AABB Math::AABB::infinite().
+       */
+      Math::AABB getBounds() const override {
+        return Math::AABB::infinite();
+      }
+
       /**
        * @brief Gets the radius of the infinite cylinder.
        * @return double The radius of the cylinder.
@@ -102,6 +118,8 @@ namespace Raytracer {
       Math::Vector3D
           _normal;     ///< The normal vector defining the cylinder's axis.
       double _radius;  ///< The radius of the cylinder.
+      Math::Vector3D _axis;  ///< Unit axis, set by commit().
+      double _radius2 = 1.0; ///< Squared radius, set by commit().
   };
 
 }  // namespace Raytracer
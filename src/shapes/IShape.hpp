@@ -12,6 +12,11 @@ namespace Raytracer {
    * Defines the common contract for shapes, including methods for
    * ray intersection testing, normal calculation, transformations,
    * and accessing properties like center, color, and material.
+   *
+   * Plugins built against earlier versions of the raytracer call the host
+   * through this vtable, so it is frozen: entry points added since are
+   * virtual functions of AShape, reached by the host through the optional
+   * tables of ShapeAbi.hpp.
    */
   class IShape {
     public:
@@ -22,7 +27,9 @@ namespace Raytracer {
 
       /**
        * @brief Calculates the intersection of a ray with the shape.
-       * @param ray The ray to test for intersection.
+       * @param ray The ray to test for intersection. Only the closest hit
+       * within its (tMin, tMax) interval counts; candidates outside of it
+       * should be rejected before any further work.
        * @return A tuple containing:
        *         - double: The distance from the ray's origin to the
        * intersection point (t).
@@ -0,0 +1,120 @@
+#include "Instance.hpp"
+#include <iostream>
+#include "IShape.hpp"
+#include "Vector3D.hpp"
+
+/**
+ * @brief Intersects the prototype with the ray expressed in object space.
+ *
+ * Both the origin and the direction go through the world-to-object
+ * transform. The direction is kept unnormalized so that the distance found
+ * by the prototype is the same parameter t along the world ray. The other
+ * fields of the ray (kind, statistics) are carried over unchanged.
+ * @param ray The world-space ray.
+ * @return A tuple containing:
+ *         - double: The distance along the world ray, 0.0 if there is no hit.
+ *         - Math::Vector3D: The color reported by the prototype.
+ *         - const Raytracer::IShape*: A pointer to this instance.
+ */
+std::tuple<double, Math::Vector3D, const Raytracer::IShape *>
+Raytracer::Instance::hits(const Raytracer::Ray &ray) const {
+  if (!_prototype)
+    return {0.0, Math::Vector3D(0, 0, 0), this};
+  Raytracer::Ray local = ray;
+  local.origin = _toObject.applyToPoint(ray.origin);
+  local.direction = _toObject.applyToVector(ray.direction);
+  auto [t, color, shape] = _prototype->hits(local);
+
+  if (t <= 0.0 || !shape)
+    return {0.0, Math::Vector3D(0, 0, 0), this};
+  return {t, color, this};
+}
+
+/**
+ * @brief Intersects the prototype with the rays of a packet expressed in
+ * object space.
+ *
+ * The rays are moved like in hits() into a packet of their own, which the
+ * prototype traces as a whole, so meshes keep walking their BVH once per
+ * packet. Their intervals, and so the hits, are the same along both rays.
+ * @param packet The world-space rays, updated with their closest hits.
+ * @param mask The rays to test.
+ */
+void Raytracer::Instance::hitsPacket(RayPacket &packet,
+                                     std::uint32_t mask) const {
+  if (!_prototype)
+    return;
+  RayPacket local;
+  local.kind = packet.kind;
+#ifdef RAYTRACER_STATS
+  local.stats = packet.stats;
+#endif
+  for (std::uint32_t rays = mask; rays; rays &= rays - 1) {
+    int i = __builtin_ctz(rays);
+    Math::Point3D origin(packet.originX[i], packet.originY[i],
+                         packet.originZ[i]);
+    Math::Vector3D direction(packet.dirX[i], packet.dirY[i], packet.dirZ[i]);
+    local.set(i, _toObject.applyToPoint(origin),
+              _toObject.applyToVector(direction), packet.tMin[i],
+              packet.tMax[i]);
+  }
+  shapeHitsPacket(_prototypeAbi, *_prototype, local, mask);
+
+  for (; mask; mask &= mask - 1) {
+    int i = __builtin_ctz(mask);
+    if (!local.shape[i])
+      continue;
+    packet.tMax[i] = local.tMax[i];
+    packet.color[i] = local.color[i];
+    packet.shape[i] = this;
+  }
+}
+
+/**
+ * @brief Gets the normal at a world-space point.
+ *
+ * The point is moved into object space, the prototype computes its normal,
+ * and the normal is brought back with the inverse transpose of the
+ * object-to-world matrix so that non-uniform scales stay correct.
+ * @param hitPoint The point on the instance surface.
+ * @return Math::Vector3D The normalized world-space normal.
+ */
+Math::Vector3D Raytracer::Instance::getNormal(
+    const Math::Point3D &hitPoint) const {
+  if (!_prototype)
+    return Math::Vector3D(0, 0, 0);
+  Math::Vector3D normal =
+      _prototype->getNormal(_toObject.applyToPoint(hitPoint));
+  return _toObject.applyToNormal(normal).normalized();
+}
+
+extern "C" {
+/**
+ * @brief Factory function to create a new Instance.
+ *
+ * This function is typically used by a plugin system to instantiate shape
+ * objects.
+ * @return Raytracer::IShape* A pointer to the newly created Instance, or
+ * nullptr on failure.
+ */
+Raytracer::IShape *addShape() {
+  try {
+    return new Raytracer::Instance();
+  } catch (const std::exception &e) {
+    std::cerr << "[ERROR] - Failed to create instance: " << e.what()
+              << std::endl;
+    return nullptr;
+  }
+}
+
+/**
+ * @brief Gives the extended entry points of the Instance plugin, see
+ * ShapeAbi.hpp.
+ * @return const Raytracer::ShapeAbi* The entry points.
+ */
+const Raytracer::ShapeAbi *shapeAbi() {
+  static const Raytracer::ShapeAbi abi =
+      Raytracer::shapeAbiOf<Raytracer::Instance>();
+  return &abi;
+}
+}
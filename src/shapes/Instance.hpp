@@ -0,0 +1,183 @@
+#pragma once
+
+#include <memory>
+#include <tuple>
+#include "AShape.hpp"
+#include "Point3D.hpp"
+#include "Ray.hpp"
+#include "Transform.hpp"
+#include "Vector3D.hpp"
+
+namespace Raytracer {
+
+  /**
+   * @brief Places a shared shape in the scene with its own transform.
+   *
+   * An instance does not own any geometry: it references a prototype (usually
+   * a mesh loaded once through the MeshCache) and stores only the
+   * object-to-world transform and its inverse. Rays are moved into the
+   * prototype's space to be intersected, so the prototype's BVH is reused by
+   * every instance.
+   *
+   * The transform is always composed as translate * rotate * scale, whatever
+   * the order in which the operations are applied.
+   */
+  class Instance : public AShape {
+    public:
+      /**
+       * @brief Default constructor. Creates an instance with no prototype and
+       * an identity transform.
+       */
+      Instance() : _scale(1, 1, 1) {
+      }
+
+      /**
+       * @brief Default destructor.
+       */
+      ~Instance() = default;
+
+      /**
+       * @brief Intersects the prototype with the ray moved into object space.
+       * The direction is not normalized, so the returned distance is valid
+       * along the original world ray.
+       * @param ray The world-space ray.
+       * @return A tuple containing the distance, the color reported by the
+       * prototype and a pointer to this instance, or t = 0 on a miss.
+       */
+      std::tuple<double, Math::Vector3D, const IShape *> hits(
+          const Raytracer::Ray &ray) const override;
+
+      /**
+       * @brief Intersects the rays of a packet with the prototype, moved
+       * into object space together.
+       * @param packet The world-space rays, updated with their closest hits.
+       * @param mask The rays to test.
+       */
+      void hitsPacket(RayPacket &packet, std::uint32_t mask) const override;
+
+      /**
+       * @brief Gets the world-space normal at a world-space point.
+       * @param hitPoint The point on the instance surface.
+       * @return Math::Vector3D The normalized normal of the prototype moved to
+       * world space.
+       */
+      Math::Vector3D getNormal(const Math::Point3D &hitPoint) const override;
+
+      /**
+       * @brief Precomputes the world-space bounds. The transforms themselves
+       * are kept up to date by every setter.
+       */
+      void commit() override {
+        _bounds = Math::AABB();
+        if (!_prototype)
+          return;
+        _bounds = shapeBounds(_prototypeAbi, *_prototype);
+        if (!_bounds.isInfinite())
+          _bounds = _toWorld.applyToBounds(_bounds);
+      }
+
+      /**
+       * @brief Gets the world-space bounds of the transformed prototype.
+       * @return Math::AABB The bounding box, infinite if the prototype is
+       * unbounded, empty if there is no prototype.
+       */
+      Math::AABB getBounds() const override {
+        return _bounds;
+      }
+
+      /**
+       * @brief Translates the instance.
+       * @param offset The translation vector.
+       */
+      void translate(const Math::Vector3D &offset) override {
+        _center = _center + offset;
+        updateTransform();
+      }
+
+      /**
+       * @brief Rotates the instance around its origin.
+       * @param axis The rotation axis.
+       * @param angle The rotation angle in degrees.
+       */
+      void rotate(const Math::Vector3D &axis, float angle) override {
+        _rotation = Math::Transform::rotation(axis, angle) * _rotation;
+        updateTransform();
+      }
+
+      /**
+       * @brief Moves the instance origin.
+       * @param center The new position of the prototype's origin.
+       */
+      void setCenter(const Math::Point3D &center) override {
+        _center = center;
+        updateTransform();
+      }
+
+      /**
+       * @brief Sets the scale factor along each axis.
+       * @param scale The scale factors, all non-zero.
+       * @throw std::runtime_error if a factor is zero.
+       */
+      void setScale(const Math::Vector3D &scale) {
+        _scale = scale;
+        updateTransform();
+      }
+
+      /**
+       * @brief Sets the shared shape placed by this instance.
+       * @param prototype The shape to reference.
+       * @param abi The extended entry points of the plugin of the shape, as
+       * given by Factory::getShapeAbi(); without them the shape is unbounded
+       * and traced one ray at a time.
+       */
+      void setPrototype(std::shared_ptr<const IShape> prototype,
+                        const ShapeAbi *abi = nullptr) {
+        _prototype = std::move(prototype);
+        _prototypeAbi = abi;
+      }
+
+      /**
+       * @brief Gets the shared shape placed by this instance.
+       * @return const std::shared_ptr<const IShape>& The prototype.
+       */
+      const std::shared_ptr<const IShape> &getPrototype() const {
+        return _prototype;
+      }
+
+      /**
+       * @brief Gets the scale factors.
+       * @return const Math::Vector3D& The scale along each axis.
+       */
+      const Math::Vector3D &getScale() const {
+        return _scale;
+      }
+
+      /**
+       * @brief Gets the object-to-world transform.
+       * @return const Math::Transform& The transform.
+       */
+      const Math::Transform &getTransform() const {
+        return _toWorld;
+      }
+
+    private:
+      std::shared_ptr<const IShape> _prototype; ///< Shared geometry.
+      const ShapeAbi *_prototypeAbi = nullptr;  ///< Entry points of its plugin.
+      Math::Transform _rotation;  ///< Accumulated rotation.
+      Math::Vector3D _scale;      ///< Scale along each axis.
+      Math::Transform _toWorld;   ///< Object-to-world transform.
+      Math::Transform _toObject;  ///< World-to-object transform.
+      Math::AABB _bounds;         ///< World-space bounds, set by commit().
+
+      /**
+       * @brief Recomputes both matrices from translation, rotation and scale.
+       */
+      void updateTransform() {
+        _toWorld = Math::Transform::translation(
+                       Math::Vector3D(_center.x, _center.y, _center.z)) *
+                   _rotation * Math::Transform::scaling(_scale);
+        _toObject = _toWorld.inverse();
+      }
+  };
+
+}  // namespace Raytracer
@@ -1,5 +1,8 @@
 #include <tuple>
 #include <vector>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 #include "Point3D.hpp"
 #include "Ray.hpp"
 #include "Vector3D.hpp"
@@ -9,8 +12,9 @@
 /**
  * @brief Calculates the intersection of a ray with the object's faces (triangles).
  *
- * Iterates through each face of the object, performing a ray-triangle intersection test
- * (Möller–Trumbore algorithm) for each. It returns the closest valid intersection.
+ * Walks the face BVH and runs a ray-triangle intersection test
+ * (Möller–Trumbore algorithm) only on the faces of the leaves the ray reaches.
+ * It returns the closest valid intersection.
  *
  * @param ray The ray to test for intersection.
  * @return A tuple containing:
@@ -24,54 +28,166 @@
 std::tuple<double, Math::Vector3D, const Raytracer::IShape *> Raytracer::Object::hits(
     const Raytracer::Ray &ray) const {
     double eps = 0.0001;
+    const Face *closest_face = nullptr;
     double closest_t = 0.0;
-    Math::Vector3D closest_color = {0.0, 0.0, 0.0};
-    bool hit = false;
+#ifdef RAYTRACER_STATS
+    std::uint64_t tested = 0;
+#endif
 
-    for (const auto &face : _faces) {
-      Math::Point3D v0 = _vertices[face.vertex[0]];
-      Math::Point3D v1 = _vertices[face.vertex[1]];
-      Math::Point3D v2 = _vertices[face.vertex[2]];
-
-      Math::Vector3D edge1 = v1 - v0;
-      Math::Vector3D edge2 = v2 - v0;
+    _bvh.traverse(ray, [&](std::uint32_t index, double &tMax) {
+#ifdef RAYTRACER_STATS
+      tested++;
+#endif
+      const FaceEdges &edges = _edges[index];
+      const Math::Point3D &v0 = edges.v0;
+      const Math::Vector3D &edge1 = edges.edge1;
+      const Math::Vector3D &edge2 = edges.edge2;
       Math::Vector3D h = Math::cross(ray.direction, edge2);
       double a = edge1.dot(h);
 
       if (a > -eps && a < eps)
-        continue;
+        return;
 
       double f = 1.0 / a;
       Math::Vector3D s = ray.origin - v0;
       double u = f * s.dot(h);
 
       if (u < 0.0 || u > 1.0)
-        continue;
+        return;
 
       Math::Vector3D q = Math::cross(s, edge1);
       double v = f * ray.direction.dot(q);
 
       if (v < 0.0 || u + v > 1.0)
-        continue;
+        return;
 
       double t = f * edge2.dot(q);
 
-      if (t > eps && (t < closest_t || closest_t == 0.0)) {
+      if (t > ray.tMin && t < tMax) {
+        tMax = t;
         closest_t = t;
-        hit = true;
-
-        if (_materials.find(face.material_name) != _materials.end()) {
-          const Mtl &material = _materials.at(face.material_name);
-          closest_color = material.diffuse;
-        } else {
-          closest_color = {1.0, 1.0, 1.0};
-        }
+        closest_face = &_faces[index];
       }
-    }
-    if (hit)
-      return {closest_t, closest_color, this};
-    else
+    });
+#ifdef RAYTRACER_STATS
+    if (ray.stats)
+      ray.stats->add(RayStats::TriangleTests, tested);
+#endif
+    if (!closest_face)
       return {0.0, Math::Vector3D(0.0, 0.0, 0.0), this};
+
+    if (closest_face->material >= 0)
+      return {closest_t, _materials[closest_face->material].diffuse, this};
+    return {closest_t, Math::Vector3D(1.0, 1.0, 1.0), this};
+}
+
+/**
+ * @brief Intersects the rays of a packet with the object's faces.
+ *
+ * The face BVH is walked once for the whole packet. Each face reached is
+ * tested against the rays that reached it four at a time, with the same
+ * Möller–Trumbore test as hits() written with SSE in single precision; the
+ * colour of the closest face of each ray is looked up at the end. Without
+ * SSE, the rays are traced one at a time.
+ * @param packet The rays, updated with their closest hits.
+ * @param mask The rays to test.
+ */
+void Raytracer::Object::hitsPacket(RayPacket &packet,
+                                   std::uint32_t mask) const {
+#if defined(__SSE2__)
+  std::uint32_t closest_face[RayPacket::size];
+  std::uint32_t hit = 0;
+  const __m128 eps = _mm_set1_ps(0.0001f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+#ifdef RAYTRACER_STATS
+  std::uint64_t tested = 0;
+#endif
+
+  _bvh.traversePacket(packet, mask, [&](std::uint32_t index,
+                                        std::uint32_t rays) {
+#ifdef RAYTRACER_STATS
+    tested += __builtin_popcount(rays);
+#endif
+    const FaceEdges &edges = _edges[index];
+    __m128 v0x = _mm_set1_ps(edges.v0.x);
+    __m128 v0y = _mm_set1_ps(edges.v0.y);
+    __m128 v0z = _mm_set1_ps(edges.v0.z);
+    __m128 e1x = _mm_set1_ps(edges.edge1.x);
+    __m128 e1y = _mm_set1_ps(edges.edge1.y);
+    __m128 e1z = _mm_set1_ps(edges.edge1.z);
+    __m128 e2x = _mm_set1_ps(edges.edge2.x);
+    __m128 e2y = _mm_set1_ps(edges.edge2.y);
+    __m128 e2z = _mm_set1_ps(edges.edge2.z);
+
+    for (int group = 0; group < RayPacket::size; group += 4) {
+      int lanes = (rays >> group) & 0xF;
+      if (!lanes)
+        continue;
+      __m128 dx = _mm_load_ps(packet.dirX + group);
+      __m128 dy = _mm_load_ps(packet.dirY + group);
+      __m128 dz = _mm_load_ps(packet.dirZ + group);
+      __m128 hx = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+      __m128 hy = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+      __m128 hz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+      __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, hx), _mm_mul_ps(e1y, hy)),
+                            _mm_mul_ps(e1z, hz));
+      __m128 f = _mm_div_ps(one, a);
+
+      __m128 sx = _mm_sub_ps(_mm_load_ps(packet.originX + group), v0x);
+      __m128 sy = _mm_sub_ps(_mm_load_ps(packet.originY + group), v0y);
+      __m128 sz = _mm_sub_ps(_mm_load_ps(packet.originZ + group), v0z);
+      __m128 u = _mm_mul_ps(
+          f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, hx), _mm_mul_ps(sy, hy)),
+                        _mm_mul_ps(sz, hz)));
+
+      __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+      __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+      __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+      __m128 v = _mm_mul_ps(
+          f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)),
+                        _mm_mul_ps(dz, qz)));
+      __m128 t = _mm_mul_ps(
+          f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)),
+                        _mm_mul_ps(e2z, qz)));
+
+      __m128 valid = _mm_or_ps(_mm_cmpge_ps(a, eps),
+                               _mm_cmple_ps(a, _mm_sub_ps(zero, eps)));
+      valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(u, zero),
+                                           _mm_cmple_ps(u, one)));
+      valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(v, zero),
+                                           _mm_cmple_ps(_mm_add_ps(u, v), one)));
+      valid = _mm_and_ps(
+          valid, _mm_and_ps(_mm_cmpgt_ps(t, _mm_load_ps(packet.tMin + group)),
+                            _mm_cmplt_ps(t, _mm_load_ps(packet.tMax + group))));
+      int found = _mm_movemask_ps(valid) & lanes;
+      if (!found)
+        continue;
+      alignas(16) float distance[4];
+      _mm_store_ps(distance, t);
+      for (; found; found &= found - 1) {
+        int lane = __builtin_ctz(found);
+        packet.tMax[group + lane] = distance[lane];
+        closest_face[group + lane] = index;
+        hit |= 1u << (group + lane);
+      }
+    }
+  });
+#ifdef RAYTRACER_STATS
+  if (packet.stats)
+    packet.stats->add(RayStats::TriangleTests, tested);
+#endif
+
+  for (; hit; hit &= hit - 1) {
+    int i = __builtin_ctz(hit);
+    const Face &face = _faces[closest_face[i]];
+    packet.color[i] = face.material >= 0 ? _materials[face.material].diffuse
+                                         : Math::Vector3D(1.0, 1.0, 1.0);
+    packet.shape[i] = this;
+  }
+#else
+  AShape::hitsPacket(packet, mask);
+#endif
 }
 
 extern "C" {
@@ -90,4 +206,15 @@ Raytracer::IShape *addShape() {
     return nullptr;
   }
 }
+
+/**
+ * @brief Gives the extended entry points of the Object plugin, see
+ * ShapeAbi.hpp.
+ * @return const Raytracer::ShapeAbi* The entry points.
+ */
+const Raytracer::ShapeAbi *shapeAbi() {
+  static const Raytracer::ShapeAbi abi =
+      Raytracer::shapeAbiOf<Raytracer::Object>();
+  return &abi;
+}
 }
@@ -1,12 +1,15 @@
 #pragma once
 
+#include <array>
+#include <string>
 #include <tuple>
-#include <unordered_map>
 #include <vector>
 #include "AShape.hpp"
 #include "Point3D.hpp"
 #include "Ray.hpp"
+#include "SharedArray.hpp"
 #include "Vector3D.hpp"
+#include "accel/BVH.hpp"
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
@@ -20,6 +23,8 @@ namespace Raytracer {
    * This class inherits from AShape and stores geometry (vertices, faces, normals)
    * and material information loaded from an OBJ file and its associated MTL file.
    * It provides methods for ray intersection testing and retrieving object data.
+   * The geometry buffers are SharedArrays, so that a mesh read out of the
+   * scene cache is traced straight from the mapped file.
    */
   class Object : public AShape {
     public:
@@ -28,6 +33,7 @@ namespace Raytracer {
        * @brief Structure to hold material properties.
        */
       struct Mtl {
+        std::string name;           ///< Name of the material in the MTL file.
         Math::Vector3D ambient;     ///< Ambient color component.
         Math::Vector3D diffuse;     ///< Diffuse color component.
         Math::Vector3D specular;    ///< Specular color component.
@@ -38,11 +44,21 @@ namespace Raytracer {
 
       /**
        * @brief Structure to represent a face (triangle) of the object.
+       * Faces are stored flat, without any per-face allocation.
        */
       struct Face {
-        std::vector<int> vertex;      ///< Indices of the vertices forming the face.
-        std::vector<int> normal;      ///< Indices of the normals for each vertex.
-        std::string material_name;  ///< Name of the material applied to this face.
+        std::array<int, 3> vertex;  ///< Indices of the vertices forming the face.
+        std::array<int, 3> normal;  ///< Indices of the normals for each vertex, -1 if absent.
+        int material = -1;          ///< Index of the material in getMaterials(), -1 if none.
+      };
+
+      /**
+       * @brief A face as the intersection test reads it, set by commit().
+       */
+      struct FaceEdges {
+        Math::Point3D v0;     ///< First vertex.
+        Math::Vector3D edge1; ///< Second vertex - first vertex.
+        Math::Vector3D edge2; ///< Third vertex - first vertex.
       };
 
       /**
@@ -65,6 +81,14 @@ namespace Raytracer {
       std::tuple<double, Math::Vector3D, const Raytracer::IShape *> hits(
           const Raytracer::Ray &ray) const override;
 
+      /**
+       * @brief Intersects the rays of a packet with the faces, walking the
+       * BVH once for the whole packet and testing four rays per face at once.
+       * @param packet The rays, updated with their closest hits.
+       * @param mask The rays to test.
+       */
+      void hitsPacket(RayPacket &packet, std::uint32_t mask) const override;
+
       /**
        * @brief Sets the path to the OBJ file.
        * @param obj_file The OBJ file path.
@@ -72,31 +96,32 @@ namespace Raytracer {
       void setObjFile(const std::string &obj_file) {_obj_file = obj_file;}
       /**
        * @brief Sets the materials for the object.
-       * @param materials An unordered_map of material names to Mtl structs.
+       * Buffers are taken by value so that loaders can move them in.
+       * @param materials A vector of Mtl structs, indexed by Face::material.
        */
-      void setMaterials(const std::unordered_map<std::string, Mtl> &materials) {
-          _materials = materials;
+      void setMaterials(std::vector<Mtl> materials) {
+          _materials = std::move(materials);
       }
       /**
        * @brief Sets the vertices of the object.
-       * @param vertices A vector of Point3D representing the vertices.
+       * @param vertices The vertices, a moved vector or a view of a cache.
        */
-      void setVertices(const std::vector<Math::Point3D> &vertices) {
-          _vertices = vertices;
+      void setVertices(SharedArray<Math::Point3D> vertices) {
+          _vertices = std::move(vertices);
       }
       /**
        * @brief Sets the normals of the object.
-       * @param normals A vector of Vector3D representing the normals.
+       * @param normals The normals, a moved vector or a view of a cache.
        */
-      void setNormals(const std::vector<Math::Vector3D> &normals) {
-          _normals = normals;
+      void setNormals(SharedArray<Math::Vector3D> normals) {
+          _normals = std::move(normals);
       }
       /**
        * @brief Sets the faces of the object.
-       * @param faces A vector of Face structs representing the faces.
+       * @param faces The faces, a moved vector or a view of a cache.
        */
-      void setFaces(const std::vector<Face> &faces) {
-          _faces = faces;
+      void setFaces(SharedArray<Face> faces) {
+          _faces = std::move(faces);
       }
 
       /**
@@ -107,24 +132,108 @@ namespace Raytracer {
 
       /**
        * @brief Gets the vertices of the object.
-       * @return const std::vector<Math::Point3D>& A const reference to the vector of vertices.
+       * @return const SharedArray<Math::Point3D>& A const reference to the vertices.
        */
-      const std::vector<Math::Point3D>& getVertices() const { return _vertices; }
+      const SharedArray<Math::Point3D>& getVertices() const { return _vertices; }
       /**
        * @brief Gets the normals of the object.
-       * @return const std::vector<Math::Vector3D>& A const reference to the vector of normals.
+       * @return const SharedArray<Math::Vector3D>& A const reference to the normals.
        */
-      const std::vector<Math::Vector3D>& getNormals() const { return _normals; }
+      const SharedArray<Math::Vector3D>& getNormals() const { return _normals; }
       /**
        * @brief Gets the faces of the object.
-       * @return const std::vector<Face>& A const reference to the vector of faces.
+       * @return const SharedArray<Face>& A const reference to the faces.
+       */
+      const SharedArray<Face>& getFaces() const { return _faces; }
+      /**
+       * @brief Gets the edges of every face, as of the last commit().
+       * @return const SharedArray<FaceEdges>& The edges, indexed like the faces.
        */
-      const std::vector<Face>& getFaces() const { return _faces; }
+      const SharedArray<FaceEdges>& getEdges() const { return _edges; }
       /**
        * @brief Gets the materials of the object.
-       * @return const std::unordered_map<std::string, Mtl>& A const reference to the map of materials.
+       * @return const std::vector<Mtl>& A const reference to the materials, indexed by Face::material.
+       */
+      const std::vector<Mtl>& getMaterials() const { return _materials; }
+
+      /**
+       * @brief Finds a material by name.
+       * @param name The material name.
+       * @return int The index of the material, or -1 if there is none with this name.
+       */
+      int findMaterial(const std::string &name) const {
+          for (std::size_t i = 0; i < _materials.size(); i++) {
+              if (_materials[i].name == name)
+                  return static_cast<int>(i);
+          }
+          return -1;
+      }
+
+      /**
+       * @brief Builds the BVH over the faces of the object, then commits it.
+       * Must be called once the vertices and faces are set, before tracing.
+       * Kept inline so the core can call it on objects created by the plugin.
+       * @param quality The build preset.
+       * @param parallelFor Runs the build tasks, serially if empty.
+       */
+      void buildAccel(BVH::Quality quality = BVH::QualitySah,
+                      const BVH::ParallelFor &parallelFor = nullptr) {
+        std::vector<Math::AABB> faceBounds(_faces.size());
+        for (std::size_t i = 0; i < _faces.size(); i++) {
+          for (int index : _faces[i].vertex)
+            faceBounds[i].expand(_vertices[index]);
+        }
+        _bvh.build(faceBounds, quality, parallelFor);
+        commit();
+      }
+
+      /**
+       * @brief Precomputes the first vertex and the two edges of every face,
+       * so that the intersection test does not gather and subtract vertices
+       * for each ray.
+       */
+      void commit() override {
+        std::vector<FaceEdges> edges(_faces.size());
+        for (std::size_t i = 0; i < _faces.size(); i++) {
+          const Math::Point3D &v0 = _vertices[_faces[i].vertex[0]];
+          edges[i] = {v0, _vertices[_faces[i].vertex[1]] - v0,
+                      _vertices[_faces[i].vertex[2]] - v0};
+        }
+        _edges = std::move(edges);
+      }
+
+      /**
+       * @brief Gets the BVH built over the faces of the object.
+       * @return const BVH& A const reference to the hierarchy.
+       */
+      const BVH &getAccel() const { return _bvh; }
+
+      /**
+       * @brief Sets a face BVH built earlier instead of calling buildAccel(),
+       * then commits the object.
+       * @param bvh A hierarchy built over the current faces.
+       */
+      void setAccel(BVH bvh) {
+        _bvh = std::move(bvh);
+        commit();
+      }
+
+      /**
+       * @brief Sets a face BVH and the face edges committed with it, both
+       * saved earlier, so that the object is ready without committing again.
+       * @param bvh A hierarchy built over the current faces.
+       * @param edges The edges getEdges() gave for the current faces.
+       */
+      void setAccel(BVH bvh, SharedArray<FaceEdges> edges) {
+        _bvh = std::move(bvh);
+        _edges = std::move(edges);
+      }
+
+      /**
+       * @brief Gets the bounding box of the object, in object space.
+       * @return Math::AABB The root bounds of the face BVH.
        */
-      const std::unordered_map<std::string, Mtl>& getMaterials() const { return _materials; }
+      Math::AABB getBounds() const override { return _bvh.getBounds(); }
 
       /**
        * @brief Gets the normal vector at a given point on the object's surface.
@@ -139,10 +248,12 @@ namespace Raytracer {
 
     private:
       std::string _obj_file; ///< Path to the OBJ file.
-      std::vector<Math::Point3D> _vertices; ///< Vector of vertices.
-      std::vector<Math::Vector3D> _normals; ///< Vector of normals.
-      std::vector<Face> _faces; ///< Vector of faces.
-      std::unordered_map<std::string, Mtl> _materials; ///< Map of materials.
+      SharedArray<Math::Point3D> _vertices; ///< Vertices.
+      SharedArray<Math::Vector3D> _normals; ///< Normals.
+      SharedArray<Face> _faces; ///< Faces.
+      std::vector<Mtl> _materials; ///< Materials, indexed by Face::material.
+      BVH _bvh; ///< Hierarchy over the faces, built by buildAccel().
+      SharedArray<FaceEdges> _edges; ///< Edges of each face, set by commit().
   };
 
 }  // namespace Raytracer
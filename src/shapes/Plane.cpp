@@ -1,27 +1,81 @@
 #include "Plane.hpp"
 #include <iostream>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 /**
  * @brief Calculates the intersection of a ray with the plane.
  * @param ray The ray to test for intersection.
  * @return A tuple containing:
  *         - double: The distance from the ray's origin to the intersection point (t).
- *                   Returns 0.0 if the ray is parallel to the plane or if the hit is behind the ray origin.
+ *                   Returns 0.0 if the ray is parallel to the plane or if the hit is outside [ray.tMin, ray.tMax].
  *         - Math::Vector3D: The color of the plane.
  *         - const Raytracer::IShape*: A pointer to this plane object, or nullptr if no valid intersection.
  */
 std::tuple<double, Math::Vector3D, const Raytracer::IShape *>
 Raytracer::Plane::hits(const Raytracer::Ray &ray) const {
-  float denominator = _normal.dot(ray.direction);
+  float denominator = _unitNormal.dot(ray.direction);
 
   if (std::abs(denominator) > 1e-6) {
-    Math::Vector3D vectorToPlane = _center - ray.origin;
-    float t = vectorToPlane.dot(_normal) / denominator;
-    return {t, _color, this};
+    Math::Vector3D origin(ray.origin.x, ray.origin.y, ray.origin.z);
+    float t = (_offset - _unitNormal.dot(origin)) / denominator;
+    if (ray.contains(t))
+      return {t, _color, this};
   }
   return {0.0, _color, nullptr};
 }
 
+/**
+ * @brief Intersects the rays of a packet with the plane, four at a time with
+ * SSE, or one at a time without it.
+ * @param packet The rays, updated with their closest hits.
+ * @param mask The rays to test.
+ */
+void Raytracer::Plane::hitsPacket(RayPacket &packet,
+                                  std::uint32_t mask) const {
+#if defined(__SSE2__)
+  const __m128 nx = _mm_set1_ps(_unitNormal.x);
+  const __m128 ny = _mm_set1_ps(_unitNormal.y);
+  const __m128 nz = _mm_set1_ps(_unitNormal.z);
+  const __m128 offset = _mm_set1_ps(static_cast<float>(_offset));
+  const __m128 parallel = _mm_set1_ps(1e-6f);
+  const __m128 sign = _mm_set1_ps(-0.0f);
+
+  for (int group = 0; group < RayPacket::size; group += 4) {
+    int lanes = (mask >> group) & 0xF;
+    if (!lanes)
+      continue;
+    __m128 denominator = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(nx, _mm_load_ps(packet.dirX + group)),
+                   _mm_mul_ps(ny, _mm_load_ps(packet.dirY + group))),
+        _mm_mul_ps(nz, _mm_load_ps(packet.dirZ + group)));
+    __m128 along = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(nx, _mm_load_ps(packet.originX + group)),
+                   _mm_mul_ps(ny, _mm_load_ps(packet.originY + group))),
+        _mm_mul_ps(nz, _mm_load_ps(packet.originZ + group)));
+    __m128 t = _mm_div_ps(_mm_sub_ps(offset, along), denominator);
+    __m128 valid = _mm_cmpgt_ps(_mm_andnot_ps(sign, denominator), parallel);
+    valid = _mm_and_ps(
+        valid, _mm_and_ps(_mm_cmpgt_ps(t, _mm_load_ps(packet.tMin + group)),
+                          _mm_cmplt_ps(t, _mm_load_ps(packet.tMax + group))));
+    int found = _mm_movemask_ps(valid) & lanes;
+    if (!found)
+      continue;
+    alignas(16) float distance[4];
+    _mm_store_ps(distance, t);
+    for (; found; found &= found - 1) {
+      int i = group + __builtin_ctz(found);
+      packet.tMax[i] = distance[i - group];
+      packet.color[i] = _color;
+      packet.shape[i] = this;
+    }
+  }
+#else
+  AShape::hitsPacket(packet, mask);
+#endif
+}
+
 extern "C" {
 /**
  * @brief Factory function to create a new Plane instance.
@@ -38,4 +92,15 @@ Raytracer::IShape *addShape() {
     return nullptr;
   }
 }
+
+/**
+ * @brief Gives the extended entry points of the Plane plugin, see
+ * ShapeAbi.hpp.
+ * @return const Raytracer::ShapeAbi* The entry points.
+ */
+const Raytracer::ShapeAbi *shapeAbi() {
+  static const Raytracer::ShapeAbi abi =
+      Raytracer::shapeAbiOf<Raytracer::Plane>();
+  return &abi;
+}
 }
@@ -23,6 +23,7 @@ namespace Raytracer {
       Plane() : _normal(Math::Vector3D()) {
         _center = Math::Point3D();
         _color = Math::Vector3D(1, 0, 0);
+        commit();
       }
 
       /**
@@ -38,6 +39,13 @@ namespace Raytracer {
       std::tuple<double, Math::Vector3D, const IShape *> hits(
           const Ray &ray) const override;
 
+      /**
+       * @brief Intersects the rays of a packet with the plane, four at a time.
+       * @param packet The rays, updated with their closest hits.
+       * @param mask The rays to test.
+       */
+      void hitsPacket(RayPacket &packet, std::uint32_t mask) const override;
+
       /**
        * @brief Gets the normal vector of the plane.
        * @param point The point on the plane's surface (unused, as plane has a constant normal).
@@ -45,7 +53,25 @@ namespace Raytracer {
        */
       Math::Vector3D getNormal(const Math::Point3D &point) const override {
         (void)point;
-        return _normal;
+        return _unitNormal;
+      }
+
+      /**
+       * @brief Precomputes the unit normal and the distance of the plane
+       * from the origin along it.
+       */
+      void commit() override {
+        _unitNormal = _normal.normalized();
+        _offset = _unitNormal.dot(Math::Vector3D(_center.x, _center.y,
+                                                 _center.z));
+      }
+
+      /**
+       * @brief Gets the bounds of the plane, which extends to infinity.
+       * @return Math::AABB Math::AABB::infinite().
+       */
+      Math::AABB getBounds() const override {
+        return Math::AABB::infinite();
       }
 
       /**
@@ -58,6 +84,8 @@ namespace Raytracer {
 
     private:
       Math::Vector3D _normal; ///< The normal vector defining the plane's orientation.
+      Math::Vector3D _unitNormal; ///< Unit normal, set by commit().
+      double _offset = 0.0;       ///< Dot product of the unit normal and any point of the plane.
   };
 
 }  // namespace Raytracer
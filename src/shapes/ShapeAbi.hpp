@@ -0,0 +1,227 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "AABB.hpp"
+#include "IShape.hpp"
+#include "RayPacket.hpp"
+
+namespace Raytracer {
+
+  /**
+   * @brief Version of the ShapeAbi table described in this file.
+   *
+   * The vtable of IShape is frozen so that plugins built against earlier
+   * versions keep working; every entry point added to shapes since goes
+   * through this table instead. A plugin without shapeAbi() (version 0) has
+   * every ray go through IShape::hits(), is never committed and has infinite
+   * bounds. Later versions only append fields to ShapeAbi, so a host reads
+   * the fields of the versions it knows and ignores the rest. Version 2
+   * added hitsPacket and commit.
+   */
+  constexpr std::uint32_t shapeAbiVersion = 2;
+
+  /**
+   * @brief Entry points a plugin implements, as bits of
+   * ShapeAbi::capabilities.
+   */
+  enum ShapeCapability : std::uint32_t {
+    ShapeBatchHits = 1u << 0, ///< ShapeAbi::hitsBatch is set.
+    ShapeBounds = 1u << 1,    ///< ShapeAbi::bounds is set.
+    ShapePackets = 1u << 2,   ///< ShapeAbi::hitsPacket is set, from version 2.
+    ShapeCommit = 1u << 3,    ///< ShapeAbi::commit is set, from version 2.
+  };
+
+  /**
+   * @brief Rays handed to a plugin together, one array per coordinate.
+   *
+   * The arrays are those of the RayPacket being traced: they hold count
+   * floats aligned on 16 bytes, so the intersector may load them four at a
+   * time. Only the rays of the mask passed along are valid.
+   */
+  struct RayBatch {
+    static constexpr std::uint32_t maxRays = 32; ///< Bits in a mask.
+
+    const float *originX; ///< Origin x of each ray.
+    const float *originY; ///< Origin y of each ray.
+    const float *originZ; ///< Origin z of each ray.
+    const float *dirX;    ///< Direction x of each ray.
+    const float *dirY;    ///< Direction y of each ray.
+    const float *dirZ;    ///< Direction z of each ray.
+    const float *tMin;    ///< Start of the interval of each ray.
+    float *tMax;   ///< End of the interval, lowered to the distance of a hit.
+    float *colorR; ///< Red of the colour at each hit.
+    float *colorG; ///< Green of the colour at each hit.
+    float *colorB; ///< Blue of the colour at each hit.
+    std::uint32_t count; ///< Number of rays in the arrays, at most maxRays.
+  };
+
+  /**
+   * @brief Extended entry points of a shape plugin, returned by its
+   * shapeAbi() export.
+   *
+   * The functions take the shape created by the addShape() of the same
+   * plugin and are called from several threads at once, like hits(), except
+   * commit() which is called while the scene is built.
+   */
+  struct ShapeAbi {
+    std::uint32_t version;      ///< shapeAbiVersion the plugin was built with.
+    std::uint32_t capabilities; ///< ShapeCapability bits.
+
+    /**
+     * @brief Intersects rays of a batch with the shape.
+     * For each ray of the mask hit within its (tMin, tMax) interval, sets
+     * tMax to the distance of the hit and the colour to the one hits()
+     * would return, the hit shape being the shape itself.
+     * @return The mask of the rays hit.
+     */
+    std::uint32_t (*hitsBatch)(const IShape *shape, RayBatch *batch,
+                               std::uint32_t mask);
+
+    /**
+     * @brief Gets the world-space bounding box of the shape, as of its last
+     * commit.
+     * @return 0 if the shape has no finite extent, min and max being left
+     * untouched; non-zero otherwise.
+     */
+    int (*bounds)(const IShape *shape, float min[3], float max[3]);
+
+    /**
+     * @brief Intersects the rays of a packet with the shape, as
+     * AShape::hitsPacket() does.
+     */
+    void (*hitsPacket)(const IShape *shape, RayPacket *packet,
+                       std::uint32_t mask);
+
+    /**
+     * @brief Precomputes the ray-independent values of the shape, as
+     * AShape::commit() does.
+     */
+    void (*commit)(IShape *shape);
+  };
+
+  /**
+   * @brief Checks whether a table provides an entry point.
+   * @param abi The table, nullptr for a plugin without one.
+   * @param version The version that added the entry point.
+   * @param capability The bit of the entry point.
+   */
+  inline bool hasShapeEntry(const ShapeAbi *abi, std::uint32_t version,
+                            ShapeCapability capability) {
+    return abi && abi->version >= version && (abi->capabilities & capability);
+  }
+
+  /**
+   * @brief Stores a box in the float arrays of ShapeAbi::bounds, rounding
+   * outwards so that the box still holds the whole shape.
+   * @return 0 for an infinite box, 1 otherwise.
+   */
+  inline int boundsToFloats(const Math::AABB &box, float min[3],
+                            float max[3]) {
+    if (box.isInfinite())
+      return 0;
+    auto down = [](double v) {
+      float f = static_cast<float>(v);
+      return f > v ? std::nextafter(f, -INFINITY) : f;
+    };
+    auto up = [](double v) {
+      float f = static_cast<float>(v);
+      return f < v ? std::nextafter(f, INFINITY) : f;
+    };
+    min[0] = down(box.min.x);
+    min[1] = down(box.min.y);
+    min[2] = down(box.min.z);
+    max[0] = up(box.max.x);
+    max[1] = up(box.max.y);
+    max[2] = up(box.max.z);
+    return 1;
+  }
+
+  /**
+   * @brief Builds the table of a shape plugin whose shapes derive from
+   * AShape, every entry point calling the member function of T.
+   *
+   * The calls are qualified, so the host reaches the code of T in a single
+   * indirect call. Plugins with a batch intersector set hitsBatch on the
+   * copy they export.
+   * @tparam T The concrete shape type of the plugin.
+   * @return ShapeAbi The table, to be kept alive by the plugin.
+   */
+  template <typename T>
+  ShapeAbi shapeAbiOf() {
+    ShapeAbi abi = {};
+    abi.version = shapeAbiVersion;
+    abi.capabilities = ShapeBounds | ShapePackets | ShapeCommit;
+    abi.bounds = [](const IShape *shape, float min[3], float max[3]) {
+      return boundsToFloats(static_cast<const T *>(shape)->T::getBounds(),
+                            min, max);
+    };
+    abi.hitsPacket = [](const IShape *shape, RayPacket *packet,
+                        std::uint32_t mask) {
+      static_cast<const T *>(shape)->T::hitsPacket(*packet, mask);
+    };
+    abi.commit = [](IShape *shape) {
+      static_cast<T *>(shape)->T::commit();
+    };
+    return abi;
+  }
+
+  /**
+   * @brief Intersects the rays of a packet with a shape, through its
+   * plugin or one ray at a time through IShape::hits().
+   * @param abi The table of the plugin of the shape, may be nullptr.
+   * @param shape The shape.
+   * @param packet The rays, updated with their closest hits.
+   * @param mask The rays to test.
+   */
+  inline void shapeHitsPacket(const ShapeAbi *abi, const IShape &shape,
+                              RayPacket &packet, std::uint32_t mask) {
+    if (hasShapeEntry(abi, 2, ShapePackets) && abi->hitsPacket) {
+      abi->hitsPacket(&shape, &packet, mask);
+      return;
+    }
+    for (; mask; mask &= mask - 1) {
+      int i = __builtin_ctz(mask);
+      auto [t, color, hit] = shape.hits(packet.ray(i));
+      packet.record(i, t, color, hit);
+    }
+  }
+
+  /**
+   * @brief Commits a shape through its plugin; shapes without the entry
+   * point have nothing to precompute.
+   * @param abi The table of the plugin of the shape, may be nullptr.
+   * @param shape The shape.
+   */
+  inline void shapeCommit(const ShapeAbi *abi, IShape &shape) {
+    if (hasShapeEntry(abi, 2, ShapeCommit) && abi->commit)
+      abi->commit(&shape);
+  }
+
+  /**
+   * @brief Gets the bounds of a shape through its plugin; shapes without
+   * the entry point are unbounded.
+   * @param abi The table of the plugin of the shape, may be nullptr.
+   * @param shape The shape.
+   * @return Math::AABB The bounding box.
+   */
+  inline Math::AABB shapeBounds(const ShapeAbi *abi, const IShape &shape) {
+    if (!hasShapeEntry(abi, 1, ShapeBounds) || !abi->bounds)
+      return Math::AABB::infinite();
+    float min[3];
+    float max[3];
+    if (!abi->bounds(&shape, min, max))
+      return Math::AABB::infinite();
+    return Math::AABB(Math::Point3D(min[0], min[1], min[2]),
+                      Math::Point3D(max[0], max[1], max[2]));
+  }
+
+}  // namespace Raytracer
+
+extern "C" {
+/**
+ * @brief Optional export of a shape plugin giving its extended entry points.
+ * The returned table must live as long as the plugin is loaded.
+ */
+const Raytracer::ShapeAbi *shapeAbi();
+}
@@ -1,44 +1,289 @@
 #include "ShapeComposite.hpp"
+#include <algorithm>
+#include "Factory.hpp"
+#include "Trace.hpp"
 #include "Vector3D.hpp"
 
+namespace {
+
+  /**
+   * @brief Intersects rays of a packet with a plugin shape through its batch
+   * entry point, the packet arrays being handed over as they are.
+   * @param abi The entry points of the plugin.
+   * @param shape The shape.
+   * @param packet The rays, updated with their closest hits.
+   * @param mask The rays to test.
+   */
+  void hitsBatch(const Raytracer::ShapeAbi &abi,
+                 const Raytracer::IShape &shape, Raytracer::RayPacket &packet,
+                 std::uint32_t mask) {
+    alignas(16) float red[Raytracer::RayPacket::size];
+    alignas(16) float green[Raytracer::RayPacket::size];
+    alignas(16) float blue[Raytracer::RayPacket::size];
+    Raytracer::RayBatch batch = {packet.originX, packet.originY,
+                                 packet.originZ, packet.dirX,
+                                 packet.dirY,    packet.dirZ,
+                                 packet.tMin,    packet.tMax,
+                                 red,            green,
+                                 blue,           Raytracer::RayPacket::size};
+    std::uint32_t hit = abi.hitsBatch(&shape, &batch, mask) & mask;
+    for (; hit; hit &= hit - 1) {
+      int i = __builtin_ctz(hit);
+      packet.color[i] = Math::Vector3D(red[i], green[i], blue[i]);
+      packet.shape[i] = &shape;
+    }
+  }
+
+}  // namespace
+
 /**
  * @brief Adds a shape to the composite collection.
  * @param shape A shared pointer to the IShape object to be added.
  */
 void Raytracer::ShapeComposite::addShape(const std::shared_ptr<IShape> &shape) {
   shapes.push_back(shape);
+  _abis.push_back(Factory::getShapeAbi(*shape));
+  _built = false;
+}
+
+/**
+ * @brief Builds the top-level BVH.
+ *
+ * Gathers the bounds of every shape, keeps shapes with infinite bounds in a
+ * separate list, and builds the BVH over the others. Shapes with empty bounds
+ * cannot be hit and end up in neither.
+ */
+void Raytracer::ShapeComposite::build() {
+  Trace::Scope scope("build top-level BVH", "build",
+                     std::to_string(shapes.size()) + " shapes");
+  _bounds.resize(shapes.size());
+  _unbounded.clear();
+  for (std::uint32_t i = 0; i < shapes.size(); i++) {
+    _bounds[i] = boundsOf(i);
+    if (_bounds[i].isInfinite()) {
+      _unbounded.push_back(i);
+      _bounds[i] = Math::AABB();
+    }
+  }
+  _bvh.build(_bounds);
+  _built = true;
+}
+
+/**
+ * @brief Refits the top-level BVH to the current shape bounds.
+ *
+ * The leaves keep the same shapes, only the boxes are recomputed bottom-up,
+ * which costs a fraction of a build and suits per-frame updates of moving
+ * shapes. If a shape moved between the bounded, unbounded and empty
+ * categories the structure no longer matches, and if the shapes moved so far
+ * from where the tree grouped them that it is expected to trace more than
+ * maxDegradation times slower, the BVH is rebuilt instead.
+ */
+void Raytracer::ShapeComposite::refit() {
+  if (!_built || _bounds.size() != shapes.size()) {
+    build();
+    return;
+  }
+  std::size_t unbounded = 0;
+  for (std::uint32_t i = 0; i < shapes.size(); i++) {
+    Math::AABB bounds = boundsOf(i);
+    bool wasUnbounded =
+        unbounded < _unbounded.size() && _unbounded[unbounded] == i;
+    if (wasUnbounded)
+      unbounded++;
+    if (bounds.isInfinite() != wasUnbounded ||
+        (!wasUnbounded && bounds.isEmpty() != _bounds[i].isEmpty())) {
+      build();
+      return;
+    }
+    if (!wasUnbounded)
+      _bounds[i] = bounds;
+  }
+  {
+    Trace::Scope scope("refit top-level BVH", "build");
+    _bvh.refit(_bounds);
+  }
+  if (_bvh.getDegradation() > maxDegradation)
+    build();
+}
+
+/**
+ * @brief Replaces the shapes with the result of a new parse.
+ *
+ * When the number of shapes is unchanged, only the slots holding a
+ * different shape are replaced and the top-level BVH is refitted; when
+ * nothing changed it is left untouched. Otherwise the list is replaced and
+ * the BVH rebuilt.
+ * @param next The new shapes.
+ * @return std::size_t The number of slots that changed.
+ */
+std::size_t Raytracer::ShapeComposite::update(
+    const std::vector<std::shared_ptr<IShape>> &next) {
+  if (next.size() != shapes.size()) {
+    std::size_t changed = std::max(next.size(), shapes.size());
+    shapes = next;
+    _abis.clear();
+    for (const auto &shape : shapes)
+      _abis.push_back(Factory::getShapeAbi(*shape));
+    build();
+    return changed;
+  }
+  std::size_t changed = 0;
+  for (std::size_t i = 0; i < next.size(); i++) {
+    if (shapes[i] != next[i]) {
+      shapes[i] = next[i];
+      _abis[i] = Factory::getShapeAbi(*shapes[i]);
+      changed++;
+    }
+  }
+  if (changed > 0)
+    refit();
+  return changed;
+}
+
+/**
+ * @brief Commits every shape through its plugin, then refits the hierarchy
+ * over them if it was built.
+ */
+void Raytracer::ShapeComposite::commit() {
+  for (std::size_t i = 0; i < shapes.size(); i++)
+    shapeCommit(_abis[i], *shapes[i]);
+  if (_built)
+    refit();
+}
+
+/**
+ * @brief Gets the bounds of a shape through its plugin, infinite when the
+ * plugin exports no bounds query.
+ * @param i The index of the shape.
+ * @return Math::AABB The bounding box.
+ */
+Math::AABB Raytracer::ShapeComposite::boundsOf(std::uint32_t i) const {
+  return shapeBounds(_abis[i], *shapes[i]);
+}
+
+/**
+ * @brief Gets the bounds of all shapes in the composite.
+ * @return Math::AABB The union of the child bounds, or an infinite box if any
+ * child is unbounded.
+ */
+Math::AABB Raytracer::ShapeComposite::getBounds() const {
+  Math::AABB bounds;
+
+  for (std::uint32_t i = 0; i < shapes.size(); i++) {
+    Math::AABB shapeBounds = boundsOf(i);
+    if (shapeBounds.isInfinite())
+      return Math::AABB::infinite();
+    bounds.expand(shapeBounds);
+  }
+  return bounds;
 }
 
 /**
  * @brief Calculates the closest intersection of a ray with the shapes in this composite.
  *
- * Iterates through all shapes in the composite, calls their `hits` method,
- * and returns the information for the closest intersection point found in front of the ray.
+ * Tests the unbounded shapes first, then walks the top-level BVH so that only
+ * shapes whose bounds are crossed by the ray (and closer than the current
+ * hit) are tested. Before build() has been called, every shape is tested.
+ * Each hit lowers the tMax of the ray handed to the next shapes, so they can
+ * reject farther candidates early.
  *
- * @param ray The ray to test for intersection.
+ * @param ray The ray to test for intersection, hits outside its
+ * [tMin, tMax] interval being ignored.
  * @return A tuple containing:
  *         - double: The distance to the closest hit point (t). If no intersection,
- *                   this value will be 0.0 (or a large initial value if logic changes).
+ *                   this value will be 0.0.
  *         - Math::Vector3D: The color of the shape at the closest hit point.
  *                           (0,0,0) if no hit.
  *         - const IShape*: A pointer to the shape that was hit. Nullptr if no hit.
  */
 std::tuple<double, Math::Vector3D, const Raytracer::IShape *>
 Raytracer::ShapeComposite::hits(const Raytracer::Ray &ray) const {
-  double closestT = 100;  // TODO: Use a more appropriate value
   Math::Vector3D hitColor;
   const IShape *hitShape = nullptr;
-
-  for (const auto &shape : shapes) {
-    auto [t, color, s] = shape->hits(ray);
-    if (t > 0.0 && t < closestT) {
-      closestT = t;
+  Ray bounded = ray;
+#ifdef RAYTRACER_STATS
+  RayStats &stats = RenderStats::local();
+  stats.add(static_cast<RayStats::Counter>(ray.kind));
+  bounded.stats = &stats;
+#endif
+  auto test = [&](const IShape &shape) {
+#ifdef RAYTRACER_STATS
+    stats.add(RayStats::ShapeTests);
+#endif
+    auto [t, color, s] = shape.hits(bounded);
+    if (s && bounded.contains(t)) {
+      bounded.tMax = t;
       hitColor = color;
       hitShape = s;
     }
+  };
+
+  if (!_built) {
+    for (const auto &shape : shapes)
+      test(*shape);
+  } else {
+    for (std::uint32_t index : _unbounded)
+      test(*shapes[index]);
+    _bvh.traverse(bounded, [&](std::uint32_t index, double &tMax) {
+      test(*shapes[index]);
+      tMax = bounded.tMax;
+    });
   }
   if (hitShape) {
-    return {closestT, hitColor, hitShape};
+    return {bounded.tMax, hitColor, hitShape};
   }
   return {0.0, Math::Vector3D(0, 0, 0), nullptr};
 }
+
+/**
+ * @brief Calculates the closest intersection of the rays of a packet with
+ * the shapes in this composite.
+ *
+ * Works like hits(), with the top-level BVH walked once for the whole
+ * packet: each shape is handed the rays that reached it through its plugin,
+ * and its hits lower their tMax before the next shapes are tested. Once
+ * built, shapes whose plugin exports a batch intersector get the rays
+ * through it.
+ * @param packet The rays. Each one hit keeps the distance, colour and shape
+ * of its closest hit in tMax, color and shape.
+ * @param mask The rays to trace.
+ */
+void Raytracer::ShapeComposite::hitsPacket(RayPacket &packet,
+                                           std::uint32_t mask) const {
+#ifdef RAYTRACER_STATS
+  RayStats &stats = RenderStats::local();
+  stats.add(static_cast<RayStats::Counter>(packet.kind),
+            __builtin_popcount(mask));
+  packet.stats = &stats;
+#endif
+  auto test = [&](std::uint32_t index, std::uint32_t rays) {
+#ifdef RAYTRACER_STATS
+    stats.add(RayStats::ShapeTests, __builtin_popcount(rays));
+#endif
+    shapeHitsPacket(_abis[index], *shapes[index], packet, rays);
+  };
+  auto testBuilt = [&](std::uint32_t index, std::uint32_t rays) {
+    const ShapeAbi *abi = _abis[index];
+    if (!hasShapeEntry(abi, 1, ShapeBatchHits) || !abi->hitsBatch) {
+      test(index, rays);
+      return;
+    }
+#ifdef RAYTRACER_STATS
+    stats.add(RayStats::ShapeTests, __builtin_popcount(rays));
+#endif
+    hitsBatch(*abi, *shapes[index], packet, rays);
+  };
+
+  if (!_built) {
+    for (std::uint32_t index = 0; index < shapes.size(); index++)
+      test(index, mask);
+  } else {
+    for (std::uint32_t index : _unbounded)
+      testBuilt(index, mask);
+    _bvh.traversePacket(packet, mask,
+                        [&](std::uint32_t index, std::uint32_t rays) {
+                          testBuilt(index, rays);
+                        });
+  }
+}
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include "AShape.hpp"
+#include "RenderStats.hpp"
+#include "ShapeAbi.hpp"
 #include "Vector3D.hpp"
+#include "accel/BVH.hpp"
 
 namespace Raytracer {
 
@@ -13,6 +17,19 @@ namespace Raytracer {
    * This class inherits from AShape and allows treating a collection of shapes
    * as a single entity. It delegates operations like ray intersection testing
    * and transformations to its child shapes.
+   *
+   * Once build() has been called, the composite is the top level of a
+   * two-level acceleration structure: a BVH over the bounds of its shapes,
+   * while meshes keep their own bottom-level BVH (shared between instances).
+   * Moving shapes only requires refit(), whose cost depends on the number of
+   * shapes and not on the number of triangles. Shapes with infinite bounds
+   * are kept out of the BVH and tested on every ray.
+   *
+   * Shapes are committed, bounded and handed packets of rays through the
+   * extended entry points their plugin exports (see ShapeAbi.hpp); those
+   * of plugins without them are unbounded and trace one ray at a time.
+   * Once built, shapes with a batch intersector get the rays of a packet as
+   * a single batch.
    */
   class ShapeComposite : public AShape {
     public:
@@ -27,6 +44,29 @@ namespace Raytracer {
        */
       void addShape(const std::shared_ptr<IShape> &shape);
 
+      /**
+       * @brief Builds the top-level BVH over the bounds of the shapes.
+       * Until it is called (and after every addShape), hits() falls back to
+       * testing every shape.
+       */
+      void build();
+
+      /**
+       * @brief Updates the top-level BVH after shapes moved, keeping its
+       * structure. Rebuilds it instead if a shape became bounded or
+       * unbounded, or if the refitted tree degraded too much.
+       */
+      void refit();
+
+      /**
+       * @brief Replaces the shapes with the result of a new parse, touching
+       * only what changed.
+       * @param next The new shapes. Shapes shared with the current list are
+       * kept as they are.
+       * @return std::size_t The number of slots that changed.
+       */
+      std::size_t update(const std::vector<std::shared_ptr<IShape>> &next);
+
       /**
        * @brief Calculates the closest intersection of a ray with any shape in the composite.
        * @param ray The ray to test for intersection.
@@ -35,6 +75,14 @@ namespace Raytracer {
       std::tuple<double, Math::Vector3D, const IShape *> hits(
           const Raytracer::Ray &ray) const override;
 
+      /**
+       * @brief Calculates the closest intersection of the rays of a packet
+       * with the shapes, walking the top-level BVH once for the packet.
+       * @param packet The rays, updated with their closest hits.
+       * @param mask The rays to trace.
+       */
+      void hitsPacket(RayPacket &packet, std::uint32_t mask) const override;
+
       /**
        * @brief Gets the normal vector at a given point.
        * @note This implementation is a placeholder and returns a zero vector.
@@ -63,10 +111,72 @@ namespace Raytracer {
       void translate(const Math::Vector3D &offset) override {
         for (const auto &shape : shapes)
           shape->translate(offset);
+        commit();
       }
 
+      /**
+       * @brief Commits every shape, then refits the hierarchy over them if it
+       * was built.
+       */
+      void commit() override;
+
+      /**
+       * @brief Gets the bounds of all shapes in the composite.
+       * @return Math::AABB The union of the child bounds, infinite if any
+       * child is unbounded.
+       */
+      Math::AABB getBounds() const override;
+
     private:
+      static constexpr double maxDegradation =
+          1.5; ///< Refitted trees expected to trace slower than this are rebuilt.
+
       std::vector<std::shared_ptr<IShape>> shapes; ///< Vector of shared pointers to IShape objects.
+      std::vector<Math::AABB> _bounds;        ///< Bounds of each shape at the last build/refit.
+      std::vector<std::uint32_t> _unbounded;  ///< Indices of shapes with infinite bounds.
+      std::vector<const ShapeAbi *> _abis;    ///< Plugin entry points of each shape.
+      BVH _bvh;                               ///< Top-level BVH over the bounded shapes.
+      bool _built = false;                    ///< Whether _bvh matches the shape list.
+
+      /**
+       * @brief Gets the bounds of shape i through its plugin.
+       */
+      Math::AABB boundsOf(std::uint32_t i) const;
+  };
+
+  /**
+   * @brief The shapes of a scene as handed to the plugins without an
+   * extended table, which may have been built against the Ray of earlier
+   * versions: an origin and a direction, nothing after.
+   *
+   * hits() only reads those two fields and traces the ray through the
+   * scene with the default interval and the kind given here. The other
+   * members see an empty composite.
+   */
+  class LegacyShapes : public ShapeComposite {
+    public:
+      /**
+       * @brief Wraps the shapes of a scene.
+       * @param shapes The shapes, which must outlive the wrapper.
+       * @param kind The kind of the rays traced through it.
+       */
+      LegacyShapes(const ShapeComposite &shapes, Ray::Kind kind)
+          : _shapes(shapes), _kind(kind) {
+      }
+
+      /**
+       * @brief Traces a ray of which only the origin and direction are read.
+       * @param ray The ray.
+       * @return The closest hit, as ShapeComposite::hits() gives it.
+       */
+      std::tuple<double, Math::Vector3D, const IShape *> hits(
+          const Raytracer::Ray &ray) const override {
+        return _shapes.hits(Ray(ray.origin, ray.direction, _kind));
+      }
+
+    private:
+      const ShapeComposite &_shapes; ///< The shapes of the scene.
+      Ray::Kind _kind;               ///< Kind of the rays traced.
   };
 
 }  // namespace Raytracer
@@ -1,6 +1,10 @@
 #include "Sphere.hpp"
 #include <cmath>
+#include <utility>
 #include <iostream>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 #include "IShape.hpp"
 #include "Vector3D.hpp"
 
@@ -9,7 +13,7 @@
  * @param ray The ray to test for intersection.
  * @return A tuple containing:
  *         - double: The distance from the ray's origin to the closest intersection point (t).
- *                   Returns 0.0 if there is no hit or if hits are behind the ray origin.
+ *                   Returns 0.0 if there is no hit or if no hit is within [ray.tMin, ray.tMax].
  *         - Math::Vector3D: The color of the sphere.
  *         - const Raytracer::IShape*: A pointer to this sphere object.
  */
@@ -19,17 +23,91 @@ Raytracer::Sphere::hits(const Raytracer::Ray &ray) const {
 
   double a = ray.direction.dot(ray.direction);
   double b = 2.0 * oc.dot(ray.direction);
-  double c = oc.dot(oc) - _radius * _radius;
+  double c = oc.dot(oc) - _radius2;
   double discriminant = b * b - 4 * a * c;
   if (discriminant < 0) {
     return {0.0, _color, this};
   }
-  double t1 = (-b - std::sqrt(discriminant)) / (2 * a);
-  double t2 = (-b + std::sqrt(discriminant)) / (2 * a);
-  if (t1 < 0 && t2 < 0) {
-    return {0.0, _color, this};
+  double sqrtDisc = std::sqrt(discriminant);
+  double t1 = (-b - sqrtDisc) / (2 * a);
+  double t2 = (-b + sqrtDisc) / (2 * a);
+  if (t1 > t2)
+    std::swap(t1, t2);
+  if (ray.contains(t1))
+    return {t1, _color, this};
+  if (ray.contains(t2))
+    return {t2, _color, this};
+  return {0.0, _color, this};
+}
+
+/**
+ * @brief Intersects the rays of a packet with the sphere.
+ *
+ * Four rays are solved at a time with SSE, in single precision. The
+ * discriminant is computed from the distance between the centre and the
+ * line of the ray rather than as b^2 - 4ac, which would cancel out badly
+ * for far away spheres in single precision. Without SSE, the rays are
+ * traced one at a time.
+ * @param packet The rays, updated with their closest hits.
+ * @param mask The rays to test.
+ */
+void Raytracer::Sphere::hitsPacket(RayPacket &packet,
+                                   std::uint32_t mask) const {
+#if defined(__SSE2__)
+  const __m128 cx = _mm_set1_ps(_center.x);
+  const __m128 cy = _mm_set1_ps(_center.y);
+  const __m128 cz = _mm_set1_ps(_center.z);
+  const __m128 radius2 = _mm_set1_ps(static_cast<float>(_radius2));
+  const __m128 zero = _mm_setzero_ps();
+
+  for (int group = 0; group < RayPacket::size; group += 4) {
+    int lanes = (mask >> group) & 0xF;
+    if (!lanes)
+      continue;
+    __m128 dx = _mm_load_ps(packet.dirX + group);
+    __m128 dy = _mm_load_ps(packet.dirY + group);
+    __m128 dz = _mm_load_ps(packet.dirZ + group);
+    __m128 ox = _mm_sub_ps(_mm_load_ps(packet.originX + group), cx);
+    __m128 oy = _mm_sub_ps(_mm_load_ps(packet.originY + group), cy);
+    __m128 oz = _mm_sub_ps(_mm_load_ps(packet.originZ + group), cz);
+    __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                          _mm_mul_ps(dz, dz));
+    __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, dx), _mm_mul_ps(oy, dy)),
+                          _mm_mul_ps(oz, dz));
+    __m128 tc = _mm_div_ps(_mm_sub_ps(zero, b), a);
+    __m128 lx = _mm_add_ps(ox, _mm_mul_ps(tc, dx));
+    __m128 ly = _mm_add_ps(oy, _mm_mul_ps(tc, dy));
+    __m128 lz = _mm_add_ps(oz, _mm_mul_ps(tc, dz));
+    __m128 h2 = _mm_div_ps(
+        _mm_sub_ps(radius2,
+                   _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)),
+                              _mm_mul_ps(lz, lz))),
+        a);
+    __m128 real = _mm_cmpge_ps(h2, zero);
+    __m128 h = _mm_sqrt_ps(_mm_max_ps(h2, zero));
+    __m128 tMin = _mm_load_ps(packet.tMin + group);
+    __m128 tMax = _mm_load_ps(packet.tMax + group);
+    __m128 t1 = _mm_sub_ps(tc, h);
+    __m128 t2 = _mm_add_ps(tc, h);
+    __m128 in1 = _mm_and_ps(_mm_cmpgt_ps(t1, tMin), _mm_cmplt_ps(t1, tMax));
+    __m128 in2 = _mm_and_ps(_mm_cmpgt_ps(t2, tMin), _mm_cmplt_ps(t2, tMax));
+    __m128 t = _mm_or_ps(_mm_and_ps(in1, t1), _mm_andnot_ps(in1, t2));
+    int found =
+        _mm_movemask_ps(_mm_and_ps(real, _mm_or_ps(in1, in2))) & lanes;
+    if (!found)
+      continue;
+    alignas(16) float distance[4];
+    _mm_store_ps(distance, t);
+    for (; found; found &= found - 1) {
+      int i = group + __builtin_ctz(found);
+      packet.tMax[i] = distance[i - group];
+      packet.color[i] = _color;
+      packet.shape[i] = this;
+    }
   }
-  return {t1 < t2 ? t1 : t2, _color, this};
+#else
+  AShape::hitsPacket(packet, mask);
+#endif
 }
 
 extern "C" {
@@ -48,4 +126,15 @@ Raytracer::IShape *addShape() {
     return nullptr;
   }
 }
+
+/**
+ * @brief Gives the extended entry points of the Sphere plugin, see
+ * ShapeAbi.hpp.
+ * @return const Raytracer::ShapeAbi* The entry points.
+ */
+const Raytracer::ShapeAbi *shapeAbi() {
+  static const Raytracer::ShapeAbi abi =
+      Raytracer::shapeAbiOf<Raytracer::Sphere>();
+  return &abi;
+}
 }
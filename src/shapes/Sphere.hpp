@@ -27,6 +27,7 @@ namespace Raytracer {
           : _radius(radius) {
         _center = center;
         _color = color;
+        commit();
       }
 
       /**
@@ -36,6 +37,7 @@ namespace Raytracer {
       Sphere() : _radius(1) {
         _center = Math::Point3D(0, 0, 0);
         _color = Math::Vector3D(1, 0, 0);
+        commit();
       }
 
       /**
@@ -51,6 +53,14 @@ namespace Raytracer {
       std::tuple<double, Math::Vector3D, const IShape *> hits(
           const Raytracer::Ray &ray) const override;
 
+      /**
+       * @brief Intersects the rays of a packet with the sphere, four at a
+       * time.
+       * @param packet The rays, updated with their closest hits.
+       * @param mask The rays to test.
+       */
+      void hitsPacket(RayPacket &packet, std::uint32_t mask) const override;
+
       /**
        * @brief Gets the normal vector at a given point on the sphere's surface.
        * @param point The point on the sphere's surface.
@@ -60,6 +70,23 @@ namespace Raytracer {
         return (point - _center).normalize();
       }
 
+      /**
+       * @brief Precomputes the squared radius and the bounds.
+       */
+      void commit() override {
+        Math::Vector3D r(_radius, _radius, _radius);
+        _radius2 = _radius * _radius;
+        _bounds = Math::AABB(_center - r, _center + r);
+      }
+
+      /**
+       * @brief Gets the bounding box of the sphere.
+       * @return Math::AABB The cube of side 2r centered on the sphere.
+       */
+      Math::AABB getBounds() const override {
+        return _bounds;
+      }
+
       /**
        * @brief Gets the radius of the sphere.
        * @return const double& A const reference to the sphere's radius.
@@ -82,6 +109,8 @@ namespace Raytracer {
 
     private:
       double _radius;
+      double _radius2 = 1.0; ///< Squared radius, set by commit().
+      Math::AABB _bounds;    ///< Bounds, set by commit().
   };
 
 }  // namespace Raytracer
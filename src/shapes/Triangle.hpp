@@ -4,6 +4,7 @@
 #include "AShape.hpp"
 #include "Point3D.hpp"
 #include "Ray.hpp"
+#include "ShapeAbi.hpp"
 #include "Vector3D.hpp"
 
 namespace Raytracer {
@@ -32,6 +33,7 @@ namespace Raytracer {
           : _normal(normal), _p1(p1), _p2(p2), _p3(p3) {
         _center = center;
         _color = color;
+        commit();
       }
 
       /**
@@ -45,6 +47,7 @@ namespace Raytracer {
             _p3(Math::Point3D(0, 1, 0)) {
         _center = Math::Point3D(0, 0, 0);
         _color = Math::Vector3D(1, 0, 0);
+        commit();
       }
 
       /**
@@ -63,6 +66,15 @@ namespace Raytracer {
       std::tuple<double, Math::Vector3D, const IShape *> hits(
           const Raytracer::Ray &ray) const override;
 
+      /**
+       * @brief Intersects the rays of a batch with the triangle, for the
+       * shapeAbi() export of the plugin.
+       * @param batch The rays, whose tMax and colour are set at each hit.
+       * @param mask The rays to test.
+       * @return std::uint32_t The mask of the rays hit.
+       */
+      std::uint32_t hitsBatch(RayBatch &batch, std::uint32_t mask) const;
+
       /**
        * @brief Gets the normal vector of the triangle.
        * @param point The point on the triangle's surface (unused, as triangle
@@ -75,13 +87,44 @@ namespace Raytracer {
       };
 
       /**
-       * @brief Translates the triangle by a given offset.
-       * This implementation only translates the center. For full triangle
-       * translation, vertices p1, p2, and p3 should also be translated.
-       * @param offset The vector by which to translate the triangle's center.
+       * @brief Translates the triangle, its center and its three vertices, by
+       * a given offset.
+       * @param offset The vector by which to translate the triangle.
        */
       void translate(const Math::Vector3D &offset) override {
         _center = _center + offset;
+        _p1 = _p1 + offset;
+        _p2 = _p2 + offset;
+        _p3 = _p3 + offset;
+      }
+
+      /**
+       * @brief Rotates the vertices and the normal of the triangle around
+       * its centroid.
+       * @param axis The axis of rotation.
+       * @param angle The angle of rotation in degrees.
+       */
+      void rotate(const Math::Vector3D &axis, float angle) override;
+
+      /**
+       * @brief Precomputes the two edges from the first vertex and the
+       * bounds.
+       */
+      void commit() override {
+        _edge1 = _p2 - _p1;
+        _edge2 = _p3 - _p1;
+        _bounds = Math::AABB();
+        _bounds.expand(_p1);
+        _bounds.expand(_p2);
+        _bounds.expand(_p3);
+      }
+
+      /**
+       * @brief Gets the bounding box of the triangle.
+       * @return Math::AABB The box enclosing the three vertices.
+       */
+      Math::AABB getBounds() const override {
+        return _bounds;
       }
 
       /**
@@ -111,6 +154,16 @@ namespace Raytracer {
       Math::Point3D _p1;       ///< The first vertex of the triangle.
       Math::Point3D _p2;       ///< The second vertex of the triangle.
       Math::Point3D _p3;       ///< The third vertex of the triangle.
+      Math::Vector3D _edge1;   ///< _p2 - _p1, set by commit().
+      Math::Vector3D _edge2;   ///< _p3 - _p1, set by commit().
+      Math::AABB _bounds;      ///< Bounds, set by commit().
+
+      /**
+       * @brief Finds where a line crosses the triangle.
+       * @return double The distance along the direction, 0 on a miss.
+       */
+      double intersect(const Math::Point3D &origin,
+                       const Math::Vector3D &direction) const;
   };
 
 }  // namespace Raytracer
@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include "accel/BVH.hpp"
+#include "exceptions/RaytracerException.hpp"
+
+namespace {
+
+  // Distance at which a ray enters a box, 0 if it misses it.
+  double enter(const Raytracer::Ray &ray, const Math::AABB &box, double tMax) {
+    double tNear = ray.tMin;
+    double tFar = tMax;
+    const float origin[3] = {ray.origin.x, ray.origin.y, ray.origin.z};
+    const float direction[3] = {ray.direction.x, ray.direction.y,
+                                ray.direction.z};
+    const float min[3] = {box.min.x, box.min.y, box.min.z};
+    const float max[3] = {box.max.x, box.max.y, box.max.z};
+    for (int axis = 0; axis < 3; axis++) {
+      double t0 = (min[axis] - origin[axis]) / direction[axis];
+      double t1 = (max[axis] - origin[axis]) / direction[axis];
+      tNear = std::max(tNear, std::min(t0, t1));
+      tFar = std::min(tFar, std::max(t0, t1));
+    }
+    return tNear <= tFar ? tNear : 0.0;
+  }
+
+  std::vector<Math::AABB> randomBoxes(std::mt19937 &random, std::size_t count) {
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> size(0.1f, 3.0f);
+    std::vector<Math::AABB> boxes;
+    for (std::size_t i = 0; i < count; i++) {
+      Math::Point3D min(position(random), position(random), position(random));
+      boxes.emplace_back(min, min + Math::Vector3D(size(random), size(random),
+                                                   size(random)));
+    }
+    return boxes;
+  }
+
+  // Distance to the closest box entered by a ray, 0 if it misses them all.
+  double closest(const Raytracer::Ray &ray,
+                 const std::vector<Math::AABB> &boxes) {
+    double expected = 0.0;
+    for (const auto &box : boxes) {
+      double t = enter(ray, box, ray.tMax);
+      if (t > 0.0 && (expected == 0.0 || t < expected))
+        expected = t;
+    }
+    return expected;
+  }
+
+  // Checks that the BVH finds the same closest box as a linear scan.
+  void expectSameHits(const Raytracer::BVH &bvh,
+                      const std::vector<Math::AABB> &boxes,
+                      std::mt19937 &random) {
+    std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+    for (int i = 0; i < 500; i++) {
+      Math::Vector3D direction(coordinate(random), coordinate(random),
+                               coordinate(random));
+      Raytracer::Ray ray(Math::Point3D(0, 0, 0), direction.normalized());
+
+      double expected = closest(ray, boxes);
+      double found = 0.0;
+      bvh.traverse(ray, [&](std::uint32_t index, double &tMax) {
+        double t = enter(ray, boxes[index], tMax);
+        if (t > 0.0) {
+          tMax = t;
+          found = t;
+        }
+      });
+      EXPECT_NEAR(found, expected, 1e-4) << "ray " << i;
+    }
+  }
+
+  // Runs the tasks of a build on threads of their own.
+  void threadedFor(std::size_t count,
+                   const std::function<void(std::size_t)> &fn) {
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < count; i++)
+      threads.emplace_back(fn, i);
+    for (auto &thread : threads)
+      thread.join();
+  }
+
+}  // namespace
+
+TEST(BVHTest, FindsTheClosestPrimitive) {
+    std::mt19937 random(7);
+    std::vector<Math::AABB> boxes = randomBoxes(random, 2000);
+    Raytracer::BVH bvh;
+
+    bvh.build(boxes);
+    expectSameHits(bvh, boxes, random);
+}
+
+TEST(BVHTest, FindsTheClosestPrimitiveAfterRefit) {
+    std::mt19937 random(11);
+    std::vector<Math::AABB> boxes = randomBoxes(random, 500);
+    Raytracer::BVH bvh;
+
+    bvh.build(boxes);
+    for (auto &box : boxes)
+      box = Math::AABB(box.min + Math::Vector3D(5, -3, 1),
+                       box.max + Math::Vector3D(5, -3, 1));
+    bvh.refit(boxes);
+    expectSameHits(bvh, boxes, random);
+}
+
+TEST(AABBTest, BoundsADiscTightly) {
+    Math::AABB flat;
+    flat.expandDisc(Math::Point3D(1, 2, 3), Math::Vector3D(0, 1, 0), 2.0);
+    EXPECT_FLOAT_EQ(flat.min.x, -1.0f);
+    EXPECT_FLOAT_EQ(flat.max.x, 3.0f);
+    EXPECT_FLOAT_EQ(flat.min.y, 2.0f);
+    EXPECT_FLOAT_EQ(flat.max.y, 2.0f);
+    EXPECT_FLOAT_EQ(flat.max.z, 5.0f);
+
+    Math::AABB tilted;
+    Math::Vector3D normal = Math::Vector3D(1, 1, 0).normalized();
+    tilted.expandDisc(Math::Point3D(0, 0, 0), normal, 1.0);
+    EXPECT_NEAR(tilted.max.x, std::sqrt(0.5), 1e-6);
+    EXPECT_NEAR(tilted.max.y, std::sqrt(0.5), 1e-6);
+    EXPECT_NEAR(tilted.max.z, 1.0, 1e-6);
+}
+
+TEST(BVHTest, HandlesASingleLeaf) {
+    std::mt19937 random(3);
+    std::vector<Math::AABB> boxes = randomBoxes(random, 3);
+    Raytracer::BVH bvh;
+
+    bvh.build(boxes);
+    expectSameHits(bvh, boxes, random);
+}
+
+TEST(BVHTest, FindsTheClosestPrimitiveWithEveryPreset) {
+    std::mt19937 random(5);
+    std::vector<Math::AABB> boxes = randomBoxes(random, 40000);
+
+    for (int i = 0; i < Raytracer::BVH::QualityCount; i++) {
+      auto quality = static_cast<Raytracer::BVH::Quality>(i);
+      Raytracer::BVH bvh;
+      bvh.build(boxes, quality, threadedFor);
+      EXPECT_EQ(bvh.getIndices().size(), boxes.size())
+          << Raytracer::BVH::qualityName(quality);
+      expectSameHits(bvh, boxes, random);
+    }
+}
+
+TEST(BVHTest, ParsesPresetNames) {
+    EXPECT_EQ(Raytracer::BVH::parseQuality("fast"),
+              Raytracer::BVH::QualityFast);
+    EXPECT_EQ(Raytracer::BVH::parseQuality("sah"), Raytracer::BVH::QualitySah);
+    EXPECT_THROW(Raytracer::BVH::parseQuality("best"), Raytracer::RaytracerError);
+}
+
+TEST(BVHTest, KeepsItsQualityWhenEverythingMovesTogether) {
+    std::mt19937 random(13);
+    std::vector<Math::AABB> boxes = randomBoxes(random, 1000);
+    Raytracer::BVH bvh;
+
+    bvh.build(boxes);
+    EXPECT_DOUBLE_EQ(bvh.getDegradation(), 1.0);
+    for (auto &box : boxes)
+      box = Math::AABB(box.min + Math::Vector3D(20, 0, -7),
+                       box.max + Math::Vector3D(20, 0, -7));
+    bvh.refit(boxes);
+    EXPECT_NEAR(bvh.getDegradation(), 1.0, 1e-3);
+}
+
+TEST(BVHTest, DegradesWhenPrimitivesScatter) {
+    std::mt19937 random(17);
+    std::vector<Math::AABB> boxes = randomBoxes(random, 1000);
+    Raytracer::BVH bvh;
+
+    bvh.build(boxes);
+    std::shuffle(boxes.begin(), boxes.end(), random);
+    bvh.refit(boxes);
+    EXPECT_GT(bvh.getDegradation(), 2.0);
+    expectSameHits(bvh, boxes, random);
+
+    bvh.build(boxes);
+    EXPECT_DOUBLE_EQ(bvh.getDegradation(), 1.0);
+}
+
+TEST(BVHTest, FindsTheClosestPrimitiveWithPackets) {
+    std::mt19937 random(19);
+    std::vector<Math::AABB> boxes = randomBoxes(random, 2000);
+    std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+    Raytracer::BVH bvh;
+
+    bvh.build(boxes);
+    // Even packets are coherent, odd ones scatter in every direction.
+    for (int p = 0; p < 60; p++) {
+      Math::Vector3D base(coordinate(random), coordinate(random),
+                          coordinate(random));
+      Raytracer::RayPacket packet;
+      for (int i = 0; i < Raytracer::RayPacket::size; i++) {
+        Math::Vector3D spread(coordinate(random), coordinate(random),
+                              coordinate(random));
+        Math::Vector3D direction = p % 2 ? spread : base + spread * 0.05f;
+        packet.set(i, Raytracer::Ray(Math::Point3D(0, 0, 0),
+                                     direction.normalized()));
+      }
+      std::uint32_t mask = 0xFFFF & ~(1u << (p % Raytracer::RayPacket::size));
+      double found[Raytracer::RayPacket::size] = {};
+      bvh.traversePacket(packet, mask, [&](std::uint32_t index,
+                                           std::uint32_t rays) {
+        for (int i = 0; i < Raytracer::RayPacket::size; i++) {
+          if (!(rays & (1u << i)))
+            continue;
+          double t = enter(packet.ray(i), boxes[index], packet.tMax[i]);
+          if (t > 0.0) {
+            packet.tMax[i] = static_cast<float>(t);
+            found[i] = t;
+          }
+        }
+      });
+      for (int i = 0; i < Raytracer::RayPacket::size; i++) {
+        double expected = mask & (1u << i) ? closest(packet.ray(i), boxes)
+                                           : 0.0;
+        EXPECT_NEAR(found[i], expected, 1e-4) << "packet " << p << " ray " << i;
+      }
+    }
+}
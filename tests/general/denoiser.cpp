@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "Denoiser.hpp"
+
+namespace {
+
+  constexpr int width = 64;
+  constexpr int height = 48;
+  constexpr std::size_t size = static_cast<std::size_t>(width) * height;
+
+  // Guide buffers of a flat white wall facing the camera.
+  struct Wall {
+    std::vector<Math::Vector3D> normals =
+        std::vector<Math::Vector3D>(size, Math::Vector3D(0, 0, 1));
+    std::vector<float> depths = std::vector<float>(size, 10.0f);
+    std::vector<Math::Vector3D> albedo =
+        std::vector<Math::Vector3D>(size, Math::Vector3D(1, 1, 1));
+
+    Raytracer::Denoiser::Guides guides() const {
+      return {normals, depths, albedo};
+    }
+  };
+
+  double meanSquaredError(const std::vector<Math::Vector3D> &image,
+                          double expected) {
+    double sum = 0.0;
+    for (const auto &color : image)
+      sum += (color.x - expected) * (color.x - expected);
+    return sum / image.size();
+  }
+
+}  // namespace
+
+TEST(DenoiserTest, SmoothsNoiseOnAFlatSurface) {
+    Wall wall;
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> noise(-0.2f, 0.2f);
+    std::vector<Math::Vector3D> image(size);
+    for (auto &color : image) {
+      float value = 0.5f + noise(random);
+      color = Math::Vector3D(value, value, value);
+    }
+    double before = meanSquaredError(image, 0.5);
+
+    Raytracer::Denoiser().filter(image, wall.guides(), width, height);
+    EXPECT_LT(meanSquaredError(image, 0.5), before / 10);
+}
+
+TEST(DenoiserTest, KeepsEdgesBetweenSurfaces) {
+    Wall wall;
+    std::vector<Math::Vector3D> image(size);
+    for (std::size_t k = 0; k < size; k++) {
+      bool left = static_cast<int>(k % width) < width / 2;
+      bool sky = static_cast<int>(k / width) < height / 2;
+      float value = sky ? 0.5f : left ? 0.4f : 0.6f;
+      image[k] = Math::Vector3D(value, value, value);
+      if (!left)
+        wall.normals[k] = Math::Vector3D(1, 0, 0);
+      if (sky)
+        wall.depths[k] = 0.0f;
+    }
+    std::vector<Math::Vector3D> expected = image;
+
+    Raytracer::Denoiser().filter(image, wall.guides(), width, height);
+    for (std::size_t k = 0; k < size; k++)
+      EXPECT_NEAR(image[k].x, expected[k].x, 1e-4) << "pixel " << k;
+}
+
+TEST(DenoiserTest, KeepsTextures) {
+    Wall wall;
+    std::vector<Math::Vector3D> image(size);
+    for (std::size_t k = 0; k < size; k++) {
+      bool dark = ((k % width) / 4 + (k / width) / 4) % 2;
+      wall.albedo[k] = dark ? Math::Vector3D(0.1, 0.2, 0.3)
+                            : Math::Vector3D(0.9, 0.8, 0.7);
+      image[k] = wall.albedo[k] * 0.5;
+    }
+    std::vector<Math::Vector3D> expected = image;
+
+    Raytracer::Denoiser().filter(image, wall.guides(), width, height);
+    for (std::size_t k = 0; k < size; k++)
+      EXPECT_NEAR(image[k].z, expected[k].z, 1e-4) << "pixel " << k;
+}
@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+#include "DynamicResolution.hpp"
+
+namespace {
+
+  // Frame time of a scene costing `fullMs` at full resolution.
+  double frameMs(double fullMs, double scale) {
+    return fullMs * scale * scale;
+  }
+
+}  // namespace
+
+TEST(DynamicResolutionTest, ConvergesToTheBudget) {
+    Raytracer::DynamicResolution resolution(16.0);
+
+    for (int i = 0; i < 30; i++)
+      resolution.update(frameMs(64.0, resolution.getScale()));
+    EXPECT_NEAR(resolution.getScale(), 0.5, 0.01);
+    EXPECT_NEAR(frameMs(64.0, resolution.getScale()), 16.0, 0.5);
+}
+
+TEST(DynamicResolutionTest, StaysWithinBounds) {
+    Raytracer::DynamicResolution resolution(16.0, 0.25, 1.0);
+
+    for (int i = 0; i < 30; i++)
+      resolution.update(frameMs(4.0, resolution.getScale()));
+    EXPECT_DOUBLE_EQ(resolution.getScale(), 1.0);
+    for (int i = 0; i < 30; i++)
+      resolution.update(frameMs(10000.0, resolution.getScale()));
+    EXPECT_DOUBLE_EQ(resolution.getScale(), 0.25);
+}
+
+TEST(DynamicResolutionTest, IgnoresEmptyFrames) {
+    Raytracer::DynamicResolution resolution(16.0);
+    double scale = resolution.getScale();
+
+    resolution.update(0.0);
+    EXPECT_DOUBLE_EQ(resolution.getScale(), scale);
+}
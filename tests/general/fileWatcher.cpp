@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include "FileWatcher.hpp"
+
+class FileWatcherTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      _dir = std::filesystem::temp_directory_path() / "raytracer_watcher";
+      std::filesystem::remove_all(_dir);
+      std::filesystem::create_directories(_dir);
+      _file = (_dir / "scene.cfg").string();
+      std::ofstream(_file) << "camera : {};\n";
+    }
+
+    void TearDown() override {
+      std::filesystem::remove_all(_dir);
+    }
+
+    // Waits long enough for the watcher to settle, or for a change.
+    static bool changed(Raytracer::FileWatcher &watcher) {
+      for (int i = 0; i < 40; i++) {
+        if (watcher.poll())
+          return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(25));
+      }
+      return false;
+    }
+
+    std::filesystem::path _dir;
+    std::string _file;
+};
+
+TEST_F(FileWatcherTest, ReportsChangeOfWatchedFile) {
+    Raytracer::FileWatcher watcher(std::chrono::milliseconds(20));
+    watcher.watch({_file});
+
+    std::ofstream(_file, std::ios::app) << "lights : {};\n";
+    EXPECT_TRUE(changed(watcher));
+    EXPECT_FALSE(watcher.poll());
+}
+
+TEST_F(FileWatcherTest, IgnoresOtherFilesOfTheDirectory) {
+    Raytracer::FileWatcher watcher(std::chrono::milliseconds(20));
+    watcher.watch({_file});
+
+    std::ofstream(_dir / "scene.cfg.cache") << "cache";
+    EXPECT_FALSE(changed(watcher));
+}
+
+TEST_F(FileWatcherTest, CoalescesBurstsOfWrites) {
+    Raytracer::FileWatcher watcher(std::chrono::milliseconds(200));
+    watcher.watch({_file});
+
+    for (int i = 0; i < 5; i++) {
+      std::ofstream(_file, std::ios::app) << "# edit " << i << "\n";
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(changed(watcher));
+    EXPECT_FALSE(changed(watcher));
+}
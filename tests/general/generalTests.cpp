@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <filesystem>
+#include <limits>
 #include "ParserConfigFile.hpp"
 #include "exceptions/RaytracerException.hpp"
 
@@ -37,3 +38,47 @@ TEST_F(ParserConfigFileTest, NegativeColorValue) {
 
   EXPECT_THROW(parser.parseConfigFile(camera, sc, lc), Raytracer::ParseError);
 }
+
+TEST_F(ParserConfigFileTest, PluginsExportTheirEntryPoints) {
+  Raytracer::Factory factory;
+  factory.initFactories(_plugins);
+  auto sphere = factory.create<Raytracer::IShape>("sphere");
+  auto light = factory.create<Raytracer::ILight>("point");
+  auto material = factory.create<Raytracer::IMaterials>("reflection");
+  ASSERT_NE(sphere, nullptr);
+  ASSERT_NE(light, nullptr);
+  ASSERT_NE(material, nullptr);
+  EXPECT_NE(Raytracer::Factory::getShapeAbi(*sphere), nullptr);
+  EXPECT_NE(Raytracer::Factory::getLightAbi(*light), nullptr);
+  EXPECT_NE(Raytracer::Factory::getMaterialAbi(*material), nullptr);
+}
+
+TEST_F(ParserConfigFileTest, PluginsWithoutEntryPointsStillWork) {
+  Raytracer::Factory factory;
+  ASSERT_NO_THROW(factory.initFactories({LEGACY_SHAPE_PLUGIN}));
+  auto shape = factory.create<Raytracer::IShape>("legacyShape");
+  ASSERT_NE(shape, nullptr);
+  EXPECT_EQ(Raytracer::Factory::getShapeAbi(*shape), nullptr);
+  shape->setCenter(Math::Point3D(0, 0, -5));
+
+  Raytracer::ShapeComposite sc;
+  sc.addShape(shape);
+  sc.build();
+  EXPECT_TRUE(sc.getBounds().isInfinite());
+
+  Raytracer::RayPacket packet;
+  for (int i = 0; i < Raytracer::RayPacket::size; i++) {
+    Math::Vector3D direction(i % 4 * 0.05 - 0.075, i / 4 * 0.05 - 0.075, -1);
+    packet.set(i, Raytracer::Ray(Math::Point3D(0, 0, 0),
+                                 direction.normalized()));
+  }
+  sc.hitsPacket(packet, 0xFFFF);
+  for (int i = 0; i < Raytracer::RayPacket::size; i++) {
+    Raytracer::Ray ray = packet.ray(i);
+    ray.tMax = std::numeric_limits<double>::infinity();
+    auto [t, color, hit] = sc.hits(ray);
+    ASSERT_EQ(hit, shape.get()) << "ray " << i;
+    EXPECT_EQ(packet.shape[i], hit) << "ray " << i;
+    EXPECT_FLOAT_EQ(packet.tMax[i], t) << "ray " << i;
+  }
+}
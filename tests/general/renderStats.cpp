@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "RenderStats.hpp"
+
+TEST(RenderStatsTest, TotalSumsEveryThread) {
+    using Raytracer::RayStats;
+    auto before = Raytracer::RenderStats::total();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+      threads.emplace_back([] {
+        RayStats &stats = Raytracer::RenderStats::local();
+        for (int j = 0; j < 1000; j++)
+          stats.add(RayStats::ShadowRays);
+        stats.add(RayStats::BvhNodes, 10);
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+
+    auto frame = Raytracer::RenderStats::total() - before;
+    EXPECT_EQ(frame[RayStats::ShadowRays], 4000u);
+    EXPECT_EQ(frame[RayStats::BvhNodes], 40u);
+    EXPECT_EQ(frame[RayStats::PrimaryRays], 0u);
+    EXPECT_EQ(frame.rays(), 4000u);
+}
+
+TEST(RenderStatsTest, LocalIsStablePerThread) {
+    Raytracer::RayStats *main = &Raytracer::RenderStats::local();
+    Raytracer::RayStats *other = nullptr;
+
+    EXPECT_EQ(main, &Raytracer::RenderStats::local());
+    std::thread([&] { other = &Raytracer::RenderStats::local(); }).join();
+    EXPECT_NE(main, other);
+}
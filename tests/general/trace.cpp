@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "Trace.hpp"
+
+namespace {
+
+  std::string readFile(const std::filesystem::path &path) {
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+  }
+
+}  // namespace
+
+TEST(TraceTest, WritesCompleteEventsPerThread) {
+    auto path = std::filesystem::temp_directory_path() / "raytracer_trace.json";
+    std::filesystem::remove(path);
+
+    Raytracer::Trace::start(path.string());
+    EXPECT_TRUE(Raytracer::Trace::enabled());
+    { Raytracer::Trace::Scope scope("outer", "test", "a \"quoted\" path"); }
+    std::thread([] { Raytracer::Trace::Scope scope("worker", "test"); }).join();
+    Raytracer::Trace::stop();
+    EXPECT_FALSE(Raytracer::Trace::enabled());
+
+    std::string json = readFile(path);
+    EXPECT_NE(json.find("\"traceEvents\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\": \"outer\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\": \"worker\""), std::string::npos);
+    EXPECT_NE(json.find("a \\\"quoted\\\" path"), std::string::npos);
+    EXPECT_NE(json.find("\"thread_name\""), std::string::npos);
+    std::filesystem::remove(path);
+}
+
+TEST(TraceTest, NothingIsRecordedWhenStopped) {
+    auto path = std::filesystem::temp_directory_path() / "raytracer_trace.json";
+    std::filesystem::remove(path);
+
+    { Raytracer::Trace::Scope scope("ignored", "test"); }
+    Raytracer::Trace::stop();
+    EXPECT_FALSE(std::filesystem::exists(path));
+}
@@ -40,3 +40,34 @@ TEST_F(ParserConfigFileTest, TestParseLights) {
 
   EXPECT_EQ(lc.getLights().size(), 3);
 }
+
+TEST_F(ParserConfigFileTest, TestLightingWithTracedShadows) {
+  _cfgFile = "tests/lights/parseLights.cfg";
+  Raytracer::ParserConfigFile parser(_cfgFile, _plugins);
+  Raytracer::Camera camera;
+  Raytracer::ShapeComposite sc;
+  Raytracer::LightComposite lc;
+
+  parser.parseConfigFile(camera, sc, lc);
+  Math::Vector3D normal(0, 1, 0);
+  Math::Vector3D color(0.8, 0.4, 0.2);
+  Math::Point3D hitPoint(1, -1, 2);
+  Math::Vector3D viewDir(0, 1, -1);
+  std::vector<unsigned char> lit(lc.getShadingOrder().size(), 0);
+  std::vector<unsigned char> dark(lc.getShadingOrder().size(), 1);
+
+  Math::Vector3D expected =
+      lc.computeLighting(normal, color, hitPoint, viewDir, sc);
+  Math::Vector3D traced =
+      lc.computeLighting(normal, color, hitPoint, viewDir, lit.data(), sc);
+  EXPECT_DOUBLE_EQ(traced.x, expected.x);
+  EXPECT_DOUBLE_EQ(traced.y, expected.y);
+  EXPECT_DOUBLE_EQ(traced.z, expected.z);
+
+  expected = lc.computeDirectLighting(normal, color, hitPoint, viewDir, true);
+  traced =
+      lc.computeLighting(normal, color, hitPoint, viewDir, dark.data(), sc);
+  EXPECT_DOUBLE_EQ(traced.x, expected.x);
+  EXPECT_DOUBLE_EQ(traced.y, expected.y);
+  EXPECT_DOUBLE_EQ(traced.z, expected.z);
+}
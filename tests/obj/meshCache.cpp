@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "Instance.hpp"
+#include "ParserConfigFile.hpp"
+#include "exceptions/RaytracerException.hpp"
+
+class ParserConfigFileTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      for (const auto& entry :
+           std::filesystem::directory_iterator("./plugins")) {
+        if (entry.is_regular_file() && entry.path().extension() == ".so") {
+          _plugins.push_back(entry.path().string());
+        }
+      }
+    }
+
+    void TearDown() override {
+    }
+
+    libconfig::Config _cfg;
+    std::string _cfgFile;
+    std::vector<std::string> _plugins;
+};
+
+TEST_F(ParserConfigFileTest, ObjectsShareCachedMesh) {
+    Raytracer::ParserConfigFile parser("tests/obj/instances.cfg", _plugins);
+    Raytracer::ShapeComposite sc;
+    Raytracer::LightComposite lc;
+
+    ASSERT_NO_THROW(parser.parseConfigFile(sc, lc));
+    ASSERT_EQ(sc.getShapes().size(), 3);
+
+    auto first = std::static_pointer_cast<Raytracer::Instance>(sc.getShapes()[0]);
+    auto second = std::static_pointer_cast<Raytracer::Instance>(sc.getShapes()[1]);
+    auto third = std::static_pointer_cast<Raytracer::Instance>(sc.getShapes()[2]);
+    ASSERT_NE(first->getPrototype(), nullptr);
+    EXPECT_EQ(first->getPrototype(), second->getPrototype());
+    EXPECT_EQ(first->getPrototype(), third->getPrototype());
+}
+
+TEST_F(ParserConfigFileTest, InstancesApplyTheirTransform) {
+    Raytracer::ParserConfigFile parser("tests/obj/instances.cfg", _plugins);
+    Raytracer::ShapeComposite sc;
+    Raytracer::LightComposite lc;
+
+    ASSERT_NO_THROW(parser.parseConfigFile(sc, lc));
+    ASSERT_EQ(sc.getShapes().size(), 3);
+
+    // Unit cube spanning x [0, 1], y [1, 2], z [0, 1].
+    Raytracer::Ray down(Math::Point3D(0.5, 10, 0.5), Math::Vector3D(0, -1, 0));
+    auto [t, color, shape] = sc.getShapes()[0]->hits(down);
+    EXPECT_NEAR(t, 8.0, 1e-4);
+    EXPECT_EQ(shape, sc.getShapes()[0].get());
+
+    // Scaled by 2 then moved: x [5, 7], y [2, 4], z [0, 2].
+    Raytracer::Ray scaled(Math::Point3D(6.5, 10, 1.5), Math::Vector3D(0, -1, 0));
+    auto [t2, color2, shape2] = sc.getShapes()[1]->hits(scaled);
+    EXPECT_NEAR(t2, 6.0, 1e-4);
+    EXPECT_EQ(shape2, sc.getShapes()[1].get());
+    auto [t3, color3, shape3] = sc.getShapes()[0]->hits(scaled);
+    EXPECT_EQ(t3, 0.0);
+
+    // Rotated 90 degrees around Y then moved: x [-5, -4], z [-1, 0].
+    Raytracer::Ray rotated(Math::Point3D(-4.5, 10, -0.5), Math::Vector3D(0, -1, 0));
+    auto [t4, color4, shape4] = sc.getShapes()[2]->hits(rotated);
+    EXPECT_NEAR(t4, 8.0, 1e-4);
+    EXPECT_EQ(shape4, sc.getShapes()[2].get());
+}
+
+TEST_F(ParserConfigFileTest, TopLevelBuildAndRefit) {
+    Raytracer::ParserConfigFile parser("tests/obj/instances.cfg", _plugins);
+    Raytracer::ShapeComposite sc;
+    Raytracer::LightComposite lc;
+
+    ASSERT_NO_THROW(parser.parseConfigFile(sc, lc));
+    Raytracer::Ray down(Math::Point3D(6.5, 10, 1.5), Math::Vector3D(0, -1, 0));
+    auto [linearT, linearColor, linearShape] = sc.hits(down);
+
+    sc.build();
+    auto [t, color, shape] = sc.hits(down);
+    EXPECT_NEAR(t, linearT, 1e-6);
+    EXPECT_EQ(shape, linearShape);
+    EXPECT_EQ(shape, sc.getShapes()[1].get());
+
+    Math::AABB bounds = sc.getBounds();
+    EXPECT_NEAR(bounds.min.x, -5.0, 1e-4);
+    EXPECT_NEAR(bounds.max.x, 7.0, 1e-4);
+    EXPECT_NEAR(bounds.max.y, 4.0, 1e-4);
+
+    sc.translate(Math::Vector3D(0, 0, 10));
+    auto [movedT, movedColor, movedShape] = sc.hits(down);
+    EXPECT_EQ(movedShape, nullptr);
+    Raytracer::Ray moved(Math::Point3D(6.5, 10, 11.5), Math::Vector3D(0, -1, 0));
+    auto [t2, color2, shape2] = sc.hits(moved);
+    EXPECT_NEAR(t2, 6.0, 1e-4);
+    EXPECT_EQ(shape2, sc.getShapes()[1].get());
+}
+
+TEST_F(ParserConfigFileTest, HitsStayWithinTheRayInterval) {
+    Raytracer::ParserConfigFile parser("tests/obj/instances.cfg", _plugins);
+    Raytracer::ShapeComposite sc;
+    Raytracer::LightComposite lc;
+
+    ASSERT_NO_THROW(parser.parseConfigFile(sc, lc));
+    sc.build();
+
+    // Second cube: x [5, 7], y [2, 4], z [0, 2].
+    Raytracer::Ray far(Math::Point3D(6.5, 500, 1.5), Math::Vector3D(0, -1, 0));
+    EXPECT_NEAR(std::get<0>(sc.hits(far)), 496.0, 1e-3);
+
+    Raytracer::Ray short_(Math::Point3D(6.5, 10, 1.5), Math::Vector3D(0, -1, 0),
+                          Raytracer::Ray::Primary, 0.0, 5.0);
+    EXPECT_EQ(std::get<2>(sc.hits(short_)), nullptr);
+
+    Raytracer::Ray inside(Math::Point3D(6.5, 10, 1.5), Math::Vector3D(0, -1, 0),
+                          Raytracer::Ray::Primary, 7.0);
+    auto [t, color, shape] = sc.hits(inside);
+    EXPECT_NEAR(t, 8.0, 1e-4);
+    EXPECT_EQ(shape, sc.getShapes()[1].get());
+}
+
+TEST_F(ParserConfigFileTest, InstancePacketsMatchSingleRays) {
+    Raytracer::ParserConfigFile parser("tests/obj/instances.cfg", _plugins);
+    Raytracer::ShapeComposite sc;
+    Raytracer::LightComposite lc;
+
+    ASSERT_NO_THROW(parser.parseConfigFile(sc, lc));
+    sc.build();
+    // Packets of parallel rays falling on a grid over the three cubes.
+    for (int p = 0; p < 16; p++) {
+      Raytracer::RayPacket packet;
+      for (int i = 0; i < Raytracer::RayPacket::size; i++) {
+        float x = ((p % 4) * 4 + i % 4) - 6.0f;
+        float z = ((p / 4) * 4 + i / 4) / 4.0f - 1.5f;
+        packet.set(i, Raytracer::Ray(Math::Point3D(x + 0.3f, 10, z),
+                                     Math::Vector3D(0, -1, 0)));
+      }
+      sc.hitsPacket(packet, 0xFFFF);
+      for (int i = 0; i < Raytracer::RayPacket::size; i++) {
+        auto [t, color, shape] =
+            sc.hits(Raytracer::Ray(Math::Point3D(packet.originX[i], 10,
+                                                 packet.originZ[i]),
+                                   Math::Vector3D(0, -1, 0)));
+        EXPECT_EQ(packet.shape[i], shape) << "packet " << p << " ray " << i;
+        if (shape) {
+          EXPECT_NEAR(packet.tMax[i], t, 1e-4);
+        }
+      }
+    }
+}
+
+TEST_F(ParserConfigFileTest, ObjectZeroScale) {
+    Raytracer::ParserConfigFile parser("tests/obj/zeroScale.cfg", _plugins);
+    Raytracer::ShapeComposite sc;
+    Raytracer::LightComposite lc;
+
+    EXPECT_THROW(parser.parseConfigFile(sc, lc), Raytracer::ParseError);
+}
@@ -55,7 +55,8 @@ TEST_F(ParserConfigFileTest, ParseValidObjFileWithMaterials) {
     EXPECT_EQ(object.getFaces()[0].normal[0], 1);
     EXPECT_EQ(object.getFaces()[0].normal[1], 1);
     EXPECT_EQ(object.getFaces()[0].normal[2], 1);
-    EXPECT_EQ(object.getFaces()[0].material_name, "red");
+    ASSERT_GE(object.getFaces()[0].material, 0);
+    EXPECT_EQ(object.getMaterials()[object.getFaces()[0].material].name, "red");
 
     ASSERT_EQ(object.getFaces()[10].vertex.size(), 3);
     EXPECT_EQ(object.getFaces()[10].vertex[0], 1);
@@ -66,12 +67,13 @@ TEST_F(ParserConfigFileTest, ParseValidObjFileWithMaterials) {
     EXPECT_EQ(object.getFaces()[10].normal[0], 0);
     EXPECT_EQ(object.getFaces()[10].normal[1], 0);
     EXPECT_EQ(object.getFaces()[10].normal[2], 0);
-    EXPECT_EQ(object.getFaces()[10].material_name, "red");
+    ASSERT_GE(object.getFaces()[10].material, 0);
+    EXPECT_EQ(object.getMaterials()[object.getFaces()[10].material].name, "red");
 
     ASSERT_FALSE(object.getMaterials().empty());
 
-    ASSERT_NE(object.getMaterials().find("red"), object.getMaterials().end());
-    const auto& redMaterial = object.getMaterials().at("red");
+    ASSERT_NE(object.findMaterial("red"), -1);
+    const auto& redMaterial = object.getMaterials()[object.findMaterial("red")];
     EXPECT_NEAR(redMaterial.ambient.x, 0.4449, 1e-5);
     EXPECT_NEAR(redMaterial.ambient.y, 0.0, 1e-5);
     EXPECT_NEAR(redMaterial.ambient.z, 0.0, 1e-5);
@@ -85,8 +87,8 @@ TEST_F(ParserConfigFileTest, ParseValidObjFileWithMaterials) {
     EXPECT_EQ(redMaterial.illumination, 2);
     EXPECT_NEAR(redMaterial.transparency, 1.0, 1e-5);
 
-    ASSERT_NE(object.getMaterials().find("white"), object.getMaterials().end());
-    const auto& whiteMaterial = object.getMaterials().at("white");
+    ASSERT_NE(object.findMaterial("white"), -1);
+    const auto& whiteMaterial = object.getMaterials()[object.findMaterial("white")];
     EXPECT_NEAR(whiteMaterial.ambient.x, 0.4000, 1e-5);
     EXPECT_NEAR(whiteMaterial.diffuse.x, 1.0000, 1e-5);
     EXPECT_NEAR(whiteMaterial.specular.x, 0.3000, 1e-5);
@@ -102,3 +104,21 @@ TEST_F(ParserConfigFileTest, ParseObjFileNotFound) {
 
     EXPECT_THROW(parser.parseObj(objPath, object), std::runtime_error);
 }
+
+TEST_F(ParserConfigFileTest, ParseObjRelativeIndicesAndPolygons) {
+    Raytracer::ParserConfigFile parser("tests/obj/dummy.cfg", _plugins);
+    Raytracer::Object object;
+
+    ASSERT_NO_THROW(parser.parseObj("tests/obj/quad.obj", object));
+
+    ASSERT_EQ(object.getVertices().size(), 4);
+    ASSERT_EQ(object.getFaces().size(), 2);
+    EXPECT_EQ(object.getFaces()[0].vertex[0], 0);
+    EXPECT_EQ(object.getFaces()[0].vertex[1], 1);
+    EXPECT_EQ(object.getFaces()[0].vertex[2], 2);
+    EXPECT_EQ(object.getFaces()[1].vertex[0], 0);
+    EXPECT_EQ(object.getFaces()[1].vertex[1], 2);
+    EXPECT_EQ(object.getFaces()[1].vertex[2], 3);
+    EXPECT_EQ(object.getFaces()[1].normal[0], -1);
+    EXPECT_EQ(object.getFaces()[1].material, -1);
+}
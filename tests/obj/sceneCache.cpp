@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include "Instance.hpp"
+#include "ParserConfigFile.hpp"
+#include "SceneCache.hpp"
+
+class SceneCacheTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      for (const auto& entry :
+           std::filesystem::directory_iterator("./plugins")) {
+        if (entry.is_regular_file() && entry.path().extension() == ".so") {
+          _plugins.push_back(entry.path().string());
+        }
+      }
+      _dir = std::filesystem::temp_directory_path() / "raytracer_scene_cache";
+      std::filesystem::remove_all(_dir);
+      std::filesystem::create_directories(_dir);
+      std::filesystem::copy_file("tests/obj/cube.obj", _dir / "cube.obj");
+      std::filesystem::copy_file("tests/obj/cube.mtl", _dir / "cube.mtl");
+      _cfgFile = (_dir / "scene.cfg").string();
+      std::ofstream(_cfgFile)
+          << "camera : { resolution = { width = 10; height = 10; };\n"
+          << "  position = { x = 0; y = 0; z = 0; };\n"
+          << "  rotation = { x = 0; y = 0; z = 0; };\n"
+          << "  fieldOfView = 45.0; };\n"
+          << "primitives : { objects = ( { obj_file = \""
+          << (_dir / "cube.obj").string() << "\"; } ); };\n";
+    }
+
+    void TearDown() override {
+      std::filesystem::remove_all(_dir);
+    }
+
+    libconfig::Config _cfg;
+    std::string _cfgFile;
+    std::vector<std::string> _plugins;
+    std::filesystem::path _dir;
+};
+
+TEST_F(SceneCacheTest, SceneCacheRoundTrip) {
+    Raytracer::Camera camera;
+    Raytracer::ShapeComposite sc;
+    Raytracer::LightComposite lc;
+    Raytracer::ParserConfigFile parser(_cfgFile, _plugins);
+    ASSERT_NO_THROW(parser.parseConfigFile(camera, sc, lc));
+    ASSERT_TRUE(std::filesystem::exists(
+        Raytracer::SceneCache::pathFor(_cfgFile)));
+    auto parsed = std::static_pointer_cast<Raytracer::Instance>(
+        sc.getShapes()[0])->getPrototype();
+    auto original = std::static_pointer_cast<const Raytracer::Object>(parsed);
+
+    Raytracer::Factory factory;
+    factory.initFactories(_plugins);
+    auto create = [&]() { return factory.create<Raytracer::Object>("object"); };
+    Raytracer::SceneCache cache(_cfgFile);
+    std::vector<std::string> sources;
+    ASSERT_EQ(cache.size(), 1);
+    auto cached = cache.find((_dir / "cube.obj").string(), create, sources);
+    ASSERT_NE(cached, nullptr);
+    EXPECT_EQ(sources.size(), 2);
+
+    EXPECT_EQ(cached->getVertices().size(), original->getVertices().size());
+    EXPECT_EQ(cached->getNormals().size(), original->getNormals().size());
+    ASSERT_EQ(cached->getFaces().size(), original->getFaces().size());
+    EXPECT_EQ(cached->getFaces()[3].vertex, original->getFaces()[3].vertex);
+    EXPECT_EQ(cached->getFaces()[3].material, original->getFaces()[3].material);
+    ASSERT_EQ(cached->getMaterials().size(), original->getMaterials().size());
+    EXPECT_EQ(cached->getMaterials()[0].name, original->getMaterials()[0].name);
+    EXPECT_EQ(cached->getAccel().getNodes().size(),
+              original->getAccel().getNodes().size());
+
+    Raytracer::Ray ray(Math::Point3D(0.5, 1.5, -5), Math::Vector3D(0, 0, 1));
+    EXPECT_DOUBLE_EQ(std::get<0>(cached->hits(ray)),
+                     std::get<0>(original->hits(ray)));
+}
+
+TEST_F(SceneCacheTest, SceneCacheInvalidatedByDependency) {
+    Raytracer::Camera camera;
+    Raytracer::ShapeComposite sc;
+    Raytracer::LightComposite lc;
+    Raytracer::ParserConfigFile parser(_cfgFile, _plugins);
+    ASSERT_NO_THROW(parser.parseConfigFile(camera, sc, lc));
+
+    Raytracer::Factory factory;
+    factory.initFactories(_plugins);
+    auto create = [&]() { return factory.create<Raytracer::Object>("object"); };
+    std::ofstream(_dir / "cube.obj", std::ios::app) << "\n# edited\n";
+
+    Raytracer::SceneCache cache(_cfgFile);
+    std::vector<std::string> sources;
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.find((_dir / "cube.obj").string(), create, sources),
+              nullptr);
+}
+
+class SceneCacheSceneTest : public SceneCacheTest {
+  protected:
+    void SetUp() override {
+      SceneCacheTest::SetUp();
+      _sceneFile = (_dir / "full.cfg").string();
+      std::ofstream(_sceneFile)
+          << "camera : { resolution = { width = 12; height = 8; };\n"
+          << "  position = { x = 1; y = 2; z = 3; };\n"
+          << "  rotation = { x = 0; y = 0; z = 0; };\n"
+          << "  fieldOfView = 60.0; };\n"
+          << "primitives : {\n"
+          << "  spheres = ( { x = 0; y = 0; z = 5; r = 1.5;\n"
+          << "    color = { r = 1.0; g = 0.0; b = 0.0; };\n"
+          << "    translate = { x = 1; y = 0; z = 0; }; } );\n"
+          << "  objects = ( { obj_file = \"" << (_dir / "cube.obj").string()
+          << "\"; scale = { x = 2; y = 2; z = 2; }; } ); };\n"
+          << "lights : { diffuse = 0.5;\n"
+          << "  point = ( { x = 0; y = 4; z = 0; intensity = 0.8;\n"
+          << "    color = { r = 1.0; g = 1.0; b = 1.0; }; } ); };\n";
+      // Older than the cache, so that its write time can be trusted.
+      _written = std::filesystem::file_time_type::clock::now() -
+                 std::chrono::hours(1);
+      std::filesystem::last_write_time(_sceneFile, _written);
+    }
+
+    void parse(Raytracer::Camera &camera, Raytracer::ShapeComposite &sc,
+               Raytracer::LightComposite &lc) {
+      Raytracer::ParserConfigFile parser(_sceneFile, _plugins);
+      parser.parseConfigFile(camera, sc, lc);
+    }
+
+    std::string _sceneFile;
+    std::filesystem::file_time_type _written;
+};
+
+TEST_F(SceneCacheSceneTest, SceneCacheReplaysFlattenedScene) {
+    Raytracer::Camera camera;
+    Raytracer::ShapeComposite sc;
+    Raytracer::LightComposite lc;
+    ASSERT_NO_THROW(parse(camera, sc, lc));
+    ASSERT_NE(Raytracer::SceneCache(_sceneFile).getScene(), nullptr);
+
+    // Same size and write time: the file is trusted without being read, so
+    // its content no longer matters.
+    std::ofstream(_sceneFile, std::ios::in | std::ios::out)
+        << "this is not a scene";
+    std::filesystem::last_write_time(_sceneFile, _written);
+
+    Raytracer::Camera cachedCamera;
+    Raytracer::ShapeComposite cachedSc;
+    Raytracer::LightComposite cachedLc;
+    ASSERT_NO_THROW(parse(cachedCamera, cachedSc, cachedLc));
+    EXPECT_EQ(cachedCamera.getWidth(), 12u);
+    EXPECT_EQ(cachedCamera.getHeight(), 8u);
+    EXPECT_FLOAT_EQ(cachedCamera.origin.z, camera.origin.z);
+    EXPECT_DOUBLE_EQ(cachedLc.getDiffuse(), 0.5);
+    ASSERT_EQ(cachedSc.getShapes().size(), sc.getShapes().size());
+    ASSERT_EQ(cachedLc.getLights().size(), lc.getLights().size());
+    EXPECT_FLOAT_EQ(cachedSc.getShapes()[0]->getCenter().x,
+                    sc.getShapes()[0]->getCenter().x);
+
+    auto instance =
+        std::static_pointer_cast<Raytracer::Instance>(cachedSc.getShapes()[1]);
+    auto mesh = std::static_pointer_cast<const Raytracer::Object>(
+        instance->getPrototype());
+    EXPECT_TRUE(mesh->getFaces().isView());
+    EXPECT_TRUE(mesh->getAccel().getNodes().isView());
+
+    Raytracer::Ray ray(Math::Point3D(1, 3, -5), Math::Vector3D(0, 0, 1));
+    EXPECT_DOUBLE_EQ(std::get<0>(cachedSc.getShapes()[1]->hits(ray)),
+                     std::get<0>(sc.getShapes()[1]->hits(ray)));
+}
+
+TEST_F(SceneCacheSceneTest, SceneCacheHashesTouchedFiles) {
+    Raytracer::Camera camera;
+    Raytracer::ShapeComposite sc;
+    Raytracer::LightComposite lc;
+    ASSERT_NO_THROW(parse(camera, sc, lc));
+
+    std::filesystem::last_write_time(_sceneFile, _written +
+                                                     std::chrono::minutes(1));
+    EXPECT_NE(Raytracer::SceneCache(_sceneFile).getScene(), nullptr);
+
+    std::string content;
+    {
+      std::ifstream in(_sceneFile);
+      content.assign(std::istreambuf_iterator<char>(in), {});
+    }
+    content[content.find("r = 1.5")] = 'R';
+    std::ofstream(_sceneFile) << content;
+    EXPECT_EQ(Raytracer::SceneCache(_sceneFile).getScene(), nullptr);
+}
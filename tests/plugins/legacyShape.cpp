@@ -0,0 +1,81 @@
+#include <cmath>
+#include "IShape.hpp"
+
+namespace {
+
+  /**
+   * @brief Unit sphere written against IShape alone, as shape plugins were
+   * before the extended entry points: it exports addShape() only, reads no
+   * more of a ray than its origin and direction, and has no bounds.
+   */
+  class LegacyShape : public Raytracer::IShape {
+    public:
+      std::tuple<double, Math::Vector3D, const IShape *> hits(
+          const Raytracer::Ray &ray) const override {
+        Math::Vector3D oc = ray.origin - _center;
+        double b = oc.dot(ray.direction);
+        double c = oc.dot(oc) - 1.0;
+        double discriminant = b * b - c;
+        if (discriminant < 0)
+          return {0.0, _color, nullptr};
+        double t = -b - std::sqrt(discriminant);
+        if (t <= 0)
+          t = -b + std::sqrt(discriminant);
+        if (t <= 0)
+          return {0.0, _color, nullptr};
+        return {t, _color, this};
+      }
+
+      Math::Vector3D getNormal(const Math::Point3D &hitPoint) const override {
+        return hitPoint - _center;
+      }
+
+      void translate(const Math::Vector3D &offset) override {
+        _center = _center + offset;
+      }
+
+      void rotate(const Math::Vector3D &, float) override {
+      }
+
+      const Math::Point3D &getCenter() const override {
+        return _center;
+      }
+
+      const Math::Vector3D &getColor() const override {
+        return _color;
+      }
+
+      double getShininess() const override {
+        return 0.0;
+      }
+
+      std::shared_ptr<Raytracer::IMaterials> getMaterial() const override {
+        return nullptr;
+      }
+
+      void setCenter(const Math::Point3D &center) override {
+        _center = center;
+      }
+
+      void setColor(const Math::Vector3D &color) override {
+        _color = color;
+      }
+
+      void setShininess(double) override {
+      }
+
+      void setMaterial(std::shared_ptr<Raytracer::IMaterials>) override {
+      }
+
+    private:
+      Math::Point3D _center;
+      Math::Vector3D _color = Math::Vector3D(1, 0, 0);
+  };
+
+}  // namespace
+
+extern "C" {
+Raytracer::IShape *addShape() {
+  return new LegacyShape();
+}
+}
@@ -1,6 +1,14 @@
 #include <gtest/gtest.h>
+#include <cmath>
 #include <filesystem>
+#include <random>
+#include "Cone.hpp"
+#include "ConeInf.hpp"
+#include "Cylinder.hpp"
+#include "CylinderInf.hpp"
 #include "ParserConfigFile.hpp"
+#include "Plane.hpp"
+#include "Sphere.hpp"
 #include "exceptions/RaytracerException.hpp"
 
 class ParserConfigFileTest : public ::testing::Test {
@@ -40,3 +48,292 @@ TEST_F(ParserConfigFileTest, TestParsePrimitives) {
 
   EXPECT_EQ(sc.getShapes().size(), 6);
 }
+
+TEST_F(ParserConfigFileTest, PrimitivePacketsMatchSingleRays) {
+  Raytracer::ParserConfigFile parser("tests/primitives/parsePrimitives.cfg",
+                                     _plugins);
+  Raytracer::Camera camera;
+  Raytracer::ShapeComposite sc;
+  Raytracer::LightComposite lc;
+
+  ASSERT_NO_THROW(parser.parseConfigFile(camera, sc, lc));
+  sc.build();
+  // 16 packets of 4x4 rays fanning out of the camera over the whole scene.
+  for (int p = 0; p < 16; p++) {
+    Raytracer::RayPacket packet;
+    for (int i = 0; i < Raytracer::RayPacket::size; i++) {
+      float x = ((p % 4) * 4 + i % 4) / 8.0f - 1.0f;
+      float y = ((p / 4) * 4 + i / 4) / 8.0f - 1.0f;
+      packet.set(i, Raytracer::Ray(Math::Point3D(0, 1, 0),
+                                   Math::Vector3D(x, y, -1).normalized()));
+    }
+    sc.hitsPacket(packet, 0xFFFF);
+    for (int i = 0; i < Raytracer::RayPacket::size; i++) {
+      Raytracer::Ray ray = packet.ray(i);
+      ray.tMax = std::numeric_limits<double>::infinity();
+      auto [t, color, shape] = sc.hits(ray);
+      EXPECT_EQ(packet.shape[i], shape) << "packet " << p << " ray " << i;
+      if (shape) {
+        EXPECT_NEAR(packet.tMax[i], t, 1e-3 * t);
+      }
+    }
+  }
+}
+
+TEST_F(ParserConfigFileTest, PluginBatchesMatchSingleRays) {
+  Raytracer::ParserConfigFile parser("tests/primitives/triangles.cfg",
+                                     _plugins);
+  Raytracer::Camera camera;
+  Raytracer::ShapeComposite sc;
+  Raytracer::LightComposite lc;
+
+  ASSERT_NO_THROW(parser.parseConfigFile(camera, sc, lc));
+  // Every shape exports a table, only the triangles a batch intersector.
+  int batched = 0;
+  for (const auto &shape : sc.getShapes()) {
+    const Raytracer::ShapeAbi *abi = Raytracer::Factory::getShapeAbi(*shape);
+    ASSERT_NE(abi, nullptr);
+    EXPECT_EQ(abi->version, Raytracer::shapeAbiVersion);
+    if (abi->capabilities & Raytracer::ShapeBatchHits)
+      batched++;
+  }
+  EXPECT_EQ(batched, 3);
+
+  sc.build();
+  for (int p = 0; p < 16; p++) {
+    Raytracer::RayPacket packet;
+    for (int i = 0; i < Raytracer::RayPacket::size; i++) {
+      float x = ((p % 4) * 4 + i % 4) / 8.0f - 1.0f;
+      float y = ((p / 4) * 4 + i / 4) / 8.0f - 1.0f;
+      packet.set(i, Raytracer::Ray(Math::Point3D(0, 1, 0),
+                                   Math::Vector3D(x, y, -1).normalized()));
+    }
+    sc.hitsPacket(packet, 0xFFFF);
+    for (int i = 0; i < Raytracer::RayPacket::size; i++) {
+      Raytracer::Ray ray = packet.ray(i);
+      ray.tMax = std::numeric_limits<double>::infinity();
+      auto [t, color, shape] = sc.hits(ray);
+      EXPECT_EQ(packet.shape[i], shape) << "packet " << p << " ray " << i;
+      if (shape) {
+        EXPECT_FLOAT_EQ(packet.tMax[i], t);
+        EXPECT_FLOAT_EQ(packet.color[i].x, color.x);
+        EXPECT_FLOAT_EQ(packet.color[i].y, color.y);
+      }
+    }
+  }
+}
+
+TEST_F(ParserConfigFileTest, BoundsHoldEveryHit) {
+  Raytracer::Camera camera;
+  Raytracer::LightComposite lc;
+  std::mt19937 random(23);
+  std::uniform_real_distribution<float> offset(-4.0f, 4.0f);
+  std::uniform_real_distribution<float> jitter(-1.5f, 1.5f);
+  int bounded = 0;
+  int infinite = 0;
+
+  for (const char *file : {"tests/primitives/parsePrimitives.cfg",
+                           "tests/primitives/triangles.cfg"}) {
+    Raytracer::ParserConfigFile parser(file, _plugins);
+    Raytracer::ShapeComposite sc;
+    ASSERT_NO_THROW(parser.parseConfigFile(camera, sc, lc));
+    for (const auto &shape : sc.getShapes()) {
+      Math::AABB bounds = Raytracer::shapeBounds(
+          Raytracer::Factory::getShapeAbi(*shape), *shape);
+      if (bounds.isInfinite()) {
+        infinite++;
+        continue;
+      }
+      bounded++;
+      ASSERT_FALSE(bounds.isEmpty());
+      Math::Point3D center = bounds.centroid();
+      int hits = 0;
+      for (int i = 0; i < 2000; i++) {
+        Math::Point3D origin =
+            center + Math::Vector3D(offset(random), offset(random),
+                                    offset(random));
+        Math::Point3D target =
+            center + Math::Vector3D(jitter(random), jitter(random),
+                                    jitter(random));
+        Raytracer::Ray ray(origin, (target - origin).normalized());
+        auto [t, color, hit] = shape->hits(ray);
+        if (!hit || t <= 0.0)
+          continue;
+        hits++;
+        Math::Point3D point = ray.origin + ray.direction * t;
+        EXPECT_GE(point.x, bounds.min.x - 1e-3) << file << " ray " << i;
+        EXPECT_GE(point.y, bounds.min.y - 1e-3) << file << " ray " << i;
+        EXPECT_GE(point.z, bounds.min.z - 1e-3) << file << " ray " << i;
+        EXPECT_LE(point.x, bounds.max.x + 1e-3) << file << " ray " << i;
+        EXPECT_LE(point.y, bounds.max.y + 1e-3) << file << " ray " << i;
+        EXPECT_LE(point.z, bounds.max.z + 1e-3) << file << " ray " << i;
+      }
+      EXPECT_GT(hits, 0) << file;
+    }
+  }
+  // Sphere, cylinder, cone and three triangles; plane, infinite cylinder
+  // and cone, then the plane under the triangles.
+  EXPECT_EQ(bounded, 6);
+  EXPECT_EQ(infinite, 4);
+}
+
+class PrimitiveIntervalTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      for (const auto &entry :
+           std::filesystem::directory_iterator("./plugins")) {
+        if (entry.is_regular_file() && entry.path().extension() == ".so") {
+          _plugins.push_back(entry.path().string());
+        }
+      }
+      _factory.initFactories(_plugins);
+    }
+
+    /**
+     * @brief A primitive and the distances at which a ray leaving
+     * (-10, 0, 0) along +x enters and leaves it.
+     */
+    struct Interval {
+      std::string name;
+      std::shared_ptr<Raytracer::IShape> shape;
+      double near;
+      double far; ///< 0 for the plane, which is crossed once.
+    };
+
+    /**
+     * @brief Creates every primitive from the plugins, placed so that the
+     * x axis crosses each of them.
+     */
+    std::vector<Interval> makeIntervals() {
+      std::vector<Interval> intervals;
+
+      auto sphere = _factory.create<Raytracer::Sphere>("sphere");
+      sphere->setCenter(Math::Point3D(0, 0, 0));
+      sphere->setRadius(1.0);
+      sphere->commit();
+      intervals.push_back({"sphere", sphere, 9.0, 11.0});
+
+      auto cylinder = _factory.create<Raytracer::Cylinder>("cylinder");
+      cylinder->setCenter(Math::Point3D(0, -1, 0));
+      cylinder->setRadius(1.0);
+      cylinder->setHeight(2.0);
+      cylinder->commit();
+      intervals.push_back({"cylinder", cylinder, 9.0, 11.0});
+
+      auto cylinderInf =
+          _factory.create<Raytracer::CylinderInf>("cylinderInf");
+      cylinderInf->setCenter(Math::Point3D(0, 0, 0));
+      cylinderInf->setRadius(1.0);
+      cylinderInf->commit();
+      intervals.push_back({"cylinderInf", cylinderInf, 9.0, 11.0});
+
+      // Radius 0.5 halfway between the base and the apex.
+      auto cone = _factory.create<Raytracer::Cone>("cone");
+      cone->setCenter(Math::Point3D(0, -1, 0));
+      cone->setNormal(Math::Vector3D(0, 1, 0));
+      cone->setRadius(1.0);
+      cone->setHeight(2.0);
+      cone->commit();
+      intervals.push_back({"cone", cone, 9.5, 10.5});
+
+      auto coneInf = _factory.create<Raytracer::ConeInf>("coneInf");
+      coneInf->setCenter(Math::Point3D(0, -1, 0));
+      coneInf->setNormal(Math::Vector3D(0, 1, 0));
+      coneInf->setAngle(M_PI / 4);
+      coneInf->commit();
+      intervals.push_back({"coneInf", coneInf, 9.0, 11.0});
+
+      auto plane = _factory.create<Raytracer::Plane>("plane");
+      plane->setCenter(Math::Point3D(0, 0, 0));
+      plane->setNormal(Math::Vector3D(1, 0, 0));
+      plane->commit();
+      intervals.push_back({"plane", plane, 10.0, 0.0});
+      return intervals;
+    }
+
+    /**
+     * @brief Gets the distance of the hit of a ray with a shape.
+     * @return The distance, or 0 if the shape is missed.
+     */
+    static double hitDistance(const Raytracer::IShape &shape,
+                              const Raytracer::Ray &ray) {
+      auto [t, color, hit] = shape.hits(ray);
+      return hit && t > 0.0 ? t : 0.0;
+    }
+
+    std::vector<std::string> _plugins;
+    Raytracer::Factory _factory;
+};
+
+TEST_F(PrimitiveIntervalTest, HitsAreClippedToTheRayInterval) {
+  const Math::Point3D origin(-10, 0, 0);
+  const Math::Vector3D x(1, 0, 0);
+  using Raytracer::Ray;
+
+  for (const Interval &p : makeIntervals()) {
+    const Raytracer::IShape &shape = *p.shape;
+    EXPECT_NEAR(hitDistance(shape, Ray(origin, x)), p.near, 1e-4) << p.name;
+    EXPECT_EQ(hitDistance(shape, Ray(origin, x, Ray::Primary, 0.0,
+                                     p.near - 0.1)), 0.0) << p.name;
+    if (p.far > 0.0) {
+      // Past the near root, the far one is the hit.
+      EXPECT_NEAR(hitDistance(shape, Ray(origin, x, Ray::Primary,
+                                         p.near + 0.1)), p.far, 1e-4)
+          << p.name;
+      EXPECT_EQ(hitDistance(shape, Ray(origin, x, Ray::Primary, p.near + 0.1,
+                                       p.far - 0.1)), 0.0) << p.name;
+      EXPECT_EQ(hitDistance(shape, Ray(origin, x, Ray::Primary,
+                                       p.far + 0.1)), 0.0) << p.name;
+    } else {
+      EXPECT_EQ(hitDistance(shape, Ray(origin, x, Ray::Primary,
+                                       p.near + 0.1)), 0.0) << p.name;
+      // Behind the origin.
+      EXPECT_EQ(hitDistance(shape, Ray(Math::Point3D(10, 0, 0), x)), 0.0)
+          << p.name;
+    }
+  }
+}
+
+TEST_F(PrimitiveIntervalTest, RaysStartingInsideHitTheFarSide) {
+  const Math::Point3D origin(0, 0, 0);
+  const Math::Vector3D x(1, 0, 0);
+
+  for (const Interval &p : makeIntervals()) {
+    if (p.far <= 0.0)
+      continue;
+    EXPECT_NEAR(hitDistance(*p.shape, Raytracer::Ray(origin, x)),
+                p.far - 10.0, 1e-4) << p.name;
+    EXPECT_NEAR(hitDistance(*p.shape, Raytracer::Ray(origin, -x)),
+                p.far - 10.0, 1e-4) << p.name;
+  }
+}
+
+TEST_F(PrimitiveIntervalTest, ConeSkipsRootsOutsideItsHeight) {
+  auto cone = _factory.create<Raytracer::Cone>("cone");
+  cone->setCenter(Math::Point3D(0, 0, 0));
+  cone->setNormal(Math::Vector3D(0, 1, 0));
+  cone->setRadius(1.0);
+  cone->setHeight(1.0);
+  cone->commit();
+
+  // Going down at x = 0.5, the ray first meets the mirrored nappe above
+  // the apex, at y = 1.5, then the side of the cone at y = 0.5.
+  Raytracer::Ray ray(Math::Point3D(0.5, 3, 0), Math::Vector3D(0, -1, 0));
+  EXPECT_NEAR(hitDistance(*cone, ray), 2.5, 1e-4);
+}
+
+TEST_F(PrimitiveIntervalTest, HitsBeyondOneHundredUnitsAreKept) {
+  const Math::Point3D origin(-200, 0, 0);
+  const Math::Vector3D x(1, 0, 0);
+
+  for (const Interval &p : makeIntervals()) {
+    Raytracer::Ray ray(origin, x);
+    EXPECT_NEAR(hitDistance(*p.shape, ray), p.near + 190.0, 1e-3) << p.name;
+    Raytracer::ShapeComposite sc;
+    sc.addShape(p.shape);
+    sc.build();
+    auto [t, color, hit] = sc.hits(ray);
+    EXPECT_EQ(hit, p.shape.get()) << p.name;
+    EXPECT_NEAR(t, p.near + 190.0, 1e-3) << p.name;
+  }
+}
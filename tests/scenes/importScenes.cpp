@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "Instance.hpp"
+#include "ParserConfigFile.hpp"
+#include "exceptions/RaytracerException.hpp"
+
+class ParserConfigFileTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      for (const auto& entry :
+           std::filesystem::directory_iterator("./plugins")) {
+        if (entry.is_regular_file() && entry.path().extension() == ".so") {
+          _plugins.push_back(entry.path().string());
+        }
+      }
+    }
+
+    void TearDown() override {
+    }
+
+    libconfig::Config _cfg;
+    std::string _cfgFile;
+    std::vector<std::string> _plugins;
+};
+
+
+TEST_F(ParserConfigFileTest, ImportedScenesMergeInImportOrder) {
+    Raytracer::ParserConfigFile parser("tests/scenes/main.cfg", _plugins);
+    Raytracer::Camera camera;
+    Raytracer::ShapeComposite sc;
+    Raytracer::LightComposite lc;
+
+    ASSERT_NO_THROW(parser.parseConfigFile(camera, sc, lc));
+    const auto &shapes = sc.getShapes();
+    ASSERT_EQ(shapes.size(), 6);
+    EXPECT_FLOAT_EQ(shapes[0]->getCenter().x, 0.0);
+    EXPECT_FLOAT_EQ(shapes[1]->getCenter().x, 1.0);
+    EXPECT_FLOAT_EQ(shapes[3]->getCenter().x, 2.0);
+    EXPECT_FLOAT_EQ(shapes[4]->getCenter().x, 3.0);
+    auto first = std::static_pointer_cast<Raytracer::Instance>(shapes[2]);
+    auto second = std::static_pointer_cast<Raytracer::Instance>(shapes[5]);
+    ASSERT_NE(first->getPrototype(), nullptr);
+    EXPECT_EQ(first->getPrototype(), second->getPrototype());
+    EXPECT_DOUBLE_EQ(lc.getDiffuse(), 0.4);
+}
+
+TEST_F(ParserConfigFileTest, ImportLoopDetected) {
+    Raytracer::ParserConfigFile parser("tests/scenes/loopFirst.cfg", _plugins);
+    Raytracer::ShapeComposite sc;
+    Raytracer::LightComposite lc;
+
+    EXPECT_THROW(parser.parseConfigFile(sc, lc), Raytracer::ParseError);
+}
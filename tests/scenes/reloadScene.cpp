@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include "Instance.hpp"
+#include "ParserConfigFile.hpp"
+#include "exceptions/RaytracerException.hpp"
+
+class ReloadSceneTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      for (const auto& entry :
+           std::filesystem::directory_iterator("./plugins")) {
+        if (entry.is_regular_file() && entry.path().extension() == ".so") {
+          _plugins.push_back(entry.path().string());
+        }
+      }
+      _dir = std::filesystem::temp_directory_path() / "raytracer_reload";
+      std::filesystem::remove_all(_dir);
+      std::filesystem::create_directories(_dir);
+      std::filesystem::copy_file("tests/obj/cube.obj", _dir / "cube.obj");
+      _cfgFile = (_dir / "scene.cfg").string();
+      writeScene(1.0);
+    }
+
+    void TearDown() override {
+      std::filesystem::remove_all(_dir);
+    }
+
+    void writeScene(double red, bool brokenLight = false) {
+      std::ofstream(_cfgFile)
+          << "camera : { resolution = { width = 10; height = 10; };\n"
+          << "  position = { x = 0; y = 0; z = 0; };\n"
+          << "  rotation = { x = 0; y = 0; z = 0; };\n"
+          << "  fieldOfView = 45.0; };\n"
+          << "primitives : {\n"
+          << "  spheres = (\n"
+          << "    { x = 0.0; y = 0.0; z = 5.0; r = 1.0;\n"
+          << "      color = { r = " << red << "; g = 0.0; b = 0.0; }; },\n"
+          << "    { x = 3.0; y = 0.0; z = 5.0; r = 1.0;\n"
+          << "      color = { r = 0.0; g = 1.0; b = 0.0; }; } );\n"
+          << "  objects = ( { obj_file = \""
+          << (_dir / "cube.obj").string() << "\"; } ); };\n"
+          << "lights : { diffuse = 0.4;\n"
+          << "  point = ( { x = 0.0; y = 5.0; z = 0.0;"
+          << (brokenLight ? "\n" : " intensity = 1.0;\n")
+          << "    color = { r = 1.0; g = 1.0; b = 1.0; }; } ); };\n";
+    }
+
+    std::shared_ptr<Raytracer::SceneIndex> parse(
+        Raytracer::ShapeComposite &sc, Raytracer::LightComposite &lc,
+        const std::shared_ptr<Raytracer::SceneIndex> &previous = nullptr) {
+      Raytracer::Camera camera;
+      Raytracer::ParserConfigFile parser(_cfgFile, _plugins);
+      parser.setMeshCache(_meshes);
+      parser.setPreviousScene(previous);
+      parser.parseConfigFile(camera, sc, lc);
+      return parser.getSceneIndex();
+    }
+
+    std::string _cfgFile;
+    std::vector<std::string> _plugins;
+    std::filesystem::path _dir;
+    std::shared_ptr<Raytracer::MeshCache> _meshes =
+        std::make_shared<Raytracer::MeshCache>();
+};
+
+TEST_F(ReloadSceneTest, UnchangedPrimitivesAreKept) {
+    Raytracer::ShapeComposite live;
+    Raytracer::LightComposite liveLights;
+    auto index = parse(live, liveLights);
+    live.build();
+    auto before = live.getShapes();
+
+    writeScene(0.5);
+    Raytracer::ShapeComposite next;
+    Raytracer::LightComposite nextLights;
+    parse(next, nextLights, index);
+    ASSERT_EQ(next.getShapes().size(), 3);
+    EXPECT_NE(next.getShapes()[0], before[0]);
+    EXPECT_EQ(next.getShapes()[1], before[1]);
+    EXPECT_EQ(next.getShapes()[2], before[2]);
+    EXPECT_EQ(nextLights.getLights()[0], liveLights.getLights()[0]);
+
+    EXPECT_EQ(live.update(next.getShapes()), 1);
+    EXPECT_EQ(live.getShapes()[0], next.getShapes()[0]);
+}
+
+TEST_F(ReloadSceneTest, ModifiedMeshIsEvicted) {
+    Raytracer::ShapeComposite live;
+    Raytracer::LightComposite liveLights;
+    auto index = parse(live, liveLights);
+    auto mesh = std::static_pointer_cast<Raytracer::Instance>(
+        live.getShapes()[2])->getPrototype();
+
+    EXPECT_EQ(_meshes->evictStale(), 0);
+    std::filesystem::last_write_time(
+        _dir / "cube.obj", std::filesystem::last_write_time(_dir / "cube.obj") +
+                               std::chrono::seconds(1));
+    EXPECT_EQ(_meshes->evictStale(), 1);
+
+    Raytracer::ShapeComposite next;
+    Raytracer::LightComposite nextLights;
+    parse(next, nextLights, index);
+    auto reloaded = std::static_pointer_cast<Raytracer::Instance>(
+        next.getShapes()[2])->getPrototype();
+    EXPECT_NE(reloaded, mesh);
+    EXPECT_EQ(next.getShapes()[0], live.getShapes()[0]);
+}
+
+TEST_F(ReloadSceneTest, FailedReloadKeepsTheLiveIndex) {
+    Raytracer::ShapeComposite live;
+    Raytracer::LightComposite liveLights;
+    auto index = parse(live, liveLights);
+    auto before = live.getShapes();
+
+    // The primitives are parsed, and reused, before the light fails.
+    writeScene(1.0, true);
+    Raytracer::ShapeComposite failed;
+    Raytracer::LightComposite failedLights;
+    EXPECT_ANY_THROW(parse(failed, failedLights, index));
+
+    writeScene(1.0);
+    Raytracer::ShapeComposite next;
+    Raytracer::LightComposite nextLights;
+    parse(next, nextLights, index);
+    ASSERT_EQ(next.getShapes().size(), before.size());
+    for (std::size_t i = 0; i < before.size(); i++)
+      EXPECT_EQ(next.getShapes()[i], before[i]) << "shape " << i;
+    EXPECT_EQ(nextLights.getLights()[0], liveLights.getLights()[0]);
+}
+
+TEST_F(ReloadSceneTest, BrokenMeshKeepsThePreviousScene) {
+    Raytracer::ShapeComposite live;
+    Raytracer::LightComposite liveLights;
+    auto index = parse(live, liveLights);
+    auto before = live.getShapes();
+    auto mesh = std::static_pointer_cast<Raytracer::Instance>(
+        before[2])->getPrototype();
+
+    std::ofstream(_dir / "cube.obj", std::ios::trunc)
+        << "v 0 0 0\nv 1 0 0\nf 1 2 9\n";
+    std::filesystem::last_write_time(
+        _dir / "cube.obj", std::filesystem::last_write_time(_dir / "cube.obj") +
+                               std::chrono::seconds(1));
+    EXPECT_EQ(_meshes->evictStale(), 1);
+    Raytracer::ShapeComposite failed;
+    Raytracer::LightComposite failedLights;
+    EXPECT_THROW(parse(failed, failedLights, index), Raytracer::ParseError);
+
+    ASSERT_EQ(live.getShapes().size(), before.size());
+    for (std::size_t i = 0; i < before.size(); i++)
+      EXPECT_EQ(live.getShapes()[i], before[i]) << "shape " << i;
+    EXPECT_EQ(std::static_pointer_cast<Raytracer::Instance>(
+                  live.getShapes()[2])->getPrototype(), mesh);
+
+    writeScene(0.5);
+    Raytracer::ShapeComposite next;
+    Raytracer::LightComposite nextLights;
+    EXPECT_THROW(parse(next, nextLights, index), Raytracer::ParseError);
+    std::filesystem::copy_file(
+        "tests/obj/cube.obj", _dir / "cube.obj",
+        std::filesystem::copy_options::overwrite_existing);
+    Raytracer::ShapeComposite fixed;
+    Raytracer::LightComposite fixedLights;
+    parse(fixed, fixedLights, index);
+    ASSERT_EQ(fixed.getShapes().size(), before.size());
+    EXPECT_EQ(fixed.getShapes()[1], before[1]);
+}